@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarktimer.h
+// ============
+// time the CPU benchmarks of the scene modules
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+
+/***********************************************************
+ *  BenchmarkTimer
+ *
+ *  This class times the work measured by the benchmarks of
+ *  the scene modules.  Keeping the fastest of several runs
+ *  leaves out the runs slowed down by the rest of the
+ *  system.
+ ***********************************************************/
+class BenchmarkTimer
+{
+public:
+	/***********************************************************
+	 *  TimeMilliseconds()
+	 *
+	 *  Run the passed in function several times and return the
+	 *  fastest run in milliseconds.
+	 ***********************************************************/
+	template <typename FUNCTION>
+	static double TimeMilliseconds(FUNCTION function, int repetitions)
+	{
+		double best = 1.0e30;
+		for (int i = 0; i < repetitions; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			auto stop = std::chrono::high_resolution_clock::now();
+			double elapsed = std::chrono::duration<double, std::milli>(stop - start).count();
+			if (elapsed < best)
+			{
+				best = elapsed;
+			}
+		}
+		return(best);
+	}
+};
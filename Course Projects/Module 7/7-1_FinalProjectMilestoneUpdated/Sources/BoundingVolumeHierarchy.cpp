@@ -0,0 +1,1309 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// 4-wide bounding volume hierarchy for spatial queries over scene objects
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+#include "BenchmarkTimer.h"
+#include "ThreadPool.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define BVH_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// largest number of objects in one leaf lane
+	const int MAX_LEAF_SIZE = 4;
+	// number of bins per axis for the surface area heuristic
+	const int SAH_BIN_COUNT = 16;
+	// deeper ranges are split at the median, which keeps the
+	// tree shallow enough for the fixed traversal stacks
+	const int MAX_SAH_DEPTH = 40;
+	const int MAX_STACK_SIZE = 256;
+	// smallest range handed to a worker as its own subtree
+	const int MIN_SUBTREE_SIZE = 4096;
+	// box used for the lanes of a node holding no child
+	const float EMPTY_BOUND = 3.0e38f;
+	// replaces the inverse of near zero ray direction components
+	const float LARGE_INVERSE = 1.0e30f;
+
+	// node of the binary tree before it is collapsed
+	struct BUILD_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		int left;
+		int right;
+		// objects of a leaf, count is 0 for inner nodes
+		int first;
+		int count;
+	};
+
+	// range left for a worker to build as a separate subtree
+	struct BUILD_TASK
+	{
+		int node;
+		int first;
+		int count;
+		int depth;
+	};
+
+	struct SAH_BIN
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		int count;
+	};
+
+	/***********************************************************
+	 *  SurfaceArea()
+	 *
+	 *  Surface area of a box, zero for an empty box.
+	 ***********************************************************/
+	float SurfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		glm::vec3 size = boundsMax - boundsMin;
+		if ((size.x < 0.0f) || (size.y < 0.0f) || (size.z < 0.0f))
+		{
+			return(0.0f);
+		}
+		return(2.0f * ((size.x * size.y) + (size.y * size.z) + (size.z * size.x)));
+	}
+
+	/***********************************************************
+	 *  TreeBuilder
+	 *
+	 *  Builds the binary tree top-down with the binned surface
+	 *  area heuristic.  The top of the tree is split on the
+	 *  calling thread until the ranges are small enough, then
+	 *  the remaining subtrees are built in parallel on the
+	 *  shared thread pool and appended to the node list.
+	 ***********************************************************/
+	class TreeBuilder
+	{
+	public:
+		TreeBuilder(
+			const std::vector<glm::vec3>& objectMin,
+			const std::vector<glm::vec3>& objectMax,
+			std::vector<int>& objects) :
+			m_objectMin(objectMin),
+			m_objectMax(objectMax),
+			m_objects(objects)
+		{
+		}
+
+		/***********************************************************
+		 *  Build()
+		 *
+		 *  Build the tree over all the objects, the root is the
+		 *  first node.
+		 ***********************************************************/
+		void Build()
+		{
+			ThreadPool* pThreadPool = ThreadPool::GetShared();
+			const int objectCount = (int)m_objects.size();
+
+			m_centroids.resize(objectCount);
+			pThreadPool->ParallelFor(objectCount, [&](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+				{
+					m_centroids[i] = (m_objectMin[i] + m_objectMax[i]) * 0.5f;
+				}
+			}, MIN_SUBTREE_SIZE);
+
+			// leave enough subtrees for every worker to stay busy
+			m_subtreeSize = std::max(objectCount / (pThreadPool->GetThreadCount() * 8), MIN_SUBTREE_SIZE);
+
+			std::vector<BUILD_TASK> tasks;
+			BuildRange(m_nodes, 0, objectCount, 0, &tasks);
+
+			std::vector<std::vector<BUILD_NODE>> subtrees(tasks.size());
+			pThreadPool->ParallelFor((int)tasks.size(), [&](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+				{
+					BuildRange(subtrees[i], tasks[i].first, tasks[i].count, tasks[i].depth, nullptr);
+				}
+			});
+
+			// the subtree root replaces the placeholder node and the
+			// rest of the subtree is appended behind the top nodes
+			for (size_t i = 0; i < tasks.size(); i++)
+			{
+				const std::vector<BUILD_NODE>& subtree = subtrees[i];
+				const int base = (int)m_nodes.size() - 1;
+				for (size_t j = 0; j < subtree.size(); j++)
+				{
+					BUILD_NODE node = subtree[j];
+					if (node.count == 0)
+					{
+						node.left = base + node.left;
+						node.right = base + node.right;
+					}
+					if (j == 0)
+					{
+						m_nodes[tasks[i].node] = node;
+					}
+					else
+					{
+						m_nodes.push_back(node);
+					}
+				}
+			}
+		}
+
+		const std::vector<BUILD_NODE>& GetNodes() const
+		{
+			return(m_nodes);
+		}
+
+	private:
+		const std::vector<glm::vec3>& m_objectMin;
+		const std::vector<glm::vec3>& m_objectMax;
+		std::vector<int>& m_objects;
+		std::vector<glm::vec3> m_centroids;
+		std::vector<BUILD_NODE> m_nodes;
+		int m_subtreeSize;
+
+		/***********************************************************
+		 *  BuildRange()
+		 *
+		 *  Build the subtree over a range of the object list and
+		 *  return the index of its root.  When a task list is
+		 *  passed in, small ranges are left as placeholder nodes
+		 *  to be built later.
+		 ***********************************************************/
+		int BuildRange(
+			std::vector<BUILD_NODE>& nodes,
+			int first,
+			int count,
+			int depth,
+			std::vector<BUILD_TASK>* pTasks)
+		{
+			const int index = (int)nodes.size();
+			BUILD_NODE node;
+			glm::vec3 centroidMin(EMPTY_BOUND);
+			glm::vec3 centroidMax(-EMPTY_BOUND);
+
+			node.boundsMin = glm::vec3(EMPTY_BOUND);
+			node.boundsMax = glm::vec3(-EMPTY_BOUND);
+			for (int i = first; i < first + count; i++)
+			{
+				int object = m_objects[i];
+				node.boundsMin = glm::min(node.boundsMin, m_objectMin[object]);
+				node.boundsMax = glm::max(node.boundsMax, m_objectMax[object]);
+				centroidMin = glm::min(centroidMin, m_centroids[object]);
+				centroidMax = glm::max(centroidMax, m_centroids[object]);
+			}
+			node.left = -1;
+			node.right = -1;
+			node.first = first;
+			node.count = count;
+			nodes.push_back(node);
+
+			if (count <= MAX_LEAF_SIZE)
+			{
+				return(index);
+			}
+
+			if ((pTasks != nullptr) && (count <= m_subtreeSize))
+			{
+				BUILD_TASK task = { index, first, count, depth };
+				pTasks->push_back(task);
+				return(index);
+			}
+
+			int middle = -1;
+			if (depth < MAX_SAH_DEPTH)
+			{
+				middle = SplitSAH(first, count, centroidMin, centroidMax);
+			}
+			if (middle < 0)
+			{
+				middle = SplitMedian(first, count, centroidMin, centroidMax);
+			}
+
+			int left = BuildRange(nodes, first, middle - first, depth + 1, pTasks);
+			int right = BuildRange(nodes, middle, first + count - middle, depth + 1, pTasks);
+			nodes[index].left = left;
+			nodes[index].right = right;
+			nodes[index].count = 0;
+
+			return(index);
+		}
+
+		/***********************************************************
+		 *  SplitSAH()
+		 *
+		 *  Sort the centroids of the range into bins along each
+		 *  axis and partition the range at the bin boundary with
+		 *  the lowest surface area cost.  Returns the first object
+		 *  of the right half, or -1 when no split was found.
+		 ***********************************************************/
+		int SplitSAH(int first, int count, const glm::vec3& centroidMin, const glm::vec3& centroidMax)
+		{
+			const glm::vec3 extent = centroidMax - centroidMin;
+			float bestCost = 1.0e38f;
+			int bestAxis = -1;
+			int bestBin = 0;
+			float bestScale = 0.0f;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (extent[axis] <= 0.0f)
+				{
+					continue;
+				}
+
+				SAH_BIN bins[SAH_BIN_COUNT];
+				for (int b = 0; b < SAH_BIN_COUNT; b++)
+				{
+					bins[b].boundsMin = glm::vec3(EMPTY_BOUND);
+					bins[b].boundsMax = glm::vec3(-EMPTY_BOUND);
+					bins[b].count = 0;
+				}
+
+				const float scale = (float)SAH_BIN_COUNT * 0.99999f / extent[axis];
+				for (int i = first; i < first + count; i++)
+				{
+					int object = m_objects[i];
+					int b = (int)((m_centroids[object][axis] - centroidMin[axis]) * scale);
+					b = std::min(std::max(b, 0), SAH_BIN_COUNT - 1);
+					bins[b].boundsMin = glm::min(bins[b].boundsMin, m_objectMin[object]);
+					bins[b].boundsMax = glm::max(bins[b].boundsMax, m_objectMax[object]);
+					bins[b].count++;
+				}
+
+				// cost of the right side of every split, swept from the end
+				float rightCost[SAH_BIN_COUNT];
+				int rightCount[SAH_BIN_COUNT];
+				glm::vec3 boundsMin(EMPTY_BOUND);
+				glm::vec3 boundsMax(-EMPTY_BOUND);
+				int sideCount = 0;
+				for (int b = SAH_BIN_COUNT - 1; b > 0; b--)
+				{
+					boundsMin = glm::min(boundsMin, bins[b].boundsMin);
+					boundsMax = glm::max(boundsMax, bins[b].boundsMax);
+					sideCount += bins[b].count;
+					rightCost[b - 1] = SurfaceArea(boundsMin, boundsMax) * (float)sideCount;
+					rightCount[b - 1] = sideCount;
+				}
+
+				boundsMin = glm::vec3(EMPTY_BOUND);
+				boundsMax = glm::vec3(-EMPTY_BOUND);
+				sideCount = 0;
+				for (int b = 0; b < SAH_BIN_COUNT - 1; b++)
+				{
+					boundsMin = glm::min(boundsMin, bins[b].boundsMin);
+					boundsMax = glm::max(boundsMax, bins[b].boundsMax);
+					sideCount += bins[b].count;
+					if ((sideCount == 0) || (rightCount[b] == 0))
+					{
+						continue;
+					}
+					float cost = (SurfaceArea(boundsMin, boundsMax) * (float)sideCount) + rightCost[b];
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = b;
+						bestScale = scale;
+					}
+				}
+			}
+
+			if (bestAxis < 0)
+			{
+				return(-1);
+			}
+
+			const float axisMin = centroidMin[bestAxis];
+			std::vector<int>::iterator middle = std::partition(
+				m_objects.begin() + first,
+				m_objects.begin() + first + count,
+				[&](int object)
+				{
+					int b = (int)((m_centroids[object][bestAxis] - axisMin) * bestScale);
+					return(std::min(std::max(b, 0), SAH_BIN_COUNT - 1) <= bestBin);
+				});
+
+			return((int)(middle - m_objects.begin()));
+		}
+
+		/***********************************************************
+		 *  SplitMedian()
+		 *
+		 *  Split the range in two halves along the longest axis
+		 *  of the centroids.
+		 ***********************************************************/
+		int SplitMedian(int first, int count, const glm::vec3& centroidMin, const glm::vec3& centroidMax)
+		{
+			const glm::vec3 extent = centroidMax - centroidMin;
+			int axis = 0;
+			if (extent.y > extent[axis])
+			{
+				axis = 1;
+			}
+			if (extent.z > extent[axis])
+			{
+				axis = 2;
+			}
+
+			const int middle = first + (count / 2);
+			std::nth_element(
+				m_objects.begin() + first,
+				m_objects.begin() + middle,
+				m_objects.begin() + first + count,
+				[&](int a, int b)
+				{
+					return(m_centroids[a][axis] < m_centroids[b][axis]);
+				});
+
+			return(middle);
+		}
+	};
+
+	/***********************************************************
+	 *  FrustumLaneMask()
+	 *
+	 *  Test the four lane boxes (minX, minY, minZ, maxX, maxY,
+	 *  maxZ, four floats each) against the frustum planes.
+	 *  Returns a bit per lane that may be visible, and sets a
+	 *  bit in insideMask for the lanes completely inside.
+	 ***********************************************************/
+	int FrustumLaneMask(const float* lanes, const glm::vec4* planes, int& insideMask)
+	{
+		int outside = 0;
+		int inside = 0xF;
+
+#ifdef BVH_USE_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 boxMin[3] = { _mm_loadu_ps(lanes + 0), _mm_loadu_ps(lanes + 4), _mm_loadu_ps(lanes + 8) };
+		const __m128 boxMax[3] = { _mm_loadu_ps(lanes + 12), _mm_loadu_ps(lanes + 16), _mm_loadu_ps(lanes + 20) };
+
+		for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+		{
+			const glm::vec4& plane = planes[p];
+			__m128 farDistance = _mm_set1_ps(plane.w);
+			__m128 nearDistance = farDistance;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				// the corner furthest along the normal decides whether
+				// the box is outside, the nearest whether it is inside
+				__m128 normal = _mm_set1_ps(plane[axis]);
+				const __m128& farCorner = (plane[axis] >= 0.0f) ? boxMax[axis] : boxMin[axis];
+				const __m128& nearCorner = (plane[axis] >= 0.0f) ? boxMin[axis] : boxMax[axis];
+				farDistance = _mm_add_ps(farDistance, _mm_mul_ps(normal, farCorner));
+				nearDistance = _mm_add_ps(nearDistance, _mm_mul_ps(normal, nearCorner));
+			}
+			outside |= _mm_movemask_ps(_mm_cmplt_ps(farDistance, zero));
+			inside &= ~_mm_movemask_ps(_mm_cmplt_ps(nearDistance, zero));
+		}
+#else
+		for (int lane = 0; lane < 4; lane++)
+		{
+			for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+			{
+				const glm::vec4& plane = planes[p];
+				float farDistance = plane.w;
+				float nearDistance = plane.w;
+				for (int axis = 0; axis < 3; axis++)
+				{
+					float boxMin = lanes[(axis * 4) + lane];
+					float boxMax = lanes[12 + (axis * 4) + lane];
+					farDistance += plane[axis] * ((plane[axis] >= 0.0f) ? boxMax : boxMin);
+					nearDistance += plane[axis] * ((plane[axis] >= 0.0f) ? boxMin : boxMax);
+				}
+				if (farDistance < 0.0f)
+				{
+					outside |= (1 << lane);
+				}
+				if (nearDistance < 0.0f)
+				{
+					inside &= ~(1 << lane);
+				}
+			}
+		}
+#endif
+
+		insideMask = inside & ~outside;
+		return(~outside & 0xF);
+	}
+
+	/***********************************************************
+	 *  SphereLaneMask()
+	 *
+	 *  Test the four lane boxes against a sphere.  Returns a bit
+	 *  per lane whose box is closer to the center than the
+	 *  radius.
+	 ***********************************************************/
+	int SphereLaneMask(const float* lanes, const glm::vec3& center, float radius)
+	{
+#ifdef BVH_USE_SSE
+		const __m128 zero = _mm_setzero_ps();
+		__m128 distanceSquared = zero;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m128 c = _mm_set1_ps(center[axis]);
+			__m128 below = _mm_sub_ps(_mm_loadu_ps(lanes + (axis * 4)), c);
+			__m128 above = _mm_sub_ps(c, _mm_loadu_ps(lanes + 12 + (axis * 4)));
+			__m128 gap = _mm_max_ps(_mm_max_ps(below, above), zero);
+			distanceSquared = _mm_add_ps(distanceSquared, _mm_mul_ps(gap, gap));
+		}
+		return(_mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_set1_ps(radius * radius))));
+#else
+		int mask = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			float distanceSquared = 0.0f;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float below = lanes[(axis * 4) + lane] - center[axis];
+				float above = center[axis] - lanes[12 + (axis * 4) + lane];
+				float gap = std::max(std::max(below, above), 0.0f);
+				distanceSquared += gap * gap;
+			}
+			if (distanceSquared <= radius * radius)
+			{
+				mask |= (1 << lane);
+			}
+		}
+		return(mask);
+#endif
+	}
+
+	/***********************************************************
+	 *  RayLaneMask()
+	 *
+	 *  Slab test of the ray against the four lane boxes.
+	 *  Returns a bit per lane hit before maxDistance and
+	 *  stores the entry distance of every lane.
+	 ***********************************************************/
+	int RayLaneMask(
+		const float* lanes,
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		float maxDistance,
+		float* entry)
+	{
+#ifdef BVH_USE_SSE
+		__m128 nearDistance = _mm_setzero_ps();
+		__m128 farDistance = _mm_set1_ps(maxDistance);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m128 o = _mm_set1_ps(origin[axis]);
+			__m128 inverse = _mm_set1_ps(inverseDirection[axis]);
+			__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(lanes + (axis * 4)), o), inverse);
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(lanes + 12 + (axis * 4)), o), inverse);
+			nearDistance = _mm_max_ps(nearDistance, _mm_min_ps(t0, t1));
+			farDistance = _mm_min_ps(farDistance, _mm_max_ps(t0, t1));
+		}
+		_mm_storeu_ps(entry, nearDistance);
+		return(_mm_movemask_ps(_mm_cmple_ps(nearDistance, farDistance)));
+#else
+		int mask = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			float nearDistance = 0.0f;
+			float farDistance = maxDistance;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float t0 = (lanes[(axis * 4) + lane] - origin[axis]) * inverseDirection[axis];
+				float t1 = (lanes[12 + (axis * 4) + lane] - origin[axis]) * inverseDirection[axis];
+				nearDistance = std::max(nearDistance, std::min(t0, t1));
+				farDistance = std::min(farDistance, std::max(t0, t1));
+			}
+			entry[lane] = nearDistance;
+			if (nearDistance <= farDistance)
+			{
+				mask |= (1 << lane);
+			}
+		}
+		return(mask);
+#endif
+	}
+
+	/***********************************************************
+	 *  IntersectRayBox()
+	 *
+	 *  Slab test of the ray against a single object box.
+	 ***********************************************************/
+	bool IntersectRayBox(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		const glm::vec3& boxMin,
+		const glm::vec3& boxMax,
+		float maxDistance,
+		float& entry)
+	{
+		float nearDistance = 0.0f;
+		float farDistance = maxDistance;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t0 = (boxMin[axis] - origin[axis]) * inverseDirection[axis];
+			float t1 = (boxMax[axis] - origin[axis]) * inverseDirection[axis];
+			nearDistance = std::max(nearDistance, std::min(t0, t1));
+			farDistance = std::min(farDistance, std::max(t0, t1));
+		}
+		entry = nearDistance;
+		return(nearDistance <= farDistance);
+	}
+
+	/***********************************************************
+	 *  IsBoxInSphere()
+	 *
+	 *  True when the box is closer to the center than the radius.
+	 ***********************************************************/
+	bool IsBoxInSphere(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& center, float radius)
+	{
+		glm::vec3 closest = glm::clamp(center, boxMin, boxMax);
+		glm::vec3 offset = closest - center;
+		return(glm::dot(offset, offset) <= radius * radius);
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over the
+ *  passed in object boxes, replacing the previous tree.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(
+	const std::vector<glm::vec3>& boundsMin,
+	const std::vector<glm::vec3>& boundsMax)
+{
+	Clear();
+
+	const int objectCount = (int)std::min(boundsMin.size(), boundsMax.size());
+	if (objectCount == 0)
+	{
+		return;
+	}
+
+	m_objectMin.assign(boundsMin.begin(), boundsMin.begin() + objectCount);
+	m_objectMax.assign(boundsMax.begin(), boundsMax.begin() + objectCount);
+	m_objectNode.assign(objectCount, 0);
+	m_objects.resize(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		m_objects[i] = i;
+	}
+
+	TreeBuilder builder(m_objectMin, m_objectMax, m_objects);
+	builder.Build();
+	const std::vector<BUILD_NODE>& buildNodes = builder.GetNodes();
+
+	// collapse the binary tree - every node opens its largest
+	// inner children until it holds four of them.  Nodes are
+	// created before the nodes below them, so a parent always
+	// has a lower index than its children.
+	struct PENDING_NODE
+	{
+		int buildNode;
+		int parent;
+		int parentLane;
+	};
+	std::vector<PENDING_NODE> pending;
+	PENDING_NODE root = { 0, -1, -1 };
+	pending.push_back(root);
+	m_nodes.reserve((buildNodes.size() / 2) + 1);
+
+	while (pending.empty() == false)
+	{
+		PENDING_NODE item = pending.back();
+		pending.pop_back();
+
+		const int nodeIndex = (int)m_nodes.size();
+		m_nodes.push_back(NODE());
+		if (item.parent >= 0)
+		{
+			m_nodes[item.parent].child[item.parentLane] = nodeIndex;
+		}
+
+		NODE& node = m_nodes[nodeIndex];
+		for (int lane = 0; lane < 4; lane++)
+		{
+			node.minX[lane] = node.minY[lane] = node.minZ[lane] = EMPTY_BOUND;
+			node.maxX[lane] = node.maxY[lane] = node.maxZ[lane] = -EMPTY_BOUND;
+			node.child[lane] = -1;
+			node.count[lane] = 0;
+		}
+		node.parent = item.parent;
+		node.parentLane = item.parentLane;
+		node.laneMask = 0;
+		node.padding = 0;
+
+		int lanes[4];
+		int laneCount = 0;
+		const BUILD_NODE& buildNode = buildNodes[item.buildNode];
+		if (buildNode.count > 0)
+		{
+			// the whole tree is a single leaf
+			lanes[laneCount++] = item.buildNode;
+		}
+		else
+		{
+			lanes[laneCount++] = buildNode.left;
+			lanes[laneCount++] = buildNode.right;
+			while (laneCount < 4)
+			{
+				int largest = -1;
+				float largestArea = -1.0f;
+				for (int lane = 0; lane < laneCount; lane++)
+				{
+					const BUILD_NODE& candidate = buildNodes[lanes[lane]];
+					float area = SurfaceArea(candidate.boundsMin, candidate.boundsMax);
+					if ((candidate.count == 0) && (area > largestArea))
+					{
+						largest = lane;
+						largestArea = area;
+					}
+				}
+				if (largest < 0)
+				{
+					break;
+				}
+				const BUILD_NODE& opened = buildNodes[lanes[largest]];
+				lanes[largest] = opened.left;
+				lanes[laneCount++] = opened.right;
+			}
+		}
+
+		for (int lane = 0; lane < laneCount; lane++)
+		{
+			const BUILD_NODE& child = buildNodes[lanes[lane]];
+			node.minX[lane] = child.boundsMin.x;
+			node.minY[lane] = child.boundsMin.y;
+			node.minZ[lane] = child.boundsMin.z;
+			node.maxX[lane] = child.boundsMax.x;
+			node.maxY[lane] = child.boundsMax.y;
+			node.maxZ[lane] = child.boundsMax.z;
+			node.laneMask |= (1 << lane);
+
+			if (child.count > 0)
+			{
+				node.child[lane] = child.first;
+				node.count[lane] = child.count;
+				for (int i = child.first; i < child.first + child.count; i++)
+				{
+					m_objectNode[m_objects[i]] = nodeIndex;
+				}
+			}
+			else
+			{
+				PENDING_NODE childItem = { lanes[lane], nodeIndex, lane };
+				pending.push_back(childItem);
+			}
+		}
+	}
+
+	m_nodeDirty.assign(m_nodes.size(), 0);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for freeing the tree.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_objects.clear();
+	m_objectMin.clear();
+	m_objectMax.clear();
+	m_objectNode.clear();
+	m_dirtyNodes.clear();
+	m_nodeDirty.clear();
+}
+
+/***********************************************************
+ *  UpdateObject()
+ *
+ *  This method is used for changing the box of an object.
+ *  The node holding the object is refit by the next call
+ *  to Refit().
+ ***********************************************************/
+void BoundingVolumeHierarchy::UpdateObject(int object, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	if ((object < 0) || (object >= (int)m_objectNode.size()))
+	{
+		return;
+	}
+
+	m_objectMin[object] = boundsMin;
+	m_objectMax[object] = boundsMax;
+	MarkDirty(m_objectNode[object]);
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for fitting the node boxes to the
+ *  objects updated since the last refit.  Only the changed
+ *  nodes and the ancestors whose boxes change are visited,
+ *  unless most of the tree is dirty, in which case a single
+ *  pass over every node from the bottom up is cheaper.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Refit()
+{
+	if (m_dirtyNodes.size() > m_nodes.size() / 8)
+	{
+		for (int node = (int)m_nodes.size() - 1; node >= 0; node--)
+		{
+			if (m_nodeDirty[node] != 0)
+			{
+				RefitNode(node);
+			}
+		}
+		m_dirtyNodes.clear();
+		return;
+	}
+
+	// the heap returns the highest index first, so children
+	// are always refit before their parents
+	while (m_dirtyNodes.empty() == false)
+	{
+		std::pop_heap(m_dirtyNodes.begin(), m_dirtyNodes.end());
+		int node = m_dirtyNodes.back();
+		m_dirtyNodes.pop_back();
+		RefitNode(node);
+	}
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used for queuing a node for the next refit.
+ ***********************************************************/
+void BoundingVolumeHierarchy::MarkDirty(int node)
+{
+	if (m_nodeDirty[node] == 0)
+	{
+		m_nodeDirty[node] = 1;
+		m_dirtyNodes.push_back(node);
+		std::push_heap(m_dirtyNodes.begin(), m_dirtyNodes.end());
+	}
+}
+
+/***********************************************************
+ *  RefitNode()
+ *
+ *  This method is used for recomputing the leaf lanes of a
+ *  node from its objects.  The lanes of its child nodes were
+ *  already written by the children.  When the box of the
+ *  whole node changes, the parent lane is updated and the
+ *  parent is queued.
+ ***********************************************************/
+void BoundingVolumeHierarchy::RefitNode(int nodeIndex)
+{
+	NODE& node = m_nodes[nodeIndex];
+	glm::vec3 nodeMin(EMPTY_BOUND);
+	glm::vec3 nodeMax(-EMPTY_BOUND);
+
+	m_nodeDirty[nodeIndex] = 0;
+
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if ((node.laneMask & (1 << lane)) == 0)
+		{
+			continue;
+		}
+
+		if (node.count[lane] > 0)
+		{
+			glm::vec3 laneMin(EMPTY_BOUND);
+			glm::vec3 laneMax(-EMPTY_BOUND);
+			for (int i = node.child[lane]; i < node.child[lane] + node.count[lane]; i++)
+			{
+				laneMin = glm::min(laneMin, m_objectMin[m_objects[i]]);
+				laneMax = glm::max(laneMax, m_objectMax[m_objects[i]]);
+			}
+			node.minX[lane] = laneMin.x;
+			node.minY[lane] = laneMin.y;
+			node.minZ[lane] = laneMin.z;
+			node.maxX[lane] = laneMax.x;
+			node.maxY[lane] = laneMax.y;
+			node.maxZ[lane] = laneMax.z;
+		}
+
+		nodeMin = glm::min(nodeMin, glm::vec3(node.minX[lane], node.minY[lane], node.minZ[lane]));
+		nodeMax = glm::max(nodeMax, glm::vec3(node.maxX[lane], node.maxY[lane], node.maxZ[lane]));
+	}
+
+	if (node.parent < 0)
+	{
+		return;
+	}
+
+	NODE& parent = m_nodes[node.parent];
+	const int lane = node.parentLane;
+	if ((parent.minX[lane] != nodeMin.x) || (parent.minY[lane] != nodeMin.y) || (parent.minZ[lane] != nodeMin.z) ||
+		(parent.maxX[lane] != nodeMax.x) || (parent.maxY[lane] != nodeMax.y) || (parent.maxZ[lane] != nodeMax.z))
+	{
+		parent.minX[lane] = nodeMin.x;
+		parent.minY[lane] = nodeMin.y;
+		parent.minZ[lane] = nodeMin.z;
+		parent.maxX[lane] = nodeMax.x;
+		parent.maxY[lane] = nodeMax.y;
+		parent.maxZ[lane] = nodeMax.z;
+		MarkDirty(node.parent);
+	}
+}
+
+/***********************************************************
+ *  AppendLane()
+ *
+ *  This method is used for appending every object below a
+ *  lane of a node without any further test.
+ ***********************************************************/
+void BoundingVolumeHierarchy::AppendLane(const NODE& node, int lane, std::vector<int>& results) const
+{
+	if (node.count[lane] > 0)
+	{
+		results.insert(
+			results.end(),
+			m_objects.begin() + node.child[lane],
+			m_objects.begin() + node.child[lane] + node.count[lane]);
+		return;
+	}
+
+	int stack[MAX_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = node.child[lane];
+
+	while (stackSize > 0)
+	{
+		const NODE& current = m_nodes[stack[--stackSize]];
+		for (int i = 0; i < 4; i++)
+		{
+			if ((current.laneMask & (1 << i)) == 0)
+			{
+				continue;
+			}
+			if (current.count[i] > 0)
+			{
+				results.insert(
+					results.end(),
+					m_objects.begin() + current.child[i],
+					m_objects.begin() + current.child[i] + current.count[i]);
+			}
+			else
+			{
+				stack[stackSize++] = current.child[i];
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for collecting the objects whose
+ *  boxes may be inside the frustum.  Subtrees completely
+ *  inside the frustum are collected without further tests.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, std::vector<int>& results) const
+{
+	results.clear();
+	if (m_nodes.empty() == true)
+	{
+		return;
+	}
+
+	glm::vec4 planes[Frustum::PLANE_COUNT];
+	for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+	{
+		planes[p] = frustum.GetPlane(p);
+	}
+
+	int stack[MAX_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const NODE& node = m_nodes[stack[--stackSize]];
+		int insideMask = 0;
+		int visibleMask = FrustumLaneMask(node.minX, planes, insideMask) & node.laneMask;
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if ((visibleMask & (1 << lane)) == 0)
+			{
+				continue;
+			}
+
+			if ((insideMask & (1 << lane)) != 0)
+			{
+				AppendLane(node, lane, results);
+			}
+			else if (node.count[lane] > 0)
+			{
+				// the lane box of a single object is the object box
+				for (int i = node.child[lane]; i < node.child[lane] + node.count[lane]; i++)
+				{
+					int object = m_objects[i];
+					if ((node.count[lane] == 1) || (frustum.IsBoxVisible(m_objectMin[object], m_objectMax[object]) == true))
+					{
+						results.push_back(object);
+					}
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.child[lane];
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  QuerySphere()
+ *
+ *  This method is used for collecting the objects whose
+ *  boxes touch the sphere.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QuerySphere(const glm::vec3& center, float radius, std::vector<int>& results) const
+{
+	results.clear();
+	if (m_nodes.empty() == true)
+	{
+		return;
+	}
+
+	int stack[MAX_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const NODE& node = m_nodes[stack[--stackSize]];
+		int hitMask = SphereLaneMask(node.minX, center, radius) & node.laneMask;
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if ((hitMask & (1 << lane)) == 0)
+			{
+				continue;
+			}
+
+			if (node.count[lane] > 0)
+			{
+				for (int i = node.child[lane]; i < node.child[lane] + node.count[lane]; i++)
+				{
+					int object = m_objects[i];
+					if ((node.count[lane] == 1) || (IsBoxInSphere(m_objectMin[object], m_objectMax[object], center, radius) == true))
+					{
+						results.push_back(object);
+					}
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.child[lane];
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  Raycast()
+ *
+ *  This method is used for finding the closest object hit
+ *  by the ray.  Children are visited nearest first and
+ *  subtrees starting beyond the closest hit are skipped.
+ *  The hit test is only called for objects whose box is
+ *  hit before the closest hit found so far.
+ ***********************************************************/
+int BoundingVolumeHierarchy::Raycast(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance,
+	const RAY_HIT_TEST& hitTest) const
+{
+	int hitObject = -1;
+	if (m_nodes.empty() == true)
+	{
+		return(hitObject);
+	}
+
+	// a finite inverse keeps the slab test free of 0 * infinity
+	glm::vec3 inverseDirection;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (std::fabs(direction[axis]) > 1.0e-30f)
+		{
+			inverseDirection[axis] = 1.0f / direction[axis];
+		}
+		else
+		{
+			inverseDirection[axis] = (direction[axis] >= 0.0f) ? LARGE_INVERSE : -LARGE_INVERSE;
+		}
+	}
+
+	struct STACK_ENTRY
+	{
+		int node;
+		float entry;
+	};
+	STACK_ENTRY stack[MAX_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize].node = 0;
+	stack[stackSize].entry = 0.0f;
+	stackSize++;
+
+	while (stackSize > 0)
+	{
+		STACK_ENTRY current = stack[--stackSize];
+		if (current.entry > distance)
+		{
+			continue;
+		}
+
+		const NODE& node = m_nodes[current.node];
+		float entry[4];
+		int hitMask = RayLaneMask(node.minX, origin, inverseDirection, distance, entry) & node.laneMask;
+
+		// order the hit lanes from near to far
+		int order[4];
+		int hitCount = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if ((hitMask & (1 << lane)) == 0)
+			{
+				continue;
+			}
+			int position = hitCount++;
+			while ((position > 0) && (entry[order[position - 1]] > entry[lane]))
+			{
+				order[position] = order[position - 1];
+				position--;
+			}
+			order[position] = lane;
+		}
+
+		for (int i = 0; i < hitCount; i++)
+		{
+			const int lane = order[i];
+			if ((node.count[lane] == 0) || (entry[lane] > distance))
+			{
+				continue;
+			}
+
+			for (int j = node.child[lane]; j < node.child[lane] + node.count[lane]; j++)
+			{
+				int object = m_objects[j];
+				float objectEntry = 0.0f;
+				if (IntersectRayBox(origin, inverseDirection, m_objectMin[object], m_objectMax[object], distance, objectEntry) == false)
+				{
+					continue;
+				}
+
+				if (!hitTest)
+				{
+					distance = objectEntry;
+					hitObject = object;
+				}
+				else
+				{
+					float objectDistance = distance;
+					if ((hitTest(object, objectDistance) == true) && (objectDistance < distance))
+					{
+						distance = objectDistance;
+						hitObject = object;
+					}
+				}
+			}
+		}
+
+		// push the far children first so the nearest is visited next
+		for (int i = hitCount - 1; i >= 0; i--)
+		{
+			const int lane = order[i];
+			if ((node.count[lane] == 0) && (entry[lane] <= distance))
+			{
+				stack[stackSize].node = node.child[lane];
+				stack[stackSize].entry = entry[lane];
+				stackSize++;
+			}
+		}
+	}
+
+	return(hitObject);
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of indexed
+ *  objects.
+ ***********************************************************/
+int BoundingVolumeHierarchy::GetObjectCount() const
+{
+	return((int)m_objectNode.size());
+}
+
+/***********************************************************
+ *  GetObjectBounds()
+ *
+ *  This method is used for getting the indexed box of an
+ *  object.
+ ***********************************************************/
+void BoundingVolumeHierarchy::GetObjectBounds(int object, glm::vec3& boundsMin, glm::vec3& boundsMax) const
+{
+	boundsMin = m_objectMin[object];
+	boundsMax = m_objectMax[object];
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the build, the refit and
+ *  the queries over randomly placed boxes.  The boxes are
+ *  spread over a volume growing with their number, so the
+ *  density of the scene stays the same.
+ ***********************************************************/
+void BoundingVolumeHierarchy::RunBenchmark()
+{
+	const int counts[] = { 1000, 100000, 1000000 };
+	const int repetitions = 3;
+	const int queryCount = 1000;
+
+	std::cout << "INFO: Bounding volume hierarchy benchmark ("
+		<< ThreadPool::GetShared()->GetThreadCount() << " threads"
+#ifdef BVH_USE_SSE
+		<< ", SSE"
+#endif
+		<< ")" << std::endl;
+	std::cout << "    objects   build ms   refit ms   refit 1% ms   frustum ms   1k rays ms   1k spheres ms   visible" << std::endl;
+
+	for (int count : counts)
+	{
+		std::mt19937 random(1234);
+		const float halfSize = std::cbrt((float)count) * 2.0f;
+		std::uniform_real_distribution<float> position(-halfSize, halfSize);
+		std::uniform_real_distribution<float> size(0.25f, 0.75f);
+		std::uniform_real_distribution<float> jitter(-0.25f, 0.25f);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		std::vector<glm::vec3> boundsMin(count);
+		std::vector<glm::vec3> boundsMax(count);
+		std::vector<glm::vec3> movedMin(count);
+		std::vector<glm::vec3> movedMax(count);
+		for (int i = 0; i < count; i++)
+		{
+			glm::vec3 center(position(random), position(random), position(random));
+			glm::vec3 extent(size(random), size(random), size(random));
+			glm::vec3 offset(jitter(random), jitter(random), jitter(random));
+			boundsMin[i] = center - extent;
+			boundsMax[i] = center + extent;
+			movedMin[i] = boundsMin[i] + offset;
+			movedMax[i] = boundsMax[i] + offset;
+		}
+
+		BoundingVolumeHierarchy hierarchy;
+		double buildTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			hierarchy.Build(boundsMin, boundsMax);
+		}, repetitions);
+
+		// every refit moves the objects back and forth
+		bool bMoved = false;
+		double refitTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			bMoved = !bMoved;
+			const std::vector<glm::vec3>& newMin = bMoved ? movedMin : boundsMin;
+			const std::vector<glm::vec3>& newMax = bMoved ? movedMax : boundsMax;
+			for (int i = 0; i < count; i++)
+			{
+				hierarchy.UpdateObject(i, newMin[i], newMax[i]);
+			}
+			hierarchy.Refit();
+		}, repetitions);
+
+		double partialRefitTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			bMoved = !bMoved;
+			const std::vector<glm::vec3>& newMin = bMoved ? movedMin : boundsMin;
+			const std::vector<glm::vec3>& newMax = bMoved ? movedMax : boundsMax;
+			for (int i = 0; i < count; i += 100)
+			{
+				hierarchy.UpdateObject(i, newMin[i], newMax[i]);
+			}
+			hierarchy.Refit();
+		}, repetitions);
+
+		// a camera outside the volume looking at its center
+		Frustum frustum;
+		frustum.ExtractPlanes(
+			glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, halfSize * 4.0f) *
+			glm::lookAt(glm::vec3(0.0f, 0.0f, halfSize * 1.5f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+		std::vector<int> results;
+		double frustumTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			hierarchy.QueryFrustum(frustum, results);
+		}, repetitions);
+		size_t visibleCount = results.size();
+
+		std::vector<glm::vec3> queryPoints(queryCount);
+		std::vector<glm::vec3> queryDirections(queryCount);
+		for (int i = 0; i < queryCount; i++)
+		{
+			queryPoints[i] = glm::vec3(position(random), position(random), position(random));
+			queryDirections[i] = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)));
+		}
+
+		double rayTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			for (int i = 0; i < queryCount; i++)
+			{
+				float distance = halfSize * 4.0f;
+				hierarchy.Raycast(queryPoints[i], queryDirections[i], distance);
+			}
+		}, repetitions);
+
+		double sphereTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			for (int i = 0; i < queryCount; i++)
+			{
+				hierarchy.QuerySphere(queryPoints[i], 2.0f, results);
+			}
+		}, repetitions);
+
+		char line[160];
+		snprintf(line, sizeof(line), "  %9d  %9.3f  %9.3f  %12.3f  %11.3f  %11.3f  %14.3f  %8d",
+			count,
+			buildTime,
+			refitTime,
+			partialRefitTime,
+			frustumTime,
+			rayTime,
+			sphereTime,
+			(int)visibleCount);
+		std::cout << line << std::endl;
+	}
+}
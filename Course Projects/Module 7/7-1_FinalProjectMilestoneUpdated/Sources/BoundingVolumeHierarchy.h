@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// 4-wide bounding volume hierarchy for spatial queries over scene objects
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class indexes the axis aligned bounding boxes of a
+ *  set of objects for frustum, ray and sphere queries.
+ *
+ *  The tree is built top-down with the binned surface area
+ *  heuristic, then collapsed so that every node holds the
+ *  boxes of up to four children side by side.  One SSE
+ *  instruction then tests all four children at once.
+ *
+ *  Objects that move only need their new box passed to
+ *  UpdateObject() - Refit() later grows or shrinks the boxes
+ *  of the changed nodes and their ancestors, without
+ *  rebuilding the tree.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// narrow phase test of the ray against one object - returns
+	// true and shortens the distance when the object is hit
+	// closer than the passed in distance
+	typedef std::function<bool(int object, float& distance)> RAY_HIT_TEST;
+
+	// constructor
+	BoundingVolumeHierarchy();
+
+	// build the tree over the bounding boxes of the objects,
+	// the object indices are the positions in the vectors
+	void Build(
+		const std::vector<glm::vec3>& boundsMin,
+		const std::vector<glm::vec3>& boundsMax);
+	// free the tree
+	void Clear();
+
+	// change the bounding box of an object, the tree is
+	// updated by the next call to Refit()
+	void UpdateObject(int object, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	// fit the boxes of the nodes to the updated objects
+	void Refit();
+
+	// collect the objects whose boxes may be inside the frustum
+	void QueryFrustum(const Frustum& frustum, std::vector<int>& results) const;
+	// collect the objects whose boxes touch the sphere
+	void QuerySphere(const glm::vec3& center, float radius, std::vector<int>& results) const;
+	// find the closest object hit by the ray within the distance,
+	// using the bounding boxes when no hit test is passed in -
+	// returns -1 when nothing is hit
+	int Raycast(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance,
+		const RAY_HIT_TEST& hitTest = RAY_HIT_TEST()) const;
+
+	// number of indexed objects
+	int GetObjectCount() const;
+	// get the indexed bounding box of an object
+	void GetObjectBounds(int object, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+
+	// time the build, refit and queries for increasing object counts
+	static void RunBenchmark();
+
+private:
+	// four children side by side, one SIMD lane per child
+	struct alignas(16) NODE
+	{
+		float minX[4];
+		float minY[4];
+		float minZ[4];
+		float maxX[4];
+		float maxY[4];
+		float maxZ[4];
+		// child node index, or first entry in the object list
+		// for leaf lanes
+		int32_t child[4];
+		// number of objects of a leaf lane, 0 for a child node
+		int32_t count[4];
+		int32_t parent;
+		int32_t parentLane;
+		// one bit per lane holding a child
+		int32_t laneMask;
+		int32_t padding;
+	};
+
+	// the nodes, parents always stored before their children
+	std::vector<NODE> m_nodes;
+	// object indices grouped by leaf
+	std::vector<int> m_objects;
+	// bounding boxes of the objects
+	std::vector<glm::vec3> m_objectMin;
+	std::vector<glm::vec3> m_objectMax;
+	// node holding the leaf lane of each object
+	std::vector<int> m_objectNode;
+	// nodes changed since the last refit, kept as a max-heap so
+	// that children are refit before their parents
+	std::vector<int> m_dirtyNodes;
+	std::vector<uint8_t> m_nodeDirty;
+
+	// mark a node for the next refit
+	void MarkDirty(int node);
+	// recompute the leaf lanes of a node and pass its new box
+	// to the parent lane
+	void RefitNode(int node);
+	// append every object below the lane of a node
+	void AppendLane(const NODE& node, int lane, std::vector<int>& results) const;
+};
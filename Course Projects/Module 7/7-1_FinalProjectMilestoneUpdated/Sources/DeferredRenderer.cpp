@@ -0,0 +1,385 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.cpp
+// ============
+// geometry buffer and per pixel lighting passes of the deferred render path
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DeferredRenderer.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// texture units the geometry buffer is read from
+	const int ALBEDO_UNIT = 0;
+	const int NORMAL_UNIT = 1;
+	const int SPECULAR_UNIT = 2;
+	const int DEPTH_UNIT = 3;
+
+	// values of the lightPass uniform
+	const int SCENE_LIGHT_PASS = 0;
+	const int POINT_LIGHT_PASS = 1;
+
+	/***********************************************************
+	 *  GetScissorRect()
+	 *
+	 *  Get the pixel rectangle covered by a light sphere, from
+	 *  the projected corners of its view space box.  Returns
+	 *  false when the sphere is outside the viewport.
+	 ***********************************************************/
+	bool GetScissorRect(
+		const glm::vec3& viewCenter,
+		float radius,
+		const glm::mat4& projection,
+		int width,
+		int height,
+		glm::ivec4& rect)
+	{
+		// the sphere is behind the camera
+		if (viewCenter.z - radius >= 0.0f)
+		{
+			return(false);
+		}
+
+		glm::vec2 screenMin = glm::vec2(1.0f);
+		glm::vec2 screenMax = glm::vec2(-1.0f);
+		bool bBehind = false;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 offset = glm::vec3(
+				(corner & 1) ? radius : -radius,
+				(corner & 2) ? radius : -radius,
+				(corner & 4) ? radius : -radius);
+			glm::vec4 clip = projection * glm::vec4(viewCenter + offset, 1.0f);
+			if (clip.w <= 1.0e-4f)
+			{
+				bBehind = true;
+				break;
+			}
+			glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+			screenMin = glm::min(screenMin, ndc);
+			screenMax = glm::max(screenMax, ndc);
+		}
+
+		// a box reaching behind the camera can cover any part of
+		// the screen
+		if (bBehind == true)
+		{
+			screenMin = glm::vec2(-1.0f);
+			screenMax = glm::vec2(1.0f);
+		}
+		screenMin = glm::max(screenMin, glm::vec2(-1.0f));
+		screenMax = glm::min(screenMax, glm::vec2(1.0f));
+		if ((screenMin.x >= screenMax.x) || (screenMin.y >= screenMax.y))
+		{
+			return(false);
+		}
+
+		int left = (int)std::floor((screenMin.x + 1.0f) * 0.5f * (float)width);
+		int bottom = (int)std::floor((screenMin.y + 1.0f) * 0.5f * (float)height);
+		int right = (int)std::ceil((screenMax.x + 1.0f) * 0.5f * (float)width);
+		int top = (int)std::ceil((screenMax.y + 1.0f) * 0.5f * (float)height);
+		rect = glm::ivec4(left, bottom, right - left, top - bottom);
+		return((rect.z > 0) && (rect.w > 0));
+	}
+}
+
+/***********************************************************
+ *  DeferredRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DeferredRenderer::DeferredRenderer(ShaderManager* pGeometryShader, ShaderManager* pLightingShader)
+{
+	m_pGeometryShader = pGeometryShader;
+	m_pLightingShader = pLightingShader;
+	m_framebuffer = 0;
+	m_targets[0] = 0;
+	m_targets[1] = 0;
+	m_targets[2] = 0;
+	m_depthTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_bComplete = false;
+	m_screenVAO = 0;
+	m_lightPasses = 0;
+	m_lightPassPixels = 0;
+}
+
+/***********************************************************
+ *  ~DeferredRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DeferredRenderer::~DeferredRenderer()
+{
+	DestroyTargets();
+	if (m_screenVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_screenVAO);
+	}
+}
+
+/***********************************************************
+ *  GetGeometryShader()
+ *
+ *  This method is used for getting the shader that writes
+ *  the geometry buffer.
+ ***********************************************************/
+ShaderManager* DeferredRenderer::GetGeometryShader() const
+{
+	return(m_pGeometryShader);
+}
+
+/***********************************************************
+ *  GetLightingShader()
+ *
+ *  This method is used for getting the shader that lights
+ *  the geometry buffer.
+ ***********************************************************/
+ShaderManager* DeferredRenderer::GetLightingShader() const
+{
+	return(m_pLightingShader);
+}
+
+/***********************************************************
+ *  BeginGeometryPass()
+ *
+ *  This method is used for binding the geometry buffer and
+ *  clearing it, with the albedo alpha marking the pixels
+ *  that no object covers.
+ ***********************************************************/
+bool DeferredRenderer::BeginGeometryPass(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+	if ((width != m_width) || (height != m_height))
+	{
+		CreateTargets(width, height);
+	}
+	if (m_bComplete == false)
+	{
+		return(false);
+	}
+
+	const GLenum drawBuffers[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glDrawBuffers(3, drawBuffers);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glDisable(GL_BLEND);
+	m_pGeometryShader->use();
+
+	return(true);
+}
+
+/***********************************************************
+ *  RenderLighting()
+ *
+ *  This method is used for lighting the geometry buffer into
+ *  the window.  The scene lights are added by a full screen
+ *  pass, then each point light with a range by a pass
+ *  scissored to its sphere.  The pixels no object covers
+ *  keep the window clear color.
+ ***********************************************************/
+void DeferredRenderer::RenderLighting(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& cameraPosition,
+	const std::vector<LightClusters::POINT_LIGHT>& lights,
+	bool bUseLighting)
+{
+	m_lightPasses = 0;
+	m_lightPassPixels = 0;
+
+	if (m_screenVAO == 0)
+	{
+		glGenVertexArrays(1, &m_screenVAO);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+
+	for (int i = 0; i < 3; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + ALBEDO_UNIT + i);
+		glBindTexture(GL_TEXTURE_2D, m_targets[i]);
+	}
+	glActiveTexture(GL_TEXTURE0 + DEPTH_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	m_pLightingShader->use();
+	m_pLightingShader->setSampler2DValue("albedoBuffer", ALBEDO_UNIT);
+	m_pLightingShader->setSampler2DValue("normalBuffer", NORMAL_UNIT);
+	m_pLightingShader->setSampler2DValue("specularBuffer", SPECULAR_UNIT);
+	m_pLightingShader->setSampler2DValue("depthBuffer", DEPTH_UNIT);
+	m_pLightingShader->setMat4Value("inverseViewProjection", glm::inverse(projection * view));
+	m_pLightingShader->setVec3Value("viewPosition", cameraPosition);
+	m_pLightingShader->setIntValue("bUseLighting", bUseLighting);
+
+	glBindVertexArray(m_screenVAO);
+
+	// the scene lights, or the albedo alone when unlit, replace
+	// the covered pixels
+	glDisable(GL_BLEND);
+	m_pLightingShader->setIntValue("lightPass", SCENE_LIGHT_PASS);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	// each point light adds to the pixels of its rectangle
+	if ((bUseLighting == true) && (lights.empty() == false))
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+		glEnable(GL_SCISSOR_TEST);
+		m_pLightingShader->setIntValue("lightPass", POINT_LIGHT_PASS);
+
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			const LightClusters::POINT_LIGHT& light = lights[i];
+			glm::vec3 viewCenter = glm::vec3(view * glm::vec4(light.position, 1.0f));
+			glm::ivec4 rect;
+			if (GetScissorRect(viewCenter, light.range, projection, m_width, m_height, rect) == false)
+			{
+				continue;
+			}
+
+			glScissor(rect.x, rect.y, rect.z, rect.w);
+			m_pLightingShader->setVec3Value("pointLightPosition", light.position);
+			m_pLightingShader->setFloatValue("pointLightRange", light.range);
+			m_pLightingShader->setVec3Value("pointLightColor", light.color);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+
+			m_lightPasses++;
+			m_lightPassPixels += (long long)rect.z * (long long)rect.w;
+		}
+
+		glDisable(GL_SCISSOR_TEST);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+	glBindVertexArray(0);
+
+	// the transparent objects are tested against the depth of
+	// the lit opaque objects
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(
+		0, 0, m_width, m_height,
+		0, 0, m_width, m_height,
+		GL_DEPTH_BUFFER_BIT,
+		GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+}
+
+/***********************************************************
+ *  GetLightPassCount()
+ *
+ *  This method is used for getting the number of point
+ *  light passes drawn in the last frame.
+ ***********************************************************/
+int DeferredRenderer::GetLightPassCount() const
+{
+	return(m_lightPasses);
+}
+
+/***********************************************************
+ *  GetLightPassPixels()
+ *
+ *  This method is used for getting the sum of the scissor
+ *  rectangle pixels of the point light passes in the last
+ *  frame.
+ ***********************************************************/
+long long DeferredRenderer::GetLightPassPixels() const
+{
+	return(m_lightPassPixels);
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the geometry buffer
+ *  textures for a viewport size.  The normal and shininess
+ *  target keeps half floats, the albedo and specular color
+ *  fit in bytes.  The depth has a stencil part so that it
+ *  matches the window depth buffer it is copied to.
+ ***********************************************************/
+void DeferredRenderer::CreateTargets(int width, int height)
+{
+	DestroyTargets();
+
+	m_width = width;
+	m_height = height;
+
+	const GLint internalFormats[3] = { GL_RGBA8, GL_RGBA16F, GL_RGBA8 };
+	const GLenum types[3] = { GL_UNSIGNED_BYTE, GL_HALF_FLOAT, GL_UNSIGNED_BYTE };
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	glGenTextures(3, m_targets);
+	for (int i = 0; i < 3; i++)
+	{
+		glBindTexture(GL_TEXTURE_2D, m_targets[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, GL_RGBA, types[i], NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_targets[i], 0);
+	}
+
+	glGenTextures(1, &m_depthTexture);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+
+	m_bComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	if (m_bComplete == false)
+	{
+		std::cout << "ERROR: the deferred geometry buffer is incomplete" << std::endl;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for freeing the geometry buffer.
+ ***********************************************************/
+void DeferredRenderer::DestroyTargets()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteTextures(3, m_targets);
+		glDeleteTextures(1, &m_depthTexture);
+		m_framebuffer = 0;
+		m_targets[0] = 0;
+		m_targets[1] = 0;
+		m_targets[2] = 0;
+		m_depthTexture = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+	m_bComplete = false;
+}
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.h
+// ============
+// geometry buffer and per pixel lighting passes of the deferred render path
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "LightClusters.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  DeferredRenderer
+ *
+ *  This class holds the geometry buffer of the deferred
+ *  render path.  The opaque objects write their albedo,
+ *  normal, specular color and shininess, and depth into it
+ *  instead of being shaded, then the lights are evaluated
+ *  once for every covered pixel.
+ *
+ *  The directional, spot and fixed point lights of the scene
+ *  shader are evaluated by one full screen pass.  Each point
+ *  light with a range is added by its own pass, scissored to
+ *  the screen rectangle of its sphere, so a light only costs
+ *  the pixels it can reach.
+ *
+ *  After the lighting, the depth of the geometry buffer is
+ *  copied to the window, so that the transparent objects can
+ *  still be drawn forward over the lit scene.
+ ***********************************************************/
+class DeferredRenderer
+{
+public:
+	// constructor - the geometry shader writes the geometry
+	// buffer, the lighting shader reads it
+	DeferredRenderer(ShaderManager* pGeometryShader, ShaderManager* pLightingShader);
+	// destructor
+	~DeferredRenderer();
+
+	// get the shader the geometry pass draws the objects with
+	ShaderManager* GetGeometryShader() const;
+	// get the shader of the lighting passes, which takes the
+	// same directional, point and spot light uniforms as the
+	// forward scene shader
+	ShaderManager* GetLightingShader() const;
+
+	// bind and clear the geometry buffer, creating it for the
+	// viewport size when needed - returns false when the
+	// buffer cannot be used
+	bool BeginGeometryPass(int width, int height);
+	// light the pixels of the geometry buffer into the window
+	// and copy its depth there - the geometry buffer is bound
+	// to the first four texture units
+	void RenderLighting(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& cameraPosition,
+		const std::vector<LightClusters::POINT_LIGHT>& lights,
+		bool bUseLighting);
+
+	// get the point light passes drawn in the last frame, and
+	// the pixels of their scissor rectangles
+	int GetLightPassCount() const;
+	long long GetLightPassPixels() const;
+
+private:
+	ShaderManager* m_pGeometryShader;
+	ShaderManager* m_pLightingShader;
+
+	// framebuffer with the albedo, normal and shininess, and
+	// specular color targets, and the depth
+	GLuint m_framebuffer;
+	GLuint m_targets[3];
+	GLuint m_depthTexture;
+	int m_width;
+	int m_height;
+	bool m_bComplete;
+	// vertex array of the full screen triangle, which has no
+	// vertex data of its own
+	GLuint m_screenVAO;
+
+	int m_lightPasses;
+	long long m_lightPassPixels;
+
+	// create the geometry buffer for a viewport size
+	void CreateTargets(int width, int height);
+	// free the geometry buffer
+	void DestroyTargets();
+};
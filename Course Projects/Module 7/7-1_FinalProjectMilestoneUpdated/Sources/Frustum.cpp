@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.cpp
+// ============
+// view frustum planes and bounding volume visibility tests
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Frustum.h"
+
+#include <cmath>
+
+/***********************************************************
+ *  Frustum()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Frustum::Frustum()
+{
+	// until planes are extracted every point is visible
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+/***********************************************************
+ *  ExtractPlanes()
+ *
+ *  This method is used for extracting the six frustum planes
+ *  from the rows of the combined view-projection matrix.
+ *  A point p is inside a plane when dot(plane.xyz, p) + plane.w
+ *  is not negative.
+ ***********************************************************/
+void Frustum::ExtractPlanes(const glm::mat4& viewProjection)
+{
+	glm::vec4 rows[4];
+
+	// glm matrices are column major, so gather the rows first
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = glm::vec4(
+			viewProjection[0][i],
+			viewProjection[1][i],
+			viewProjection[2][i],
+			viewProjection[3][i]);
+	}
+
+	m_planes[0] = rows[3] + rows[0];	// left
+	m_planes[1] = rows[3] - rows[0];	// right
+	m_planes[2] = rows[3] + rows[1];	// bottom
+	m_planes[3] = rows[3] - rows[1];	// top
+	m_planes[4] = rows[3] + rows[2];	// near
+	m_planes[5] = rows[3] - rows[2];	// far
+
+	// normalize so the plane equation returns real distances
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		float length = glm::length(glm::vec3(m_planes[i].x, m_planes[i].y, m_planes[i].z));
+		if (length > 0.0f)
+		{
+			m_planes[i] = m_planes[i] / length;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsSphereVisible()
+ *
+ *  This method is used for testing a bounding sphere against
+ *  the frustum.  The sphere is rejected only when it lies
+ *  completely outside one of the planes.
+ ***********************************************************/
+bool Frustum::IsSphereVisible(const glm::vec3& center, float radius) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		const glm::vec4& plane = m_planes[i];
+		float distance = (plane.x * center.x) + (plane.y * center.y) + (plane.z * center.z) + plane.w;
+		if (distance < -radius)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsBoxVisible()
+ *
+ *  This method is used for testing an axis aligned bounding
+ *  box against the frustum.  For each plane only the box
+ *  corner furthest along the plane normal is tested.
+ ***********************************************************/
+bool Frustum::IsBoxVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		const glm::vec4& plane = m_planes[i];
+		float x = (plane.x >= 0.0f) ? boxMax.x : boxMin.x;
+		float y = (plane.y >= 0.0f) ? boxMax.y : boxMin.y;
+		float z = (plane.z >= 0.0f) ? boxMax.z : boxMin.z;
+		if ((plane.x * x) + (plane.y * y) + (plane.z * z) + plane.w < 0.0f)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetPlane()
+ *
+ *  This method is used for getting one of the normalized
+ *  frustum planes.
+ ***********************************************************/
+const glm::vec4& Frustum::GetPlane(int index) const
+{
+	return(m_planes[index]);
+}
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.h
+// ============
+// view frustum planes and bounding volume visibility tests
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  Frustum
+ *
+ *  This class holds the six clipping planes of the camera
+ *  in world space.  The planes are extracted directly from
+ *  the combined view-projection matrix, so the same code
+ *  works for both perspective and orthographic projection.
+ ***********************************************************/
+class Frustum
+{
+public:
+	// constructor
+	Frustum();
+
+	// extract the world space planes from projection * view
+	void ExtractPlanes(const glm::mat4& viewProjection);
+
+	// true when any part of the sphere may be inside the frustum
+	bool IsSphereVisible(const glm::vec3& center, float radius) const;
+	// true when any part of the axis aligned box may be inside the frustum
+	bool IsBoxVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+	// get one of the normalized planes (xyz = normal, w = distance)
+	const glm::vec4& GetPlane(int index) const;
+
+	// number of planes bounding the frustum
+	static const int PLANE_COUNT = 6;
+
+private:
+	// left, right, bottom, top, near, far
+	glm::vec4 m_planes[PLANE_COUNT];
+};
@@ -0,0 +1,439 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.cpp
+// ============
+// binning of point lights into view space clusters for forward shading
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightClusters.h"
+#include "BenchmarkTimer.h"
+#include "ThreadPool.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+// declaration of global variables
+namespace
+{
+	// closest view depth of the perspective clusters
+	const float MIN_NEAR_DEPTH = 0.01f;
+
+	/***********************************************************
+	 *  ProjectPoint()
+	 *
+	 *  Get the normalized device X and Y of a view space point.
+	 ***********************************************************/
+	glm::vec2 ProjectPoint(const glm::mat4& projection, float x, float y, float depth)
+	{
+		glm::vec4 clip = projection * glm::vec4(x, y, -depth, 1.0f);
+		return(glm::vec2(clip.x, clip.y) / clip.w);
+	}
+}
+
+/***********************************************************
+ *  LightClusters()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightClusters::LightClusters()
+{
+	m_projection = glm::mat4(0.0f);
+	m_bPerspective = true;
+	m_nearDepth = 0.1f;
+	m_farDepth = 100.0f;
+	m_clusterLights.resize(CLUSTER_COUNT);
+	m_clusterTable.assign(CLUSTER_COUNT * 2, 0);
+
+	for (int i = 0; i < 3; i++)
+	{
+		m_buffers[i] = 0;
+		m_textures[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~LightClusters()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightClusters::~LightClusters()
+{
+	if (m_buffers[0] != 0)
+	{
+		glDeleteTextures(3, m_textures);
+		glDeleteBuffers(3, m_buffers);
+	}
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for listing the lights of every
+ *  cluster.  Each light is first narrowed to the depth
+ *  slices and screen tiles around its sphere, then its
+ *  sphere is tested against the box of each of those
+ *  clusters.
+ ***********************************************************/
+void LightClusters::Build(
+	const std::vector<POINT_LIGHT>& lights,
+	const glm::mat4& view,
+	const glm::mat4& projection)
+{
+	if (memcmp(&projection, &m_projection, sizeof(glm::mat4)) != 0)
+	{
+		SetProjection(projection);
+	}
+
+	const int lightCount = (int)lights.size();
+	m_viewLights.resize(lightCount);
+	m_lightTiles.resize(lightCount);
+	m_lightSlices.resize(lightCount);
+	m_lightData.resize((size_t)std::max(lightCount, 1) * 2, glm::vec4(0.0f));
+
+	for (int i = 0; i < lightCount; i++)
+	{
+		const POINT_LIGHT& light = lights[i];
+		glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		float depth = -center.z;
+
+		m_viewLights[i] = glm::vec4(center, light.range);
+		m_lightData[(i * 2) + 0] = glm::vec4(light.position, light.range);
+		m_lightData[(i * 2) + 1] = glm::vec4(light.color, 0.0f);
+
+		// no slices for the lights outside the depth range
+		m_lightSlices[i] = glm::ivec2(1, 0);
+		float nearDepth = std::max(depth - light.range, m_nearDepth);
+		float farDepth = std::min(depth + light.range, m_farDepth);
+		if (nearDepth > farDepth)
+		{
+			continue;
+		}
+
+		// the box around the sphere, cut to the depth range,
+		// projects onto every pixel the sphere can cover
+		glm::vec2 screenMin(1.0e30f);
+		glm::vec2 screenMax(-1.0e30f);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec2 point = ProjectPoint(
+				projection,
+				center.x + (((corner & 1) != 0) ? light.range : -light.range),
+				center.y + (((corner & 2) != 0) ? light.range : -light.range),
+				((corner & 4) != 0) ? farDepth : nearDepth);
+			screenMin = glm::min(screenMin, point);
+			screenMax = glm::max(screenMax, point);
+		}
+
+		glm::ivec4 tiles(
+			std::max(0, (int)std::floor((screenMin.x + 1.0f) * 0.5f * TILES_X)),
+			std::max(0, (int)std::floor((screenMin.y + 1.0f) * 0.5f * TILES_Y)),
+			std::min(TILES_X - 1, (int)std::floor((screenMax.x + 1.0f) * 0.5f * TILES_X)),
+			std::min(TILES_Y - 1, (int)std::floor((screenMax.y + 1.0f) * 0.5f * TILES_Y)));
+		if ((tiles.x > tiles.z) || (tiles.y > tiles.w))
+		{
+			continue;
+		}
+
+		m_lightTiles[i] = tiles;
+		m_lightSlices[i] = glm::ivec2(GetDepthSlice(nearDepth), GetDepthSlice(farDepth));
+	}
+
+	// each task lists the lights of whole depth slices, so no
+	// two tasks write the same cluster
+	ThreadPool::GetShared()->ParallelFor(SLICES, [&](int begin, int end)
+	{
+		for (int slice = begin; slice < end; slice++)
+		{
+			const int firstCluster = slice * TILES_X * TILES_Y;
+			for (int cluster = firstCluster; cluster < firstCluster + (TILES_X * TILES_Y); cluster++)
+			{
+				m_clusterLights[cluster].clear();
+			}
+
+			for (int i = 0; i < lightCount; i++)
+			{
+				if ((slice < m_lightSlices[i].x) || (slice > m_lightSlices[i].y))
+				{
+					continue;
+				}
+
+				const glm::vec3 center = glm::vec3(m_viewLights[i]);
+				const float rangeSquared = m_viewLights[i].w * m_viewLights[i].w;
+				const glm::ivec4& tiles = m_lightTiles[i];
+				for (int tileY = tiles.y; tileY <= tiles.w; tileY++)
+				{
+					for (int tileX = tiles.x; tileX <= tiles.z; tileX++)
+					{
+						const int cluster = firstCluster + (tileY * TILES_X) + tileX;
+						glm::vec3 closest = glm::clamp(center, m_clusterMin[cluster], m_clusterMax[cluster]);
+						glm::vec3 offset = closest - center;
+						if (glm::dot(offset, offset) <= rangeSquared)
+						{
+							m_clusterLights[cluster].push_back((uint32_t)i);
+						}
+					}
+				}
+			}
+		}
+	});
+
+	// pack the lists one after the other
+	m_lightIndices.clear();
+	for (int cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		m_clusterTable[(cluster * 2) + 0] = (uint32_t)m_lightIndices.size();
+		m_clusterTable[(cluster * 2) + 1] = (uint32_t)m_clusterLights[cluster].size();
+		m_lightIndices.insert(m_lightIndices.end(), m_clusterLights[cluster].begin(), m_clusterLights[cluster].end());
+	}
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for copying the light data and the
+ *  cluster lists into their texture buffers.
+ ***********************************************************/
+void LightClusters::Upload()
+{
+	if (m_buffers[0] == 0)
+	{
+		glGenBuffers(3, m_buffers);
+		glGenTextures(3, m_textures);
+	}
+
+	// an empty buffer cannot back a texture
+	if (m_lightIndices.empty() == true)
+	{
+		m_lightIndices.push_back(0);
+	}
+
+	const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+	const void* data[3] = { m_lightData.data(), m_clusterTable.data(), m_lightIndices.data() };
+	const size_t sizes[3] =
+	{
+		m_lightData.size() * sizeof(glm::vec4),
+		m_clusterTable.size() * sizeof(uint32_t),
+		m_lightIndices.size() * sizeof(uint32_t)
+	};
+
+	for (int i = 0; i < 3; i++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, sizes[i], data[i], GL_STREAM_DRAW);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the light data, cluster
+ *  table and light index buffers to three texture units.
+ ***********************************************************/
+void LightClusters::Bind(int firstTextureUnit) const
+{
+	for (int i = 0; i < 3; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + firstTextureUnit + i);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+	}
+}
+
+/***********************************************************
+ *  GetDepthSliceParameters()
+ *
+ *  This method is used for getting the values the shader
+ *  uses to find the depth slice of a fragment, matching
+ *  GetDepthSlice().
+ ***********************************************************/
+glm::vec3 LightClusters::GetDepthSliceParameters() const
+{
+	if (m_bPerspective == true)
+	{
+		float scale = (float)SLICES / std::log(m_farDepth / m_nearDepth);
+		return(glm::vec3(scale, -std::log(m_nearDepth) * scale, 1.0f));
+	}
+
+	float scale = (float)SLICES / (m_farDepth - m_nearDepth);
+	return(glm::vec3(scale, -m_nearDepth * scale, 0.0f));
+}
+
+/***********************************************************
+ *  GetLightCount()
+ *
+ *  This method is used for getting the number of lights of
+ *  the last build.
+ ***********************************************************/
+int LightClusters::GetLightCount() const
+{
+	return((int)m_viewLights.size());
+}
+
+/***********************************************************
+ *  GetIndexCount()
+ *
+ *  This method is used for getting the total length of the
+ *  cluster light lists of the last build.
+ ***********************************************************/
+int LightClusters::GetIndexCount() const
+{
+	// the lists end where the list of the last cluster ends
+	const int last = (CLUSTER_COUNT - 1) * 2;
+	return((int)(m_clusterTable[last] + m_clusterTable[last + 1]));
+}
+
+/***********************************************************
+ *  SetProjection()
+ *
+ *  This method is used for finding the depth range of a
+ *  perspective or orthographic projection, and the view
+ *  space box of every cluster within it.
+ ***********************************************************/
+void LightClusters::SetProjection(const glm::mat4& projection)
+{
+	m_projection = projection;
+	m_bPerspective = (projection[3][3] != 1.0f);
+
+	if (m_bPerspective == true)
+	{
+		m_nearDepth = std::max(projection[3][2] / (projection[2][2] - 1.0f), MIN_NEAR_DEPTH);
+		m_farDepth = projection[3][2] / (projection[2][2] + 1.0f);
+	}
+	else
+	{
+		m_nearDepth = (1.0f + projection[3][2]) / projection[2][2];
+		m_farDepth = (projection[3][2] - 1.0f) / projection[2][2];
+	}
+
+	const glm::mat4 inverseProjection = glm::inverse(projection);
+	m_clusterMin.resize(CLUSTER_COUNT);
+	m_clusterMax.resize(CLUSTER_COUNT);
+
+	for (int slice = 0; slice < SLICES; slice++)
+	{
+		const float depths[2] = { GetSliceDepth(slice), GetSliceDepth(slice + 1) };
+
+		for (int tileY = 0; tileY < TILES_Y; tileY++)
+		{
+			for (int tileX = 0; tileX < TILES_X; tileX++)
+			{
+				const int cluster = (((slice * TILES_Y) + tileY) * TILES_X) + tileX;
+				glm::vec3 boxMin(1.0e30f);
+				glm::vec3 boxMax(-1.0e30f);
+
+				// unproject the corners of the tile at the depths
+				// where the slice starts and ends
+				for (int corner = 0; corner < 8; corner++)
+				{
+					float depth = depths[corner >> 2];
+					glm::vec4 clip = projection * glm::vec4(0.0f, 0.0f, -depth, 1.0f);
+					glm::vec4 ndc(
+						-1.0f + (2.0f * (float)(tileX + (corner & 1)) / (float)TILES_X),
+						-1.0f + (2.0f * (float)(tileY + ((corner >> 1) & 1)) / (float)TILES_Y),
+						clip.z / clip.w,
+						1.0f);
+					glm::vec4 point = inverseProjection * ndc;
+					glm::vec3 viewPoint = glm::vec3(point) / point.w;
+
+					boxMin = glm::min(boxMin, viewPoint);
+					boxMax = glm::max(boxMax, viewPoint);
+				}
+
+				m_clusterMin[cluster] = boxMin;
+				m_clusterMax[cluster] = boxMax;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetDepthSlice()
+ *
+ *  This method is used for finding the depth slice holding
+ *  a view depth, clamped to the slices.
+ ***********************************************************/
+int LightClusters::GetDepthSlice(float depth) const
+{
+	glm::vec3 parameters = GetDepthSliceParameters();
+	float slice = (m_bPerspective == true) ?
+		(std::log(std::max(depth, m_nearDepth)) * parameters.x) + parameters.y :
+		(depth * parameters.x) + parameters.y;
+	return(std::min(std::max((int)slice, 0), SLICES - 1));
+}
+
+/***********************************************************
+ *  GetSliceDepth()
+ *
+ *  This method is used for getting the view depth where a
+ *  depth slice starts.
+ ***********************************************************/
+float LightClusters::GetSliceDepth(int slice) const
+{
+	float fraction = (float)slice / (float)SLICES;
+	if (m_bPerspective == true)
+	{
+		return(m_nearDepth * std::pow(m_farDepth / m_nearDepth, fraction));
+	}
+	return(m_nearDepth + ((m_farDepth - m_nearDepth) * fraction));
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the binning of random
+ *  lights spread over a scene the size of the toy scene.
+ ***********************************************************/
+void LightClusters::RunBenchmark()
+{
+	const int lightCounts[] = { 16, 64, 256, 1024, 4096 };
+	const int repetitions = 10;
+
+	std::cout << "INFO: Light clustering benchmark ("
+		<< TILES_X << " x " << TILES_Y << " x " << SLICES << " clusters, "
+		<< ThreadPool::GetShared()->GetThreadCount() << " threads)" << std::endl;
+	std::cout << "     lights   indices   lights/cluster   build ms" << std::endl;
+
+	const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 3.0f, 14.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	for (int lightCount : lightCounts)
+	{
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> positionX(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> positionY(0.0f, 10.0f);
+		std::uniform_real_distribution<float> positionZ(-10.0f, 10.0f);
+		std::uniform_real_distribution<float> range(1.0f, 4.0f);
+
+		std::vector<POINT_LIGHT> lights(lightCount);
+		for (POINT_LIGHT& light : lights)
+		{
+			light.position = glm::vec3(positionX(random), positionY(random), positionZ(random));
+			light.range = range(random);
+			light.color = glm::vec3(1.0f);
+		}
+
+		LightClusters clusters;
+		double buildTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			clusters.Build(lights, view, projection);
+		}, repetitions);
+
+		char line[128];
+		snprintf(line, sizeof(line), "  %9d  %8d  %15.2f  %9.3f",
+			lightCount,
+			clusters.GetIndexCount(),
+			(double)clusters.GetIndexCount() / (double)CLUSTER_COUNT,
+			buildTime);
+		std::cout << line << std::endl;
+	}
+}
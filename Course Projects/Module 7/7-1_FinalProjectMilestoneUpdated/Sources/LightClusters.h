@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.h
+// ============
+// binning of point lights into view space clusters for forward shading
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  LightClusters
+ *
+ *  This class splits the view frustum into screen tiles and
+ *  depth slices, and lists for every cluster the point
+ *  lights whose range reaches into it.  The fragment shader
+ *  finds its cluster from its pixel and depth, and only
+ *  evaluates the lights of that list.
+ *
+ *  The depth slices grow exponentially with the distance in
+ *  perspective views, so near clusters stay small.  The
+ *  lights are binned on the CPU, one depth slice per task of
+ *  the shared thread pool, and passed to the shader in three
+ *  texture buffers - the light data, the offset and count of
+ *  each cluster, and the light indices of all clusters.
+ ***********************************************************/
+class LightClusters
+{
+public:
+	// number of screen tiles and depth slices
+	static const int TILES_X = 16;
+	static const int TILES_Y = 9;
+	static const int SLICES = 24;
+	static const int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+
+	// a point light that reaches no further than its range
+	struct POINT_LIGHT
+	{
+		glm::vec3 position;
+		float range;
+		glm::vec3 color;
+	};
+
+	// constructor
+	LightClusters();
+	// destructor
+	~LightClusters();
+
+	// bin the lights into the clusters of the camera view
+	void Build(
+		const std::vector<POINT_LIGHT>& lights,
+		const glm::mat4& view,
+		const glm::mat4& projection);
+	// copy the lights and the cluster lists into the texture
+	// buffers, creating them on first use
+	void Upload();
+	// bind the three texture buffers to the texture units
+	// starting with the passed in one
+	void Bind(int firstTextureUnit) const;
+
+	// scale and bias turning the view depth, or its logarithm
+	// when the third value is one, into the depth slice
+	glm::vec3 GetDepthSliceParameters() const;
+
+	// number of binned lights and of light indices in all of
+	// the cluster lists
+	int GetLightCount() const;
+	int GetIndexCount() const;
+
+	// time the binning for increasing light counts
+	static void RunBenchmark();
+
+private:
+	// view space box of every cluster
+	std::vector<glm::vec3> m_clusterMin;
+	std::vector<glm::vec3> m_clusterMax;
+	// the projection the cluster boxes were computed for
+	glm::mat4 m_projection;
+	bool m_bPerspective;
+	float m_nearDepth;
+	float m_farDepth;
+
+	// lights of each cluster while binning
+	std::vector<std::vector<uint32_t>> m_clusterLights;
+	// view space sphere and slice and tile ranges of each light
+	std::vector<glm::vec4> m_viewLights;
+	std::vector<glm::ivec4> m_lightTiles;
+	std::vector<glm::ivec2> m_lightSlices;
+
+	// data uploaded into the texture buffers
+	std::vector<glm::vec4> m_lightData;
+	std::vector<uint32_t> m_clusterTable;
+	std::vector<uint32_t> m_lightIndices;
+
+	// buffer objects and their buffer textures
+	GLuint m_buffers[3];
+	GLuint m_textures[3];
+
+	// compute the cluster boxes of a projection
+	void SetProjection(const glm::mat4& projection);
+	// depth slice holding a view depth
+	int GetDepthSlice(float depth) const;
+	// view depth where a slice starts
+	float GetSliceDepth(int slice) const;
+};
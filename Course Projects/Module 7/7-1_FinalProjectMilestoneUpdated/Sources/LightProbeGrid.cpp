@@ -0,0 +1,474 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightprobegrid.cpp
+// ============
+// grid of spherical harmonic irradiance probes baked by ray casting
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightProbeGrid.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// declaration of global variables
+namespace
+{
+	const float PI = 3.14159265f;
+	// the rays leave the probe this far along their direction
+	const float PROBE_RAY_OFFSET = 1.0e-3f;
+	// floats held by the coefficients of one probe
+	const int PROBE_FLOATS = LightProbeGrid::SH_COEFFICIENTS * 3;
+
+	/***********************************************************
+	 *  EvaluateBasis()
+	 *
+	 *  Get the nine second order spherical harmonics in a unit
+	 *  direction, in the order the scene shader reads them.
+	 ***********************************************************/
+	void EvaluateBasis(const glm::vec3& direction, float basis[LightProbeGrid::SH_COEFFICIENTS])
+	{
+		const float x = direction.x;
+		const float y = direction.y;
+		const float z = direction.z;
+
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * y;
+		basis[2] = 0.488603f * z;
+		basis[3] = 0.488603f * x;
+		basis[4] = 1.092548f * x * y;
+		basis[5] = 1.092548f * y * z;
+		basis[6] = 0.315392f * ((3.0f * z * z) - 1.0f);
+		basis[7] = 1.092548f * x * z;
+		basis[8] = 0.546274f * ((x * x) - (y * y));
+	}
+
+	/***********************************************************
+	 *  GetProbeCount()
+	 *
+	 *  Get the number of probes about the spacing apart along
+	 *  a length, with one on each end.
+	 ***********************************************************/
+	int GetProbeCount(float length, float spacing)
+	{
+		int count = (int)std::ceil(length / spacing) + 1;
+		return(std::min(std::max(count, 2), LightProbeGrid::MAX_PROBES_PER_AXIS));
+	}
+}
+
+/***********************************************************
+ *  LightProbeGrid()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightProbeGrid::LightProbeGrid()
+{
+	m_texture = 0;
+	Clear();
+}
+
+/***********************************************************
+ *  ~LightProbeGrid()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightProbeGrid::~LightProbeGrid()
+{
+	if (m_texture != 0)
+	{
+		glDeleteTextures(1, &m_texture);
+	}
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for baking the probes of the grid.
+ *  Every probe casts the rays in directions spread evenly
+ *  over the sphere, seeded by its index so the bake does not
+ *  depend on the number of threads, and adds the light they
+ *  bring back into the spherical harmonics.  The light is
+ *  then convolved with the cosine lobe, giving the light
+ *  reaching a surface of each normal in the units of the
+ *  lightmap texels.
+ ***********************************************************/
+void LightProbeGrid::Bake(
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax,
+	float spacing,
+	int raysPerProbe,
+	const std::vector<LightmapBaker::BAKE_SURFACE>& surfaces,
+	const std::vector<LightClusters::POINT_LIGHT>& lights,
+	const LightmapBaker::BAKE_SETTINGS& settings,
+	const LightmapBaker::RAY_CAST& castRay,
+	ThreadPool* pThreadPool)
+{
+	Clear();
+
+	if (NULL == pThreadPool)
+	{
+		pThreadPool = ThreadPool::GetShared();
+	}
+
+	// a flat box still gets a layer of probes on both sides
+	spacing = std::max(spacing, 0.01f);
+	m_boundsMin = glm::min(boundsMin, boundsMax);
+	m_boundsMax = glm::max(m_boundsMin + glm::vec3(spacing), glm::max(boundsMin, boundsMax));
+	glm::vec3 extent = m_boundsMax - m_boundsMin;
+	m_counts = glm::ivec3(
+		GetProbeCount(extent.x, spacing),
+		GetProbeCount(extent.y, spacing),
+		GetProbeCount(extent.z, spacing));
+
+	const int probeCount = m_counts.x * m_counts.y * m_counts.z;
+	m_coefficients.assign((size_t)probeCount * PROBE_FLOATS, 0.0f);
+
+	LightmapBaker::BAKE_SCENE scene;
+	LightmapBaker::PrepareScene(scene, surfaces, lights, settings, castRay);
+
+	const int rays = std::max(1, raysPerProbe);
+	// the cosine lobe of each band divided by pi, as the
+	// lightmap texels hold the light without it
+	const float bandScale[3] = { 1.0f, 2.0f / 3.0f, 0.25f };
+	const float sampleWeight = (4.0f * PI) / (float)rays;
+
+	pThreadPool->ParallelFor(probeCount, [&](int begin, int end)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		float basis[SH_COEFFICIENTS];
+
+		for (int probe = begin; probe < end; probe++)
+		{
+			glm::ivec3 cell(
+				probe % m_counts.x,
+				(probe / m_counts.x) % m_counts.y,
+				probe / (m_counts.x * m_counts.y));
+			glm::vec3 position = m_boundsMin + (extent * (glm::vec3(cell) / glm::vec3(m_counts - 1)));
+
+			std::mt19937 random((unsigned int)probe);
+			glm::vec3 light[SH_COEFFICIENTS];
+			for (int i = 0; i < SH_COEFFICIENTS; i++)
+			{
+				light[i] = glm::vec3(0.0f);
+			}
+
+			for (int ray = 0; ray < rays; ray++)
+			{
+				float z = 1.0f - (2.0f * unit(random));
+				float radius = std::sqrt(std::max(0.0f, 1.0f - (z * z)));
+				float angle = 2.0f * PI * unit(random);
+				glm::vec3 direction(radius * std::cos(angle), radius * std::sin(angle), z);
+
+				glm::vec3 radiance = LightmapBaker::TraceRadiance(
+					scene, position + (direction * PROBE_RAY_OFFSET), direction, random);
+				EvaluateBasis(direction, basis);
+				for (int i = 0; i < SH_COEFFICIENTS; i++)
+				{
+					light[i] += radiance * basis[i];
+				}
+			}
+
+			float* coefficients = &m_coefficients[(size_t)probe * PROBE_FLOATS];
+			for (int i = 0; i < SH_COEFFICIENTS; i++)
+			{
+				int band = (i == 0) ? 0 : ((i < 4) ? 1 : 2);
+				glm::vec3 irradiance = light[i] * (sampleWeight * bandScale[band]);
+				coefficients[(i * 3) + 0] = irradiance.r;
+				coefficients[(i * 3) + 1] = irradiance.g;
+				coefficients[(i * 3) + 2] = irradiance.b;
+			}
+		}
+	});
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for freeing the probes.
+ ***********************************************************/
+void LightProbeGrid::Clear()
+{
+	m_counts = glm::ivec3(0);
+	m_boundsMin = glm::vec3(0.0f);
+	m_boundsMax = glm::vec3(0.0f);
+	m_coefficients.clear();
+}
+
+/***********************************************************
+ *  IsEmpty()
+ *
+ *  This method is used for checking whether any probes are
+ *  baked or loaded.
+ ***********************************************************/
+bool LightProbeGrid::IsEmpty() const
+{
+	return(m_coefficients.empty());
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the grid box and the
+ *  coefficients of the probes into a file.
+ ***********************************************************/
+bool LightProbeGrid::Save(const char* filename) const
+{
+	PROBE_FILE_HEADER header;
+	FILE* file = fopen(filename, "wb");
+
+	if (file == nullptr)
+	{
+		std::cout << "Could not create file:" << filename << std::endl;
+		return(false);
+	}
+
+	header.magic = PROBE_FILE_MAGIC;
+	header.version = PROBE_FILE_VERSION;
+	header.countX = (uint32_t)m_counts.x;
+	header.countY = (uint32_t)m_counts.y;
+	header.countZ = (uint32_t)m_counts.z;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		header.boundsMin[axis] = m_boundsMin[axis];
+		header.boundsMax[axis] = m_boundsMax[axis];
+	}
+
+	bool bSuccess =
+		(fwrite(&header, sizeof(header), 1, file) == 1) &&
+		(fwrite(m_coefficients.data(), sizeof(float), m_coefficients.size(), file) == m_coefficients.size());
+	bSuccess = (fclose(file) == 0) && bSuccess;
+
+	if (bSuccess == false)
+	{
+		std::cout << "Could not write file:" << filename << std::endl;
+	}
+
+	return(bSuccess);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading the probes written by
+ *  Save(), checking that the file size matches its header
+ *  and that the grid fits the probe texture.
+ ***********************************************************/
+bool LightProbeGrid::Load(const char* filename)
+{
+	PROBE_FILE_HEADER header;
+	MappedFile file;
+
+	Clear();
+
+	if (file.Open(filename) == false)
+	{
+		std::cout << "Could not open file:" << filename << std::endl;
+		return(false);
+	}
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	if (size >= sizeof(header))
+	{
+		memcpy(&header, data, sizeof(header));
+	}
+
+	bool bValid =
+		(size >= sizeof(header)) &&
+		(header.magic == PROBE_FILE_MAGIC) &&
+		(header.version == PROBE_FILE_VERSION);
+	const uint32_t counts[3] = { header.countX, header.countY, header.countZ };
+	for (int axis = 0; (axis < 3) && (bValid == true); axis++)
+	{
+		bValid =
+			(counts[axis] >= 2) &&
+			(counts[axis] <= (uint32_t)MAX_PROBES_PER_AXIS) &&
+			(header.boundsMax[axis] > header.boundsMin[axis]);
+	}
+	size_t probeCount = bValid ? ((size_t)header.countX * (size_t)header.countY * (size_t)header.countZ) : 0;
+	if ((bValid == false) ||
+		(sizeof(header) + (probeCount * PROBE_FLOATS * sizeof(float)) != size))
+	{
+		std::cout << "Not a valid light probe file:" << filename << std::endl;
+		return(false);
+	}
+
+	m_counts = glm::ivec3((int)header.countX, (int)header.countY, (int)header.countZ);
+	m_boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	m_boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+	m_coefficients.resize(probeCount * PROBE_FLOATS);
+	memcpy(m_coefficients.data(), data + sizeof(header), m_coefficients.size() * sizeof(float));
+
+	return(true);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for copying the probes into a half
+ *  float 3D texture.  The seven RGBA texels of each probe go
+ *  into seven blocks of the grid size placed along X, so the
+ *  texture filters each coefficient between the probes.
+ ***********************************************************/
+void LightProbeGrid::Upload()
+{
+	if (IsEmpty() == true)
+	{
+		return;
+	}
+
+	const int width = m_counts.x * PROBE_BLOCKS;
+	std::vector<float> texels((size_t)width * (size_t)m_counts.y * (size_t)m_counts.z * 4, 0.0f);
+	const int probeCount = m_counts.x * m_counts.y * m_counts.z;
+	for (int probe = 0; probe < probeCount; probe++)
+	{
+		int x = probe % m_counts.x;
+		int row = probe / m_counts.x;
+		const float* coefficients = &m_coefficients[(size_t)probe * PROBE_FLOATS];
+		for (int value = 0; value < PROBE_FLOATS; value++)
+		{
+			int block = value / 4;
+			size_t texel = ((size_t)row * (size_t)width) + (size_t)(block * m_counts.x) + (size_t)x;
+			texels[(texel * 4) + (value % 4)] = coefficients[value];
+		}
+	}
+
+	if (m_texture == 0)
+	{
+		glGenTextures(1, &m_texture);
+	}
+
+	glBindTexture(GL_TEXTURE_3D, m_texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, width, m_counts.y, m_counts.z, 0, GL_RGBA, GL_FLOAT, texels.data());
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the probe texture to a
+ *  texture unit.
+ ***********************************************************/
+void LightProbeGrid::Bind(int textureUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_3D, m_texture);
+}
+
+/***********************************************************
+ *  GetBoundsMin()
+ *
+ *  This method is used for getting the lowest corner of the
+ *  box covered by the grid.
+ ***********************************************************/
+glm::vec3 LightProbeGrid::GetBoundsMin() const
+{
+	return(m_boundsMin);
+}
+
+/***********************************************************
+ *  GetBoundsMax()
+ *
+ *  This method is used for getting the highest corner of the
+ *  box covered by the grid.
+ ***********************************************************/
+glm::vec3 LightProbeGrid::GetBoundsMax() const
+{
+	return(m_boundsMax);
+}
+
+/***********************************************************
+ *  GetProbeCounts()
+ *
+ *  This method is used for getting the number of probes
+ *  along each axis of the grid.
+ ***********************************************************/
+glm::ivec3 LightProbeGrid::GetProbeCounts() const
+{
+	return(m_counts);
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the bake of the probes of
+ *  a scene on pools of increasing thread counts.  The probes
+ *  of each bake are compared with the ones baked on a single
+ *  thread.
+ ***********************************************************/
+void LightProbeGrid::RunBenchmark(
+	const std::vector<LightmapBaker::BAKE_SURFACE>& surfaces,
+	const std::vector<LightClusters::POINT_LIGHT>& lights,
+	const LightmapBaker::BAKE_SETTINGS& settings,
+	const LightmapBaker::RAY_CAST& castRay)
+{
+	const float spacing = 1.0f;
+	const int raysPerProbe = 128;
+
+	// the probes cover the surfaces up to a little over them
+	glm::vec3 boundsMin = glm::vec3(1.0e30f);
+	glm::vec3 boundsMax = glm::vec3(-1.0e30f);
+	for (const LightmapBaker::BAKE_SURFACE& surface : surfaces)
+	{
+		glm::vec3 center = glm::vec3(surface.model[3]);
+		boundsMin = glm::min(boundsMin, center);
+		boundsMax = glm::max(boundsMax, center);
+	}
+	boundsMax.y += 2.0f;
+
+	// thread counts doubling up to the number of cores
+	int hardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < hardwareThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(hardwareThreads);
+
+	std::cout << "INFO: Light probe bake benchmark (" << surfaces.size() << " objects, "
+		<< raysPerProbe << " rays per probe, " << settings.bounces << " bounces)" << std::endl;
+	std::cout << "    threads     probes    bake ms  speedup  efficiency  same as 1 thread" << std::endl;
+
+	std::vector<float> singleThreadCoefficients;
+	double singleThreadTime = 0.0;
+	for (int threads : threadCounts)
+	{
+		ThreadPool pool(threads);
+		LightProbeGrid grid;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		grid.Bake(boundsMin, boundsMax, spacing, raysPerProbe, surfaces, lights, settings, castRay, &pool);
+		auto stop = std::chrono::high_resolution_clock::now();
+		double bakeTime = std::chrono::duration<double, std::milli>(stop - start).count();
+
+		if (threads == 1)
+		{
+			singleThreadCoefficients = grid.m_coefficients;
+			singleThreadTime = bakeTime;
+		}
+
+		double speedup = singleThreadTime / bakeTime;
+
+		char line[128];
+		snprintf(line, sizeof(line), "  %9d  %9d  %9.1f  %7.2f  %9.0f%%  %16s",
+			pool.GetThreadCount(),
+			grid.m_counts.x * grid.m_counts.y * grid.m_counts.z,
+			bakeTime,
+			speedup,
+			100.0 * speedup / (double)threads,
+			(grid.m_coefficients == singleThreadCoefficients) ? "yes" : "no");
+		std::cout << line << std::endl;
+	}
+}
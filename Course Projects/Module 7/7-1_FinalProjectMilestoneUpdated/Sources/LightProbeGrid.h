@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightprobegrid.h
+// ============
+// grid of spherical harmonic irradiance probes baked by ray casting
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LightmapBaker.h"
+#include "ThreadPool.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  LightProbeGrid
+ *
+ *  This class bakes the indirect light of the scene into a
+ *  regular grid of probes over the static objects.  Each
+ *  probe casts rays in every direction on the thread pool,
+ *  traced like the lightmap texels, and projects the light
+ *  they bring back onto the nine coefficients of the second
+ *  order spherical harmonics.  The coefficients are stored
+ *  already convolved with the cosine lobe, so the shader
+ *  gets the irradiance for a normal from a few products.
+ *
+ *  The 27 color coefficients of each probe are uploaded as
+ *  seven blocks of RGBA texels placed side by side in one
+ *  3D texture, and the shader blends the eight probes around
+ *  a fragment with the filtering of the texture.
+ ***********************************************************/
+class LightProbeGrid
+{
+public:
+	// second order spherical harmonics, and the texels of a
+	// probe holding their color coefficients
+	static const int SH_COEFFICIENTS = 9;
+	static const int PROBE_BLOCKS = 7;
+	// most probes along an axis, keeping the texture width
+	// under the smallest 3D texture size of OpenGL 3.3
+	static const int MAX_PROBES_PER_AXIS = 32;
+
+	struct PROBE_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t countX;
+		uint32_t countY;
+		uint32_t countZ;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	static const uint32_t PROBE_FILE_MAGIC = 0x31504853;	// "SHP1"
+	static const uint32_t PROBE_FILE_VERSION = 1;
+
+	// constructor
+	LightProbeGrid();
+	// destructor
+	~LightProbeGrid();
+
+	// place probes about the spacing apart over the box and
+	// trace their rays on the thread pool, the shared one when
+	// none is passed in
+	void Bake(
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		float spacing,
+		int raysPerProbe,
+		const std::vector<LightmapBaker::BAKE_SURFACE>& surfaces,
+		const std::vector<LightClusters::POINT_LIGHT>& lights,
+		const LightmapBaker::BAKE_SETTINGS& settings,
+		const LightmapBaker::RAY_CAST& castRay,
+		ThreadPool* pThreadPool = NULL);
+	// free the probes
+	void Clear();
+	// true when no probes are baked or loaded
+	bool IsEmpty() const;
+
+	// write and read the baked probes
+	bool Save(const char* filename) const;
+	bool Load(const char* filename);
+
+	// copy the probes into a texture, creating it on first use
+	void Upload();
+	// bind the probe texture to the texture unit
+	void Bind(int textureUnit) const;
+
+	// box covered by the grid, with a probe on each corner
+	glm::vec3 GetBoundsMin() const;
+	glm::vec3 GetBoundsMax() const;
+	// number of probes along each axis
+	glm::ivec3 GetProbeCounts() const;
+
+	// time the probes of a scene baked on increasing thread
+	// counts, comparing each bake with the one on one thread
+	static void RunBenchmark(
+		const std::vector<LightmapBaker::BAKE_SURFACE>& surfaces,
+		const std::vector<LightClusters::POINT_LIGHT>& lights,
+		const LightmapBaker::BAKE_SETTINGS& settings,
+		const LightmapBaker::RAY_CAST& castRay);
+
+private:
+	glm::ivec3 m_counts;
+	glm::vec3 m_boundsMin;
+	glm::vec3 m_boundsMax;
+	// RGB of the nine coefficients of each probe, with X
+	// changing fastest
+	std::vector<float> m_coefficients;
+
+	GLuint m_texture;
+};
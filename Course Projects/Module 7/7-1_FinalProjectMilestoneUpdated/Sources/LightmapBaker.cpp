@@ -0,0 +1,1088 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmapbaker.cpp
+// ============
+// diffuse lighting of the static scene path traced offline into a lightmap
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightmapBaker.h"
+#include "BoundingVolumeHierarchy.h"
+#include "LightProbeGrid.h"
+#include "MappedFile.h"
+#include "RayIntersection.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+
+// declaration of global variables
+namespace
+{
+	const float PI = 3.14159265f;
+	// length of the rays leaving the scene, longer than any scene
+	const float MAX_RAY_DISTANCE = 1.0e4f;
+	// rays start this far off the surface they leave, so they
+	// do not hit it again
+	const float RAY_OFFSET = 1.0e-3f;
+	// number of see-through objects a ray passes before it stops
+	const int MAX_SEE_THROUGH_HITS = 8;
+	// the chart resolution is lowered until the charts fit
+	// under this atlas height
+	const int MAX_ATLAS_HEIGHT = 4096;
+	const float CHART_SHRINK = 0.7f;
+
+	typedef LightmapBaker::BAKE_SCENE BAKE_SCENE;
+
+	/***********************************************************
+	 *  TraceRay()
+	 *
+	 *  Find the closest object hit by the ray that stops it,
+	 *  passing through the see-through objects - returns -1
+	 *  when nothing stops the ray within the distance.
+	 ***********************************************************/
+	int TraceRay(const BAKE_SCENE& scene, glm::vec3 origin, const glm::vec3& direction, float& distance)
+	{
+		float travelled = 0.0f;
+
+		for (int hit = 0; hit < MAX_SEE_THROUGH_HITS; hit++)
+		{
+			float hitDistance = distance - travelled;
+			int object = (*scene.pCastRay)(origin, direction, hitDistance);
+			if (object < 0)
+			{
+				return(-1);
+			}
+			if ((*scene.pSurfaces)[object].bSeeThrough == false)
+			{
+				distance = travelled + hitDistance;
+				return(object);
+			}
+			travelled += hitDistance + RAY_OFFSET;
+			origin = origin + (direction * (hitDistance + RAY_OFFSET));
+		}
+
+		return(-1);
+	}
+
+	/***********************************************************
+	 *  GatherDirectLight()
+	 *
+	 *  Add up the sun and point lights reaching a point of a
+	 *  surface, casting a shadow ray to each of them.  The
+	 *  point lights fade out at their range like in the scene
+	 *  shader.
+	 ***********************************************************/
+	glm::vec3 GatherDirectLight(const BAKE_SCENE& scene, const glm::vec3& position, const glm::vec3& normal)
+	{
+		const LightmapBaker::BAKE_SETTINGS& settings = *scene.pSettings;
+		const glm::vec3 origin = position + (normal * RAY_OFFSET);
+		glm::vec3 light = glm::vec3(0.0f);
+
+		glm::vec3 toSun = -glm::normalize(settings.sunDirection);
+		float sunCosine = glm::dot(normal, toSun);
+		if (sunCosine > 0.0f)
+		{
+			float distance = MAX_RAY_DISTANCE;
+			if (TraceRay(scene, origin, toSun, distance) < 0)
+			{
+				light += settings.sunColor * sunCosine;
+			}
+		}
+
+		for (const LightClusters::POINT_LIGHT& pointLight : *scene.pLights)
+		{
+			glm::vec3 toLight = pointLight.position - origin;
+			float distance = glm::length(toLight);
+			if ((distance >= pointLight.range) || (distance <= 0.0f))
+			{
+				continue;
+			}
+			glm::vec3 lightDirection = toLight / distance;
+			float cosine = glm::dot(normal, lightDirection);
+			if (cosine <= 0.0f)
+			{
+				continue;
+			}
+
+			float shadowDistance = distance;
+			if (TraceRay(scene, origin, lightDirection, shadowDistance) >= 0)
+			{
+				continue;
+			}
+
+			// windowed inverse square attenuation
+			float ratio = distance / pointLight.range;
+			float window = std::min(std::max(1.0f - (ratio * ratio * ratio * ratio), 0.0f), 1.0f);
+			float attenuation = (window * window) / ((distance * distance) + 1.0f);
+			light += pointLight.color * (cosine * attenuation);
+		}
+
+		return(light);
+	}
+
+	/***********************************************************
+	 *  CosineDirection()
+	 *
+	 *  Turn two uniform random numbers into a direction over
+	 *  the hemisphere of the normal, more often close to the
+	 *  normal as the cosine of the angle to it.
+	 ***********************************************************/
+	glm::vec3 CosineDirection(const glm::vec3& normal, float u1, float u2)
+	{
+		float radius = std::sqrt(u1);
+		float angle = 2.0f * PI * u2;
+		float x = radius * std::cos(angle);
+		float y = radius * std::sin(angle);
+		float z = std::sqrt(std::max(0.0f, 1.0f - u1));
+
+		// any two axes perpendicular to the normal
+		glm::vec3 helper = (std::fabs(normal.x) > 0.9f) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		glm::vec3 tangent = glm::normalize(glm::cross(helper, normal));
+		glm::vec3 bitangent = glm::cross(normal, tangent);
+
+		return(glm::normalize((tangent * x) + (bitangent * y) + (normal * z)));
+	}
+
+	/***********************************************************
+	 *  TracePath()
+	 *
+	 *  Follow one path of diffuse bounces away from a surface,
+	 *  adding the direct light reflected at every bounce and
+	 *  the sky reached by the path.
+	 ***********************************************************/
+	glm::vec3 TracePath(
+		const BAKE_SCENE& scene,
+		glm::vec3 position,
+		glm::vec3 normal,
+		std::mt19937& random)
+	{
+		const LightmapBaker::BAKE_SETTINGS& settings = *scene.pSettings;
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		glm::vec3 light = glm::vec3(0.0f);
+		glm::vec3 throughput = glm::vec3(1.0f);
+
+		for (int bounce = 0; bounce < settings.bounces; bounce++)
+		{
+			float u1 = unit(random);
+			float u2 = unit(random);
+			glm::vec3 direction = CosineDirection(normal, u1, u2);
+			float distance = MAX_RAY_DISTANCE;
+			int object = TraceRay(scene, position + (normal * RAY_OFFSET), direction, distance);
+			if (object < 0)
+			{
+				light += throughput * settings.skyColor;
+				break;
+			}
+
+			const LightmapBaker::BAKE_SURFACE& surface = (*scene.pSurfaces)[object];
+			position = position + (normal * RAY_OFFSET) + (direction * distance);
+			glm::vec3 localPosition = glm::vec3(scene.inverseModels[object] * glm::vec4(position, 1.0f));
+			normal = glm::normalize(scene.normalMatrices[object] *
+				LightmapBaker::GetSurfaceNormal(surface.shape, localPosition));
+			// the path leaves from the side it arrived on
+			if (glm::dot(normal, direction) > 0.0f)
+			{
+				normal = -normal;
+			}
+
+			throughput *= surface.albedo;
+			light += throughput * GatherDirectLight(scene, position, normal);
+		}
+
+		return(light);
+	}
+
+	/***********************************************************
+	 *  GetChartLength()
+	 *
+	 *  Get the number of texels covering a length of the world,
+	 *  kept between the smallest and largest chart side.
+	 ***********************************************************/
+	int GetChartLength(float length, float texelsPerUnit, const LightmapBaker::BAKE_SETTINGS& settings)
+	{
+		int texels = (int)std::ceil(length * texelsPerUnit);
+		return(std::min(std::max(texels, settings.minChartSize), settings.maxChartSize));
+	}
+
+	/***********************************************************
+	 *  GetShapeBounds()
+	 *
+	 *  Get the object space bounding box of a chart shape.
+	 ***********************************************************/
+	void GetShapeBounds(LightmapBaker::CHART_SHAPE shape, float tube, glm::vec3& boundsMin, glm::vec3& boundsMax)
+	{
+		switch (shape)
+		{
+		case LightmapBaker::CHART_PLANE:
+			boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+			boundsMax = glm::vec3(1.0f, 0.0f, 1.0f);
+			return;
+		case LightmapBaker::CHART_BOX:
+			boundsMin = glm::vec3(-0.5f);
+			boundsMax = glm::vec3(0.5f);
+			return;
+		case LightmapBaker::CHART_CYLINDER:
+			boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+			boundsMax = glm::vec3(1.0f, 1.0f, 1.0f);
+			return;
+		case LightmapBaker::CHART_SPHERE:
+			boundsMin = glm::vec3(-1.0f);
+			boundsMax = glm::vec3(1.0f);
+			return;
+		default:
+			boundsMin = glm::vec3(-1.0f - tube, -1.0f - tube, -tube);
+			boundsMax = glm::vec3(1.0f + tube, 1.0f + tube, tube);
+			return;
+		}
+	}
+}
+
+/***********************************************************
+ *  LightmapBaker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightmapBaker::LightmapBaker()
+{
+	m_texture = 0;
+	Clear();
+}
+
+/***********************************************************
+ *  ~LightmapBaker()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightmapBaker::~LightmapBaker()
+{
+	if (m_texture != 0)
+	{
+		glDeleteTextures(1, &m_texture);
+	}
+}
+
+/***********************************************************
+ *  GetDefaultSettings()
+ *
+ *  This method is used for getting the settings the scene
+ *  is baked with - a warm sun from above and in front, a
+ *  pale sky, and two bounces of sixty four paths.
+ ***********************************************************/
+LightmapBaker::BAKE_SETTINGS LightmapBaker::GetDefaultSettings()
+{
+	BAKE_SETTINGS settings;
+
+	settings.sunDirection = glm::normalize(glm::vec3(-0.4f, -1.0f, -0.5f));
+	settings.sunColor = glm::vec3(0.9f, 0.85f, 0.75f);
+	settings.skyColor = glm::vec3(0.35f, 0.4f, 0.45f);
+	settings.texelsPerUnit = 8.0f;
+	settings.minChartSize = 4;
+	settings.maxChartSize = 128;
+	settings.atlasWidth = 1024;
+	settings.samplesPerTexel = 64;
+	settings.bounces = 2;
+
+	return(settings);
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for path tracing the light reaching
+ *  every texel of the charts.  The rows of all the charts
+ *  are traced in parallel, and each texel seeds its random
+ *  numbers from its place in the atlas, so the lightmap is
+ *  the same whatever the number of threads.
+ ***********************************************************/
+void LightmapBaker::Bake(
+	const std::vector<BAKE_SURFACE>& surfaces,
+	const std::vector<LightClusters::POINT_LIGHT>& lights,
+	const BAKE_SETTINGS& settings,
+	const RAY_CAST& castRay,
+	ThreadPool* pThreadPool)
+{
+	Clear();
+
+	if (NULL == pThreadPool)
+	{
+		pThreadPool = ThreadPool::GetShared();
+	}
+
+	// lower the resolution until the charts fit into the atlas
+	float texelsPerUnit = settings.texelsPerUnit;
+	while (PackCharts(surfaces, settings, texelsPerUnit) == false)
+	{
+		texelsPerUnit *= CHART_SHRINK;
+	}
+	m_texels.assign((size_t)m_atlasWidth * (size_t)m_atlasHeight * 3, 0.0f);
+
+	BAKE_SCENE scene;
+	PrepareScene(scene, surfaces, lights, settings, castRay);
+
+	// one work item per row of each chart
+	std::vector<glm::ivec2> rows;
+	for (size_t object = 0; object < m_charts.size(); object++)
+	{
+		for (int row = 0; row < m_charts[object].height; row++)
+		{
+			rows.push_back(glm::ivec2((int)object, row));
+		}
+	}
+
+	const int samples = std::max(1, settings.samplesPerTexel);
+
+	pThreadPool->ParallelFor((int)rows.size(), [&](int begin, int end)
+	{
+		for (int item = begin; item < end; item++)
+		{
+			const int object = rows[item].x;
+			const int row = rows[item].y;
+			const CHART& chart = m_charts[object];
+			const BAKE_SURFACE& surface = surfaces[object];
+
+			for (int column = 0; column < chart.width; column++)
+			{
+				glm::vec2 chartPosition(
+					((float)column + 0.5f) / (float)chart.width,
+					((float)row + 0.5f) / (float)chart.height);
+				glm::vec3 localPosition;
+				glm::vec3 localNormal;
+				GetChartSurface(surface.shape, surface.tubeRadius, chartPosition, localPosition, localNormal);
+
+				glm::vec3 position = glm::vec3(surface.model * glm::vec4(localPosition, 1.0f));
+				glm::vec3 normal = glm::normalize(scene.normalMatrices[object] * localNormal);
+
+				size_t texel = ((size_t)(chart.y + row) * (size_t)m_atlasWidth) + (size_t)(chart.x + column);
+				std::mt19937 random((unsigned int)texel);
+
+				glm::vec3 bounced = glm::vec3(0.0f);
+				for (int sample = 0; sample < samples; sample++)
+				{
+					bounced += TracePath(scene, position, normal, random);
+				}
+				glm::vec3 light = GatherDirectLight(scene, position, normal) + (bounced / (float)samples);
+
+				m_texels[(texel * 3) + 0] = light.r;
+				m_texels[(texel * 3) + 1] = light.g;
+				m_texels[(texel * 3) + 2] = light.b;
+			}
+		}
+	});
+}
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for pointing a bake scene at the
+ *  surfaces, lights and settings it reads, and computing the
+ *  inverse and normal matrices of the surfaces.
+ ***********************************************************/
+void LightmapBaker::PrepareScene(
+	BAKE_SCENE& scene,
+	const std::vector<BAKE_SURFACE>& surfaces,
+	const std::vector<LightClusters::POINT_LIGHT>& lights,
+	const BAKE_SETTINGS& settings,
+	const RAY_CAST& castRay)
+{
+	scene.pSurfaces = &surfaces;
+	scene.pLights = &lights;
+	scene.pSettings = &settings;
+	scene.pCastRay = &castRay;
+	scene.inverseModels.resize(surfaces.size());
+	scene.normalMatrices.resize(surfaces.size());
+	for (size_t i = 0; i < surfaces.size(); i++)
+	{
+		scene.inverseModels[i] = glm::inverse(surfaces[i].model);
+		scene.normalMatrices[i] = glm::transpose(glm::mat3(scene.inverseModels[i]));
+	}
+}
+
+/***********************************************************
+ *  TraceRadiance()
+ *
+ *  This method is used for getting the light arriving at a
+ *  point from a direction.  A ray leaving the scene brings
+ *  the sky, and a ray hitting a surface brings the direct
+ *  and bounced light reflected by it, in the units of the
+ *  lightmap texels multiplied by the albedo.
+ ***********************************************************/
+glm::vec3 LightmapBaker::TraceRadiance(
+	const BAKE_SCENE& scene,
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	std::mt19937& random)
+{
+	float distance = MAX_RAY_DISTANCE;
+	int object = TraceRay(scene, origin, direction, distance);
+	if (object < 0)
+	{
+		return(scene.pSettings->skyColor);
+	}
+
+	const BAKE_SURFACE& surface = (*scene.pSurfaces)[object];
+	glm::vec3 position = origin + (direction * distance);
+	glm::vec3 localPosition = glm::vec3(scene.inverseModels[object] * glm::vec4(position, 1.0f));
+	glm::vec3 normal = glm::normalize(scene.normalMatrices[object] *
+		GetSurfaceNormal(surface.shape, localPosition));
+	// the light leaves the side the ray arrived from
+	if (glm::dot(normal, direction) > 0.0f)
+	{
+		normal = -normal;
+	}
+
+	return(surface.albedo * (GatherDirectLight(scene, position, normal) + TracePath(scene, position, normal, random)));
+}
+
+/***********************************************************
+ *  PackCharts()
+ *
+ *  This method is used for sizing the chart of every
+ *  lightmapped surface from the scale of its model matrix,
+ *  and placing the charts into rows of the atlas from the
+ *  tallest to the shortest.
+ ***********************************************************/
+bool LightmapBaker::PackCharts(
+	const std::vector<BAKE_SURFACE>& surfaces,
+	const BAKE_SETTINGS& settings,
+	float texelsPerUnit)
+{
+	m_charts.assign(surfaces.size(), CHART{ 0, 0, 0, 0 });
+	m_atlasWidth = std::max(settings.atlasWidth, settings.maxChartSize);
+	m_atlasHeight = 0;
+
+	std::vector<int> order;
+	for (size_t i = 0; i < surfaces.size(); i++)
+	{
+		const BAKE_SURFACE& surface = surfaces[i];
+		if (surface.bLightmapped == false)
+		{
+			continue;
+		}
+
+		glm::vec3 scale(
+			glm::length(glm::vec3(surface.model[0])),
+			glm::length(glm::vec3(surface.model[1])),
+			glm::length(glm::vec3(surface.model[2])));
+		float largest = std::max(scale.x, std::max(scale.y, scale.z));
+		float radius = std::max(scale.x, scale.z);
+		float ring = std::max(scale.x, scale.y);
+
+		// world lengths along the two chart axes
+		glm::vec2 size;
+		switch (surface.shape)
+		{
+		case CHART_PLANE:
+			size = glm::vec2(2.0f * scale.x, 2.0f * scale.z);
+			break;
+		case CHART_BOX:
+			size = glm::vec2(3.0f * largest, 2.0f * largest);
+			break;
+		case CHART_CYLINDER:
+			// the side fills the lower half, the caps the upper
+			size = glm::vec2(2.0f * PI * radius, 2.0f * std::max(scale.y, 2.0f * radius));
+			break;
+		case CHART_SPHERE:
+			size = glm::vec2(2.0f * PI * largest, PI * largest);
+			break;
+		case CHART_TORUS:
+			size = glm::vec2(2.0f * PI * ring, 2.0f * PI * surface.tubeRadius * largest);
+			break;
+		case CHART_QUARTER_TORUS:
+			size = glm::vec2(0.5f * PI * ring, 2.0f * PI * surface.tubeRadius * largest);
+			break;
+		}
+
+		m_charts[i].width = GetChartLength(size.x, texelsPerUnit, settings);
+		m_charts[i].height = GetChartLength(size.y, texelsPerUnit, settings);
+		order.push_back((int)i);
+	}
+
+	std::sort(order.begin(), order.end(), [&](int a, int b)
+	{
+		return(m_charts[a].height > m_charts[b].height);
+	});
+
+	int rowX = 0;
+	int rowY = 0;
+	int rowHeight = 0;
+	for (int object : order)
+	{
+		CHART& chart = m_charts[object];
+		if (rowX + chart.width > m_atlasWidth)
+		{
+			rowY += rowHeight;
+			rowX = 0;
+			rowHeight = 0;
+		}
+		chart.x = rowX;
+		chart.y = rowY;
+		rowX += chart.width;
+		rowHeight = std::max(rowHeight, chart.height);
+	}
+	m_atlasHeight = std::max(1, rowY + rowHeight);
+
+	return(m_atlasHeight <= MAX_ATLAS_HEIGHT);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for freeing the lightmap, after
+ *  which no object has a chart.
+ ***********************************************************/
+void LightmapBaker::Clear()
+{
+	m_atlasWidth = 0;
+	m_atlasHeight = 0;
+	m_charts.clear();
+	m_texels.clear();
+}
+
+/***********************************************************
+ *  IsEmpty()
+ *
+ *  This method is used for checking whether a lightmap was
+ *  baked or loaded.
+ ***********************************************************/
+bool LightmapBaker::IsEmpty() const
+{
+	return(m_texels.empty());
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the charts and the
+ *  texels of the atlas into a file.
+ ***********************************************************/
+bool LightmapBaker::Save(const char* filename) const
+{
+	LIGHTMAP_FILE_HEADER header;
+	FILE* file = fopen(filename, "wb");
+
+	if (file == nullptr)
+	{
+		std::cout << "Could not create file:" << filename << std::endl;
+		return(false);
+	}
+
+	header.magic = LIGHTMAP_FILE_MAGIC;
+	header.version = LIGHTMAP_FILE_VERSION;
+	header.atlasWidth = (uint32_t)m_atlasWidth;
+	header.atlasHeight = (uint32_t)m_atlasHeight;
+	header.objectCount = (uint32_t)m_charts.size();
+
+	bool bSuccess =
+		(fwrite(&header, sizeof(header), 1, file) == 1) &&
+		(fwrite(m_charts.data(), sizeof(CHART), m_charts.size(), file) == m_charts.size()) &&
+		(fwrite(m_texels.data(), sizeof(float), m_texels.size(), file) == m_texels.size());
+	bSuccess = (fclose(file) == 0) && bSuccess;
+
+	if (bSuccess == false)
+	{
+		std::cout << "Could not write file:" << filename << std::endl;
+	}
+
+	return(bSuccess);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading the lightmap written by
+ *  Save(), checking that the file size matches its header
+ *  and that every chart lies inside the atlas.
+ ***********************************************************/
+bool LightmapBaker::Load(const char* filename)
+{
+	LIGHTMAP_FILE_HEADER header;
+	MappedFile file;
+
+	Clear();
+
+	if (file.Open(filename) == false)
+	{
+		std::cout << "Could not open file:" << filename << std::endl;
+		return(false);
+	}
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	if (size >= sizeof(header))
+	{
+		memcpy(&header, data, sizeof(header));
+	}
+
+	size_t texelCount = (size_t)header.atlasWidth * (size_t)header.atlasHeight;
+	size_t chartBytes = (size_t)header.objectCount * sizeof(CHART);
+	if ((size < sizeof(header)) ||
+		(header.magic != LIGHTMAP_FILE_MAGIC) ||
+		(header.version != LIGHTMAP_FILE_VERSION) ||
+		(texelCount == 0) ||
+		(header.objectCount == 0) ||
+		(sizeof(header) + chartBytes + (texelCount * 3 * sizeof(float)) != size))
+	{
+		std::cout << "Not a valid lightmap file:" << filename << std::endl;
+		return(false);
+	}
+
+	m_charts.resize(header.objectCount);
+	memcpy(m_charts.data(), data + sizeof(header), chartBytes);
+	for (const CHART& chart : m_charts)
+	{
+		if ((chart.x < 0) || (chart.y < 0) || (chart.width < 0) || (chart.height < 0) ||
+			(chart.x + chart.width > (int32_t)header.atlasWidth) ||
+			(chart.y + chart.height > (int32_t)header.atlasHeight))
+		{
+			std::cout << "Not a valid lightmap file:" << filename << std::endl;
+			m_charts.clear();
+			return(false);
+		}
+	}
+
+	m_atlasWidth = (int)header.atlasWidth;
+	m_atlasHeight = (int)header.atlasHeight;
+	m_texels.resize(texelCount * 3);
+	memcpy(m_texels.data(), data + sizeof(header) + chartBytes, m_texels.size() * sizeof(float));
+
+	return(true);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for copying the atlas into a half
+ *  float texture.  The texels are filtered between their
+ *  centers, which the shader keeps inside each chart cell.
+ ***********************************************************/
+void LightmapBaker::Upload()
+{
+	if (IsEmpty() == true)
+	{
+		return;
+	}
+
+	if (m_texture == 0)
+	{
+		glGenTextures(1, &m_texture);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, m_atlasWidth, m_atlasHeight, 0, GL_RGB, GL_FLOAT, m_texels.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the atlas texture to a
+ *  texture unit.
+ ***********************************************************/
+void LightmapBaker::Bind(int textureUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+}
+
+/***********************************************************
+ *  HasChart()
+ *
+ *  This method is used for checking whether an object was
+ *  given a chart in the lightmap.
+ ***********************************************************/
+bool LightmapBaker::HasChart(int object) const
+{
+	if ((object < 0) || (object >= (int)m_charts.size()))
+	{
+		return(false);
+	}
+	return((m_charts[object].width > 0) && (m_charts[object].height > 0));
+}
+
+/***********************************************************
+ *  GetChartRect()
+ *
+ *  This method is used for getting the offset and size of
+ *  the chart of an object, in the zero to one coordinates
+ *  of the atlas texture.
+ ***********************************************************/
+glm::vec4 LightmapBaker::GetChartRect(int object) const
+{
+	if (HasChart(object) == false)
+	{
+		return(glm::vec4(0.0f));
+	}
+
+	const CHART& chart = m_charts[object];
+	return(glm::vec4(
+		(float)chart.x / (float)m_atlasWidth,
+		(float)chart.y / (float)m_atlasHeight,
+		(float)chart.width / (float)m_atlasWidth,
+		(float)chart.height / (float)m_atlasHeight));
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of objects
+ *  the lightmap was baked for.
+ ***********************************************************/
+int LightmapBaker::GetObjectCount() const
+{
+	return((int)m_charts.size());
+}
+
+/***********************************************************
+ *  GetAtlasWidth()
+ *
+ *  This method is used for getting the width of the atlas
+ *  in texels.
+ ***********************************************************/
+int LightmapBaker::GetAtlasWidth() const
+{
+	return(m_atlasWidth);
+}
+
+/***********************************************************
+ *  GetAtlasHeight()
+ *
+ *  This method is used for getting the height of the atlas
+ *  in texels.
+ ***********************************************************/
+int LightmapBaker::GetAtlasHeight() const
+{
+	return(m_atlasHeight);
+}
+
+/***********************************************************
+ *  GetChartSurface()
+ *
+ *  This method is used for finding the point of a primitive
+ *  under a point of its chart.  The layouts are:
+ *
+ *  - plane: X and Z across the whole chart
+ *  - box: a 3 x 2 grid of cells, for the +X, -X, +Y, -Y, +Z
+ *    and -Z faces in order
+ *  - cylinder: the side around its axis in the lower half,
+ *    the top and bottom caps side by side in the upper half
+ *  - sphere: the longitude across and the latitude up
+ *  - torus: the angle around the main ring across and the
+ *    angle around the tube up, the quarter torus spreading
+ *    its quarter of the ring across the chart
+ *
+ *  The scene shader maps the other way with the same
+ *  layouts.
+ ***********************************************************/
+void LightmapBaker::GetChartSurface(
+	CHART_SHAPE shape,
+	float tubeRadius,
+	const glm::vec2& chartPosition,
+	glm::vec3& position,
+	glm::vec3& normal)
+{
+	const float u = chartPosition.x;
+	const float v = chartPosition.y;
+
+	switch (shape)
+	{
+	case CHART_PLANE:
+		position = glm::vec3((u * 2.0f) - 1.0f, 0.0f, (v * 2.0f) - 1.0f);
+		normal = glm::vec3(0.0f, 1.0f, 0.0f);
+		return;
+
+	case CHART_BOX:
+	{
+		int column = std::min((int)(u * 3.0f), 2);
+		int row = std::min((int)(v * 2.0f), 1);
+		int face = (row * 3) + column;
+		int axis = face / 2;
+		float side = ((face % 2) == 0) ? 1.0f : -1.0f;
+		glm::vec2 local((u * 3.0f) - (float)column - 0.5f, (v * 2.0f) - (float)row - 0.5f);
+
+		// the two axes across each face, as in the shader
+		const int acrossAxes[3][2] = { { 2, 1 }, { 0, 2 }, { 0, 1 } };
+		position = glm::vec3(0.0f);
+		position[axis] = 0.5f * side;
+		position[acrossAxes[axis][0]] = local.x;
+		position[acrossAxes[axis][1]] = local.y;
+		normal = glm::vec3(0.0f);
+		normal[axis] = side;
+		return;
+	}
+
+	case CHART_CYLINDER:
+		if (v < 0.5f)
+		{
+			float angle = (u - 0.5f) * 2.0f * PI;
+			normal = glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+			position = glm::vec3(normal.x, v * 2.0f, normal.z);
+		}
+		else
+		{
+			bool bTop = (u < 0.5f);
+			glm::vec2 disc(
+				(((bTop ? u : u - 0.5f) * 2.0f) * 2.0f) - 1.0f,
+				(((v - 0.5f) * 2.0f) * 2.0f) - 1.0f);
+			// the texels past the rim take the light at the rim
+			float length = glm::length(disc);
+			if (length > 1.0f)
+			{
+				disc /= length;
+			}
+			position = glm::vec3(disc.x, bTop ? 1.0f : 0.0f, disc.y);
+			normal = glm::vec3(0.0f, bTop ? 1.0f : -1.0f, 0.0f);
+		}
+		return;
+
+	case CHART_SPHERE:
+	{
+		float longitude = (u - 0.5f) * 2.0f * PI;
+		float latitude = (v - 0.5f) * PI;
+		normal = glm::vec3(
+			std::cos(latitude) * std::cos(longitude),
+			std::sin(latitude),
+			std::cos(latitude) * std::sin(longitude));
+		position = normal;
+		return;
+	}
+
+	case CHART_TORUS:
+	case CHART_QUARTER_TORUS:
+	{
+		float ringAngle = (shape == CHART_TORUS) ? ((u - 0.5f) * 2.0f * PI) : (u * 0.5f * PI);
+		float tubeAngle = (v - 0.5f) * 2.0f * PI;
+		glm::vec2 ring(std::cos(ringAngle), std::sin(ringAngle));
+		normal = glm::vec3(
+			std::cos(tubeAngle) * ring.x,
+			std::cos(tubeAngle) * ring.y,
+			std::sin(tubeAngle));
+		position = glm::vec3(ring, 0.0f) + (normal * tubeRadius);
+		return;
+	}
+	}
+
+	position = glm::vec3(0.0f);
+	normal = glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+/***********************************************************
+ *  GetSurfaceNormal()
+ *
+ *  This method is used for getting the outward normal of a
+ *  primitive at a point found on its surface by a ray.
+ ***********************************************************/
+glm::vec3 LightmapBaker::GetSurfaceNormal(
+	CHART_SHAPE shape,
+	const glm::vec3& position)
+{
+	switch (shape)
+	{
+	case CHART_PLANE:
+		return(glm::vec3(0.0f, 1.0f, 0.0f));
+
+	case CHART_BOX:
+	{
+		// the face the point is closest to
+		glm::vec3 extent = glm::abs(position);
+		int axis = (extent.x >= extent.y) ? ((extent.x >= extent.z) ? 0 : 2) : ((extent.y >= extent.z) ? 1 : 2);
+		glm::vec3 normal = glm::vec3(0.0f);
+		normal[axis] = (position[axis] >= 0.0f) ? 1.0f : -1.0f;
+		return(normal);
+	}
+
+	case CHART_CYLINDER:
+	{
+		float radius = std::sqrt((position.x * position.x) + (position.z * position.z));
+		float sideDistance = std::fabs(radius - 1.0f);
+		float capDistance = std::min(std::fabs(position.y), std::fabs(position.y - 1.0f));
+		if ((capDistance < sideDistance) || (radius <= 0.0f))
+		{
+			return(glm::vec3(0.0f, (position.y > 0.5f) ? 1.0f : -1.0f, 0.0f));
+		}
+		return(glm::vec3(position.x / radius, 0.0f, position.z / radius));
+	}
+
+	case CHART_SPHERE:
+		return(glm::normalize(position));
+
+	case CHART_TORUS:
+	case CHART_QUARTER_TORUS:
+	{
+		glm::vec2 ring = glm::vec2(position.x, position.y);
+		float ringLength = glm::length(ring);
+		ring = (ringLength > 0.0f) ? (ring / ringLength) : glm::vec2(1.0f, 0.0f);
+		glm::vec3 offset = position - glm::vec3(ring, 0.0f);
+		float offsetLength = glm::length(offset);
+		return((offsetLength > 0.0f) ? (offset / offsetLength) : glm::vec3(ring, 0.0f));
+	}
+	}
+
+	return(glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the bake of a test scene
+ *  of a floor and rows of primitives, lit by the sun and a
+ *  few point lights, on pools of increasing thread counts.
+ *  The lightmap of each bake is compared with the one baked
+ *  on a single thread, and the light probes of the same
+ *  scene are timed after it.
+ ***********************************************************/
+void LightmapBaker::RunBenchmark()
+{
+	const int rows = 4;
+	const int columns = 6;
+	const CHART_SHAPE shapes[] = { CHART_BOX, CHART_SPHERE, CHART_CYLINDER, CHART_TORUS };
+
+	std::vector<BAKE_SURFACE> surfaces;
+	BAKE_SURFACE floor;
+	floor.shape = CHART_PLANE;
+	floor.tubeRadius = 0.0f;
+	floor.model = glm::scale(glm::vec3(10.0f, 1.0f, 10.0f));
+	floor.albedo = glm::vec3(0.6f);
+	floor.bLightmapped = true;
+	floor.bSeeThrough = false;
+	surfaces.push_back(floor);
+
+	for (int row = 0; row < rows; row++)
+	{
+		for (int column = 0; column < columns; column++)
+		{
+			BAKE_SURFACE surface;
+			surface.shape = shapes[(row + column) % 4];
+			surface.tubeRadius = 0.3f;
+			surface.model = glm::translate(glm::vec3(-7.5f + (3.0f * (float)column), 1.0f, -4.5f + (3.0f * (float)row)));
+			surface.albedo = glm::vec3(0.3f + (0.1f * (float)row), 0.5f, 0.8f - (0.1f * (float)column));
+			surface.bLightmapped = true;
+			surface.bSeeThrough = false;
+			surfaces.push_back(surface);
+		}
+	}
+
+	std::vector<glm::vec3> boundsMin(surfaces.size());
+	std::vector<glm::vec3> boundsMax(surfaces.size());
+	std::vector<glm::mat4> inverseModels(surfaces.size());
+	for (size_t i = 0; i < surfaces.size(); i++)
+	{
+		glm::vec3 localMin;
+		glm::vec3 localMax;
+		GetShapeBounds(surfaces[i].shape, surfaces[i].tubeRadius, localMin, localMax);
+
+		boundsMin[i] = glm::vec3(1.0e30f);
+		boundsMax[i] = glm::vec3(-1.0e30f);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 point(
+				(corner & 1) ? localMax.x : localMin.x,
+				(corner & 2) ? localMax.y : localMin.y,
+				(corner & 4) ? localMax.z : localMin.z);
+			point = glm::vec3(surfaces[i].model * glm::vec4(point, 1.0f));
+			boundsMin[i] = glm::min(boundsMin[i], point);
+			boundsMax[i] = glm::max(boundsMax[i], point);
+		}
+		inverseModels[i] = glm::inverse(surfaces[i].model);
+	}
+
+	BoundingVolumeHierarchy hierarchy;
+	hierarchy.Build(boundsMin, boundsMax);
+
+	RAY_CAST castRay = [&](const glm::vec3& origin, const glm::vec3& direction, float& distance)
+	{
+		return(hierarchy.Raycast(origin, direction, distance, [&](int object, float& hitDistance)
+		{
+			glm::vec3 localOrigin = glm::vec3(inverseModels[object] * glm::vec4(origin, 1.0f));
+			glm::vec3 localDirection = glm::vec3(inverseModels[object] * glm::vec4(direction, 0.0f));
+			switch (surfaces[object].shape)
+			{
+			case CHART_PLANE:
+				return(RayIntersection::IntersectPlane(localOrigin, localDirection, hitDistance));
+			case CHART_BOX:
+				return(RayIntersection::IntersectBox(localOrigin, localDirection, hitDistance));
+			case CHART_CYLINDER:
+				return(RayIntersection::IntersectCylinder(localOrigin, localDirection, hitDistance));
+			case CHART_SPHERE:
+				return(RayIntersection::IntersectSphere(localOrigin, localDirection, hitDistance));
+			default:
+				return(RayIntersection::IntersectTorus(localOrigin, localDirection, surfaces[object].tubeRadius,
+					surfaces[object].shape == CHART_QUARTER_TORUS, hitDistance));
+			}
+		}));
+	};
+
+	std::vector<LightClusters::POINT_LIGHT> lights(4);
+	for (int i = 0; i < 4; i++)
+	{
+		lights[i].position = glm::vec3(-6.0f + (4.0f * (float)i), 3.0f, 0.0f);
+		lights[i].range = 6.0f;
+		lights[i].color = glm::vec3(1.0f, 0.8f, 0.6f);
+	}
+
+	BAKE_SETTINGS settings = GetDefaultSettings();
+	settings.samplesPerTexel = 16;
+
+	// thread counts doubling up to the number of cores
+	int hardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < hardwareThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(hardwareThreads);
+
+	std::cout << "INFO: Lightmap bake benchmark (" << surfaces.size() << " objects, "
+		<< settings.samplesPerTexel << " paths per texel, " << settings.bounces << " bounces)" << std::endl;
+	std::cout << "    threads     texels    bake ms  speedup  efficiency  same as 1 thread" << std::endl;
+
+	std::vector<float> singleThreadTexels;
+	double singleThreadTime = 0.0;
+	for (int threads : threadCounts)
+	{
+		ThreadPool pool(threads);
+		LightmapBaker baker;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		baker.Bake(surfaces, lights, settings, castRay, &pool);
+		auto stop = std::chrono::high_resolution_clock::now();
+		double bakeTime = std::chrono::duration<double, std::milli>(stop - start).count();
+
+		if (threads == 1)
+		{
+			singleThreadTexels = baker.m_texels;
+			singleThreadTime = bakeTime;
+		}
+
+		size_t texelCount = 0;
+		for (const CHART& chart : baker.m_charts)
+		{
+			texelCount += (size_t)chart.width * (size_t)chart.height;
+		}
+		double speedup = singleThreadTime / bakeTime;
+
+		char line[128];
+		snprintf(line, sizeof(line), "  %9d  %9zu  %9.1f  %7.2f  %9.0f%%  %16s",
+			pool.GetThreadCount(),
+			texelCount,
+			bakeTime,
+			speedup,
+			100.0 * speedup / (double)threads,
+			(baker.m_texels == singleThreadTexels) ? "yes" : "no");
+		std::cout << line << std::endl;
+	}
+
+	LightProbeGrid::RunBenchmark(surfaces, lights, settings, castRay);
+}
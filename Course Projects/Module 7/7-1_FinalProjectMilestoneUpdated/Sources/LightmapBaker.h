@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmapbaker.h
+// ============
+// diffuse lighting of the static scene path traced offline into a lightmap
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LightClusters.h"
+#include "ThreadPool.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+/***********************************************************
+ *  LightmapBaker
+ *
+ *  This class bakes the diffuse light reaching the static
+ *  scene objects into one lightmap atlas.  Each object gets
+ *  a chart in the atlas, sized by its surface in the world,
+ *  and its lightmap coordinates are computed from the
+ *  object space position and normal of the primitive, so
+ *  the generated meshes need no second set of UVs.  The
+ *  scene shader computes the same coordinates.
+ *
+ *  Every texel is path traced on the thread pool - the sun,
+ *  sky and point lights are sampled directly at each bounce
+ *  with shadow rays, and the light bounced by the diffuse
+ *  surfaces is gathered over cosine weighted directions.
+ *  The rays are traced through the caller, which finds the
+ *  closest object with the scene hierarchy and the exact
+ *  primitive tests.
+ *
+ *  The baked texels hold the light multiplied into the
+ *  albedo, matching the diffuse term of the lit shader.
+ *  The same paths are traced for the light probes, through
+ *  TraceRadiance().
+ ***********************************************************/
+class LightmapBaker
+{
+public:
+	// find the closest object hit by the ray within the distance
+	// and shorten the distance to the hit - returns -1 when
+	// nothing is hit
+	typedef std::function<int(const glm::vec3& origin, const glm::vec3& direction, float& distance)> RAY_CAST;
+
+	// primitives the charts are laid out for, matching the
+	// layouts of the scene shader
+	enum CHART_SHAPE
+	{
+		// 2 x 2 plane in the XZ plane
+		CHART_PLANE,
+		// unit box, one cell per face
+		CHART_BOX,
+		// capped cylinder, the side and the two caps
+		CHART_CYLINDER,
+		// unit sphere, by longitude and latitude
+		CHART_SPHERE,
+		// torus, around the main ring and around the tube
+		CHART_TORUS,
+		// the quarter of the torus with positive X and Y
+		CHART_QUARTER_TORUS
+	};
+
+	// a scene object as seen by the baker
+	struct BAKE_SURFACE
+	{
+		CHART_SHAPE shape;
+		// tube radius of the torus shapes
+		float tubeRadius;
+		glm::mat4 model;
+		// diffuse color bounced by the surface
+		glm::vec3 albedo;
+		// the object receives a chart in the lightmap
+		bool bLightmapped;
+		// rays and light pass through the object
+		bool bSeeThrough;
+	};
+
+	struct BAKE_SETTINGS
+	{
+		// direction the sunlight travels in, and its color
+		glm::vec3 sunDirection;
+		glm::vec3 sunColor;
+		// light arriving from the rays that leave the scene
+		glm::vec3 skyColor;
+		// chart resolution in texels per world unit, and the
+		// smallest and largest chart side
+		float texelsPerUnit;
+		int minChartSize;
+		int maxChartSize;
+		// width of the atlas, the height grows with the charts
+		int atlasWidth;
+		// paths traced per texel, and the diffuse bounces
+		// followed along each path
+		int samplesPerTexel;
+		int bounces;
+	};
+
+	// place of an object chart in the atlas, in texels
+	struct CHART
+	{
+		int32_t x;
+		int32_t y;
+		int32_t width;
+		int32_t height;
+	};
+
+	struct LIGHTMAP_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t atlasWidth;
+		uint32_t atlasHeight;
+		uint32_t objectCount;
+	};
+
+	static const uint32_t LIGHTMAP_FILE_MAGIC = 0x31504D4C;	// "LMP1"
+	static const uint32_t LIGHTMAP_FILE_VERSION = 1;
+
+	// the scene objects and lights a bake reads, with the
+	// matrices moving points into and normals out of the
+	// object space of each surface
+	struct BAKE_SCENE
+	{
+		const std::vector<BAKE_SURFACE>* pSurfaces;
+		const std::vector<LightClusters::POINT_LIGHT>* pLights;
+		const BAKE_SETTINGS* pSettings;
+		const RAY_CAST* pCastRay;
+		std::vector<glm::mat4> inverseModels;
+		std::vector<glm::mat3> normalMatrices;
+	};
+
+	// constructor
+	LightmapBaker();
+	// destructor
+	~LightmapBaker();
+
+	// settings the scene is baked with by default
+	static BAKE_SETTINGS GetDefaultSettings();
+
+	// lay out the charts of the lightmapped surfaces and trace
+	// their texels on the thread pool, the shared one when none
+	// is passed in - there is one surface per object
+	void Bake(
+		const std::vector<BAKE_SURFACE>& surfaces,
+		const std::vector<LightClusters::POINT_LIGHT>& lights,
+		const BAKE_SETTINGS& settings,
+		const RAY_CAST& castRay,
+		ThreadPool* pThreadPool = NULL);
+	// free the lightmap
+	void Clear();
+	// true when no lightmap is baked or loaded
+	bool IsEmpty() const;
+
+	// write and read the baked lightmap
+	bool Save(const char* filename) const;
+	bool Load(const char* filename);
+
+	// copy the atlas into a texture, creating it on first use
+	void Upload();
+	// bind the atlas texture to the texture unit
+	void Bind(int textureUnit) const;
+
+	// true when the object has a chart
+	bool HasChart(int object) const;
+	// offset and size of the chart of an object in the
+	// coordinates of the atlas texture
+	glm::vec4 GetChartRect(int object) const;
+	// number of objects the lightmap was baked for
+	int GetObjectCount() const;
+	// size of the atlas in texels
+	int GetAtlasWidth() const;
+	int GetAtlasHeight() const;
+
+	// point the scene at the surfaces, lights and settings of a
+	// bake and compute the matrices of the surfaces - they must
+	// outlive the scene
+	static void PrepareScene(
+		BAKE_SCENE& scene,
+		const std::vector<BAKE_SURFACE>& surfaces,
+		const std::vector<LightClusters::POINT_LIGHT>& lights,
+		const BAKE_SETTINGS& settings,
+		const RAY_CAST& castRay);
+	// light arriving at a point from a direction - the sky, or
+	// the diffuse light leaving the first surface hit, traced
+	// with one path like the lightmap texels
+	static glm::vec3 TraceRadiance(
+		const BAKE_SCENE& scene,
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		std::mt19937& random);
+
+	// object space position and normal at a point of a chart,
+	// the chart coordinates going from zero to one
+	static void GetChartSurface(
+		CHART_SHAPE shape,
+		float tubeRadius,
+		const glm::vec2& chartPosition,
+		glm::vec3& position,
+		glm::vec3& normal);
+	// object space normal of the surface at a point on it
+	static glm::vec3 GetSurfaceNormal(
+		CHART_SHAPE shape,
+		const glm::vec3& position);
+
+	// time the bake of a test scene on increasing thread counts
+	static void RunBenchmark();
+
+private:
+	int m_atlasWidth;
+	int m_atlasHeight;
+	// chart of each object, zero sized for the objects that
+	// are not lightmapped
+	std::vector<CHART> m_charts;
+	// RGB texels of the atlas, row by row
+	std::vector<float> m_texels;
+
+	GLuint m_texture;
+
+	// size the charts of the surfaces and pack them into rows
+	// of the atlas - returns false when they do not fit
+	bool PackCharts(
+		const std::vector<BAKE_SURFACE>& surfaces,
+		const BAKE_SETTINGS& settings,
+		float texelsPerUnit);
+};
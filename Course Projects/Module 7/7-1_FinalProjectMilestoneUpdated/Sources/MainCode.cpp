@@ -8,7 +8,12 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
+#include <cstdlib>          // EXIT_FAILURE, atof
+#include <cstring>          // strcmp
+#include <cstdio>           // snprintf
+#include <algorithm>        // std::max
+#include <random>           // benchmark light placement
+#include <cmath>            // std::sin
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -22,6 +27,18 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "ShaderVariants.h"
+#include "ProgramBinaryCache.h"
+#include "ShapeGenerator.h"
+#include "MeshSimplifier.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCuller.h"
+#include "SceneGraph.h"
+#include "LightClusters.h"
+#include "ObjectLightLists.h"
+#include "LightmapBaker.h"
+#include "DeferredRenderer.h"
+#include "TransparencyRenderer.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,6 +46,65 @@ namespace
 	// Macro for window title
 	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
 
+	// command line switch for running the CPU benchmarks
+	const char* const BENCHMARK_SWITCH = "-benchmark";
+	// command line switch for baking the levels of detail of
+	// a model: -simplify input.obj output.lod
+	const char* const SIMPLIFY_SWITCH = "-simplify";
+	// command line switch for laying down the depth of the
+	// opaque objects before shading them
+	const char* const DEPTH_PREPASS_SWITCH = "-depthprepass";
+	// command line switches for baking the visible sets of the
+	// camera region into a file and exiting, and for drawing
+	// with the baked sets: -bakepvs output.pvs, -pvs input.pvs
+	const char* const BAKE_PVS_SWITCH = "-bakepvs";
+	const char* const PVS_SWITCH = "-pvs";
+	// command line switches for baking the lighting of the
+	// static objects into a lightmap file and exiting, and for
+	// drawing with the baked lightmap: -bakelightmap output.lmp,
+	// -lightmap input.lmp
+	const char* const BAKE_LIGHTMAP_SWITCH = "-bakelightmap";
+	const char* const LIGHTMAP_SWITCH = "-lightmap";
+	// command line switches for baking the indirect light of
+	// the scene into a light probe file and exiting, and for
+	// drawing with the baked probes: -bakeprobes output.shp,
+	// -probes input.shp
+	const char* const BAKE_PROBES_SWITCH = "-bakeprobes";
+	const char* const PROBES_SWITCH = "-probes";
+	// command line switch for timing the rendering passes of
+	// the scene from fixed cameras, then exiting
+	const char* const RENDER_BENCHMARK_SWITCH = "-renderbenchmark";
+	// path prefix of the cached shader variant binaries
+	const char* const PROGRAM_CACHE_PREFIX = "shaders/variant_";
+
+	// command line switch for lighting the opaque objects per
+	// pixel through the geometry buffer instead of forward
+	const char* const DEFERRED_SWITCH = "-deferred";
+	// command line switch for lighting the scene with a sun and
+	// a spot light that cast shadows
+	const char* const SHADOWS_SWITCH = "-shadows";
+	// size of the shadow maps of the sun and the spot light
+	const int SUN_SHADOW_RESOLUTION = 2048;
+	const int SPOT_SHADOW_RESOLUTION = 1024;
+	// command line switch for the screen coverage in pixels
+	// below which the objects are lit per vertex, 0 lighting
+	// every object per fragment: -vertexlighting 400
+	const char* const VERTEX_LIGHTING_SWITCH = "-vertexlighting";
+	// command line switch for adding the transparent objects
+	// into the weighted blended transparency targets in any
+	// order, instead of blending them back to front
+	const char* const OIT_SWITCH = "-oit";
+	// command line switch for importing an OBJ, glTF or LOD
+	// model and placing it in front of the scene objects:
+	// -model input.obj
+	const char* const MODEL_SWITCH = "-model";
+	// tag and position of the imported model
+	const char* const IMPORTED_MODEL_TAG = "importedModel";
+	const glm::vec3 IMPORTED_MODEL_POSITION = glm::vec3(0.0f, 0.0f, 4.0f);
+
+	// number of frames rendered for each render benchmark case
+	const int RENDER_BENCHMARK_FRAMES = 100;
+
 	// Main GLFW window
 	GLFWwindow* g_Window = nullptr;
 
@@ -36,6 +112,20 @@ namespace
 	SceneManager* g_SceneManager = nullptr;
 	// shader manager object for dynamic interaction with the shader code
 	ShaderManager* g_ShaderManager = nullptr;
+	// shader manager object for the depth only pre-pass shader
+	ShaderManager* g_DepthShaderManager = nullptr;
+	// specialized variants of the scene shader
+	ShaderVariants* g_ShaderVariants = nullptr;
+	// linked variant programs kept between launches
+	ProgramBinaryCache* g_ProgramBinaryCache = nullptr;
+	// geometry buffer and lighting shaders of the deferred path
+	ShaderManager* g_GeometryShaderManager = nullptr;
+	ShaderManager* g_DeferredLightShaderManager = nullptr;
+	DeferredRenderer* g_DeferredRenderer = nullptr;
+	// composite shader and targets of the order independent
+	// transparency pass
+	ShaderManager* g_OITCompositeShaderManager = nullptr;
+	TransparencyRenderer* g_TransparencyRenderer = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
 }
@@ -44,6 +134,13 @@ namespace
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+bool HasSwitch(int argc, char* argv[], const char* name);
+const char* GetSwitchValue(int argc, char* argv[], const char* name);
+void RunBenchmarks();
+void RunRenderBenchmark();
+double TimeFrames(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position, int frames);
+void UpdateWindowTitle();
+void ReportPickedObject();
 
 
 /***********************************************************
@@ -54,6 +151,19 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// the CPU benchmarks do not need a window or OpenGL context
+	if ((argc > 1) && (strcmp(argv[1], BENCHMARK_SWITCH) == 0))
+	{
+		RunBenchmarks();
+		return(EXIT_SUCCESS);
+	}
+
+	// the offline simplification step does not need a window either
+	if ((argc > 3) && (strcmp(argv[1], SIMPLIFY_SWITCH) == 0))
+	{
+		return(MeshSimplifier::BakeLODFile(argv[2], argv[3]) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -81,10 +191,181 @@ int main(int argc, char* argv[])
 		"shaders/fragmentShader.glsl");
 	g_ShaderManager->use();
 
+	// load the depth only shader used by the depth pre-pass
+	g_DepthShaderManager = new ShaderManager();
+	g_DepthShaderManager->LoadShaders(
+		"shaders/depthVertexShader.glsl",
+		"shaders/depthFragmentShader.glsl");
+	g_ShaderManager->use();
+
+	// compile the scene shader into variants of only the features
+	// each object needs, the shader manager program is used
+	// when the sources cannot be read - the variants linked on
+	// an earlier launch are loaded from their binaries
+	g_ShaderVariants = new ShaderVariants();
+	if (g_ShaderVariants->LoadSources(
+		"shaders/vertexShader.glsl",
+		"shaders/fragmentShader.glsl") == false)
+	{
+		delete g_ShaderVariants;
+		g_ShaderVariants = NULL;
+	}
+	else
+	{
+		g_ProgramBinaryCache = new ProgramBinaryCache();
+		if (g_ProgramBinaryCache->Open(PROGRAM_CACHE_PREFIX) == true)
+		{
+			g_ShaderVariants->SetBinaryCache(g_ProgramBinaryCache);
+		}
+	}
+
+	// load the deferred path shaders when it is selected, or
+	// compared against forward shading by the render benchmark
+	const bool bDeferred = HasSwitch(argc, argv, DEFERRED_SWITCH);
+	if ((bDeferred == true) || (HasSwitch(argc, argv, RENDER_BENCHMARK_SWITCH) == true))
+	{
+		g_GeometryShaderManager = new ShaderManager();
+		g_GeometryShaderManager->LoadShaders(
+			"shaders/vertexShader.glsl",
+			"shaders/gBufferFragmentShader.glsl");
+		g_DeferredLightShaderManager = new ShaderManager();
+		g_DeferredLightShaderManager->LoadShaders(
+			"shaders/deferredLightVertexShader.glsl",
+			"shaders/deferredLightFragmentShader.glsl");
+		g_DeferredRenderer = new DeferredRenderer(g_GeometryShaderManager, g_DeferredLightShaderManager);
+		g_ShaderManager->use();
+	}
+
+	// load the order independent transparency composite shader
+	// when it is selected, or compared against sorted blending
+	// by the render benchmark
+	const bool bOrderIndependent = HasSwitch(argc, argv, OIT_SWITCH);
+	if ((bOrderIndependent == true) || (HasSwitch(argc, argv, RENDER_BENCHMARK_SWITCH) == true))
+	{
+		g_OITCompositeShaderManager = new ShaderManager();
+		g_OITCompositeShaderManager->LoadShaders(
+			"shaders/deferredLightVertexShader.glsl",
+			"shaders/oitCompositeFragmentShader.glsl");
+		g_TransparencyRenderer = new TransparencyRenderer(g_OITCompositeShaderManager);
+		g_ShaderManager->use();
+	}
+
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetShaderVariants(g_ShaderVariants);
+	g_SceneManager->SetDepthPrePassShader(g_DepthShaderManager);
+	g_SceneManager->SetDepthPrePass(HasSwitch(argc, argv, DEPTH_PREPASS_SWITCH));
+	g_SceneManager->SetDeferredRenderer(g_DeferredRenderer);
+	g_SceneManager->SetDeferredShading(bDeferred);
+	g_SceneManager->SetTransparencyRenderer(g_TransparencyRenderer);
+	g_SceneManager->SetOrderIndependentTransparency(bOrderIndependent);
 	g_SceneManager->PrepareScene();
 
+	// add the imported model to the scene objects, with levels
+	// of detail built for OBJ meshes
+	const char* modelFilename = GetSwitchValue(argc, argv, MODEL_SWITCH);
+	if ((modelFilename != NULL) &&
+		(g_SceneManager->LoadSceneModel(modelFilename, IMPORTED_MODEL_TAG, true) == true))
+	{
+		g_SceneManager->AddSceneModel(
+			IMPORTED_MODEL_TAG,
+			glm::vec3(1.0f),
+			0.0f,
+			0.0f,
+			0.0f,
+			IMPORTED_MODEL_POSITION,
+			"",
+			glm::vec2(1.0f),
+			glm::vec4(0.8f, 0.8f, 0.8f, 1.0f));
+	}
+
+	// bake the visible sets, the lightmap or the light probes
+	// of the static scene and exit
+	const char* bakePVSFilename = GetSwitchValue(argc, argv, BAKE_PVS_SWITCH);
+	const char* bakeLightmapFilename = GetSwitchValue(argc, argv, BAKE_LIGHTMAP_SWITCH);
+	const char* bakeProbesFilename = GetSwitchValue(argc, argv, BAKE_PROBES_SWITCH);
+	if ((bakePVSFilename != NULL) || (bakeLightmapFilename != NULL) || (bakeProbesFilename != NULL))
+	{
+		bool bBaked = true;
+		if (bakePVSFilename != NULL)
+		{
+			bBaked = g_SceneManager->BakeVisibleSets(bakePVSFilename) && bBaked;
+		}
+		if (bakeLightmapFilename != NULL)
+		{
+			bBaked = g_SceneManager->BakeLightmaps(bakeLightmapFilename) && bBaked;
+		}
+		if (bakeProbesFilename != NULL)
+		{
+			bBaked = g_SceneManager->BakeLightProbes(bakeProbesFilename) && bBaked;
+		}
+		delete g_SceneManager;
+		delete g_ShaderVariants;
+		delete g_ProgramBinaryCache;
+		delete g_DeferredRenderer;
+		delete g_GeometryShaderManager;
+		delete g_DeferredLightShaderManager;
+		delete g_TransparencyRenderer;
+		delete g_OITCompositeShaderManager;
+		delete g_DepthShaderManager;
+		delete g_ViewManager;
+		delete g_ShaderManager;
+		return(bBaked ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// draw with previously baked visible sets
+	const char* PVSFilename = GetSwitchValue(argc, argv, PVS_SWITCH);
+	if (PVSFilename != NULL)
+	{
+		g_SceneManager->LoadVisibleSets(PVSFilename);
+	}
+
+	// draw the static objects with a previously baked lightmap
+	const char* lightmapFilename = GetSwitchValue(argc, argv, LIGHTMAP_SWITCH);
+	if (lightmapFilename != NULL)
+	{
+		g_SceneManager->LoadLightmaps(lightmapFilename);
+	}
+
+	// light the scene with previously baked light probes
+	const char* probesFilename = GetSwitchValue(argc, argv, PROBES_SWITCH);
+	if (probesFilename != NULL)
+	{
+		g_SceneManager->LoadLightProbes(probesFilename);
+	}
+
+	// light the objects covering fewer pixels per vertex
+	const char* vertexLightingPixels = GetSwitchValue(argc, argv, VERTEX_LIGHTING_SWITCH);
+	if (vertexLightingPixels != NULL)
+	{
+		g_SceneManager->SetVertexLightingThreshold((float)atof(vertexLightingPixels));
+	}
+
+	// the sun and spot light shadows are drawn from depth maps
+	// that keep the static objects between frames
+	if (HasSwitch(argc, argv, SHADOWS_SWITCH) == true)
+	{
+		g_SceneManager->SetDirectionalLight(
+			glm::vec3(-0.4f, -1.0f, -0.3f),
+			glm::vec3(0.8f, 0.8f, 0.75f),
+			SUN_SHADOW_RESOLUTION);
+		g_SceneManager->SetSpotLight(
+			glm::vec3(4.0f, 8.0f, 6.0f),
+			glm::vec3(-0.4f, -1.0f, -0.6f),
+			20.0f,
+			30.0f,
+			20.0f,
+			glm::vec3(1.0f, 0.9f, 0.8f),
+			SPOT_SHADOW_RESOLUTION);
+	}
+
+	// time the rendering passes instead of opening the scene
+	if (HasSwitch(argc, argv, RENDER_BENCHMARK_SWITCH) == true)
+	{
+		RunRenderBenchmark();
+		glfwSetWindowShouldClose(g_Window, GL_TRUE);
+	}
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
@@ -99,9 +380,20 @@ int main(int argc, char* argv[])
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
 
+		// pass the camera of this frame to the scene for culling
+		g_SceneManager->SetViewParameters(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetCameraPosition());
+
+		// print the scene object under the cursor when clicked
+		ReportPickedObject();
+
 		// refresh the 3D scene
 		g_SceneManager->RenderScene();
 
+		// show the culling results of this frame in the title bar
+		UpdateWindowTitle();
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
@@ -121,6 +413,46 @@ int main(int argc, char* argv[])
 		delete g_ViewManager;
 		g_ViewManager = NULL;
 	}
+	if (NULL != g_ShaderVariants)
+	{
+		delete g_ShaderVariants;
+		g_ShaderVariants = NULL;
+	}
+	if (NULL != g_ProgramBinaryCache)
+	{
+		delete g_ProgramBinaryCache;
+		g_ProgramBinaryCache = NULL;
+	}
+	if (NULL != g_DeferredRenderer)
+	{
+		delete g_DeferredRenderer;
+		g_DeferredRenderer = NULL;
+	}
+	if (NULL != g_GeometryShaderManager)
+	{
+		delete g_GeometryShaderManager;
+		g_GeometryShaderManager = NULL;
+	}
+	if (NULL != g_DeferredLightShaderManager)
+	{
+		delete g_DeferredLightShaderManager;
+		g_DeferredLightShaderManager = NULL;
+	}
+	if (NULL != g_TransparencyRenderer)
+	{
+		delete g_TransparencyRenderer;
+		g_TransparencyRenderer = NULL;
+	}
+	if (NULL != g_OITCompositeShaderManager)
+	{
+		delete g_OITCompositeShaderManager;
+		g_OITCompositeShaderManager = NULL;
+	}
+	if (NULL != g_DepthShaderManager)
+	{
+		delete g_DepthShaderManager;
+		g_DepthShaderManager = NULL;
+	}
 	if (NULL != g_ShaderManager)
 	{
 		delete g_ShaderManager;
@@ -183,4 +515,487 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *	HasSwitch()
+ *
+ *  This function is used to check whether a command line
+ *  switch was passed in when the application was launched.
+ ***********************************************************/
+bool HasSwitch(int argc, char* argv[], const char* name)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *	GetSwitchValue()
+ *
+ *  This function is used to get the argument following a
+ *  command line switch - returns NULL when the switch was
+ *  not passed in or has no argument.
+ ***********************************************************/
+const char* GetSwitchValue(int argc, char* argv[], const char* name)
+{
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return(argv[i + 1]);
+		}
+	}
+	return(NULL);
+}
+
+/***********************************************************
+ *	RunBenchmarks()
+ *
+ *  This function is used to run the CPU side benchmarks
+ *  when the application is launched with -benchmark.
+ ***********************************************************/
+void RunBenchmarks()
+{
+	ShapeGenerator::RunGenerationBenchmark();
+	BoundingVolumeHierarchy::RunBenchmark();
+	OcclusionCuller::RunBenchmark();
+	SceneGraph::RunBenchmark();
+	LightClusters::RunBenchmark();
+	ObjectLightLists::RunBenchmark();
+	LightmapBaker::RunBenchmark();
+}
+
+/***********************************************************
+ *	RunRenderBenchmark()
+ *
+ *  This function is used to time the rendering of the scene
+ *  from fixed cameras - blended in the defined order, split
+ *  into sorted opaque and transparent passes, and with the
+ *  depth pre-pass - when the application is launched with
+ *  -renderbenchmark.
+ *  The GPU time and the number of shaded samples of each
+ *  case are printed, followed by the GPU time of the front
+ *  view lit by growing numbers of point lights, with the
+ *  lights listed per view cluster and per object, written
+ *  into the fixed point light array while they fit, and with
+ *  the deferred path.  The per object lists also print the
+ *  average number of lights of each drawn object.
+ *  The front view is then timed with a shadow casting sun
+ *  and spot light and a moving object, with the static
+ *  shadow depth drawn every frame and cached, then a wide
+ *  shot with the small objects lit per vertex under growing
+ *  screen coverages, and last both views with the
+ *  transparent objects sorted and blended in any order.
+ *  The compiled shader variants are listed at the end.
+ ***********************************************************/
+void RunRenderBenchmark()
+{
+	struct BENCHMARK_VIEW
+	{
+		const char* name;
+		glm::vec3 position;
+		glm::vec3 target;
+	};
+	// the side view looks through the ring stacker into the
+	// bead maze, where the most surfaces overlap
+	const BENCHMARK_VIEW views[] =
+	{
+		{ "front", glm::vec3(0.0f, 2.0f, 12.0f), glm::vec3(0.0f, 2.0f, 0.0f) },
+		{ "side", glm::vec3(15.0f, 3.0f, -3.5f), glm::vec3(0.0f, 1.0f, -3.5f) }
+	};
+
+	int windowWidth = 0;
+	int windowHeight = 0;
+	glfwGetWindowSize(g_Window, &windowWidth, &windowHeight);
+	glm::mat4 projection = glm::perspective(
+		glm::radians(45.0f),
+		(float)windowWidth / (float)std::max(windowHeight, 1),
+		0.1f, 100.0f);
+
+	g_SceneManager->SetShadedSampleCounting(true);
+
+	std::cout << "INFO: render benchmark, " << RENDER_BENCHMARK_FRAMES << " frames per case" << std::endl;
+	std::cout << "view    passes     GPU ms/frame   shaded samples" << std::endl;
+
+	const char* const modeNames[] = { "defined", "sorted", "pre-pass" };
+
+	for (size_t v = 0; v < sizeof(views) / sizeof(views[0]); v++)
+	{
+		glm::mat4 view = glm::lookAt(views[v].position, views[v].target, glm::vec3(0.0f, 1.0f, 0.0f));
+
+		for (int mode = 0; mode < 3; mode++)
+		{
+			g_SceneManager->SetObjectSorting(mode > 0);
+			g_SceneManager->SetDepthPrePass(mode == 2);
+
+			const double milliseconds = TimeFrames(view, projection, views[v].position, RENDER_BENCHMARK_FRAMES);
+
+			char line[128];
+			snprintf(
+				line,
+				sizeof(line),
+				"%-7s %-10s %12.3f %16llu",
+				views[v].name,
+				modeNames[mode],
+				milliseconds,
+				(unsigned long long)g_SceneManager->GetShadedSampleCount());
+			std::cout << line << std::endl;
+		}
+	}
+
+	// random lights over the scene, with the same placement
+	// in every run
+	const int lightCounts[] = { 0, 4, 16, 64, 256, 1024 };
+	std::mt19937 generator(330);
+	std::uniform_real_distribution<float> spreadX(-15.0f, 15.0f);
+	std::uniform_real_distribution<float> spreadY(0.2f, 6.0f);
+	std::uniform_real_distribution<float> spreadZ(-8.0f, 8.0f);
+	std::uniform_real_distribution<float> intensity(0.2f, 1.0f);
+	glm::mat4 lightView = glm::lookAt(views[0].position, views[0].target, glm::vec3(0.0f, 1.0f, 0.0f));
+
+	const char* const pathNames[] = { "clustered", "per-object", "fixed", "deferred" };
+	const SceneManager::LIGHT_ASSIGNMENT pathAssignments[] = {
+		SceneManager::LIGHTS_PER_CLUSTER,
+		SceneManager::LIGHTS_PER_OBJECT,
+		SceneManager::LIGHTS_FIXED,
+		SceneManager::LIGHTS_PER_CLUSTER };
+
+	g_SceneManager->SetObjectSorting(true);
+	g_SceneManager->SetDepthPrePass(false);
+	std::cout << "lights  path        GPU ms/frame  lights/object  light passes" << std::endl;
+	for (size_t c = 0; c < sizeof(lightCounts) / sizeof(lightCounts[0]); c++)
+	{
+		g_SceneManager->ClearPointLights();
+		for (int i = 0; i < lightCounts[c]; i++)
+		{
+			g_SceneManager->AddPointLight(
+				glm::vec3(spreadX(generator), spreadY(generator), spreadZ(generator)),
+				3.0f,
+				glm::vec3(intensity(generator), intensity(generator), intensity(generator)) * 4.0f);
+		}
+
+		for (int path = 0; path < 4; path++)
+		{
+			// the fixed array only holds the first few lights
+			if (((path == 2) && (lightCounts[c] > ShaderVariants::MAX_POINT_LIGHTS)) ||
+				((path == 3) && (NULL == g_DeferredRenderer)))
+			{
+				continue;
+			}
+			g_SceneManager->SetLightAssignment(pathAssignments[path]);
+			g_SceneManager->SetDeferredShading(path == 3);
+
+			const double milliseconds = TimeFrames(lightView, projection, views[0].position, RENDER_BENCHMARK_FRAMES);
+
+			char line[128];
+			snprintf(
+				line,
+				sizeof(line),
+				"%6d  %-10s %13.3f %14.2f %13d",
+				lightCounts[c],
+				pathNames[path],
+				milliseconds,
+				g_SceneManager->GetAverageObjectLightCount(),
+				(path == 3) ? g_DeferredRenderer->GetLightPassCount() : 0);
+			std::cout << line << std::endl;
+		}
+	}
+	g_SceneManager->ClearPointLights();
+	g_SceneManager->SetLightAssignment(SceneManager::LIGHTS_PER_CLUSTER);
+	g_SceneManager->SetDeferredShading(false);
+
+	// a sun and a spot light casting shadows, with the object in
+	// the middle of the front view moving every frame - the
+	// static depth is either drawn again every frame, or cached
+	// with only the moving object drawn over it
+	float pickDistance = 100.0f;
+	const int movingObject = g_SceneManager->PickSceneObject(
+		views[0].position,
+		glm::normalize(views[0].target - views[0].position),
+		pickDistance);
+	int movingNode = -1;
+	glm::vec3 movingPosition = glm::vec3(0.0f);
+	if (movingObject >= 0)
+	{
+		movingNode = g_SceneManager->GetSceneObject(movingObject).node;
+		movingPosition = g_SceneManager->GetSceneObject(movingObject).positionXYZ;
+		g_SceneManager->SetSceneObjectDynamic(movingObject, true);
+	}
+	g_SceneManager->SetDirectionalLight(glm::vec3(-0.4f, -1.0f, -0.3f), glm::vec3(0.8f), SUN_SHADOW_RESOLUTION);
+	g_SceneManager->SetSpotLight(
+		glm::vec3(4.0f, 8.0f, 6.0f),
+		glm::vec3(-0.4f, -1.0f, -0.6f),
+		20.0f,
+		30.0f,
+		20.0f,
+		glm::vec3(1.0f),
+		SPOT_SHADOW_RESOLUTION);
+
+	const char* const shadowNames[] = { "uncached", "cached" };
+	std::cout << "shadows    GPU ms/frame  caster draws/frame" << std::endl;
+	for (int cached = 0; cached < 2; cached++)
+	{
+		g_SceneManager->SetShadowCaching(cached == 1);
+
+		double totalMilliseconds = 0.0;
+		long long casterDraws = 0;
+		for (int frame = 0; frame < RENDER_BENCHMARK_FRAMES; frame++)
+		{
+			if (movingNode >= 0)
+			{
+				g_SceneManager->SetSceneNodePosition(
+					movingNode,
+					movingPosition + glm::vec3(0.0f, 0.25f * std::sin((float)frame * 0.2f), 0.0f));
+			}
+			totalMilliseconds += TimeFrames(lightView, projection, views[0].position, 1);
+			casterDraws += g_SceneManager->GetShadowCasterDrawCount();
+		}
+
+		char line[128];
+		snprintf(
+			line,
+			sizeof(line),
+			"%-9s %13.3f %19.2f",
+			shadowNames[cached],
+			totalMilliseconds / RENDER_BENCHMARK_FRAMES,
+			(double)casterDraws / RENDER_BENCHMARK_FRAMES);
+		std::cout << line << std::endl;
+	}
+	if (movingNode >= 0)
+	{
+		g_SceneManager->SetSceneNodePosition(movingNode, movingPosition);
+		g_SceneManager->SetSceneObjectDynamic(movingObject, false);
+	}
+	g_SceneManager->ClearSceneLights();
+	g_SceneManager->SetShadowCaching(true);
+
+	// a wide shot from far behind the front view, lit by the
+	// sun and point lights listed per object, with the objects
+	// under increasing screen coverages lit per vertex
+	const float vertexLightingThresholds[] = { 0.0f, 400.0f, 4000.0f, 40000.0f };
+	glm::vec3 widePosition = glm::vec3(0.0f, 12.0f, 45.0f);
+	glm::mat4 wideView = glm::lookAt(widePosition, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	for (int i = 0; i < 64; i++)
+	{
+		g_SceneManager->AddPointLight(
+			glm::vec3(spreadX(generator), spreadY(generator), spreadZ(generator)),
+			3.0f,
+			glm::vec3(intensity(generator), intensity(generator), intensity(generator)) * 4.0f);
+	}
+	g_SceneManager->SetLightAssignment(SceneManager::LIGHTS_PER_OBJECT);
+	g_SceneManager->SetDirectionalLight(glm::vec3(-0.4f, -1.0f, -0.3f), glm::vec3(0.8f));
+
+	std::cout << "vertex lit below px  GPU ms/frame  vertex lit/drawn  shaded samples" << std::endl;
+	for (size_t t = 0; t < sizeof(vertexLightingThresholds) / sizeof(vertexLightingThresholds[0]); t++)
+	{
+		g_SceneManager->SetVertexLightingThreshold(vertexLightingThresholds[t]);
+
+		const double milliseconds = TimeFrames(wideView, projection, widePosition, RENDER_BENCHMARK_FRAMES);
+
+		char line[128];
+		snprintf(
+			line,
+			sizeof(line),
+			"%19.0f %13.3f %11d/%-5d %15llu",
+			vertexLightingThresholds[t],
+			milliseconds,
+			g_SceneManager->GetVertexLitObjectCount(),
+			g_SceneManager->GetDrawnObjectCount(),
+			(unsigned long long)g_SceneManager->GetShadedSampleCount());
+		std::cout << line << std::endl;
+	}
+	g_SceneManager->ClearPointLights();
+	g_SceneManager->ClearSceneLights();
+	g_SceneManager->SetLightAssignment(SceneManager::LIGHTS_PER_CLUSTER);
+	g_SceneManager->SetVertexLightingThreshold(vertexLightingThresholds[1]);
+
+	// the transparent objects of both views blended back to
+	// front, or added into the transparency targets grouped by
+	// shader variant and composited once
+	if (NULL != g_TransparencyRenderer)
+	{
+		const char* const transparencyNames[] = { "sorted", "weighted" };
+		std::cout << "view    transparency  GPU ms/frame   shaded samples" << std::endl;
+		for (size_t v = 0; v < sizeof(views) / sizeof(views[0]); v++)
+		{
+			glm::mat4 view = glm::lookAt(views[v].position, views[v].target, glm::vec3(0.0f, 1.0f, 0.0f));
+
+			for (int mode = 0; mode < 2; mode++)
+			{
+				g_SceneManager->SetOrderIndependentTransparency(mode == 1);
+
+				const double milliseconds = TimeFrames(view, projection, views[v].position, RENDER_BENCHMARK_FRAMES);
+
+				char line[128];
+				snprintf(
+					line,
+					sizeof(line),
+					"%-7s %-12s %13.3f %16llu",
+					views[v].name,
+					transparencyNames[mode],
+					milliseconds,
+					(unsigned long long)g_SceneManager->GetShadedSampleCount());
+				std::cout << line << std::endl;
+			}
+		}
+		g_SceneManager->SetOrderIndependentTransparency(false);
+	}
+
+	if (NULL != g_ShaderVariants)
+	{
+		g_ShaderVariants->ReportVariants();
+	}
+
+	g_SceneManager->SetShadedSampleCounting(false);
+	g_SceneManager->SetObjectSorting(true);
+	g_SceneManager->SetDepthPrePass(false);
+}
+
+/***********************************************************
+ *	TimeFrames()
+ *
+ *  This function is used to render the scene from a camera
+ *  for a number of frames, and returns the average GPU time
+ *  of a frame in milliseconds.
+ ***********************************************************/
+double TimeFrames(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position, int frames)
+{
+	GLuint timeQuery = 0;
+	glGenQueries(1, &timeQuery);
+
+	double totalMilliseconds = 0.0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		glEnable(GL_DEPTH_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		g_ShaderManager->use();
+		g_ShaderManager->setMat4Value("view", view);
+		g_ShaderManager->setMat4Value("projection", projection);
+		g_ShaderManager->setVec3Value("viewPosition", position);
+		g_SceneManager->SetViewParameters(view, projection, position);
+
+		glBeginQuery(GL_TIME_ELAPSED, timeQuery);
+		g_SceneManager->RenderScene();
+		glEndQuery(GL_TIME_ELAPSED);
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(timeQuery, GL_QUERY_RESULT, &nanoseconds);
+		totalMilliseconds += (double)nanoseconds / 1.0e6;
+
+		glfwSwapBuffers(g_Window);
+		glfwPollEvents();
+	}
+
+	glDeleteQueries(1, &timeQuery);
+	return(totalMilliseconds / std::max(frames, 1));
+}
+
+/***********************************************************
+ *	UpdateWindowTitle()
+ *
+ *  This function is used to show the number of drawn, culled,
+ *  occluded and too small scene objects in the window title.  The title is
+ *  only changed when the numbers change.
+ ***********************************************************/
+void UpdateWindowTitle()
+{
+	static int lastDrawnObjects = -1;
+	static int lastCulledObjects = -1;
+	static int lastOccludedObjects = -1;
+	static int lastSmallObjects = -1;
+
+	int drawnObjects = g_SceneManager->GetDrawnObjectCount();
+	int culledObjects = g_SceneManager->GetCulledObjectCount();
+	int occludedObjects = g_SceneManager->GetOccludedObjectCount();
+	int smallObjects = g_SceneManager->GetSmallObjectCount();
+
+	if ((drawnObjects != lastDrawnObjects) ||
+		(culledObjects != lastCulledObjects) ||
+		(occludedObjects != lastOccludedObjects) ||
+		(smallObjects != lastSmallObjects))
+	{
+		char title[256];
+		snprintf(
+			title,
+			sizeof(title),
+			"%s - drawn: %d culled: %d occluded: %d small: %d",
+			WINDOW_TITLE,
+			drawnObjects,
+			culledObjects,
+			occludedObjects,
+			smallObjects);
+		glfwSetWindowTitle(g_Window, title);
+
+		lastDrawnObjects = drawnObjects;
+		lastCulledObjects = culledObjects;
+		lastOccludedObjects = occludedObjects;
+		lastSmallObjects = smallObjects;
+	}
+}
+
+/***********************************************************
+ *	ReportPickedObject()
+ *
+ *  This function is used to print the scene object under
+ *  the cursor after a left click, along with its material
+ *  and world transformation.  The scale and the X, Y, Z
+ *  rotation are taken back out of the world matrix, which
+ *  applies them in that order.
+ ***********************************************************/
+void ReportPickedObject()
+{
+	glm::vec3 origin;
+	glm::vec3 direction;
+
+	if (g_ViewManager->GetPickRequest(origin, direction) == false)
+	{
+		return;
+	}
+
+	float distance = 1.0e30f;
+	int picked = g_SceneManager->PickSceneObject(origin, direction, distance);
+	if (picked < 0)
+	{
+		std::cout << "Picked nothing" << std::endl;
+		return;
+	}
+
+	const SceneManager::SCENE_OBJECT& object = g_SceneManager->GetSceneObject(picked);
+	const glm::mat4 world = g_SceneManager->GetSceneObjectWorldMatrix(picked);
+	const glm::vec3 scale = glm::vec3(
+		glm::length(glm::vec3(world[0])),
+		glm::length(glm::vec3(world[1])),
+		glm::length(glm::vec3(world[2])));
+	const glm::vec3 axisX = glm::vec3(world[0]) / scale.x;
+	const glm::vec3 axisY = glm::vec3(world[1]) / scale.y;
+	const glm::vec3 axisZ = glm::vec3(world[2]) / scale.z;
+	const glm::vec3 rotation = glm::degrees(glm::vec3(
+		std::atan2(-axisZ.y, axisZ.z),
+		std::asin(glm::clamp(axisZ.x, -1.0f, 1.0f)),
+		std::atan2(-axisY.x, axisX.x)));
+
+	char line[320];
+	snprintf(
+		line,
+		sizeof(line),
+		"Picked %s (%s %d) at distance %.2f - material: %s, texture: %s, position: (%.2f, %.2f, %.2f), "
+		"rotation: (%.1f, %.1f, %.1f), scale: (%.2f, %.2f, %.2f)",
+		object.name.c_str(),
+		SceneManager::GetSceneMeshName(object.mesh),
+		picked,
+		distance,
+		(object.materialTag.empty() == true) ? "none" : object.materialTag.c_str(),
+		(object.textureTag.empty() == true) ? "color" : object.textureTag.c_str(),
+		world[3].x, world[3].y, world[3].z,
+		rotation.x, rotation.y, rotation.z,
+		scale.x, scale.y, scale.z);
+	std::cout << line << std::endl;
+}
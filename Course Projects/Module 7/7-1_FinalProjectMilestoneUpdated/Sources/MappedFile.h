@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// read-only memory mapping of files on disk
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class maps a whole file into the address space of
+ *  the process, so that large model files can be parsed and
+ *  uploaded without reading them into separate buffers.
+ *  The operating system pages the data in on demand.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// map the file read-only - returns false on failure
+	bool Open(const char* filename);
+	// unmap the file and close its handles
+	void Close();
+
+	// first byte of the mapped file
+	const unsigned char* GetData() const;
+	// size of the mapped file in bytes
+	size_t GetSize() const;
+
+private:
+	// mapped file contents
+	const unsigned char* m_pData;
+	size_t m_size;
+
+#ifdef _WIN32
+	// Windows file and mapping handles
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#else
+	// POSIX file descriptor
+	int m_fileDescriptor;
+#endif
+
+	// copying would unmap the same view twice
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+};
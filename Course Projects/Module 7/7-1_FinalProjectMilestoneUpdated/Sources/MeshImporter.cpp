@@ -0,0 +1,1845 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.cpp
+// ============
+// import Wavefront OBJ and binary glTF 2.0 models from memory-mapped files
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshImporter.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// declaration of the local helpers
+namespace
+{
+	// target size of the slices of an OBJ file parsed by each task
+	const size_t OBJ_CHUNK_BYTES = 4 * 1024 * 1024;
+
+	// glTF binary container identifiers
+	const uint32_t GLB_MAGIC = 0x46546C67;		// "glTF"
+	const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;	// "JSON"
+	const uint32_t GLB_CHUNK_BIN = 0x004E4942;	// "BIN\0"
+	const int GLB_MAX_NODE_DEPTH = 64;
+	const int JSON_MAX_DEPTH = 64;
+
+	// exact powers of ten representable by a double
+	const double POWERS_OF_TEN[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	/***********************************************************
+	 *  OBJ parsing
+	 ***********************************************************/
+
+	// read position inside a slice of the mapped OBJ text
+	struct OBJ_TOKENIZER
+	{
+		const char* cursor;
+		const char* end;
+	};
+
+	// one corner of a face, as 0-based attribute indices
+	// (-1 when the attribute is not given)
+	struct OBJ_CORNER
+	{
+		int position;
+		int texCoord;
+		int normal;
+	};
+
+	// number of elements of each kind in a slice of the file
+	struct OBJ_COUNTS
+	{
+		size_t positions;
+		size_t texCoords;
+		size_t normals;
+		size_t faces;
+		size_t corners;
+		size_t triangles;
+	};
+
+	// a slice of the file ending on a line break, with its
+	// element counts and the first output element of each kind
+	struct OBJ_CHUNK
+	{
+		const char* begin;
+		const char* end;
+		OBJ_COUNTS counts;
+		OBJ_COUNTS bases;
+	};
+
+	// attribute and face data gathered from the whole file
+	struct OBJ_CONTENTS
+	{
+		std::vector<float> positions;
+		std::vector<float> texCoords;
+		std::vector<float> normals;
+		std::vector<OBJ_CORNER> corners;
+		std::vector<uint32_t> faceSizes;
+	};
+
+	inline bool IsSpace(char c)
+	{
+		return((c == ' ') || (c == '\t') || (c == '\r'));
+	}
+
+	inline bool IsDigit(char c)
+	{
+		return((c >= '0') && (c <= '9'));
+	}
+
+	inline void SkipSpaces(OBJ_TOKENIZER& tokenizer)
+	{
+		while ((tokenizer.cursor < tokenizer.end) && IsSpace(*tokenizer.cursor))
+		{
+			tokenizer.cursor++;
+		}
+	}
+
+	inline void SkipLine(OBJ_TOKENIZER& tokenizer)
+	{
+		const void* lineEnd = memchr(tokenizer.cursor, '\n', tokenizer.end - tokenizer.cursor);
+		tokenizer.cursor = (lineEnd != nullptr) ? ((const char*)lineEnd + 1) : tokenizer.end;
+	}
+
+	inline bool AtLineEnd(const OBJ_TOKENIZER& tokenizer)
+	{
+		return((tokenizer.cursor >= tokenizer.end) ||
+			(*tokenizer.cursor == '\n') ||
+			(*tokenizer.cursor == '#'));
+	}
+
+	// true when the keyword at the cursor matches and is
+	// followed by white space, which is then skipped
+	inline bool MatchKeyword(OBJ_TOKENIZER& tokenizer, const char* keyword, size_t length)
+	{
+		if (((size_t)(tokenizer.end - tokenizer.cursor) <= length) ||
+			(memcmp(tokenizer.cursor, keyword, length) != 0) ||
+			(IsSpace(tokenizer.cursor[length]) == false))
+		{
+			return(false);
+		}
+		tokenizer.cursor += length;
+		SkipSpaces(tokenizer);
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseFloat()
+	 *
+	 *  Parse a decimal number in place.  The mapped text is not
+	 *  null terminated, so the C library parsers cannot be used
+	 *  without copying each token.
+	 ***********************************************************/
+	bool ParseFloat(OBJ_TOKENIZER& tokenizer, float& value)
+	{
+		const char* p = tokenizer.cursor;
+		const char* end = tokenizer.end;
+		bool bNegative = false;
+		bool bAnyDigits = false;
+		uint64_t mantissa = 0;
+		int significantDigits = 0;
+		int exponent = 0;
+
+		if ((p < end) && ((*p == '-') || (*p == '+')))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+
+		// integer part - digits beyond the precision of the
+		// mantissa only scale the value
+		while ((p < end) && IsDigit(*p))
+		{
+			if (significantDigits < 19)
+			{
+				mantissa = (mantissa * 10) + (uint64_t)(*p - '0');
+				significantDigits += (mantissa != 0) ? 1 : 0;
+			}
+			else
+			{
+				exponent++;
+			}
+			bAnyDigits = true;
+			p++;
+		}
+
+		// fractional part
+		if ((p < end) && (*p == '.'))
+		{
+			p++;
+			while ((p < end) && IsDigit(*p))
+			{
+				if (significantDigits < 19)
+				{
+					mantissa = (mantissa * 10) + (uint64_t)(*p - '0');
+					significantDigits += (mantissa != 0) ? 1 : 0;
+					exponent--;
+				}
+				bAnyDigits = true;
+				p++;
+			}
+		}
+
+		if (bAnyDigits == false)
+		{
+			return(false);
+		}
+
+		// exponent part
+		if ((p < end) && ((*p == 'e') || (*p == 'E')))
+		{
+			const char* exponentStart = p;
+			bool bNegativeExponent = false;
+			int exponentValue = 0;
+
+			p++;
+			if ((p < end) && ((*p == '-') || (*p == '+')))
+			{
+				bNegativeExponent = (*p == '-');
+				p++;
+			}
+			if ((p < end) && IsDigit(*p))
+			{
+				while ((p < end) && IsDigit(*p))
+				{
+					if (exponentValue < 10000)
+					{
+						exponentValue = (exponentValue * 10) + (*p - '0');
+					}
+					p++;
+				}
+				exponent += bNegativeExponent ? -exponentValue : exponentValue;
+			}
+			else
+			{
+				// not an exponent after all
+				p = exponentStart;
+			}
+		}
+
+		double result = 0.0;
+		if (mantissa != 0)
+		{
+			int scale = (exponent < 0) ? -exponent : exponent;
+			double power = (scale <= 22) ? POWERS_OF_TEN[scale] : std::pow(10.0, (double)scale);
+			result = (exponent < 0) ? ((double)mantissa / power) : ((double)mantissa * power);
+		}
+
+		value = (float)(bNegative ? -result : result);
+		tokenizer.cursor = p;
+		return(true);
+	}
+
+	// parse an optionally signed integer at the cursor
+	bool ParseInteger(OBJ_TOKENIZER& tokenizer, long long& value)
+	{
+		const char* p = tokenizer.cursor;
+		bool bNegative = false;
+		long long result = 0;
+
+		if ((p < tokenizer.end) && ((*p == '-') || (*p == '+')))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+		if ((p >= tokenizer.end) || (IsDigit(*p) == false))
+		{
+			return(false);
+		}
+		while ((p < tokenizer.end) && IsDigit(*p))
+		{
+			if (result < 0x7FFFFFFF)
+			{
+				result = (result * 10) + (*p - '0');
+			}
+			p++;
+		}
+
+		value = bNegative ? -result : result;
+		tokenizer.cursor = p;
+		return(true);
+	}
+
+	// convert a 1-based or negative relative OBJ index into a
+	// 0-based index, given the elements defined before the line
+	inline int ResolveIndex(long long index, size_t definedBefore)
+	{
+		if (index > 0)
+		{
+			return((int)(index - 1));
+		}
+		if ((index < 0) && ((size_t)(-index) <= definedBefore))
+		{
+			return((int)((long long)definedBefore + index));
+		}
+		return(-2);
+	}
+
+	// count the corners of the face at the cursor
+	size_t CountFaceCorners(OBJ_TOKENIZER tokenizer)
+	{
+		size_t corners = 0;
+
+		while (AtLineEnd(tokenizer) == false)
+		{
+			while ((AtLineEnd(tokenizer) == false) && (IsSpace(*tokenizer.cursor) == false))
+			{
+				tokenizer.cursor++;
+			}
+			SkipSpaces(tokenizer);
+			corners++;
+		}
+
+		return(corners);
+	}
+
+	/***********************************************************
+	 *  CountChunk()
+	 *
+	 *  First pass over a slice of the file, counting the
+	 *  elements so each slice knows where its output goes.
+	 ***********************************************************/
+	void CountChunk(OBJ_CHUNK& chunk)
+	{
+		OBJ_TOKENIZER tokenizer = { chunk.begin, chunk.end };
+		memset(&chunk.counts, 0, sizeof(chunk.counts));
+
+		while (tokenizer.cursor < tokenizer.end)
+		{
+			SkipSpaces(tokenizer);
+
+			if (MatchKeyword(tokenizer, "v", 1))
+			{
+				chunk.counts.positions++;
+			}
+			else if (MatchKeyword(tokenizer, "vt", 2))
+			{
+				chunk.counts.texCoords++;
+			}
+			else if (MatchKeyword(tokenizer, "vn", 2))
+			{
+				chunk.counts.normals++;
+			}
+			else if (MatchKeyword(tokenizer, "f", 1))
+			{
+				size_t corners = CountFaceCorners(tokenizer);
+				if (corners >= 3)
+				{
+					chunk.counts.faces++;
+					chunk.counts.corners += corners;
+					chunk.counts.triangles += corners - 2;
+				}
+			}
+			SkipLine(tokenizer);
+		}
+	}
+
+	/***********************************************************
+	 *  ParseChunk()
+	 *
+	 *  Second pass over a slice of the file, writing its
+	 *  attributes and face corners into the ranges reserved for
+	 *  it.  Returns false when the slice contains bad data.
+	 ***********************************************************/
+	bool ParseChunk(const OBJ_CHUNK& chunk, const OBJ_COUNTS& totals, OBJ_CONTENTS& contents)
+	{
+		OBJ_TOKENIZER tokenizer = { chunk.begin, chunk.end };
+		OBJ_COUNTS parsed = chunk.bases;
+
+		while (tokenizer.cursor < tokenizer.end)
+		{
+			SkipSpaces(tokenizer);
+
+			if (MatchKeyword(tokenizer, "v", 1))
+			{
+				float* out = &contents.positions[parsed.positions * 3];
+				for (int i = 0; i < 3; i++)
+				{
+					SkipSpaces(tokenizer);
+					if (ParseFloat(tokenizer, out[i]) == false)
+					{
+						return(false);
+					}
+				}
+				parsed.positions++;
+			}
+			else if (MatchKeyword(tokenizer, "vt", 2))
+			{
+				float* out = &contents.texCoords[parsed.texCoords * 2];
+				out[1] = 0.0f;
+				if (ParseFloat(tokenizer, out[0]) == false)
+				{
+					return(false);
+				}
+				SkipSpaces(tokenizer);
+				ParseFloat(tokenizer, out[1]);
+				parsed.texCoords++;
+			}
+			else if (MatchKeyword(tokenizer, "vn", 2))
+			{
+				float* out = &contents.normals[parsed.normals * 3];
+				for (int i = 0; i < 3; i++)
+				{
+					SkipSpaces(tokenizer);
+					if (ParseFloat(tokenizer, out[i]) == false)
+					{
+						return(false);
+					}
+				}
+				parsed.normals++;
+			}
+			else if (MatchKeyword(tokenizer, "f", 1))
+			{
+				size_t cornerCount = CountFaceCorners(tokenizer);
+				if (cornerCount >= 3)
+				{
+					OBJ_CORNER* out = &contents.corners[parsed.corners];
+					for (size_t i = 0; i < cornerCount; i++)
+					{
+						long long index = 0;
+
+						// position/texCoord/normal, with the last two optional
+						out[i].texCoord = -1;
+						out[i].normal = -1;
+						if (ParseInteger(tokenizer, index) == false)
+						{
+							return(false);
+						}
+						out[i].position = ResolveIndex(index, parsed.positions);
+						if ((tokenizer.cursor < tokenizer.end) && (*tokenizer.cursor == '/'))
+						{
+							tokenizer.cursor++;
+							if (ParseInteger(tokenizer, index))
+							{
+								out[i].texCoord = ResolveIndex(index, parsed.texCoords);
+							}
+							if ((tokenizer.cursor < tokenizer.end) && (*tokenizer.cursor == '/'))
+							{
+								tokenizer.cursor++;
+								if (ParseInteger(tokenizer, index))
+								{
+									out[i].normal = ResolveIndex(index, parsed.normals);
+								}
+							}
+						}
+
+						if ((out[i].position < 0) ||
+							((size_t)out[i].position >= totals.positions) ||
+							(out[i].texCoord < -1) ||
+							(out[i].texCoord >= (long long)totals.texCoords) ||
+							(out[i].normal < -1) ||
+							(out[i].normal >= (long long)totals.normals))
+						{
+							return(false);
+						}
+						SkipSpaces(tokenizer);
+					}
+					contents.faceSizes[parsed.faces] = (uint32_t)cornerCount;
+					parsed.faces++;
+					parsed.corners += cornerCount;
+				}
+			}
+			SkipLine(tokenizer);
+		}
+
+		return(true);
+	}
+
+	/***********************************************************
+	 *  glTF parsing
+	 ***********************************************************/
+
+	enum JSON_TYPE
+	{
+		JSON_NULL,
+		JSON_BOOLEAN,
+		JSON_NUMBER,
+		JSON_STRING,
+		JSON_ARRAY,
+		JSON_OBJECT
+	};
+
+	// one value of the parsed JSON chunk
+	struct JSON_VALUE
+	{
+		JSON_TYPE type;
+		double number;
+		// string contents, left in place inside the mapped file
+		const char* text;
+		size_t length;
+		// values of the array elements or object members
+		std::vector<int> children;
+		// names of the object members, parallel to children
+		std::vector<int> keys;
+	};
+
+	/***********************************************************
+	 *  JsonDocument
+	 *
+	 *  Minimal reader for the JSON chunk of a .glb file.  Values
+	 *  are referred to by index, and strings are not unescaped
+	 *  since glTF property names and enums are plain ASCII.
+	 ***********************************************************/
+	class JsonDocument
+	{
+	public:
+		bool Parse(const char* text, size_t length)
+		{
+			m_cursor = text;
+			m_end = text + length;
+			m_values.clear();
+			if (ParseValue(0) != 0)
+			{
+				return(false);
+			}
+			SkipWhitespace();
+			return(m_cursor == m_end);
+		}
+
+		int Root() const
+		{
+			return(0);
+		}
+
+		// value of the named object member, or -1
+		int Member(int object, const char* name) const
+		{
+			if ((object < 0) || (m_values[object].type != JSON_OBJECT))
+			{
+				return(-1);
+			}
+			size_t nameLength = strlen(name);
+			const JSON_VALUE& value = m_values[object];
+			for (size_t i = 0; i < value.keys.size(); i++)
+			{
+				const JSON_VALUE& key = m_values[value.keys[i]];
+				if ((key.length == nameLength) && (memcmp(key.text, name, nameLength) == 0))
+				{
+					return(value.children[i]);
+				}
+			}
+			return(-1);
+		}
+
+		// value of the array element, or -1
+		int Element(int array, int index) const
+		{
+			if ((array < 0) ||
+				(m_values[array].type != JSON_ARRAY) ||
+				(index < 0) ||
+				(index >= (int)m_values[array].children.size()))
+			{
+				return(-1);
+			}
+			return(m_values[array].children[index]);
+		}
+
+		// number of array elements, or 0
+		int Count(int array) const
+		{
+			if ((array < 0) || (m_values[array].type != JSON_ARRAY))
+			{
+				return(0);
+			}
+			return((int)m_values[array].children.size());
+		}
+
+		double Number(int value, double defaultValue) const
+		{
+			if ((value < 0) || (m_values[value].type != JSON_NUMBER))
+			{
+				return(defaultValue);
+			}
+			return(m_values[value].number);
+		}
+
+		bool IsString(int value, const char* text) const
+		{
+			if ((value < 0) || (m_values[value].type != JSON_STRING))
+			{
+				return(false);
+			}
+			size_t length = strlen(text);
+			return((m_values[value].length == length) &&
+				(memcmp(m_values[value].text, text, length) == 0));
+		}
+
+	private:
+		const char* m_cursor;
+		const char* m_end;
+		std::vector<JSON_VALUE> m_values;
+
+		void SkipWhitespace()
+		{
+			while ((m_cursor < m_end) &&
+				((*m_cursor == ' ') || (*m_cursor == '\t') || (*m_cursor == '\r') || (*m_cursor == '\n')))
+			{
+				m_cursor++;
+			}
+		}
+
+		int AddValue(JSON_TYPE type)
+		{
+			JSON_VALUE value;
+			value.type = type;
+			value.number = 0.0;
+			value.text = nullptr;
+			value.length = 0;
+			m_values.push_back(value);
+			return((int)m_values.size() - 1);
+		}
+
+		bool MatchLiteral(const char* literal)
+		{
+			size_t length = strlen(literal);
+			if (((size_t)(m_end - m_cursor) < length) || (memcmp(m_cursor, literal, length) != 0))
+			{
+				return(false);
+			}
+			m_cursor += length;
+			return(true);
+		}
+
+		int ParseString()
+		{
+			const char* start = ++m_cursor;
+			while ((m_cursor < m_end) && (*m_cursor != '"'))
+			{
+				m_cursor += (*m_cursor == '\\') ? 2 : 1;
+			}
+			if (m_cursor >= m_end)
+			{
+				return(-1);
+			}
+			int index = AddValue(JSON_STRING);
+			m_values[index].text = start;
+			m_values[index].length = (size_t)(m_cursor - start);
+			m_cursor++;
+			return(index);
+		}
+
+		int ParseNumber()
+		{
+			// copy the token so strtod sees a terminated string
+			char buffer[64];
+			size_t length = 0;
+			while ((m_cursor < m_end) && (length < sizeof(buffer) - 1) &&
+				(IsDigit(*m_cursor) || (*m_cursor == '-') || (*m_cursor == '+') ||
+				(*m_cursor == '.') || (*m_cursor == 'e') || (*m_cursor == 'E')))
+			{
+				buffer[length++] = *m_cursor++;
+			}
+			buffer[length] = '\0';
+
+			char* parsedEnd = nullptr;
+			double number = strtod(buffer, &parsedEnd);
+			if ((length == 0) || (parsedEnd != buffer + length))
+			{
+				return(-1);
+			}
+			int index = AddValue(JSON_NUMBER);
+			m_values[index].number = number;
+			return(index);
+		}
+
+		int ParseValue(int depth)
+		{
+			SkipWhitespace();
+			if ((m_cursor >= m_end) || (depth > JSON_MAX_DEPTH))
+			{
+				return(-1);
+			}
+
+			char c = *m_cursor;
+			if ((c == '{') || (c == '['))
+			{
+				bool bObject = (c == '{');
+				char closing = bObject ? '}' : ']';
+				int index = AddValue(bObject ? JSON_OBJECT : JSON_ARRAY);
+
+				m_cursor++;
+				SkipWhitespace();
+				if ((m_cursor < m_end) && (*m_cursor == closing))
+				{
+					m_cursor++;
+					return(index);
+				}
+
+				while (true)
+				{
+					int key = -1;
+					if (bObject)
+					{
+						SkipWhitespace();
+						if ((m_cursor >= m_end) || (*m_cursor != '"') || ((key = ParseString()) < 0))
+						{
+							return(-1);
+						}
+						SkipWhitespace();
+						if ((m_cursor >= m_end) || (*m_cursor != ':'))
+						{
+							return(-1);
+						}
+						m_cursor++;
+					}
+
+					int child = ParseValue(depth + 1);
+					if (child < 0)
+					{
+						return(-1);
+					}
+					// the vector may have grown, so index it again
+					m_values[index].children.push_back(child);
+					if (bObject)
+					{
+						m_values[index].keys.push_back(key);
+					}
+
+					SkipWhitespace();
+					if (m_cursor >= m_end)
+					{
+						return(-1);
+					}
+					if (*m_cursor == ',')
+					{
+						m_cursor++;
+					}
+					else if (*m_cursor == closing)
+					{
+						m_cursor++;
+						return(index);
+					}
+					else
+					{
+						return(-1);
+					}
+				}
+			}
+			if (c == '"')
+			{
+				return(ParseString());
+			}
+			if (MatchLiteral("true") || MatchLiteral("false"))
+			{
+				int index = AddValue(JSON_BOOLEAN);
+				m_values[index].number = (c == 't') ? 1.0 : 0.0;
+				return(index);
+			}
+			if (MatchLiteral("null"))
+			{
+				return(AddValue(JSON_NULL));
+			}
+			return(ParseNumber());
+		}
+	};
+
+	// a validated bufferView of the binary chunk
+	struct GLB_BUFFER_VIEW
+	{
+		size_t byteOffset;
+		size_t byteLength;
+		size_t byteStride;
+	};
+
+	// a validated accessor into a bufferView
+	struct GLB_ACCESSOR
+	{
+		int bufferView;
+		size_t byteOffset;
+		GLenum componentType;
+		bool bNormalized;
+		size_t count;
+		int components;
+		int minMax;		// JSON index of the accessor, for min/max
+	};
+
+	// state shared while importing the primitives of a .glb
+	struct GLB_CONTEXT
+	{
+		JsonDocument json;
+		const unsigned char* binData;
+		size_t binLength;
+		std::vector<GLB_BUFFER_VIEW> views;
+		// OpenGL buffer of each bufferView, created on first use
+		std::vector<GLuint> viewBuffers;
+		// first primitive and primitive count of each glTF mesh
+		std::vector<int> meshFirstPrimitive;
+		std::vector<int> meshPrimitiveCount;
+	};
+
+	inline uint32_t ReadUint32(const unsigned char* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return(value);
+	}
+
+	inline size_t ComponentSize(GLenum componentType)
+	{
+		switch (componentType)
+		{
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE:
+			return(1);
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+			return(2);
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+			return(4);
+		default:
+			return(0);
+		}
+	}
+
+	/***********************************************************
+	 *  ReadAccessor()
+	 *
+	 *  Read an accessor and check that every element it
+	 *  addresses lies inside its bufferView.
+	 ***********************************************************/
+	bool ReadAccessor(const GLB_CONTEXT& context, int accessorIndex, GLB_ACCESSOR& accessor)
+	{
+		const JsonDocument& json = context.json;
+		int value = json.Element(json.Member(json.Root(), "accessors"), accessorIndex);
+		if ((value < 0) || (json.Member(value, "sparse") >= 0))
+		{
+			return(false);
+		}
+
+		int type = json.Member(value, "type");
+		accessor.components =
+			json.IsString(type, "SCALAR") ? 1 :
+			json.IsString(type, "VEC2") ? 2 :
+			json.IsString(type, "VEC3") ? 3 :
+			json.IsString(type, "VEC4") ? 4 : 0;
+		accessor.bufferView = (int)json.Number(json.Member(value, "bufferView"), -1.0);
+		accessor.byteOffset = (size_t)json.Number(json.Member(value, "byteOffset"), 0.0);
+		accessor.componentType = (GLenum)json.Number(json.Member(value, "componentType"), 0.0);
+		accessor.bNormalized = (json.Number(json.Member(value, "normalized"), 0.0) != 0.0);
+		accessor.count = (size_t)json.Number(json.Member(value, "count"), 0.0);
+		accessor.minMax = value;
+
+		size_t componentSize = ComponentSize(accessor.componentType);
+		if ((accessor.components == 0) ||
+			(componentSize == 0) ||
+			(accessor.bufferView < 0) ||
+			(accessor.bufferView >= (int)context.views.size()))
+		{
+			return(false);
+		}
+
+		const GLB_BUFFER_VIEW& view = context.views[accessor.bufferView];
+		size_t elementSize = componentSize * accessor.components;
+		size_t stride = (view.byteStride != 0) ? view.byteStride : elementSize;
+		if ((accessor.count > 0) &&
+			(accessor.byteOffset + (stride * (accessor.count - 1)) + elementSize > view.byteLength))
+		{
+			return(false);
+		}
+
+		return(true);
+	}
+
+	// OpenGL buffer holding the bufferView, uploaded straight
+	// from the mapped file the first time it is needed
+	GLuint GetViewBuffer(GLB_CONTEXT& context, int view, MeshImporter::IMPORTED_MODEL& model)
+	{
+		if (context.viewBuffers[view] == 0)
+		{
+			GLuint buffer = 0;
+			glGenBuffers(1, &buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glBufferData(
+				GL_ARRAY_BUFFER,
+				(GLsizeiptr)context.views[view].byteLength,
+				context.binData + context.views[view].byteOffset,
+				GL_STATIC_DRAW);
+			context.viewBuffers[view] = buffer;
+			model.buffers.push_back(buffer);
+		}
+		return(context.viewBuffers[view]);
+	}
+
+	// describe an accessor to OpenGL as a vertex attribute
+	void SetAttribute(
+		GLB_CONTEXT& context,
+		const GLB_ACCESSOR& accessor,
+		GLuint location,
+		MeshImporter::IMPORTED_MODEL& model)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, GetViewBuffer(context, accessor.bufferView, model));
+		glVertexAttribPointer(
+			location,
+			accessor.components,
+			accessor.componentType,
+			accessor.bNormalized ? GL_TRUE : GL_FALSE,
+			(GLsizei)context.views[accessor.bufferView].byteStride,
+			(void*)accessor.byteOffset);
+		glEnableVertexAttribArray(location);
+	}
+
+	/***********************************************************
+	 *  CreatePrimitive()
+	 *
+	 *  Create the vertex array object of one glTF primitive.
+	 *  Returns false when the primitive cannot be drawn.
+	 ***********************************************************/
+	bool CreatePrimitive(
+		GLB_CONTEXT& context,
+		int primitiveValue,
+		MeshImporter::IMPORTED_MODEL& model,
+		MeshImporter::IMPORTED_PRIMITIVE& primitive)
+	{
+		const JsonDocument& json = context.json;
+		int attributes = json.Member(primitiveValue, "attributes");
+		int positionIndex = (int)json.Number(json.Member(attributes, "POSITION"), -1.0);
+		int normalIndex = (int)json.Number(json.Member(attributes, "NORMAL"), -1.0);
+		int texCoordIndex = (int)json.Number(json.Member(attributes, "TEXCOORD_0"), -1.0);
+		int indicesIndex = (int)json.Number(json.Member(primitiveValue, "indices"), -1.0);
+		GLB_ACCESSOR position;
+		GLB_ACCESSOR normal;
+		GLB_ACCESSOR texCoord;
+		GLB_ACCESSOR indices;
+
+		// compressed primitives need a decoder
+		if (json.Member(json.Member(primitiveValue, "extensions"), "KHR_draco_mesh_compression") >= 0)
+		{
+			return(false);
+		}
+
+		if ((ReadAccessor(context, positionIndex, position) == false) ||
+			(position.components != 3) ||
+			(position.componentType != GL_FLOAT))
+		{
+			return(false);
+		}
+
+		primitive.mode = (GLenum)json.Number(json.Member(primitiveValue, "mode"), 4.0);
+		primitive.vertexCount = (GLsizei)position.count;
+		primitive.indexType = GL_NONE;
+		primitive.indexCount = 0;
+		primitive.indexOffset = 0;
+		primitive.bHasNormals =
+			ReadAccessor(context, normalIndex, normal) &&
+			(normal.components == 3) &&
+			(normal.count == position.count);
+		primitive.bHasTexCoords =
+			ReadAccessor(context, texCoordIndex, texCoord) &&
+			(texCoord.components == 2) &&
+			(texCoord.count == position.count);
+
+		if (primitive.mode > GL_TRIANGLE_FAN)
+		{
+			return(false);
+		}
+
+		if (indicesIndex >= 0)
+		{
+			if ((ReadAccessor(context, indicesIndex, indices) == false) ||
+				(indices.components != 1) ||
+				((indices.componentType != GL_UNSIGNED_BYTE) &&
+				(indices.componentType != GL_UNSIGNED_SHORT) &&
+				(indices.componentType != GL_UNSIGNED_INT)))
+			{
+				return(false);
+			}
+			primitive.indexType = indices.componentType;
+			primitive.indexCount = (GLsizei)indices.count;
+			primitive.indexOffset = indices.byteOffset;
+		}
+
+		// the model space bounds are required on positions
+		int minValue = json.Member(position.minMax, "min");
+		int maxValue = json.Member(position.minMax, "max");
+		for (int i = 0; i < 3; i++)
+		{
+			primitive.boundsMin[i] = (float)json.Number(json.Element(minValue, i), 0.0);
+			primitive.boundsMax[i] = (float)json.Number(json.Element(maxValue, i), 0.0);
+		}
+
+		glGenVertexArrays(1, &primitive.vao);
+		glBindVertexArray(primitive.vao);
+
+		SetAttribute(context, position, 0, model);
+		if (primitive.bHasNormals)
+		{
+			SetAttribute(context, normal, 1, model);
+		}
+		if (primitive.bHasTexCoords)
+		{
+			SetAttribute(context, texCoord, 2, model);
+		}
+		if (primitive.indexType != GL_NONE)
+		{
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GetViewBuffer(context, indices.bufferView, model));
+		}
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		return(true);
+	}
+
+	// get the primitives of a glTF mesh, creating them the
+	// first time the mesh is referenced
+	void GetMeshPrimitives(
+		GLB_CONTEXT& context,
+		int mesh,
+		MeshImporter::IMPORTED_MODEL& model,
+		int& firstPrimitive,
+		int& primitiveCount)
+	{
+		if (context.meshFirstPrimitive[mesh] < 0)
+		{
+			const JsonDocument& json = context.json;
+			int meshValue = json.Element(json.Member(json.Root(), "meshes"), mesh);
+			int primitives = json.Member(meshValue, "primitives");
+
+			context.meshFirstPrimitive[mesh] = (int)model.primitives.size();
+			for (int i = 0; i < json.Count(primitives); i++)
+			{
+				MeshImporter::IMPORTED_PRIMITIVE primitive;
+				if (CreatePrimitive(context, json.Element(primitives, i), model, primitive))
+				{
+					model.primitives.push_back(primitive);
+				}
+				else
+				{
+					std::cout << "Skipped unsupported glTF primitive " << i << " of mesh " << mesh << std::endl;
+				}
+			}
+			context.meshPrimitiveCount[mesh] = (int)model.primitives.size() - context.meshFirstPrimitive[mesh];
+		}
+
+		firstPrimitive = context.meshFirstPrimitive[mesh];
+		primitiveCount = context.meshPrimitiveCount[mesh];
+	}
+
+	// local transformation of a glTF node
+	glm::mat4 GetNodeTransform(const JsonDocument& json, int node)
+	{
+		glm::mat4 transform(1.0f);
+		int matrix = json.Member(node, "matrix");
+
+		if (json.Count(matrix) == 16)
+		{
+			// stored column major, like glm
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					transform[column][row] = (float)json.Number(json.Element(matrix, (column * 4) + row), 0.0);
+				}
+			}
+			return(transform);
+		}
+
+		int translation = json.Member(node, "translation");
+		int rotation = json.Member(node, "rotation");
+		int scale = json.Member(node, "scale");
+		float x = (float)json.Number(json.Element(rotation, 0), 0.0);
+		float y = (float)json.Number(json.Element(rotation, 1), 0.0);
+		float z = (float)json.Number(json.Element(rotation, 2), 0.0);
+		float w = (float)json.Number(json.Element(rotation, 3), 1.0);
+		glm::vec3 scaleXYZ(
+			(float)json.Number(json.Element(scale, 0), 1.0),
+			(float)json.Number(json.Element(scale, 1), 1.0),
+			(float)json.Number(json.Element(scale, 2), 1.0));
+
+		// translation * rotation * scale, with the rotation
+		// matrix built from the unit quaternion
+		transform[0] = glm::vec4(
+			(1.0f - 2.0f * (y * y + z * z)) * scaleXYZ.x,
+			(2.0f * (x * y + z * w)) * scaleXYZ.x,
+			(2.0f * (x * z - y * w)) * scaleXYZ.x,
+			0.0f);
+		transform[1] = glm::vec4(
+			(2.0f * (x * y - z * w)) * scaleXYZ.y,
+			(1.0f - 2.0f * (x * x + z * z)) * scaleXYZ.y,
+			(2.0f * (y * z + x * w)) * scaleXYZ.y,
+			0.0f);
+		transform[2] = glm::vec4(
+			(2.0f * (x * z + y * w)) * scaleXYZ.z,
+			(2.0f * (y * z - x * w)) * scaleXYZ.z,
+			(1.0f - 2.0f * (x * x + y * y)) * scaleXYZ.z,
+			0.0f);
+		transform[3] = glm::vec4(
+			(float)json.Number(json.Element(translation, 0), 0.0),
+			(float)json.Number(json.Element(translation, 1), 0.0),
+			(float)json.Number(json.Element(translation, 2), 0.0),
+			1.0f);
+
+		return(transform);
+	}
+
+	// add an instance of every primitive of the mesh
+	void AddMeshInstances(
+		GLB_CONTEXT& context,
+		int mesh,
+		const glm::mat4& transform,
+		MeshImporter::IMPORTED_MODEL& model)
+	{
+		int firstPrimitive = 0;
+		int primitiveCount = 0;
+
+		if ((mesh < 0) || (mesh >= (int)context.meshFirstPrimitive.size()))
+		{
+			return;
+		}
+
+		GetMeshPrimitives(context, mesh, model, firstPrimitive, primitiveCount);
+		for (int i = firstPrimitive; i < firstPrimitive + primitiveCount; i++)
+		{
+			MeshImporter::IMPORTED_INSTANCE instance;
+			instance.primitive = i;
+			instance.transform = transform;
+			model.instances.push_back(instance);
+		}
+	}
+
+	// walk a node hierarchy, instancing the meshes it holds
+	void AddNode(
+		GLB_CONTEXT& context,
+		int node,
+		const glm::mat4& parentTransform,
+		int depth,
+		MeshImporter::IMPORTED_MODEL& model)
+	{
+		const JsonDocument& json = context.json;
+		int nodeValue = json.Element(json.Member(json.Root(), "nodes"), node);
+
+		// the depth limit also stops cyclic hierarchies
+		if ((nodeValue < 0) || (depth > GLB_MAX_NODE_DEPTH))
+		{
+			return;
+		}
+
+		glm::mat4 transform = parentTransform * GetNodeTransform(json, nodeValue);
+		AddMeshInstances(context, (int)json.Number(json.Member(nodeValue, "mesh"), -1.0), transform, model);
+
+		int children = json.Member(nodeValue, "children");
+		for (int i = 0; i < json.Count(children); i++)
+		{
+			AddNode(context, (int)json.Number(json.Element(children, i), -1.0), transform, depth + 1, model);
+		}
+	}
+
+	// number of triangles drawn by a primitive
+	size_t CountTriangles(const MeshImporter::IMPORTED_PRIMITIVE& primitive)
+	{
+		size_t count = (primitive.indexType != GL_NONE) ? primitive.indexCount : primitive.vertexCount;
+
+		if (primitive.mode == GL_TRIANGLES)
+		{
+			return(count / 3);
+		}
+		if (((primitive.mode == GL_TRIANGLE_STRIP) || (primitive.mode == GL_TRIANGLE_FAN)) && (count >= 3))
+		{
+			return(count - 2);
+		}
+		return(0);
+	}
+
+	// bounding box of interleaved vertex positions
+	void ComputeBounds(
+		const float* vertices,
+		size_t vertexCount,
+		MeshImporter::IMPORTED_PRIMITIVE& primitive)
+	{
+		primitive.boundsMin = glm::vec3(vertices[0], vertices[1], vertices[2]);
+		primitive.boundsMax = primitive.boundsMin;
+		for (size_t i = 1; i < vertexCount; i++)
+		{
+			const float* vertex = vertices + (i * ShapeGenerator::FLOATS_PER_VERTEX);
+			glm::vec3 position(vertex[0], vertex[1], vertex[2]);
+			primitive.boundsMin = glm::min(primitive.boundsMin, position);
+			primitive.boundsMax = glm::max(primitive.boundsMax, position);
+		}
+	}
+
+	// grow the model bounds by the transformed primitive bounds
+	void AddInstanceBounds(
+		const MeshImporter::IMPORTED_PRIMITIVE& primitive,
+		const glm::mat4& transform,
+		MeshImporter::IMPORTED_MODEL& model,
+		bool bFirst)
+	{
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec4 point(
+				(corner & 1) ? primitive.boundsMax.x : primitive.boundsMin.x,
+				(corner & 2) ? primitive.boundsMax.y : primitive.boundsMin.y,
+				(corner & 4) ? primitive.boundsMax.z : primitive.boundsMin.z,
+				1.0f);
+			glm::vec4 transformed = transform * point;
+			glm::vec3 position(transformed.x, transformed.y, transformed.z);
+
+			if (bFirst && (corner == 0))
+			{
+				model.boundsMin = position;
+				model.boundsMax = position;
+			}
+			model.boundsMin = glm::min(model.boundsMin, position);
+			model.boundsMax = glm::max(model.boundsMax, position);
+		}
+	}
+}
+
+/***********************************************************
+ *  ImportModel()
+ *
+ *  This method is used for importing a model file into
+ *  OpenGL buffers.  The format is chosen by the extension.
+ ***********************************************************/
+bool MeshImporter::ImportModel(const char* filename, IMPORTED_MODEL& model, bool bBuildLODs)
+{
+	const char* extension = strrchr(filename, '.');
+	char lowerExtension[8] = { 0 };
+	bool bSuccess = false;
+
+	model.primitives.clear();
+	model.instances.clear();
+	model.buffers.clear();
+	model.boundsMin = glm::vec3(0.0f);
+	model.boundsMax = glm::vec3(0.0f);
+	model.triangleCount = 0;
+
+	for (int i = 0; (extension != nullptr) && (extension[i] != '\0') && (i < 7); i++)
+	{
+		lowerExtension[i] = (char)tolower((unsigned char)extension[i]);
+	}
+
+	if (strcmp(lowerExtension, ".obj") == 0)
+	{
+		bSuccess = ImportOBJ(filename, model, bBuildLODs);
+	}
+	else if (strcmp(lowerExtension, ".glb") == 0)
+	{
+		bSuccess = ImportGLB(filename, model);
+	}
+	else if (strcmp(lowerExtension, ".lod") == 0)
+	{
+		bSuccess = ImportLOD(filename, model);
+	}
+	else
+	{
+		std::cout << "Unsupported model format:" << filename << std::endl;
+	}
+
+	if (bSuccess == false)
+	{
+		DestroyModel(model);
+		return(false);
+	}
+
+	for (size_t i = 0; i < model.instances.size(); i++)
+	{
+		const IMPORTED_PRIMITIVE& primitive = model.primitives[model.instances[i].primitive];
+		AddInstanceBounds(primitive, model.instances[i].transform, model, i == 0);
+		model.triangleCount += CountTriangles(primitive);
+	}
+
+	std::cout << "Successfully imported model:" << filename
+		<< ", primitives:" << model.primitives.size()
+		<< ", triangles:" << model.triangleCount << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  LoadOBJ()
+ *
+ *  This method is used for parsing an OBJ file into
+ *  interleaved vertex and index data.  The mapped file is
+ *  split into slices on line breaks; a counting pass sizes
+ *  every output array exactly, and a parsing pass fills them
+ *  in parallel.  Corners sharing the same position, UV and
+ *  normal are then merged into single vertices, and polygons
+ *  are split into triangle fans.
+ ***********************************************************/
+bool MeshImporter::LoadOBJ(const char* filename, ShapeGenerator::MESH_DATA& mesh)
+{
+	MappedFile file;
+	std::vector<OBJ_CHUNK> chunks;
+	OBJ_COUNTS totals;
+	OBJ_CONTENTS contents;
+	ThreadPool* pThreadPool = ThreadPool::GetShared();
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	if (file.Open(filename) == false)
+	{
+		return(false);
+	}
+
+	// split the file into slices ending on line breaks
+	const char* text = (const char*)file.GetData();
+	const char* textEnd = text + file.GetSize();
+	const char* chunkBegin = text;
+	while (chunkBegin < textEnd)
+	{
+		OBJ_CHUNK chunk;
+		const char* chunkEnd = textEnd;
+		if ((size_t)(textEnd - chunkBegin) > OBJ_CHUNK_BYTES)
+		{
+			const void* lineEnd = memchr(chunkBegin + OBJ_CHUNK_BYTES, '\n', textEnd - (chunkBegin + OBJ_CHUNK_BYTES));
+			chunkEnd = (lineEnd != nullptr) ? ((const char*)lineEnd + 1) : textEnd;
+		}
+		chunk.begin = chunkBegin;
+		chunk.end = chunkEnd;
+		chunks.push_back(chunk);
+		chunkBegin = chunkEnd;
+	}
+
+	// count the elements of every slice
+	pThreadPool->ParallelFor((int)chunks.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			CountChunk(chunks[i]);
+		}
+	});
+
+	// the first output element of a slice is the total of
+	// the slices before it
+	memset(&totals, 0, sizeof(totals));
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		chunks[i].bases = totals;
+		totals.positions += chunks[i].counts.positions;
+		totals.texCoords += chunks[i].counts.texCoords;
+		totals.normals += chunks[i].counts.normals;
+		totals.faces += chunks[i].counts.faces;
+		totals.corners += chunks[i].counts.corners;
+		totals.triangles += chunks[i].counts.triangles;
+	}
+
+	if ((totals.positions == 0) || (totals.triangles == 0))
+	{
+		std::cout << "No triangles found in OBJ file:" << filename << std::endl;
+		return(false);
+	}
+	if ((totals.corners > 0x7FFFFFFF) || (totals.triangles * 3 > 0xFFFFFFFF))
+	{
+		std::cout << "OBJ file is too large to index:" << filename << std::endl;
+		return(false);
+	}
+
+	contents.positions.resize(totals.positions * 3);
+	contents.texCoords.resize(totals.texCoords * 2);
+	contents.normals.resize(totals.normals * 3);
+	contents.corners.resize(totals.corners);
+	contents.faceSizes.resize(totals.faces);
+
+	// parse every slice into its reserved ranges
+	std::atomic<bool> bValid(true);
+	pThreadPool->ParallelFor((int)chunks.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (ParseChunk(chunks[i], totals, contents) == false)
+			{
+				bValid = false;
+			}
+		}
+	});
+
+	if (bValid == false)
+	{
+		std::cout << "Malformed OBJ file:" << filename << std::endl;
+		return(false);
+	}
+
+	// merge identical corners into vertices - each position
+	// keeps a short list of the vertices that use it, and the
+	// corner position is replaced by the vertex index
+	std::vector<int> firstVertex(totals.positions, -1);
+	std::vector<int> nextVertex;
+	std::vector<OBJ_CORNER> vertexKeys;
+	vertexKeys.reserve(totals.positions);
+	nextVertex.reserve(totals.positions);
+	for (size_t i = 0; i < contents.corners.size(); i++)
+	{
+		OBJ_CORNER& corner = contents.corners[i];
+		int vertex = firstVertex[corner.position];
+
+		while ((vertex >= 0) &&
+			((vertexKeys[vertex].texCoord != corner.texCoord) || (vertexKeys[vertex].normal != corner.normal)))
+		{
+			vertex = nextVertex[vertex];
+		}
+		if (vertex < 0)
+		{
+			vertex = (int)vertexKeys.size();
+			vertexKeys.push_back(corner);
+			nextVertex.push_back(firstVertex[corner.position]);
+			firstVertex[corner.position] = vertex;
+		}
+		corner.position = vertex;
+	}
+	std::vector<int>().swap(firstVertex);
+	std::vector<int>().swap(nextVertex);
+
+	// split the polygons into triangle fans
+	mesh.indices.resize(totals.triangles * 3);
+	pThreadPool->ParallelFor((int)chunks.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			const OBJ_CORNER* corners = &contents.corners[chunks[i].bases.corners];
+			GLuint* out = mesh.indices.data() + (chunks[i].bases.triangles * 3);
+			for (size_t face = 0; face < chunks[i].counts.faces; face++)
+			{
+				uint32_t faceSize = contents.faceSizes[chunks[i].bases.faces + face];
+				for (uint32_t j = 1; j + 1 < faceSize; j++)
+				{
+					*out++ = (GLuint)corners[0].position;
+					*out++ = (GLuint)corners[j].position;
+					*out++ = (GLuint)corners[j + 1].position;
+				}
+				corners += faceSize;
+			}
+		}
+	});
+	std::vector<OBJ_CORNER>().swap(contents.corners);
+	std::vector<uint32_t>().swap(contents.faceSizes);
+
+	// vertices without a normal use the area weighted normal
+	// of the faces around their position
+	std::vector<float> smoothNormals;
+	bool bNeedsNormals = false;
+	for (size_t i = 0; (i < vertexKeys.size()) && (bNeedsNormals == false); i++)
+	{
+		bNeedsNormals = (vertexKeys[i].normal < 0);
+	}
+	if (bNeedsNormals)
+	{
+		smoothNormals.assign(totals.positions * 3, 0.0f);
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			int a = vertexKeys[mesh.indices[i]].position;
+			int b = vertexKeys[mesh.indices[i + 1]].position;
+			int c = vertexKeys[mesh.indices[i + 2]].position;
+			const float* pa = &contents.positions[(size_t)a * 3];
+			const float* pb = &contents.positions[(size_t)b * 3];
+			const float* pc = &contents.positions[(size_t)c * 3];
+			glm::vec3 faceNormal = glm::cross(
+				glm::vec3(pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]),
+				glm::vec3(pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2]));
+			for (int k = 0; k < 3; k++)
+			{
+				smoothNormals[(size_t)a * 3 + k] += faceNormal[k];
+				smoothNormals[(size_t)b * 3 + k] += faceNormal[k];
+				smoothNormals[(size_t)c * 3 + k] += faceNormal[k];
+			}
+		}
+	}
+
+	// gather the interleaved vertices
+	mesh.vertices.resize(vertexKeys.size() * ShapeGenerator::FLOATS_PER_VERTEX);
+	pThreadPool->ParallelFor((int)vertexKeys.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			const OBJ_CORNER& key = vertexKeys[i];
+			float* out = &mesh.vertices[(size_t)i * ShapeGenerator::FLOATS_PER_VERTEX];
+			const float* position = &contents.positions[(size_t)key.position * 3];
+
+			out[0] = position[0];
+			out[1] = position[1];
+			out[2] = position[2];
+
+			glm::vec3 normal(0.0f, 1.0f, 0.0f);
+			if (key.normal >= 0)
+			{
+				const float* source = &contents.normals[(size_t)key.normal * 3];
+				normal = glm::vec3(source[0], source[1], source[2]);
+			}
+			else
+			{
+				const float* source = &smoothNormals[(size_t)key.position * 3];
+				glm::vec3 sum(source[0], source[1], source[2]);
+				float length = glm::length(sum);
+				if (length > 0.0f)
+				{
+					normal = sum / length;
+				}
+			}
+			out[3] = normal.x;
+			out[4] = normal.y;
+			out[5] = normal.z;
+
+			if (key.texCoord >= 0)
+			{
+				out[6] = contents.texCoords[(size_t)key.texCoord * 2];
+				out[7] = contents.texCoords[((size_t)key.texCoord * 2) + 1];
+			}
+			else
+			{
+				out[6] = 0.0f;
+				out[7] = 0.0f;
+			}
+		}
+	}, 4096);
+
+	return(true);
+}
+
+/***********************************************************
+ *  ImportOBJ()
+ *
+ *  This method is used for importing an OBJ file as one
+ *  indexed primitive, optionally simplified into levels of
+ *  detail that share its vertices.  The CPU copy of the data
+ *  is freed as soon as it has been uploaded.
+ ***********************************************************/
+bool MeshImporter::ImportOBJ(const char* filename, IMPORTED_MODEL& model, bool bBuildLODs)
+{
+	ShapeGenerator::GL_MESH glMesh;
+	IMPORTED_PRIMITIVE primitive;
+	IMPORTED_INSTANCE instance;
+	bool bUploaded = false;
+
+	{
+		ShapeGenerator::MESH_DATA mesh;
+		if (LoadOBJ(filename, mesh) == false)
+		{
+			return(false);
+		}
+
+		ComputeBounds(
+			mesh.vertices.data(),
+			mesh.vertices.size() / ShapeGenerator::FLOATS_PER_VERTEX,
+			primitive);
+
+		if (bBuildLODs)
+		{
+			MeshSimplifier::LOD_CHAIN chain;
+			MeshSimplifier::BuildLODChain(mesh, chain);
+			primitive.lods = chain.levels;
+			bUploaded = ShapeGenerator::UploadMesh(
+				mesh.vertices.data(),
+				(int)(mesh.vertices.size() / ShapeGenerator::FLOATS_PER_VERTEX),
+				chain.indices.data(),
+				(int)chain.indices.size(),
+				glMesh);
+		}
+		else
+		{
+			bUploaded = ShapeGenerator::UploadMesh(mesh, glMesh);
+		}
+	}
+
+	if (bUploaded == false)
+	{
+		return(false);
+	}
+
+	primitive.vao = glMesh.vao;
+	primitive.mode = GL_TRIANGLES;
+	primitive.indexType = GL_UNSIGNED_INT;
+	primitive.indexCount = primitive.lods.empty() ? glMesh.nIndices : primitive.lods[0].indexCount;
+	primitive.vertexCount = glMesh.nVertices;
+	primitive.indexOffset = 0;
+	primitive.bHasNormals = true;
+	primitive.bHasTexCoords = true;
+	model.primitives.push_back(primitive);
+	model.buffers.push_back(glMesh.vbo);
+	model.buffers.push_back(glMesh.ebo);
+
+	instance.primitive = 0;
+	instance.transform = glm::mat4(1.0f);
+	model.instances.push_back(instance);
+
+	return(true);
+}
+
+/***********************************************************
+ *  ImportLOD()
+ *
+ *  This method is used for importing a mesh baked offline
+ *  by MeshSimplifier.  The vertices and the indices of all
+ *  the levels are uploaded straight from the mapped file.
+ ***********************************************************/
+bool MeshImporter::ImportLOD(const char* filename, IMPORTED_MODEL& model)
+{
+	MappedFile file;
+	MeshSimplifier::LOD_FILE_HEADER header;
+	ShapeGenerator::GL_MESH glMesh;
+	IMPORTED_PRIMITIVE primitive;
+	IMPORTED_INSTANCE instance;
+
+	if (file.Open(filename) == false)
+	{
+		return(false);
+	}
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	if (size >= sizeof(header))
+	{
+		memcpy(&header, data, sizeof(header));
+	}
+
+	size_t levelsOffset = sizeof(header);
+	size_t verticesOffset = levelsOffset + ((size_t)header.levelCount * sizeof(MeshSimplifier::LOD_LEVEL));
+	size_t indicesOffset = verticesOffset + ((size_t)header.vertexCount * ShapeGenerator::FLOATS_PER_VERTEX * sizeof(float));
+	if ((size < sizeof(header)) ||
+		(header.magic != MeshSimplifier::LOD_FILE_MAGIC) ||
+		(header.version != MeshSimplifier::LOD_FILE_VERSION) ||
+		(header.levelCount == 0) ||
+		(header.vertexCount == 0) ||
+		(indicesOffset + ((size_t)header.indexCount * sizeof(GLuint)) != size))
+	{
+		std::cout << "Not a valid LOD file:" << filename << std::endl;
+		return(false);
+	}
+
+	primitive.lods.resize(header.levelCount);
+	memcpy(primitive.lods.data(), data + levelsOffset, header.levelCount * sizeof(MeshSimplifier::LOD_LEVEL));
+	for (size_t i = 0; i < primitive.lods.size(); i++)
+	{
+		const MeshSimplifier::LOD_LEVEL& level = primitive.lods[i];
+		if ((level.firstIndex < 0) ||
+			(level.indexCount <= 0) ||
+			((size_t)level.firstIndex + (size_t)level.indexCount > header.indexCount))
+		{
+			std::cout << "Invalid level of detail in file:" << filename << std::endl;
+			return(false);
+		}
+	}
+
+	// the vertex and index layout matches the GPU buffers
+	const float* vertices = (const float*)(data + verticesOffset);
+	ComputeBounds(vertices, header.vertexCount, primitive);
+	if (ShapeGenerator::UploadMesh(
+		vertices,
+		(int)header.vertexCount,
+		(const GLuint*)(data + indicesOffset),
+		(int)header.indexCount,
+		glMesh) == false)
+	{
+		return(false);
+	}
+
+	primitive.vao = glMesh.vao;
+	primitive.mode = GL_TRIANGLES;
+	primitive.indexType = GL_UNSIGNED_INT;
+	primitive.indexCount = primitive.lods[0].indexCount;
+	primitive.vertexCount = glMesh.nVertices;
+	primitive.indexOffset = (size_t)primitive.lods[0].firstIndex * sizeof(GLuint);
+	primitive.bHasNormals = true;
+	primitive.bHasTexCoords = true;
+	model.primitives.push_back(primitive);
+	model.buffers.push_back(glMesh.vbo);
+	model.buffers.push_back(glMesh.ebo);
+
+	instance.primitive = 0;
+	instance.transform = glm::mat4(1.0f);
+	model.instances.push_back(instance);
+
+	return(true);
+}
+
+/***********************************************************
+ *  ImportGLB()
+ *
+ *  This method is used for importing a binary glTF 2.0 file.
+ *  Each bufferView used by a primitive is uploaded once,
+ *  straight from the mapped binary chunk, and the accessors
+ *  become vertex attribute pointers into those buffers.  The
+ *  nodes of the default scene place the mesh primitives.
+ ***********************************************************/
+bool MeshImporter::ImportGLB(const char* filename, IMPORTED_MODEL& model)
+{
+	MappedFile file;
+	GLB_CONTEXT context;
+
+	if (file.Open(filename) == false)
+	{
+		return(false);
+	}
+
+	// 12 byte header followed by the JSON chunk header
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	if ((size < 20) ||
+		(ReadUint32(data) != GLB_MAGIC) ||
+		(ReadUint32(data + 4) != 2) ||
+		(ReadUint32(data + 8) > size) ||
+		(ReadUint32(data + 16) != GLB_CHUNK_JSON))
+	{
+		std::cout << "Not a glTF 2.0 binary file:" << filename << std::endl;
+		return(false);
+	}
+	size = ReadUint32(data + 8);
+
+	size_t jsonLength = ReadUint32(data + 12);
+	if (20 + jsonLength > size)
+	{
+		std::cout << "Truncated glTF file:" << filename << std::endl;
+		return(false);
+	}
+
+	// the optional binary chunk follows the JSON chunk
+	context.binData = nullptr;
+	context.binLength = 0;
+	size_t binHeader = 20 + jsonLength;
+	if ((binHeader + 8 <= size) && (ReadUint32(data + binHeader + 4) == GLB_CHUNK_BIN))
+	{
+		context.binLength = ReadUint32(data + binHeader);
+		context.binData = data + binHeader + 8;
+		if (binHeader + 8 + context.binLength > size)
+		{
+			std::cout << "Truncated glTF file:" << filename << std::endl;
+			return(false);
+		}
+	}
+
+	if (context.json.Parse((const char*)data + 20, jsonLength) == false)
+	{
+		std::cout << "Malformed glTF JSON:" << filename << std::endl;
+		return(false);
+	}
+
+	const JsonDocument& json = context.json;
+	int root = json.Root();
+
+	// only the embedded binary buffer is supported
+	int buffers = json.Member(root, "buffers");
+	if ((json.Count(buffers) > 1) || (json.Member(json.Element(buffers, 0), "uri") >= 0))
+	{
+		std::cout << "glTF files with external buffers are not supported:" << filename << std::endl;
+		return(false);
+	}
+
+	int bufferViews = json.Member(root, "bufferViews");
+	for (int i = 0; i < json.Count(bufferViews); i++)
+	{
+		int value = json.Element(bufferViews, i);
+		GLB_BUFFER_VIEW view;
+		view.byteOffset = (size_t)json.Number(json.Member(value, "byteOffset"), 0.0);
+		view.byteLength = (size_t)json.Number(json.Member(value, "byteLength"), 0.0);
+		view.byteStride = (size_t)json.Number(json.Member(value, "byteStride"), 0.0);
+		if ((json.Number(json.Member(value, "buffer"), 0.0) != 0.0) ||
+			(view.byteOffset + view.byteLength > context.binLength))
+		{
+			std::cout << "Invalid glTF buffer view " << i << ":" << filename << std::endl;
+			return(false);
+		}
+		context.views.push_back(view);
+	}
+	context.viewBuffers.assign(context.views.size(), 0);
+
+	int meshCount = json.Count(json.Member(root, "meshes"));
+	context.meshFirstPrimitive.assign(meshCount, -1);
+	context.meshPrimitiveCount.assign(meshCount, 0);
+
+	int scenes = json.Member(root, "scenes");
+	int scene = json.Element(scenes, (int)json.Number(json.Member(root, "scene"), 0.0));
+	if (scene >= 0)
+	{
+		int nodes = json.Member(scene, "nodes");
+		for (int i = 0; i < json.Count(nodes); i++)
+		{
+			AddNode(context, (int)json.Number(json.Element(nodes, i), -1.0), glm::mat4(1.0f), 0, model);
+		}
+	}
+	else
+	{
+		// without a scene, every mesh is shown once unplaced
+		for (int i = 0; i < meshCount; i++)
+		{
+			AddMeshInstances(context, i, glm::mat4(1.0f), model);
+		}
+	}
+
+	if (model.instances.empty())
+	{
+		std::cout << "No drawable meshes found in glTF file:" << filename << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  DrawPrimitive()
+ *
+ *  This method is used for drawing one primitive of an
+ *  imported model.  The caller sets the model matrix.
+ ***********************************************************/
+void MeshImporter::DrawPrimitive(const IMPORTED_MODEL& model, int primitive, int lod)
+{
+	const IMPORTED_PRIMITIVE& current = model.primitives[primitive];
+	GLsizei indexCount = current.indexCount;
+	size_t indexOffset = current.indexOffset;
+
+	// the levels of detail are ranges of the same index buffer
+	if ((lod > 0) && (lod < (int)current.lods.size()))
+	{
+		indexCount = current.lods[lod].indexCount;
+		indexOffset = (size_t)current.lods[lod].firstIndex * sizeof(GLuint);
+	}
+
+	glBindVertexArray(current.vao);
+
+	// constant values stand in for the missing attributes
+	if (current.bHasNormals == false)
+	{
+		glVertexAttrib3f(1, 0.0f, 1.0f, 0.0f);
+	}
+	if (current.bHasTexCoords == false)
+	{
+		glVertexAttrib2f(2, 0.0f, 0.0f);
+	}
+
+	if (current.indexType != GL_NONE)
+	{
+		glDrawElements(current.mode, indexCount, current.indexType, (void*)indexOffset);
+	}
+	else
+	{
+		glDrawArrays(current.mode, 0, current.vertexCount);
+	}
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyModel()
+ *
+ *  This method is used for freeing the OpenGL objects of a
+ *  previously imported model.
+ ***********************************************************/
+void MeshImporter::DestroyModel(IMPORTED_MODEL& model)
+{
+	for (size_t i = 0; i < model.primitives.size(); i++)
+	{
+		glDeleteVertexArrays(1, &model.primitives[i].vao);
+	}
+	if (model.buffers.empty() == false)
+	{
+		glDeleteBuffers((GLsizei)model.buffers.size(), model.buffers.data());
+	}
+
+	model.primitives.clear();
+	model.instances.clear();
+	model.buffers.clear();
+	model.triangleCount = 0;
+}
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.h
+// ============
+// import Wavefront OBJ and binary glTF 2.0 models from memory-mapped files
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeGenerator.h"
+#include "MeshSimplifier.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  MeshImporter
+ *
+ *  This class loads model files into OpenGL buffers.  The
+ *  file is memory-mapped instead of read into a buffer.
+ *
+ *  OBJ text is parsed in place by a tokenizer that never
+ *  allocates per token, with the chunks of the file split
+ *  across the shared thread pool.  Binary glTF (.glb) buffer
+ *  views are uploaded directly from the mapping and the glTF
+ *  accessors are described to OpenGL as-is, so the vertex and
+ *  index data is never copied or converted on the CPU.
+ *
+ *  OBJ meshes can get a level of detail chain at load time,
+ *  and .lod files baked offline by MeshSimplifier are
+ *  uploaded straight from the mapping as well.
+ *
+ *  Imported vertices use the same attribute locations as the
+ *  generated meshes: position (0), normal (1), UV (2).
+ ***********************************************************/
+class MeshImporter
+{
+public:
+	// OpenGL state for drawing one glTF primitive or OBJ mesh
+	struct IMPORTED_PRIMITIVE
+	{
+		GLuint vao;
+		GLenum mode;
+		// GL_NONE when the primitive is not indexed
+		GLenum indexType;
+		GLsizei indexCount;
+		GLsizei vertexCount;
+		// byte offset of the first index in the index buffer
+		size_t indexOffset;
+		// missing attributes are replaced by constant values
+		bool bHasNormals;
+		bool bHasTexCoords;
+		// bounding box of the vertex positions
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// index ranges of the levels of detail, finest first,
+		// or empty when the primitive has a single level
+		std::vector<MeshSimplifier::LOD_LEVEL> lods;
+	};
+
+	// placement of a primitive within the model
+	struct IMPORTED_INSTANCE
+	{
+		int primitive;
+		glm::mat4 transform;
+	};
+
+	// all the OpenGL objects of an imported model file
+	struct IMPORTED_MODEL
+	{
+		std::vector<IMPORTED_PRIMITIVE> primitives;
+		std::vector<IMPORTED_INSTANCE> instances;
+		std::vector<GLuint> buffers;
+		// model space bounding box of all the instances
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		size_t triangleCount;
+	};
+
+	// import an .obj, .glb or .lod file, chosen by the file
+	// extension - OBJ meshes can build their levels of detail
+	static bool ImportModel(const char* filename, IMPORTED_MODEL& model, bool bBuildLODs = false);
+	// parse an .obj file into interleaved vertex and index data
+	static bool LoadOBJ(const char* filename, ShapeGenerator::MESH_DATA& mesh);
+	// draw one primitive of an imported model at a level of detail
+	static void DrawPrimitive(const IMPORTED_MODEL& model, int primitive, int lod = 0);
+	// free the OpenGL objects of an imported model
+	static void DestroyModel(IMPORTED_MODEL& model);
+
+private:
+	// import the mesh of an .obj file
+	static bool ImportOBJ(const char* filename, IMPORTED_MODEL& model, bool bBuildLODs);
+	// import a mesh and its levels of detail from a .lod file
+	static bool ImportLOD(const char* filename, IMPORTED_MODEL& model);
+	// import all the meshes of the default scene of a .glb file
+	static bool ImportGLB(const char* filename, IMPORTED_MODEL& model);
+};
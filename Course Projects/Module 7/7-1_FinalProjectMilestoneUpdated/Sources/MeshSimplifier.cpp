@@ -0,0 +1,864 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.cpp
+// ============
+// quadric error mesh simplification and level of detail chains
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshSimplifier.h"
+#include "MeshImporter.h"
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+
+// declaration of the local helpers
+namespace
+{
+	// weight of the planes that keep open edges in place,
+	// relative to the surface planes
+	const double OPEN_EDGE_WEIGHT = 10.0;
+	// merged vertices may not turn their normal further than
+	// this (minimum dot product between the two normals)
+	const float MIN_NORMAL_DOT = 0.25f;
+	// stop the chain when a level removes less than this
+	// fraction of the triangles of the previous level
+	const float MIN_LEVEL_REDUCTION = 0.1f;
+
+	// state of a position during a collapse pass
+	const unsigned char POSITION_FREE = 0;
+	const unsigned char POSITION_TOUCHED = 1;
+	const unsigned char POSITION_MOVED = 2;
+
+	// edge flags stored per triangle - bit k is set when the
+	// edge starting at corner k is open, and bit k + 3 when it
+	// is also a border
+	const unsigned char BORDER_EDGE_SHIFT = 3;
+
+	/***********************************************************
+	 *  QUADRIC
+	 *
+	 *  Sum of weighted squared distances to a set of planes,
+	 *  stored as the symmetric 3x3 matrix A, the vector b and
+	 *  the constant c of  p'Ap + 2b'p + c.
+	 ***********************************************************/
+	struct QUADRIC
+	{
+		double a00, a01, a02, a11, a12, a22;
+		double b0, b1, b2;
+		double c;
+		double weight;
+	};
+
+	inline void ClearQuadric(QUADRIC& q)
+	{
+		q.a00 = q.a01 = q.a02 = q.a11 = q.a12 = q.a22 = 0.0;
+		q.b0 = q.b1 = q.b2 = 0.0;
+		q.c = 0.0;
+		q.weight = 0.0;
+	}
+
+	inline void AddQuadric(QUADRIC& q, const QUADRIC& other)
+	{
+		q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02;
+		q.a11 += other.a11; q.a12 += other.a12; q.a22 += other.a22;
+		q.b0 += other.b0; q.b1 += other.b1; q.b2 += other.b2;
+		q.c += other.c;
+		q.weight += other.weight;
+	}
+
+	// add the plane through point with the unit normal
+	inline void AddPlane(QUADRIC& q, const glm::vec3& normal, const glm::vec3& point, double weight)
+	{
+		double nx = normal.x;
+		double ny = normal.y;
+		double nz = normal.z;
+		double d = -((nx * point.x) + (ny * point.y) + (nz * point.z));
+
+		q.a00 += weight * nx * nx; q.a01 += weight * nx * ny; q.a02 += weight * nx * nz;
+		q.a11 += weight * ny * ny; q.a12 += weight * ny * nz; q.a22 += weight * nz * nz;
+		q.b0 += weight * nx * d; q.b1 += weight * ny * d; q.b2 += weight * nz * d;
+		q.c += weight * d * d;
+		q.weight += weight;
+	}
+
+	inline double EvaluateQuadric(const QUADRIC& q, const glm::vec3& p)
+	{
+		double x = p.x;
+		double y = p.y;
+		double z = p.z;
+
+		return((q.a00 * x * x) + (2.0 * q.a01 * x * y) + (2.0 * q.a02 * x * z) +
+			(q.a11 * y * y) + (2.0 * q.a12 * y * z) + (q.a22 * z * z) +
+			(2.0 * ((q.b0 * x) + (q.b1 * y) + (q.b2 * z))) + q.c);
+	}
+
+	// a candidate edge collapse, moving the wedges of the
+	// position of "from" onto the position of "to"
+	struct COLLAPSE
+	{
+		GLuint from;
+		GLuint to;
+		bool bOpen;
+		float error;
+	};
+
+	/***********************************************************
+	 *  Simplifier
+	 *
+	 *  Simplification state of one mesh.  Vertices are called
+	 *  wedges here, and wedges with bitwise equal positions
+	 *  share one position and one quadric.  Each pass ranks all
+	 *  edges, then applies the cheapest collapses that do not
+	 *  touch each other, so successive calls keep refining the
+	 *  same index buffer for the next level of detail.
+	 ***********************************************************/
+	class Simplifier
+	{
+	public:
+		Simplifier(const ShapeGenerator::MESH_DATA& mesh);
+
+		// collapse edges until at most targetIndexCount indices
+		// remain, or until no collapse stays under maxError
+		void SimplifyTo(size_t targetIndexCount, float maxError);
+
+		const std::vector<GLuint>& GetIndices() const
+		{
+			return(m_indices);
+		}
+
+		float GetError() const
+		{
+			return(m_error);
+		}
+
+	private:
+		const ShapeGenerator::MESH_DATA& m_mesh;
+		std::vector<GLuint> m_indices;
+		// position of each wedge, and a circular list through
+		// the wedges sharing that position
+		std::vector<int> m_positionOf;
+		std::vector<int> m_nextWedge;
+		std::vector<glm::vec3> m_positions;
+		std::vector<QUADRIC> m_quadrics;
+		// triangles around each position
+		std::vector<int> m_adjacencyOffsets;
+		std::vector<int> m_adjacency;
+		std::vector<unsigned char> m_edgeFlags;
+		std::vector<unsigned char> m_positionOpen;
+		std::vector<unsigned char> m_positionState;
+		std::vector<int> m_wedgeRemap;
+		float m_error;
+
+		glm::vec3 GetNormal(GLuint wedge) const
+		{
+			const float* vertex = &m_mesh.vertices[(size_t)wedge * ShapeGenerator::FLOATS_PER_VERTEX];
+			return(glm::vec3(vertex[3], vertex[4], vertex[5]));
+		}
+
+		void BuildAdjacency();
+		void ClassifyEdges();
+		void ComputeQuadrics();
+		int FindWedgeTarget(int wedge, int toPosition) const;
+		bool EvaluateCollapse(GLuint from, GLuint to, bool bOpen, float& error) const;
+		void MarkCollapsed(int fromPosition, int toPosition);
+		void RemoveDegenerateTriangles();
+	};
+
+	/***********************************************************
+	 *  Simplifier()
+	 *
+	 *  Weld the wedges by position and build the initial
+	 *  quadrics from the triangles around every position.
+	 ***********************************************************/
+	Simplifier::Simplifier(const ShapeGenerator::MESH_DATA& mesh)
+		: m_mesh(mesh)
+	{
+		const float* vertices = mesh.vertices.data();
+		int wedgeCount = (int)(mesh.vertices.size() / ShapeGenerator::FLOATS_PER_VERTEX);
+		std::vector<int> order(wedgeCount);
+
+		m_error = 0.0f;
+
+		// sort the wedges so equal positions are adjacent
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [vertices](int a, int b)
+		{
+			const float* pa = vertices + ((size_t)a * ShapeGenerator::FLOATS_PER_VERTEX);
+			const float* pb = vertices + ((size_t)b * ShapeGenerator::FLOATS_PER_VERTEX);
+			if (pa[0] != pb[0]) return(pa[0] < pb[0]);
+			if (pa[1] != pb[1]) return(pa[1] < pb[1]);
+			return(pa[2] < pb[2]);
+		});
+
+		m_positionOf.resize(wedgeCount);
+		m_nextWedge.resize(wedgeCount);
+		for (int i = 0; i < wedgeCount; )
+		{
+			const float* first = vertices + ((size_t)order[i] * ShapeGenerator::FLOATS_PER_VERTEX);
+			int groupEnd = i + 1;
+			while (groupEnd < wedgeCount)
+			{
+				const float* next = vertices + ((size_t)order[groupEnd] * ShapeGenerator::FLOATS_PER_VERTEX);
+				if ((next[0] != first[0]) || (next[1] != first[1]) || (next[2] != first[2]))
+				{
+					break;
+				}
+				groupEnd++;
+			}
+
+			int position = (int)m_positions.size();
+			m_positions.push_back(glm::vec3(first[0], first[1], first[2]));
+			for (int j = i; j < groupEnd; j++)
+			{
+				m_positionOf[order[j]] = position;
+				m_nextWedge[order[j]] = order[(j + 1 < groupEnd) ? (j + 1) : i];
+			}
+			i = groupEnd;
+		}
+
+		m_indices = mesh.indices;
+		RemoveDegenerateTriangles();
+
+		m_positionState.assign(m_positions.size(), POSITION_FREE);
+		m_wedgeRemap.resize(wedgeCount);
+		std::iota(m_wedgeRemap.begin(), m_wedgeRemap.end(), 0);
+
+		BuildAdjacency();
+		ClassifyEdges();
+		ComputeQuadrics();
+	}
+
+	/***********************************************************
+	 *  BuildAdjacency()
+	 *
+	 *  List the triangles around each position.
+	 ***********************************************************/
+	void Simplifier::BuildAdjacency()
+	{
+		size_t positionCount = m_positions.size();
+
+		m_adjacencyOffsets.assign(positionCount + 1, 0);
+		for (size_t i = 0; i < m_indices.size(); i++)
+		{
+			m_adjacencyOffsets[m_positionOf[m_indices[i]] + 1]++;
+		}
+		for (size_t i = 0; i < positionCount; i++)
+		{
+			m_adjacencyOffsets[i + 1] += m_adjacencyOffsets[i];
+		}
+
+		std::vector<int> cursor(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+		m_adjacency.resize(m_indices.size());
+		for (size_t i = 0; i < m_indices.size(); i++)
+		{
+			m_adjacency[cursor[m_positionOf[m_indices[i]]]++] = (int)(i / 3);
+		}
+	}
+
+	/***********************************************************
+	 *  ClassifyEdges()
+	 *
+	 *  Flag the edges without a matching opposite edge between
+	 *  the same wedges (borders, UV seams and hard edges), and
+	 *  the edges without any opposite edge (borders).  Then
+	 *  flag the positions touching an open edge.
+	 ***********************************************************/
+	void Simplifier::ClassifyEdges()
+	{
+		int triangleCount = (int)(m_indices.size() / 3);
+
+		m_edgeFlags.resize(triangleCount);
+		ThreadPool::GetShared()->ParallelFor(triangleCount, [&](int begin, int end)
+		{
+			for (int t = begin; t < end; t++)
+			{
+				unsigned char flags = 0;
+				for (int k = 0; k < 3; k++)
+				{
+					GLuint a = m_indices[(t * 3) + k];
+					GLuint b = m_indices[(t * 3) + ((k + 1) % 3)];
+					int pa = m_positionOf[a];
+					int pb = m_positionOf[b];
+					bool bWedgeOpposite = false;
+					bool bPositionOpposite = false;
+
+					for (int i = m_adjacencyOffsets[pa]; i < m_adjacencyOffsets[pa + 1]; i++)
+					{
+						const GLuint* other = &m_indices[(size_t)m_adjacency[i] * 3];
+						for (int j = 0; j < 3; j++)
+						{
+							GLuint c = other[j];
+							GLuint d = other[(j + 1) % 3];
+							if ((m_positionOf[c] == pb) && (m_positionOf[d] == pa))
+							{
+								bPositionOpposite = true;
+								bWedgeOpposite = bWedgeOpposite || ((c == b) && (d == a));
+							}
+						}
+					}
+
+					if (bWedgeOpposite == false)
+					{
+						flags |= (unsigned char)(1 << k);
+					}
+					if (bPositionOpposite == false)
+					{
+						flags |= (unsigned char)(1 << (k + BORDER_EDGE_SHIFT));
+					}
+				}
+				m_edgeFlags[t] = flags;
+			}
+		}, 1024);
+
+		m_positionOpen.resize(m_positions.size());
+		ThreadPool::GetShared()->ParallelFor((int)m_positions.size(), [&](int begin, int end)
+		{
+			for (int p = begin; p < end; p++)
+			{
+				unsigned char bOpen = 0;
+				for (int i = m_adjacencyOffsets[p]; (i < m_adjacencyOffsets[p + 1]) && (bOpen == 0); i++)
+				{
+					int t = m_adjacency[i];
+					for (int k = 0; k < 3; k++)
+					{
+						bool bTouches =
+							(m_positionOf[m_indices[(t * 3) + k]] == p) ||
+							(m_positionOf[m_indices[(t * 3) + ((k + 1) % 3)]] == p);
+						if (bTouches && ((m_edgeFlags[t] & (1 << k)) != 0))
+						{
+							bOpen = 1;
+						}
+					}
+				}
+				m_positionOpen[p] = bOpen;
+			}
+		}, 1024);
+	}
+
+	/***********************************************************
+	 *  ComputeQuadrics()
+	 *
+	 *  Sum the area weighted planes of the triangles around
+	 *  each position, plus a plane perpendicular to each open
+	 *  edge so borders and seams resist moving.
+	 ***********************************************************/
+	void Simplifier::ComputeQuadrics()
+	{
+		m_quadrics.resize(m_positions.size());
+		ThreadPool::GetShared()->ParallelFor((int)m_positions.size(), [&](int begin, int end)
+		{
+			for (int p = begin; p < end; p++)
+			{
+				QUADRIC& q = m_quadrics[p];
+				ClearQuadric(q);
+
+				for (int i = m_adjacencyOffsets[p]; i < m_adjacencyOffsets[p + 1]; i++)
+				{
+					int t = m_adjacency[i];
+					glm::vec3 corners[3];
+					for (int k = 0; k < 3; k++)
+					{
+						corners[k] = m_positions[m_positionOf[m_indices[(t * 3) + k]]];
+					}
+
+					glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+					float doubleArea = glm::length(normal);
+					if (doubleArea <= 0.0f)
+					{
+						continue;
+					}
+					normal = normal / doubleArea;
+					AddPlane(q, normal, corners[0], 0.5 * doubleArea);
+
+					for (int k = 0; k < 3; k++)
+					{
+						int next = (k + 1) % 3;
+						bool bTouches =
+							(m_positionOf[m_indices[(t * 3) + k]] == p) ||
+							(m_positionOf[m_indices[(t * 3) + next]] == p);
+						if (bTouches && ((m_edgeFlags[t] & (1 << k)) != 0))
+						{
+							glm::vec3 edge = corners[next] - corners[k];
+							glm::vec3 edgeNormal = glm::cross(edge, normal);
+							float length = glm::length(edgeNormal);
+							if (length > 0.0f)
+							{
+								AddPlane(q, edgeNormal / length, corners[k], OPEN_EDGE_WEIGHT * glm::dot(edge, edge));
+							}
+						}
+					}
+				}
+			}
+		}, 1024);
+	}
+
+	/***********************************************************
+	 *  FindWedgeTarget()
+	 *
+	 *  Find the wedge at toPosition that shares a triangle edge
+	 *  with the passed in wedge.  Returns -1 when there is none,
+	 *  or -2 when the wedge is no longer used by any triangle.
+	 ***********************************************************/
+	int Simplifier::FindWedgeTarget(int wedge, int toPosition) const
+	{
+		int position = m_positionOf[wedge];
+		bool bUsed = false;
+
+		for (int i = m_adjacencyOffsets[position]; i < m_adjacencyOffsets[position + 1]; i++)
+		{
+			const GLuint* triangle = &m_indices[(size_t)m_adjacency[i] * 3];
+			for (int k = 0; k < 3; k++)
+			{
+				if ((int)triangle[k] == wedge)
+				{
+					GLuint next = triangle[(k + 1) % 3];
+					GLuint previous = triangle[(k + 2) % 3];
+					bUsed = true;
+					if (m_positionOf[next] == toPosition)
+					{
+						return((int)next);
+					}
+					if (m_positionOf[previous] == toPosition)
+					{
+						return((int)previous);
+					}
+				}
+			}
+		}
+
+		return(bUsed ? -1 : -2);
+	}
+
+	/***********************************************************
+	 *  EvaluateCollapse()
+	 *
+	 *  Check that the position of "from" can move onto the
+	 *  position of "to", and compute the resulting error.
+	 ***********************************************************/
+	bool Simplifier::EvaluateCollapse(GLuint from, GLuint to, bool bOpen, float& error) const
+	{
+		int pu = m_positionOf[from];
+		int pv = m_positionOf[to];
+
+		// positions on borders or seams only move along them
+		if ((m_positionOpen[pu] != 0) && (bOpen == false))
+		{
+			return(false);
+		}
+
+		// every wedge of the moving position must merge into a
+		// wedge of the target that it shares an edge with
+		int wedge = (int)from;
+		do
+		{
+			int target = FindWedgeTarget(wedge, pv);
+			if (target == -1)
+			{
+				return(false);
+			}
+			if ((target >= 0) && (glm::dot(GetNormal(wedge), GetNormal(target)) < MIN_NORMAL_DOT))
+			{
+				return(false);
+			}
+			wedge = m_nextWedge[wedge];
+		} while (wedge != (int)from);
+
+		// the remaining triangles around the moving position
+		// must not flip over
+		const glm::vec3& target = m_positions[pv];
+		for (int i = m_adjacencyOffsets[pu]; i < m_adjacencyOffsets[pu + 1]; i++)
+		{
+			const GLuint* triangle = &m_indices[(size_t)m_adjacency[i] * 3];
+			glm::vec3 before[3];
+			glm::vec3 after[3];
+			bool bRemoved = false;
+
+			for (int k = 0; k < 3; k++)
+			{
+				int position = m_positionOf[triangle[k]];
+				bRemoved = bRemoved || (position == pv);
+				before[k] = m_positions[position];
+				after[k] = (position == pu) ? target : before[k];
+			}
+			if (bRemoved)
+			{
+				continue;
+			}
+
+			glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+			if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+			{
+				return(false);
+			}
+		}
+
+		QUADRIC q = m_quadrics[pu];
+		AddQuadric(q, m_quadrics[pv]);
+		double cost = std::max(EvaluateQuadric(q, target), 0.0);
+		error = (q.weight > 0.0) ? (float)std::sqrt(cost / q.weight) : 0.0f;
+
+		return(true);
+	}
+
+	// mark the moved position, and keep the positions sharing
+	// a triangle with it from moving during the same pass, so
+	// every collapse was checked against unchanged triangles
+	void Simplifier::MarkCollapsed(int fromPosition, int toPosition)
+	{
+		for (int i = m_adjacencyOffsets[fromPosition]; i < m_adjacencyOffsets[fromPosition + 1]; i++)
+		{
+			const GLuint* triangle = &m_indices[(size_t)m_adjacency[i] * 3];
+			for (int k = 0; k < 3; k++)
+			{
+				int position = m_positionOf[triangle[k]];
+				m_positionState[position] = std::max(m_positionState[position], POSITION_TOUCHED);
+			}
+		}
+		m_positionState[toPosition] = std::max(m_positionState[toPosition], POSITION_TOUCHED);
+		m_positionState[fromPosition] = POSITION_MOVED;
+	}
+
+	// drop the triangles with two corners at the same position
+	void Simplifier::RemoveDegenerateTriangles()
+	{
+		size_t write = 0;
+		for (size_t i = 0; i + 2 < m_indices.size(); i += 3)
+		{
+			int a = m_positionOf[m_indices[i]];
+			int b = m_positionOf[m_indices[i + 1]];
+			int c = m_positionOf[m_indices[i + 2]];
+			if ((a != b) && (b != c) && (c != a))
+			{
+				m_indices[write] = m_indices[i];
+				m_indices[write + 1] = m_indices[i + 1];
+				m_indices[write + 2] = m_indices[i + 2];
+				write += 3;
+			}
+		}
+		m_indices.resize(write);
+	}
+
+	/***********************************************************
+	 *  SimplifyTo()
+	 *
+	 *  Run collapse passes until the target is reached.  The
+	 *  quadrics of merged positions are summed, so the error of
+	 *  later collapses includes the earlier ones.
+	 ***********************************************************/
+	void Simplifier::SimplifyTo(size_t targetIndexCount, float maxError)
+	{
+		ThreadPool* pThreadPool = ThreadPool::GetShared();
+		bool bFirstPass = true;
+
+		while (m_indices.size() > targetIndexCount)
+		{
+			// the constructor already prepared the first pass
+			if (bFirstPass == false)
+			{
+				BuildAdjacency();
+				ClassifyEdges();
+			}
+			bFirstPass = false;
+
+			// each interior edge once, from the triangle where
+			// it runs towards the higher position, and each
+			// border edge from its only triangle
+			std::vector<COLLAPSE> collapses;
+			collapses.reserve(m_indices.size() / 2);
+			for (size_t t = 0; t < m_indices.size() / 3; t++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					GLuint a = m_indices[(t * 3) + k];
+					GLuint b = m_indices[(t * 3) + ((k + 1) % 3)];
+					bool bBorder = (m_edgeFlags[t] & (1 << (k + BORDER_EDGE_SHIFT))) != 0;
+					if ((m_positionOf[a] < m_positionOf[b]) || bBorder)
+					{
+						COLLAPSE collapse;
+						collapse.from = a;
+						collapse.to = b;
+						collapse.bOpen = (m_edgeFlags[t] & (1 << k)) != 0;
+						collapse.error = FLT_MAX;
+						collapses.push_back(collapse);
+					}
+				}
+			}
+
+			// rank both directions of every edge in parallel
+			pThreadPool->ParallelFor((int)collapses.size(), [&](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+				{
+					COLLAPSE& collapse = collapses[i];
+					float forward = FLT_MAX;
+					float backward = FLT_MAX;
+
+					if (EvaluateCollapse(collapse.from, collapse.to, collapse.bOpen, forward) == false)
+					{
+						forward = FLT_MAX;
+					}
+					if (EvaluateCollapse(collapse.to, collapse.from, collapse.bOpen, backward) == false)
+					{
+						backward = FLT_MAX;
+					}
+					if (backward < forward)
+					{
+						std::swap(collapse.from, collapse.to);
+					}
+					collapse.error = std::min(forward, backward);
+				}
+			}, 1024);
+
+			// drop the invalid collapses before sorting the rest
+			collapses.erase(
+				std::remove_if(collapses.begin(), collapses.end(), [maxError](const COLLAPSE& collapse)
+				{
+					return((collapse.error == FLT_MAX) || (collapse.error > maxError));
+				}),
+				collapses.end());
+			std::sort(collapses.begin(), collapses.end(), [](const COLLAPSE& a, const COLLAPSE& b)
+			{
+				return(a.error < b.error);
+			});
+
+			// apply the cheapest collapses whose triangles were not
+			// changed by an earlier one - each removes about two
+			// triangles
+			size_t collapseGoal = ((m_indices.size() - targetIndexCount) / 6) + 1;
+			size_t applied = 0;
+			std::vector<int> remappedWedges;
+			std::fill(m_positionState.begin(), m_positionState.end(), POSITION_FREE);
+
+			for (size_t i = 0; (i < collapses.size()) && (applied < collapseGoal); i++)
+			{
+				const COLLAPSE& collapse = collapses[i];
+				int pu = m_positionOf[collapse.from];
+				int pv = m_positionOf[collapse.to];
+				if ((m_positionState[pu] != POSITION_FREE) || (m_positionState[pv] == POSITION_MOVED))
+				{
+					continue;
+				}
+
+				int wedge = (int)collapse.from;
+				do
+				{
+					int target = FindWedgeTarget(wedge, pv);
+					if (target >= 0)
+					{
+						m_wedgeRemap[wedge] = target;
+						remappedWedges.push_back(wedge);
+					}
+					wedge = m_nextWedge[wedge];
+				} while (wedge != (int)collapse.from);
+
+				AddQuadric(m_quadrics[pv], m_quadrics[pu]);
+				MarkCollapsed(pu, pv);
+				m_error = std::max(m_error, collapse.error);
+				applied++;
+			}
+
+			if (applied == 0)
+			{
+				break;
+			}
+
+			pThreadPool->ParallelFor((int)m_indices.size(), [&](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+				{
+					m_indices[i] = (GLuint)m_wedgeRemap[m_indices[i]];
+				}
+			}, 4096);
+			for (size_t i = 0; i < remappedWedges.size(); i++)
+			{
+				m_wedgeRemap[remappedWedges[i]] = remappedWedges[i];
+			}
+
+			RemoveDegenerateTriangles();
+		}
+	}
+}
+
+/***********************************************************
+ *  Simplify()
+ *
+ *  This method is used for simplifying a mesh to a single
+ *  reduced index buffer.
+ ***********************************************************/
+float MeshSimplifier::Simplify(
+	const ShapeGenerator::MESH_DATA& mesh,
+	size_t targetIndexCount,
+	float maxError,
+	std::vector<GLuint>& result)
+{
+	Simplifier simplifier(mesh);
+
+	simplifier.SimplifyTo(targetIndexCount, maxError);
+	result = simplifier.GetIndices();
+
+	return(simplifier.GetError());
+}
+
+/***********************************************************
+ *  BuildLODChain()
+ *
+ *  This method is used for building the levels of detail of
+ *  a mesh.  One simplifier keeps refining the same indices,
+ *  and a copy is stored each time the next target is met,
+ *  so the error of every level is measured against the
+ *  original surface.
+ ***********************************************************/
+void MeshSimplifier::BuildLODChain(
+	const ShapeGenerator::MESH_DATA& mesh,
+	LOD_CHAIN& chain,
+	int maxLevels,
+	float reduction)
+{
+	LOD_LEVEL level;
+
+	chain.indices = mesh.indices;
+	chain.levels.clear();
+
+	level.firstIndex = 0;
+	level.indexCount = (GLsizei)mesh.indices.size();
+	level.error = 0.0f;
+	chain.levels.push_back(level);
+
+	if ((maxLevels <= 1) || (mesh.indices.empty()))
+	{
+		return;
+	}
+
+	Simplifier simplifier(mesh);
+	while ((int)chain.levels.size() < maxLevels)
+	{
+		size_t previousCount = (size_t)chain.levels.back().indexCount;
+		size_t target = ((size_t)(previousCount * reduction) / 3) * 3;
+
+		simplifier.SimplifyTo(target, FLT_MAX);
+
+		const std::vector<GLuint>& indices = simplifier.GetIndices();
+		if ((indices.empty()) ||
+			(indices.size() > (size_t)(previousCount * (1.0f - MIN_LEVEL_REDUCTION))))
+		{
+			break;
+		}
+
+		level.firstIndex = (GLsizei)chain.indices.size();
+		level.indexCount = (GLsizei)indices.size();
+		level.error = simplifier.GetError();
+		chain.indices.insert(chain.indices.end(), indices.begin(), indices.end());
+		chain.levels.push_back(level);
+	}
+}
+
+/***********************************************************
+ *  SelectLOD()
+ *
+ *  This method is used for choosing the level to draw.  The
+ *  error of each level is projected to the screen, and the
+ *  coarsest level that stays under the limit wins.
+ ***********************************************************/
+int MeshSimplifier::SelectLOD(
+	const std::vector<LOD_LEVEL>& levels,
+	float pixelsPerUnit,
+	float maxPixelError)
+{
+	int selected = 0;
+
+	for (int i = 1; i < (int)levels.size(); i++)
+	{
+		if (levels[i].error * pixelsPerUnit > maxPixelError)
+		{
+			break;
+		}
+		selected = i;
+	}
+
+	return(selected);
+}
+
+/***********************************************************
+ *  SaveLODFile()
+ *
+ *  This method is used for writing a mesh and its levels in
+ *  the layout MeshImporter uploads straight from the mapped
+ *  file.
+ ***********************************************************/
+bool MeshSimplifier::SaveLODFile(
+	const char* filename,
+	const ShapeGenerator::MESH_DATA& mesh,
+	const LOD_CHAIN& chain)
+{
+	LOD_FILE_HEADER header;
+	FILE* file = fopen(filename, "wb");
+
+	if (file == nullptr)
+	{
+		std::cout << "Could not create file:" << filename << std::endl;
+		return(false);
+	}
+
+	header.magic = LOD_FILE_MAGIC;
+	header.version = LOD_FILE_VERSION;
+	header.vertexCount = (uint32_t)(mesh.vertices.size() / ShapeGenerator::FLOATS_PER_VERTEX);
+	header.indexCount = (uint32_t)chain.indices.size();
+	header.levelCount = (uint32_t)chain.levels.size();
+
+	bool bSuccess =
+		(fwrite(&header, sizeof(header), 1, file) == 1) &&
+		(fwrite(chain.levels.data(), sizeof(LOD_LEVEL), chain.levels.size(), file) == chain.levels.size()) &&
+		(fwrite(mesh.vertices.data(), sizeof(float), mesh.vertices.size(), file) == mesh.vertices.size()) &&
+		(fwrite(chain.indices.data(), sizeof(GLuint), chain.indices.size(), file) == chain.indices.size());
+	bSuccess = (fclose(file) == 0) && bSuccess;
+
+	if (bSuccess == false)
+	{
+		std::cout << "Could not write file:" << filename << std::endl;
+	}
+
+	return(bSuccess);
+}
+
+/***********************************************************
+ *  BakeLODFile()
+ *
+ *  This method is used for the offline simplification step,
+ *  converting an .obj file into a .lod file with its levels
+ *  of detail already built.
+ ***********************************************************/
+bool MeshSimplifier::BakeLODFile(const char* inputFilename, const char* outputFilename)
+{
+	ShapeGenerator::MESH_DATA mesh;
+	LOD_CHAIN chain;
+
+	if (MeshImporter::LoadOBJ(inputFilename, mesh) == false)
+	{
+		return(false);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	BuildLODChain(mesh, chain);
+	auto stop = std::chrono::high_resolution_clock::now();
+	double elapsed = std::chrono::duration<double, std::milli>(stop - start).count();
+
+	std::cout << "INFO: Simplified " << inputFilename << " in " << elapsed << " ms" << std::endl;
+	for (size_t i = 0; i < chain.levels.size(); i++)
+	{
+		std::cout << "  LOD " << i
+			<< "  triangles:" << (chain.levels[i].indexCount / 3)
+			<< "  error:" << chain.levels[i].error << std::endl;
+	}
+
+	return(SaveLODFile(outputFilename, mesh, chain));
+}
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.h
+// ============
+// quadric error mesh simplification and level of detail chains
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeGenerator.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  MeshSimplifier
+ *
+ *  This class reduces the triangle count of indexed meshes
+ *  with the quadric error metric of Garland and Heckbert.
+ *  Edges are collapsed onto one of their existing vertices,
+ *  so every level of detail reuses the vertex buffer of the
+ *  original mesh and only needs its own range of indices.
+ *
+ *  Vertices sharing a position but not a UV or normal (seams
+ *  and hard edges) may only move along the seam, together
+ *  with all their copies, and open borders only collapse
+ *  along the border.  Each pass evaluates the candidate
+ *  collapses on the shared thread pool.
+ ***********************************************************/
+class MeshSimplifier
+{
+public:
+	// one level of detail inside a shared index buffer
+	struct LOD_LEVEL
+	{
+		GLsizei firstIndex;
+		GLsizei indexCount;
+		// object space distance from the original surface
+		float error;
+	};
+
+	// index ranges of every level, finest first
+	struct LOD_CHAIN
+	{
+		std::vector<GLuint> indices;
+		std::vector<LOD_LEVEL> levels;
+	};
+
+	// header of a baked level of detail file, followed by the
+	// levels, the interleaved vertices and the indices
+	struct LOD_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t levelCount;
+	};
+
+	static const uint32_t LOD_FILE_MAGIC = 0x31444F4C;	// "LOD1"
+	static const uint32_t LOD_FILE_VERSION = 1;
+
+	// simplify the mesh until at most targetIndexCount indices
+	// remain, or no collapse stays under maxError - returns
+	// the error of the result
+	static float Simplify(
+		const ShapeGenerator::MESH_DATA& mesh,
+		size_t targetIndexCount,
+		float maxError,
+		std::vector<GLuint>& result);
+
+	// build a chain of levels, each with about reduction times
+	// the triangles of the previous one
+	static void BuildLODChain(
+		const ShapeGenerator::MESH_DATA& mesh,
+		LOD_CHAIN& chain,
+		int maxLevels = 8,
+		float reduction = 0.5f);
+
+	// pick the coarsest level whose error covers at most
+	// maxPixelError pixels at the given pixels per unit
+	static int SelectLOD(
+		const std::vector<LOD_LEVEL>& levels,
+		float pixelsPerUnit,
+		float maxPixelError);
+
+	// write the mesh and its levels to a .lod file
+	static bool SaveLODFile(
+		const char* filename,
+		const ShapeGenerator::MESH_DATA& mesh,
+		const LOD_CHAIN& chain);
+
+	// offline step - convert an .obj file into a .lod file
+	static bool BakeLODFile(const char* inputFilename, const char* outputFilename);
+};
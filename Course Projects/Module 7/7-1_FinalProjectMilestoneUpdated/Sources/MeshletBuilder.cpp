@@ -0,0 +1,381 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshletbuilder.cpp
+// ============
+// split meshes into small triangle clusters that can be culled on the CPU
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// normal cones wider than this (minimum dot product between
+	// the axis and any triangle normal) are never back-face culled
+	const float MIN_CONE_DOT = 0.05f;
+
+	/***********************************************************
+	 *  GetPosition()
+	 *
+	 *  Read the position of a vertex from the interleaved data.
+	 ***********************************************************/
+	inline glm::vec3 GetPosition(const std::vector<float>& vertices, GLuint index)
+	{
+		const float* vertex = &vertices[(size_t)index * ShapeGenerator::FLOATS_PER_VERTEX];
+		return(glm::vec3(vertex[0], vertex[1], vertex[2]));
+	}
+
+	/***********************************************************
+	 *  ComputeMeshletBounds()
+	 *
+	 *  Calculate the bounding sphere and the normal cone of the
+	 *  triangles in the passed in index range.
+	 ***********************************************************/
+	void ComputeMeshletBounds(
+		const std::vector<float>& vertices,
+		const GLuint* indices,
+		MeshletBuilder::MESHLET& meshlet)
+	{
+		const int triangleCount = (int)meshlet.indexCount / 3;
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normalSum(0.0f);
+
+		for (GLuint i = 0; i < meshlet.indexCount; i++)
+		{
+			centroid += GetPosition(vertices, indices[i]);
+		}
+		centroid /= (float)meshlet.indexCount;
+
+		float radiusSquared = 0.0f;
+		for (GLuint i = 0; i < meshlet.indexCount; i++)
+		{
+			glm::vec3 offset = GetPosition(vertices, indices[i]) - centroid;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		meshlet.center = centroid;
+		meshlet.radius = std::sqrt(radiusSquared);
+
+		// average the unit face normals to find the cone axis
+		std::vector<glm::vec3> faceNormals(triangleCount);
+		for (int t = 0; t < triangleCount; t++)
+		{
+			glm::vec3 p0 = GetPosition(vertices, indices[t * 3 + 0]);
+			glm::vec3 p1 = GetPosition(vertices, indices[t * 3 + 1]);
+			glm::vec3 p2 = GetPosition(vertices, indices[t * 3 + 2]);
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float length = glm::length(normal);
+
+			faceNormals[t] = (length > 0.0f) ? (normal / length) : glm::vec3(0.0f);
+			normalSum += faceNormals[t];
+		}
+
+		meshlet.coneAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+		meshlet.coneCutoff = 1.0f;
+
+		float sumLength = glm::length(normalSum);
+		if (sumLength <= 0.0f)
+		{
+			return;
+		}
+		glm::vec3 axis = normalSum / sumLength;
+
+		float minDot = 1.0f;
+		for (int t = 0; t < triangleCount; t++)
+		{
+			if (faceNormals[t] != glm::vec3(0.0f))
+			{
+				minDot = std::min(minDot, glm::dot(axis, faceNormals[t]));
+			}
+		}
+
+		if (minDot > MIN_CONE_DOT)
+		{
+			meshlet.coneAxis = axis;
+			meshlet.coneCutoff = std::sqrt(std::max(0.0f, 1.0f - (minDot * minDot)));
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildMeshlets()
+ *
+ *  This method is used for clustering the triangles of the
+ *  mesh.  Starting from the first unassigned triangle, each
+ *  meshlet grows breadth first through triangles that share a
+ *  vertex, which keeps the clusters compact.  The index buffer
+ *  is rewritten so every meshlet occupies a contiguous range.
+ ***********************************************************/
+void MeshletBuilder::BuildMeshlets(
+	ShapeGenerator::MESH_DATA& mesh,
+	std::vector<MESHLET>& meshlets,
+	int maxTriangles)
+{
+	const int triangleCount = (int)mesh.indices.size() / 3;
+	const int vertexCount = (int)(mesh.vertices.size() / ShapeGenerator::FLOATS_PER_VERTEX);
+
+	meshlets.clear();
+	if (triangleCount == 0)
+	{
+		return;
+	}
+	maxTriangles = std::max(1, maxTriangles);
+
+	// build the vertex to triangle adjacency in compressed rows
+	std::vector<int> adjacencyOffsets(vertexCount + 1, 0);
+	for (GLuint index : mesh.indices)
+	{
+		adjacencyOffsets[index + 1]++;
+	}
+	for (int v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	}
+	std::vector<int> adjacency(mesh.indices.size());
+	std::vector<int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (int t = 0; t < triangleCount; t++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			adjacency[fill[mesh.indices[t * 3 + k]]++] = t;
+		}
+	}
+
+	std::vector<GLuint> reordered;
+	std::vector<int> queue;
+	// meshlet number + 1 that queued the triangle, 0 when never queued
+	std::vector<int> queuedBy(triangleCount, 0);
+	std::vector<bool> assigned(triangleCount, false);
+	int nextSeed = 0;
+
+	reordered.reserve(mesh.indices.size());
+	queue.reserve(maxTriangles * 8);
+
+	while (nextSeed < triangleCount)
+	{
+		if (assigned[nextSeed] == true)
+		{
+			nextSeed++;
+			continue;
+		}
+
+		MESHLET meshlet;
+		int meshletTriangles = 0;
+		int stamp = (int)meshlets.size() + 1;
+		size_t head = 0;
+
+		meshlet.firstIndex = (GLuint)reordered.size();
+		queue.clear();
+		queue.push_back(nextSeed);
+		queuedBy[nextSeed] = stamp;
+
+		while ((head < queue.size()) && (meshletTriangles < maxTriangles))
+		{
+			int t = queue[head++];
+			if (assigned[t] == true)
+			{
+				continue;
+			}
+
+			assigned[t] = true;
+			meshletTriangles++;
+			for (int k = 0; k < 3; k++)
+			{
+				GLuint vertex = mesh.indices[t * 3 + k];
+				reordered.push_back(vertex);
+
+				// queue the unassigned neighbors sharing this vertex
+				for (int a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++)
+				{
+					int neighbor = adjacency[a];
+					if ((assigned[neighbor] == false) && (queuedBy[neighbor] != stamp))
+					{
+						queuedBy[neighbor] = stamp;
+						queue.push_back(neighbor);
+					}
+				}
+			}
+		}
+
+		meshlet.indexCount = (GLuint)(meshletTriangles * 3);
+		meshlets.push_back(meshlet);
+	}
+
+	mesh.indices.swap(reordered);
+
+	for (MESHLET& meshlet : meshlets)
+	{
+		ComputeMeshletBounds(mesh.vertices, &mesh.indices[meshlet.firstIndex], meshlet);
+	}
+}
+
+/***********************************************************
+ *  UploadMeshletMesh()
+ *
+ *  This method is used for clustering the mesh into meshlets
+ *  and uploading the reordered vertex and index data.
+ ***********************************************************/
+bool MeshletBuilder::UploadMeshletMesh(
+	ShapeGenerator::MESH_DATA& mesh,
+	MESHLET_MESH& meshletMesh,
+	int maxTriangles)
+{
+	std::vector<MESHLET> meshlets;
+
+	BuildMeshlets(mesh, meshlets, maxTriangles);
+
+	return(UploadMeshletMesh(
+		mesh.vertices.data(),
+		(int)(mesh.vertices.size() / ShapeGenerator::FLOATS_PER_VERTEX),
+		mesh.indices.data(),
+		(int)mesh.indices.size(),
+		meshlets,
+		meshletMesh));
+}
+
+/***********************************************************
+ *  UploadMeshletMesh()
+ *
+ *  This method is used for uploading a mesh that was already
+ *  clustered, such as the compile time primitive tables.
+ ***********************************************************/
+bool MeshletBuilder::UploadMeshletMesh(
+	const float* vertices,
+	int vertexCount,
+	const GLuint* indices,
+	int indexCount,
+	const std::vector<MESHLET>& meshlets,
+	MESHLET_MESH& meshletMesh)
+{
+	meshletMesh.meshlets = meshlets;
+	meshletMesh.drawCounts.reserve(meshlets.size());
+	meshletMesh.drawOffsets.reserve(meshlets.size());
+	meshletMesh.visibleMeshlets = 0;
+	meshletMesh.culledMeshlets = 0;
+
+	return(ShapeGenerator::UploadMesh(
+		vertices,
+		vertexCount,
+		indices,
+		indexCount,
+		meshletMesh.glMesh));
+}
+
+/***********************************************************
+ *  CullMeshlets()
+ *
+ *  This method is used for testing every meshlet against the
+ *  view frustum and its normal cone against the camera
+ *  position.  Neighboring visible meshlets are merged into a
+ *  single draw range.  The number of visible meshlets is
+ *  returned.
+ ***********************************************************/
+int MeshletBuilder::CullMeshlets(
+	MESHLET_MESH& meshletMesh,
+	const glm::mat4& model,
+	const Frustum& frustum,
+	const glm::vec3& cameraPosition)
+{
+	meshletMesh.drawCounts.clear();
+	meshletMesh.drawOffsets.clear();
+	meshletMesh.visibleMeshlets = 0;
+	meshletMesh.culledMeshlets = 0;
+
+	// the bounding spheres grow by the largest axis scale
+	glm::vec3 axisScale(
+		glm::length(glm::vec3(model[0])),
+		glm::length(glm::vec3(model[1])),
+		glm::length(glm::vec3(model[2])));
+	float maxScale = std::max(axisScale.x, std::max(axisScale.y, axisScale.z));
+	float minScale = std::min(axisScale.x, std::min(axisScale.y, axisScale.z));
+
+	// normals are transformed by the inverse transpose, which
+	// only keeps cone angles intact when the scale is uniform
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+	bool bUniformScale = (maxScale - minScale) <= (0.001f * maxScale);
+
+	GLuint rangeEnd = 0;
+
+	for (const MESHLET& meshlet : meshletMesh.meshlets)
+	{
+		glm::vec3 center = glm::vec3(model * glm::vec4(meshlet.center, 1.0f));
+		float radius = meshlet.radius * maxScale;
+		bool bVisible = frustum.IsSphereVisible(center, radius);
+
+		// a flat meshlet keeps a single normal under any scale
+		if ((bVisible == true) &&
+			(meshlet.coneCutoff < 1.0f) &&
+			((bUniformScale == true) || (meshlet.coneCutoff == 0.0f)))
+		{
+			glm::vec3 axis = glm::normalize(normalMatrix * meshlet.coneAxis);
+			glm::vec3 toCenter = center - cameraPosition;
+
+			// every triangle faces away from the camera
+			if (glm::dot(toCenter, axis) >= (meshlet.coneCutoff * glm::length(toCenter)) + radius)
+			{
+				bVisible = false;
+			}
+		}
+
+		if (bVisible == false)
+		{
+			meshletMesh.culledMeshlets++;
+			continue;
+		}
+		meshletMesh.visibleMeshlets++;
+
+		// extend the previous range when the meshlets are adjacent
+		if ((meshletMesh.drawCounts.empty() == false) && (rangeEnd == meshlet.firstIndex))
+		{
+			meshletMesh.drawCounts.back() += (GLsizei)meshlet.indexCount;
+		}
+		else
+		{
+			meshletMesh.drawCounts.push_back((GLsizei)meshlet.indexCount);
+			meshletMesh.drawOffsets.push_back((const void*)(sizeof(GLuint) * (size_t)meshlet.firstIndex));
+		}
+		rangeEnd = meshlet.firstIndex + meshlet.indexCount;
+	}
+
+	return(meshletMesh.visibleMeshlets);
+}
+
+/***********************************************************
+ *  DrawVisibleMeshlets()
+ *
+ *  This method is used for drawing the index ranges that
+ *  were found visible by the last CullMeshlets() call.
+ ***********************************************************/
+void MeshletBuilder::DrawVisibleMeshlets(const MESHLET_MESH& meshletMesh)
+{
+	if (meshletMesh.drawCounts.empty())
+	{
+		return;
+	}
+
+	glBindVertexArray(meshletMesh.glMesh.vao);
+	glMultiDrawElements(
+		GL_TRIANGLES,
+		meshletMesh.drawCounts.data(),
+		GL_UNSIGNED_INT,
+		meshletMesh.drawOffsets.data(),
+		(GLsizei)meshletMesh.drawCounts.size());
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyMeshletMesh()
+ *
+ *  This method is used for freeing the OpenGL buffers of the
+ *  meshlet mesh.
+ ***********************************************************/
+void MeshletBuilder::DestroyMeshletMesh(MESHLET_MESH& meshletMesh)
+{
+	ShapeGenerator::DestroyMesh(meshletMesh.glMesh);
+	meshletMesh.meshlets.clear();
+	meshletMesh.drawCounts.clear();
+	meshletMesh.drawOffsets.clear();
+}
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshletbuilder.h
+// ============
+// split meshes into small triangle clusters that can be culled on the CPU
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeGenerator.h"
+#include "Frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  MeshletBuilder
+ *
+ *  This class groups the triangles of an indexed mesh into
+ *  meshlets of up to MAX_MESHLET_TRIANGLES connected
+ *  triangles.  Each meshlet stores a bounding sphere and a
+ *  normal cone, and its indices are stored contiguously so
+ *  that the visible meshlets can be drawn with a single
+ *  glMultiDrawElements() call after CPU culling.
+ ***********************************************************/
+class MeshletBuilder
+{
+public:
+	// upper limit of triangles in a single meshlet
+	static const int MAX_MESHLET_TRIANGLES = 124;
+
+	// a cluster of triangles with its culling bounds
+	struct MESHLET
+	{
+		// first index of the meshlet in the index buffer
+		GLuint firstIndex;
+		// number of indices (3 per triangle)
+		GLuint indexCount;
+		// bounding sphere in model space
+		glm::vec3 center;
+		float radius;
+		// normal cone in model space - the cone cutoff is the
+		// sine of the cone half angle, 1.0 disables the test
+		glm::vec3 coneAxis;
+		float coneCutoff;
+	};
+
+	// an uploaded mesh with its meshlets and draw ranges
+	struct MESHLET_MESH
+	{
+		ShapeGenerator::GL_MESH glMesh;
+		std::vector<MESHLET> meshlets;
+		// index ranges of the visible meshlets for the next draw
+		std::vector<GLsizei> drawCounts;
+		std::vector<const void*> drawOffsets;
+		// culling results of the last CullMeshlets() call
+		int visibleMeshlets;
+		int culledMeshlets;
+	};
+
+	// cluster the triangles of the mesh and reorder its indices
+	// so that every meshlet is a contiguous range
+	static void BuildMeshlets(
+		ShapeGenerator::MESH_DATA& mesh,
+		std::vector<MESHLET>& meshlets,
+		int maxTriangles = MAX_MESHLET_TRIANGLES);
+
+	// build the meshlets and upload the reordered mesh
+	static bool UploadMeshletMesh(
+		ShapeGenerator::MESH_DATA& mesh,
+		MESHLET_MESH& meshletMesh,
+		int maxTriangles = MAX_MESHLET_TRIANGLES);
+
+	// upload a mesh whose indices are already grouped into
+	// the passed in meshlets
+	static bool UploadMeshletMesh(
+		const float* vertices,
+		int vertexCount,
+		const GLuint* indices,
+		int indexCount,
+		const std::vector<MESHLET>& meshlets,
+		MESHLET_MESH& meshletMesh);
+
+	// reject off-screen and back-facing meshlets and build the
+	// draw ranges of the remaining ones
+	static int CullMeshlets(
+		MESHLET_MESH& meshletMesh,
+		const glm::mat4& model,
+		const Frustum& frustum,
+		const glm::vec3& cameraPosition);
+
+	// draw the meshlets that survived the last CullMeshlets()
+	static void DrawVisibleMeshlets(const MESHLET_MESH& meshletMesh);
+
+	// free the OpenGL buffers of the meshlet mesh
+	static void DestroyMeshletMesh(MESHLET_MESH& meshletMesh);
+};
@@ -0,0 +1,254 @@
+///////////////////////////////////////////////////////////////////////////////
+// objectlightlists.cpp
+// ============
+// assignment of point lights to the scene objects their range reaches
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ObjectLightLists.h"
+#include "BenchmarkTimer.h"
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+/***********************************************************
+ *  ObjectLightLists()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ObjectLightLists::ObjectLightLists()
+{
+	m_drawnCount = 0;
+	m_buffers[0] = 0;
+	m_buffers[1] = 0;
+	m_textures[0] = 0;
+	m_textures[1] = 0;
+}
+
+/***********************************************************
+ *  ~ObjectLightLists()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ObjectLightLists::~ObjectLightLists()
+{
+	if (m_buffers[0] != 0)
+	{
+		glDeleteTextures(2, m_textures);
+		glDeleteBuffers(2, m_buffers);
+	}
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for listing the lights of the drawn
+ *  objects.  Each light collects the objects its sphere
+ *  touches from the hierarchy, and is added to the lists of
+ *  the drawn ones, so the lists keep the light order.
+ ***********************************************************/
+void ObjectLightLists::Build(
+	const std::vector<LightClusters::POINT_LIGHT>& lights,
+	const BoundingVolumeHierarchy& hierarchy,
+	const std::vector<int>& drawnObjects)
+{
+	const int objectCount = hierarchy.GetObjectCount();
+
+	m_bDrawn.assign(objectCount, 0);
+	m_assigned.resize(objectCount);
+	for (int object : drawnObjects)
+	{
+		m_bDrawn[object] = 1;
+		m_assigned[object].clear();
+	}
+	m_drawnCount = (int)drawnObjects.size();
+
+	m_lightData.resize(lights.size() * 2);
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		const LightClusters::POINT_LIGHT& light = lights[i];
+		m_lightData[(i * 2) + 0] = glm::vec4(light.position, light.range);
+		m_lightData[(i * 2) + 1] = glm::vec4(light.color, 0.0f);
+
+		hierarchy.QuerySphere(light.position, light.range, m_queryResults);
+		for (int object : m_queryResults)
+		{
+			if (m_bDrawn[object] != 0)
+			{
+				m_assigned[object].push_back((uint32_t)i);
+			}
+		}
+	}
+
+	// pack the lists one after another, the objects that are
+	// not drawn keep an empty list
+	m_objectLists.assign(objectCount, glm::ivec2(0, 0));
+	m_lightIndices.clear();
+	for (int object : drawnObjects)
+	{
+		m_objectLists[object] = glm::ivec2((int)m_lightIndices.size(), (int)m_assigned[object].size());
+		m_lightIndices.insert(m_lightIndices.end(), m_assigned[object].begin(), m_assigned[object].end());
+	}
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for copying the light data and the
+ *  object lists into their texture buffers.
+ ***********************************************************/
+void ObjectLightLists::Upload()
+{
+	if (m_buffers[0] == 0)
+	{
+		glGenBuffers(2, m_buffers);
+		glGenTextures(2, m_textures);
+	}
+
+	// an empty buffer cannot back a texture
+	if (m_lightData.empty() == true)
+	{
+		m_lightData.push_back(glm::vec4(0.0f));
+	}
+	if (m_lightIndices.empty() == true)
+	{
+		m_lightIndices.push_back(0);
+	}
+
+	const GLenum formats[2] = { GL_RGBA32F, GL_R32UI };
+	const void* data[2] = { m_lightData.data(), m_lightIndices.data() };
+	const size_t sizes[2] =
+	{
+		m_lightData.size() * sizeof(glm::vec4),
+		m_lightIndices.size() * sizeof(uint32_t)
+	};
+
+	for (int i = 0; i < 2; i++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, sizes[i], data[i], GL_STREAM_DRAW);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the light data and light
+ *  index buffers to two texture units.
+ ***********************************************************/
+void ObjectLightLists::Bind(int firstTextureUnit) const
+{
+	for (int i = 0; i < 2; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + firstTextureUnit + i);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+	}
+}
+
+/***********************************************************
+ *  GetObjectList()
+ *
+ *  This method is used for getting where the light list of
+ *  an object starts in the light index buffer, and its
+ *  length.
+ ***********************************************************/
+glm::ivec2 ObjectLightLists::GetObjectList(int object) const
+{
+	if ((object < 0) || (object >= (int)m_objectLists.size()))
+	{
+		return(glm::ivec2(0, 0));
+	}
+	return(m_objectLists[object]);
+}
+
+/***********************************************************
+ *  GetAverageLightCount()
+ *
+ *  This method is used for getting the average number of
+ *  lights listed for the drawn objects of the last build.
+ ***********************************************************/
+float ObjectLightLists::GetAverageLightCount() const
+{
+	if (m_drawnCount == 0)
+	{
+		return(0.0f);
+	}
+
+	// counted from the lists, as the uploaded indices hold a
+	// placeholder when every list is empty
+	size_t indexCount = 0;
+	for (const glm::ivec2& list : m_objectLists)
+	{
+		indexCount += (size_t)list.y;
+	}
+	return((float)indexCount / (float)m_drawnCount);
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the assignment of random
+ *  lights to random objects spread over a scene the size of
+ *  the toy scene.
+ ***********************************************************/
+void ObjectLightLists::RunBenchmark()
+{
+	const int lightCounts[] = { 16, 64, 256, 1024, 4096 };
+	const int objectCount = 2000;
+	const int repetitions = 10;
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> positionX(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> positionY(0.0f, 10.0f);
+	std::uniform_real_distribution<float> positionZ(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> size(0.1f, 1.0f);
+	std::uniform_real_distribution<float> range(1.0f, 4.0f);
+
+	std::vector<glm::vec3> boundsMin(objectCount);
+	std::vector<glm::vec3> boundsMax(objectCount);
+	std::vector<int> drawnObjects(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		glm::vec3 center = glm::vec3(positionX(random), positionY(random), positionZ(random));
+		glm::vec3 extent = glm::vec3(size(random), size(random), size(random));
+		boundsMin[i] = center - extent;
+		boundsMax[i] = center + extent;
+		drawnObjects[i] = i;
+	}
+
+	BoundingVolumeHierarchy hierarchy;
+	hierarchy.Build(boundsMin, boundsMax);
+
+	std::cout << "INFO: Object light list benchmark (" << objectCount << " objects)" << std::endl;
+	std::cout << "     lights   lights/object   build ms" << std::endl;
+
+	for (int lightCount : lightCounts)
+	{
+		std::vector<LightClusters::POINT_LIGHT> lights(lightCount);
+		for (LightClusters::POINT_LIGHT& light : lights)
+		{
+			light.position = glm::vec3(positionX(random), positionY(random), positionZ(random));
+			light.range = range(random);
+			light.color = glm::vec3(1.0f);
+		}
+
+		ObjectLightLists lists;
+		double buildTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			lists.Build(lights, hierarchy, drawnObjects);
+		}, repetitions);
+
+		char line[128];
+		snprintf(line, sizeof(line), "  %9d  %14.2f  %9.3f",
+			lightCount,
+			lists.GetAverageLightCount(),
+			buildTime);
+		std::cout << line << std::endl;
+	}
+}
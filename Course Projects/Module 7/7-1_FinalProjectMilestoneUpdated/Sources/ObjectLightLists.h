@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// objectlightlists.h
+// ============
+// assignment of point lights to the scene objects their range reaches
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolumeHierarchy.h"
+#include "LightClusters.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  ObjectLightLists
+ *
+ *  This class lists for every drawn object the point lights
+ *  whose sphere touches its bounding box.  Each light is
+ *  looked up in the object hierarchy with a sphere query,
+ *  instead of testing every light against every object.
+ *
+ *  The lights and the lists of all objects are passed to
+ *  the shader in two texture buffers, and each draw only
+ *  sets the offset and length of its list - objects out of
+ *  reach of every light skip the point light loop.
+ ***********************************************************/
+class ObjectLightLists
+{
+public:
+	// constructor
+	ObjectLightLists();
+	// destructor
+	~ObjectLightLists();
+
+	// list the lights reaching each of the drawn objects,
+	// indexed like the boxes of the hierarchy
+	void Build(
+		const std::vector<LightClusters::POINT_LIGHT>& lights,
+		const BoundingVolumeHierarchy& hierarchy,
+		const std::vector<int>& drawnObjects);
+	// copy the lights and the lists into the texture buffers,
+	// creating them on first use
+	void Upload();
+	// bind the light data and light index buffers to the
+	// texture units starting with the passed in one
+	void Bind(int firstTextureUnit) const;
+
+	// get the first entry and the length of the list of an
+	// object in the light index buffer
+	glm::ivec2 GetObjectList(int object) const;
+	// average list length of the drawn objects
+	float GetAverageLightCount() const;
+
+	// time the assignment for increasing light counts
+	static void RunBenchmark();
+
+private:
+	// list of each object, empty for the objects not drawn
+	std::vector<glm::ivec2> m_objectLists;
+	// objects reached by the light being assigned
+	std::vector<int> m_queryResults;
+	// drawn flag of every object
+	std::vector<uint8_t> m_bDrawn;
+	// lights of each drawn object while they are assigned
+	std::vector<std::vector<uint32_t>> m_assigned;
+	int m_drawnCount;
+
+	// data uploaded into the texture buffers
+	std::vector<glm::vec4> m_lightData;
+	std::vector<uint32_t> m_lightIndices;
+
+	// buffer objects and their buffer textures
+	GLuint m_buffers[2];
+	GLuint m_textures[2];
+};
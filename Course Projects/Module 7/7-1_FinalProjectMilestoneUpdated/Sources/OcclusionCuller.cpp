@@ -0,0 +1,505 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// software rasterized depth buffer for occlusion culling on the CPU
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+#include "BenchmarkTimer.h"
+#include "StaticPrimitives.h"
+#include "ThreadPool.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OCCLUSION_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// depth of the cleared buffer, the far plane
+	const float FAR_DEPTH = 1.0f;
+	// triangles with a smaller doubled screen area are skipped
+	const float MIN_TRIANGLE_AREA = 1.0e-6f;
+}
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller()
+{
+	m_viewProjection = glm::mat4(1.0f);
+	m_depth.assign(BUFFER_WIDTH * BUFFER_HEIGHT, FAR_DEPTH);
+	m_tileMaxDepth.assign(TILES_X * TILES_Y, FAR_DEPTH);
+	m_bRasterized = false;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a new frame.  Until the
+ *  occluders are rasterized every box is visible.
+ ***********************************************************/
+void OcclusionCuller::BeginFrame(const glm::mat4& viewProjection)
+{
+	m_viewProjection = viewProjection;
+	m_triangles.clear();
+	m_bRasterized = false;
+}
+
+/***********************************************************
+ *  AddOccluder()
+ *
+ *  This method is used for transforming the triangles of an
+ *  occluder mesh into clip space and setting up the ones
+ *  facing the camera for rasterization.
+ ***********************************************************/
+void OcclusionCuller::AddOccluder(
+	const float* vertices,
+	int floatsPerVertex,
+	const GLuint* indices,
+	int indexCount,
+	const glm::mat4& modelMatrix)
+{
+	const glm::mat4 modelViewProjection = m_viewProjection * modelMatrix;
+
+	GLuint vertexCount = 0;
+	for (int i = 0; i < indexCount; i++)
+	{
+		vertexCount = std::max(vertexCount, indices[i] + 1);
+	}
+
+	m_clipVertices.resize(vertexCount);
+	for (GLuint i = 0; i < vertexCount; i++)
+	{
+		const float* position = vertices + (i * floatsPerVertex);
+		m_clipVertices[i] = modelViewProjection * glm::vec4(position[0], position[1], position[2], 1.0f);
+	}
+
+	for (int i = 0; i + 2 < indexCount; i += 3)
+	{
+		AddClipTriangle(
+			m_clipVertices[indices[i]],
+			m_clipVertices[indices[i + 1]],
+			m_clipVertices[indices[i + 2]]);
+	}
+}
+
+/***********************************************************
+ *  AddClipTriangle()
+ *
+ *  This method is used for clipping a clip space triangle
+ *  against the near plane (z + w >= 0).  The other planes
+ *  are handled by clamping to the buffer while rasterizing.
+ ***********************************************************/
+void OcclusionCuller::AddClipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+	const glm::vec4 input[3] = { a, b, c };
+	glm::vec4 polygon[4];
+	int polygonSize = 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& current = input[i];
+		const glm::vec4& next = input[(i + 1) % 3];
+		float currentDistance = current.z + current.w;
+		float nextDistance = next.z + next.w;
+
+		if (currentDistance >= 0.0f)
+		{
+			polygon[polygonSize++] = current;
+		}
+		if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+		{
+			float t = currentDistance / (currentDistance - nextDistance);
+			polygon[polygonSize++] = current + ((next - current) * t);
+		}
+	}
+
+	for (int i = 1; i + 1 < polygonSize; i++)
+	{
+		SetupTriangle(polygon[0], polygon[i], polygon[i + 1]);
+	}
+}
+
+/***********************************************************
+ *  SetupTriangle()
+ *
+ *  This method is used for projecting a clipped triangle to
+ *  the buffer and computing its edge and depth equations.
+ *  Back-facing and degenerate triangles are dropped.
+ ***********************************************************/
+void OcclusionCuller::SetupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+	const glm::vec4* clip[3] = { &a, &b, &c };
+	float x[3];
+	float y[3];
+	float z[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		const float inverseW = 1.0f / clip[i]->w;
+		x[i] = ((clip[i]->x * inverseW * 0.5f) + 0.5f) * (float)BUFFER_WIDTH;
+		y[i] = ((clip[i]->y * inverseW * 0.5f) + 0.5f) * (float)BUFFER_HEIGHT;
+		z[i] = clip[i]->z * inverseW;
+	}
+
+	// counter-clockwise triangles have a positive area
+	const float area = ((x[1] - x[0]) * (y[2] - y[0])) - ((x[2] - x[0]) * (y[1] - y[0]));
+	if (area <= MIN_TRIANGLE_AREA)
+	{
+		return;
+	}
+
+	SETUP_TRIANGLE triangle;
+
+	// only pixels whose centers are inside are covered
+	triangle.minX = std::max((int)std::ceil(std::min(x[0], std::min(x[1], x[2])) - 0.5f), 0);
+	triangle.maxX = std::min((int)std::floor(std::max(x[0], std::max(x[1], x[2])) - 0.5f), BUFFER_WIDTH - 1);
+	triangle.minY = std::max((int)std::ceil(std::min(y[0], std::min(y[1], y[2])) - 0.5f), 0);
+	triangle.maxY = std::min((int)std::floor(std::max(y[0], std::max(y[1], y[2])) - 0.5f), BUFFER_HEIGHT - 1);
+	if ((triangle.minX > triangle.maxX) || (triangle.minY > triangle.maxY))
+	{
+		return;
+	}
+
+	// a point is inside when it is left of every edge
+	for (int i = 0; i < 3; i++)
+	{
+		const int j = (i + 1) % 3;
+		triangle.edgeA[i] = y[i] - y[j];
+		triangle.edgeB[i] = x[j] - x[i];
+		triangle.edgeC[i] = ((y[j] - y[i]) * x[i]) - ((x[j] - x[i]) * y[i]);
+	}
+
+	// depth is linear in screen space after the divide by w
+	const float depthX = (((z[1] - z[0]) * (y[2] - y[0])) - ((z[2] - z[0]) * (y[1] - y[0]))) / area;
+	const float depthY = (((x[1] - x[0]) * (z[2] - z[0])) - ((x[2] - x[0]) * (z[1] - z[0]))) / area;
+	triangle.depthA = depthX;
+	triangle.depthB = depthY;
+	triangle.depthC = z[0] - (depthX * x[0]) - (depthY * y[0]);
+
+	m_triangles.push_back(triangle);
+}
+
+/***********************************************************
+ *  RasterizeOccluders()
+ *
+ *  This method is used for rasterizing the occluders into
+ *  the depth buffer.  Every worker clears and fills its own
+ *  rows of tiles, so no two workers write the same pixels.
+ ***********************************************************/
+void OcclusionCuller::RasterizeOccluders()
+{
+	ThreadPool::GetShared()->ParallelFor(TILES_Y, [&](int begin, int end)
+	{
+		RasterizeTileRows(begin, end);
+	});
+
+	m_bRasterized = true;
+}
+
+/***********************************************************
+ *  RasterizeTileRows()
+ *
+ *  This method is used for clearing a range of tile rows,
+ *  rasterizing every occluder triangle overlapping them and
+ *  storing the farthest depth of each tile.
+ ***********************************************************/
+void OcclusionCuller::RasterizeTileRows(int firstRow, int endRow)
+{
+	const int firstY = firstRow * TILE_HEIGHT;
+	const int endY = endRow * TILE_HEIGHT;
+
+	std::fill(
+		m_depth.begin() + (firstY * BUFFER_WIDTH),
+		m_depth.begin() + (endY * BUFFER_WIDTH),
+		FAR_DEPTH);
+
+	for (const SETUP_TRIANGLE& triangle : m_triangles)
+	{
+		const int minY = std::max(triangle.minY, firstY);
+		const int maxY = std::min(triangle.maxY, endY - 1);
+		// start at a multiple of four so the SSE loads are aligned
+		// with the rows, the buffer width is a multiple of four
+		const int minX = triangle.minX & ~3;
+
+		for (int py = minY; py <= maxY; py++)
+		{
+			float* row = &m_depth[py * BUFFER_WIDTH];
+			const float centerY = (float)py + 0.5f;
+
+#ifdef OCCLUSION_USE_SSE
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 step = _mm_set1_ps(4.0f);
+			__m128 centerX = _mm_add_ps(_mm_set1_ps((float)minX + 0.5f), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+			__m128 edgeA[3];
+			__m128 edgeRow[3];
+			for (int i = 0; i < 3; i++)
+			{
+				edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+				edgeRow[i] = _mm_set1_ps((triangle.edgeB[i] * centerY) + triangle.edgeC[i]);
+			}
+			const __m128 depthA = _mm_set1_ps(triangle.depthA);
+			const __m128 depthRow = _mm_set1_ps((triangle.depthB * centerY) + triangle.depthC);
+
+			for (int px = minX; px <= triangle.maxX; px += 4)
+			{
+				__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], centerX), edgeRow[0]), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], centerX), edgeRow[1]), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], centerX), edgeRow[2]), zero));
+
+				if (_mm_movemask_ps(inside) != 0)
+				{
+					__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, centerX), depthRow);
+					__m128 current = _mm_loadu_ps(row + px);
+					__m128 closest = _mm_min_ps(current, depth);
+					_mm_storeu_ps(row + px, _mm_or_ps(_mm_and_ps(inside, closest), _mm_andnot_ps(inside, current)));
+				}
+
+				centerX = _mm_add_ps(centerX, step);
+			}
+#else
+			for (int px = triangle.minX; px <= triangle.maxX; px++)
+			{
+				const float centerX = (float)px + 0.5f;
+				bool bInside = true;
+				for (int i = 0; i < 3; i++)
+				{
+					if ((triangle.edgeA[i] * centerX) + (triangle.edgeB[i] * centerY) + triangle.edgeC[i] < 0.0f)
+					{
+						bInside = false;
+					}
+				}
+				if (bInside == true)
+				{
+					float depth = (triangle.depthA * centerX) + (triangle.depthB * centerY) + triangle.depthC;
+					row[px] = std::min(row[px], depth);
+				}
+			}
+#endif
+		}
+	}
+
+	for (int tileY = firstRow; tileY < endRow; tileY++)
+	{
+		for (int tileX = 0; tileX < TILES_X; tileX++)
+		{
+			float farthest = -FAR_DEPTH;
+			for (int py = tileY * TILE_HEIGHT; py < (tileY + 1) * TILE_HEIGHT; py++)
+			{
+				const float* row = &m_depth[(py * BUFFER_WIDTH) + (tileX * TILE_WIDTH)];
+				for (int px = 0; px < TILE_WIDTH; px++)
+				{
+					farthest = std::max(farthest, row[px]);
+				}
+			}
+			m_tileMaxDepth[(tileY * TILES_X) + tileX] = farthest;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsBoxVisible()
+ *
+ *  This method is used for testing a world space box against
+ *  the depth buffer.  The box is hidden when its closest
+ *  point is behind the occluders at every pixel its screen
+ *  rectangle touches.  Boxes crossing the near plane are
+ *  always visible.
+ ***********************************************************/
+bool OcclusionCuller::IsBoxVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+	if ((m_bRasterized == false) || (m_triangles.empty() == true))
+	{
+		return(true);
+	}
+
+	glm::vec3 screenMin(1.0e30f);
+	glm::vec3 screenMax(-1.0e30f);
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 clip = m_viewProjection * glm::vec4(
+			(corner & 1) ? boxMax.x : boxMin.x,
+			(corner & 2) ? boxMax.y : boxMin.y,
+			(corner & 4) ? boxMax.z : boxMin.z,
+			1.0f);
+		if (clip.z + clip.w < 0.0f)
+		{
+			return(true);
+		}
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		screenMin = glm::min(screenMin, ndc);
+		screenMax = glm::max(screenMax, ndc);
+	}
+
+	// every pixel the rectangle touches, even partially
+	const int minX = std::max((int)std::floor(((screenMin.x * 0.5f) + 0.5f) * (float)BUFFER_WIDTH), 0);
+	const int maxX = std::min((int)std::floor(((screenMax.x * 0.5f) + 0.5f) * (float)BUFFER_WIDTH), BUFFER_WIDTH - 1);
+	const int minY = std::max((int)std::floor(((screenMin.y * 0.5f) + 0.5f) * (float)BUFFER_HEIGHT), 0);
+	const int maxY = std::min((int)std::floor(((screenMax.y * 0.5f) + 0.5f) * (float)BUFFER_HEIGHT), BUFFER_HEIGHT - 1);
+	if ((minX > maxX) || (minY > maxY))
+	{
+		// off screen, left to the frustum test
+		return(true);
+	}
+
+	const float closest = screenMin.z;
+	for (int tileY = minY / TILE_HEIGHT; tileY <= maxY / TILE_HEIGHT; tileY++)
+	{
+		for (int tileX = minX / TILE_WIDTH; tileX <= maxX / TILE_WIDTH; tileX++)
+		{
+			if (closest > m_tileMaxDepth[(tileY * TILES_X) + tileX])
+			{
+				// behind every pixel of the tile
+				continue;
+			}
+
+			const int tileMinX = std::max(minX, tileX * TILE_WIDTH);
+			const int tileMaxX = std::min(maxX, ((tileX + 1) * TILE_WIDTH) - 1);
+			const int tileMinY = std::max(minY, tileY * TILE_HEIGHT);
+			const int tileMaxY = std::min(maxY, ((tileY + 1) * TILE_HEIGHT) - 1);
+			for (int py = tileMinY; py <= tileMaxY; py++)
+			{
+				const float* row = &m_depth[py * BUFFER_WIDTH];
+				for (int px = tileMinX; px <= tileMaxX; px++)
+				{
+					if (closest <= row[px])
+					{
+						return(true);
+					}
+				}
+			}
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  GetOccluderTriangleCount()
+ *
+ *  This method is used for getting the number of occluder
+ *  triangles set up for rasterization in the frame.
+ ***********************************************************/
+int OcclusionCuller::GetOccluderTriangleCount() const
+{
+	return((int)m_triangles.size());
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing a frame of occlusion
+ *  culling - a wall and a floor plus increasing numbers of
+ *  box occluders, and 10k boxes tested against them.
+ ***********************************************************/
+void OcclusionCuller::RunBenchmark()
+{
+	const int occluderCounts[] = { 8, 64, 512 };
+	const int occludeeCount = 10000;
+	const int repetitions = 10;
+
+	std::cout << "INFO: Software occlusion benchmark ("
+		<< BUFFER_WIDTH << " x " << BUFFER_HEIGHT << ", "
+		<< ThreadPool::GetShared()->GetThreadCount() << " threads"
+#ifdef OCCLUSION_USE_SSE
+		<< ", SSE"
+#endif
+		<< ")" << std::endl;
+	std::cout << "  occluders   triangles   rasterize ms   10k tests ms   occluded" << std::endl;
+
+	const glm::mat4 viewProjection =
+		glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 200.0f) *
+		glm::lookAt(glm::vec3(0.0f, 8.0f, 30.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	for (int occluderCount : occluderCounts)
+	{
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> height(0.0f, 6.0f);
+		std::uniform_real_distribution<float> size(0.5f, 3.0f);
+
+		std::vector<glm::mat4> occluders;
+		occluders.push_back(glm::scale(glm::vec3(40.0f, 1.0f, 40.0f)));
+		occluders.push_back(glm::translate(glm::vec3(0.0f, 0.0f, -20.0f)) * glm::rotate(glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)) * glm::scale(glm::vec3(40.0f, 1.0f, 40.0f)));
+		for (int i = 0; i < occluderCount; i++)
+		{
+			occluders.push_back(
+				glm::translate(glm::vec3(position(random), height(random), position(random))) *
+				glm::scale(glm::vec3(size(random), size(random), size(random))));
+		}
+
+		std::vector<glm::vec3> boxMin(occludeeCount);
+		std::vector<glm::vec3> boxMax(occludeeCount);
+		for (int i = 0; i < occludeeCount; i++)
+		{
+			glm::vec3 center(position(random), height(random), position(random));
+			boxMin[i] = center - glm::vec3(0.25f);
+			boxMax[i] = center + glm::vec3(0.25f);
+		}
+
+		OcclusionCuller culler;
+		double rasterizeTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			culler.BeginFrame(viewProjection);
+			culler.AddOccluder(
+				StaticPrimitives::PLANE_OCCLUDER.vertices,
+				StaticPrimitives::FLOATS_PER_VERTEX,
+				StaticPrimitives::PLANE_OCCLUDER.indices,
+				StaticPrimitives::PLANE_OCCLUDER.indexCount,
+				occluders[0]);
+			culler.AddOccluder(
+				StaticPrimitives::PLANE_OCCLUDER.vertices,
+				StaticPrimitives::FLOATS_PER_VERTEX,
+				StaticPrimitives::PLANE_OCCLUDER.indices,
+				StaticPrimitives::PLANE_OCCLUDER.indexCount,
+				occluders[1]);
+			for (size_t i = 2; i < occluders.size(); i++)
+			{
+				culler.AddOccluder(
+					StaticPrimitives::BOX.vertices,
+					StaticPrimitives::FLOATS_PER_VERTEX,
+					StaticPrimitives::BOX.indices,
+					StaticPrimitives::BOX.indexCount,
+					occluders[i]);
+			}
+			culler.RasterizeOccluders();
+		}, repetitions);
+
+		int occludedCount = 0;
+		double testTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			occludedCount = 0;
+			for (int i = 0; i < occludeeCount; i++)
+			{
+				if (culler.IsBoxVisible(boxMin[i], boxMax[i]) == false)
+				{
+					occludedCount++;
+				}
+			}
+		}, repetitions);
+
+		char line[128];
+		snprintf(line, sizeof(line), "  %9d  %10d  %13.3f  %13.3f  %9d",
+			occluderCount,
+			culler.GetOccluderTriangleCount(),
+			rasterizeTime,
+			testTime,
+			occludedCount);
+		std::cout << line << std::endl;
+	}
+}
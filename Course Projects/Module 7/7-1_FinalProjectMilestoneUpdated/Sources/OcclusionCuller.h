@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// software rasterized depth buffer for occlusion culling on the CPU
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class rasterizes a few large occluders into a low
+ *  resolution depth buffer every frame, then rejects the
+ *  objects whose bounding boxes are completely behind it.
+ *
+ *  The buffer is split into tiles of 8 x 4 pixels.  Each
+ *  tile keeps the farthest depth of its pixels, so most
+ *  boxes are accepted or rejected from the tiles alone,
+ *  and only the tiles at the edge of an occluder are tested
+ *  pixel by pixel.  Rows of tiles are rasterized on the
+ *  shared thread pool, four pixels at a time with SSE.
+ *
+ *  Depth is the normalized device Z of OpenGL, smaller is
+ *  closer, and only front-facing occluder triangles are
+ *  rasterized.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// size of the depth buffer in pixels
+	static const int BUFFER_WIDTH = 320;
+	static const int BUFFER_HEIGHT = 180;
+	// size of the tiles holding the farthest depth
+	static const int TILE_WIDTH = 8;
+	static const int TILE_HEIGHT = 4;
+
+	// constructor
+	OcclusionCuller();
+
+	// start a frame with the camera matrix, dropping the
+	// occluders of the previous frame
+	void BeginFrame(const glm::mat4& viewProjection);
+	// add the triangles of an occluder mesh - the positions are
+	// the first three floats of each vertex
+	void AddOccluder(
+		const float* vertices,
+		int floatsPerVertex,
+		const GLuint* indices,
+		int indexCount,
+		const glm::mat4& modelMatrix);
+	// rasterize the occluders added since BeginFrame()
+	void RasterizeOccluders();
+
+	// true when any part of the world space box may be in
+	// front of the rasterized occluders
+	bool IsBoxVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+	// number of front-facing occluder triangles in the frame
+	int GetOccluderTriangleCount() const;
+
+	// time the rasterization and the box tests
+	static void RunBenchmark();
+
+private:
+	// screen space edge and depth equations of a triangle,
+	// each evaluated as A * x + B * y + C at pixel centers
+	struct SETUP_TRIANGLE
+	{
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		float depthA;
+		float depthB;
+		float depthC;
+		int minX;
+		int maxX;
+		int minY;
+		int maxY;
+	};
+
+	static const int TILES_X = BUFFER_WIDTH / TILE_WIDTH;
+	static const int TILES_Y = BUFFER_HEIGHT / TILE_HEIGHT;
+
+	glm::mat4 m_viewProjection;
+	std::vector<SETUP_TRIANGLE> m_triangles;
+	// clip space positions of the occluder being added
+	std::vector<glm::vec4> m_clipVertices;
+	std::vector<float> m_depth;
+	std::vector<float> m_tileMaxDepth;
+	bool m_bRasterized;
+
+	// clip a triangle against the near plane and set up the
+	// resulting screen space triangles
+	void AddClipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+	void SetupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+	// clear and rasterize a range of tile rows
+	void RasterizeTileRows(int firstRow, int endRow);
+};
@@ -0,0 +1,380 @@
+///////////////////////////////////////////////////////////////////////////////
+// potentiallyvisibleset.cpp
+// ============
+// precomputed sets of the objects visible from cells of the camera region
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PotentiallyVisibleSet.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+// declaration of global variables
+namespace
+{
+	// the ray origins of a cell are jittered over a grid of
+	// this many points along each axis
+	const int SAMPLE_GRID = 2;
+	// number of ray directions cast from each origin
+	const int RAYS_PER_SAMPLE = 1024;
+	// number of see-through objects a ray passes before it stops
+	const int MAX_SEE_THROUGH_HITS = 8;
+	// length of the rays, longer than any scene
+	const float MAX_RAY_DISTANCE = 1.0e4f;
+	// step past a see-through hit before casting again
+	const float SEE_THROUGH_STEP = 1.0e-3f;
+
+	/***********************************************************
+	 *  SphereDirection()
+	 *
+	 *  Get one of count directions spread evenly over the unit
+	 *  sphere on a Fibonacci spiral, turned around the Y axis
+	 *  by the passed in angle.
+	 ***********************************************************/
+	glm::vec3 SphereDirection(int index, int count, float turn)
+	{
+		const float goldenAngle = 2.39996323f;
+		float y = 1.0f - ((2.0f * (float)index + 1.0f) / (float)count);
+		float radius = std::sqrt(std::max(0.0f, 1.0f - (y * y)));
+		float angle = (goldenAngle * (float)index) + turn;
+		return(glm::vec3(std::cos(angle) * radius, y, std::sin(angle) * radius));
+	}
+}
+
+/***********************************************************
+ *  PotentiallyVisibleSet()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PotentiallyVisibleSet::PotentiallyVisibleSet()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for computing the objects visible
+ *  from every cell of the region.  Rays are cast in evenly
+ *  spread directions from jittered points inside the cell,
+ *  and every object a ray reaches is marked visible.  The
+ *  cells are baked in parallel, each writing only its own
+ *  words of the bitsets.
+ *
+ *  The sampling can miss objects that are thinner than the
+ *  gaps between the rays, so the cell size and ray counts
+ *  trade the bake time against how conservative the sets are.
+ ***********************************************************/
+void PotentiallyVisibleSet::Bake(
+	const glm::vec3& regionMin,
+	const glm::vec3& regionMax,
+	float cellSize,
+	const std::vector<bool>& seeThroughObjects,
+	const RAY_CAST& castRay)
+{
+	Clear();
+
+	m_regionMin = regionMin;
+	m_cellSize = cellSize;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_cellCount[axis] = std::max(1, (int)std::ceil((regionMax[axis] - regionMin[axis]) / cellSize));
+	}
+	m_objectCount = (int)seeThroughObjects.size();
+	m_wordsPerCell = (m_objectCount + 63) / 64;
+	m_bits.assign((size_t)GetCellCount() * (size_t)m_wordsPerCell, 0);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	ThreadPool::GetShared()->ParallelFor(GetCellCount(), [&](int begin, int end)
+	{
+		for (int cell = begin; cell < end; cell++)
+		{
+			uint64_t* bits = &m_bits[(size_t)cell * (size_t)m_wordsPerCell];
+			int cellX = cell % m_cellCount[0];
+			int cellY = (cell / m_cellCount[0]) % m_cellCount[1];
+			int cellZ = cell / (m_cellCount[0] * m_cellCount[1]);
+			glm::vec3 cellMin = m_regionMin + (glm::vec3((float)cellX, (float)cellY, (float)cellZ) * m_cellSize);
+
+			// the same seed for a cell gives the same sets on
+			// every bake, whatever the number of threads
+			std::mt19937 random((unsigned int)cell);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+			for (int sample = 0; sample < SAMPLE_GRID * SAMPLE_GRID * SAMPLE_GRID; sample++)
+			{
+				glm::vec3 jitter(
+					(float)(sample % SAMPLE_GRID) + unit(random),
+					(float)((sample / SAMPLE_GRID) % SAMPLE_GRID) + unit(random),
+					(float)(sample / (SAMPLE_GRID * SAMPLE_GRID)) + unit(random));
+				glm::vec3 sampleOrigin = cellMin + (jitter * (m_cellSize / (float)SAMPLE_GRID));
+				float turn = unit(random) * 6.28318531f;
+
+				for (int ray = 0; ray < RAYS_PER_SAMPLE; ray++)
+				{
+					glm::vec3 direction = SphereDirection(ray, RAYS_PER_SAMPLE, turn);
+					glm::vec3 origin = sampleOrigin;
+
+					for (int hit = 0; hit < MAX_SEE_THROUGH_HITS; hit++)
+					{
+						float distance = MAX_RAY_DISTANCE;
+						int object = castRay(origin, direction, distance);
+						if ((object < 0) || (object >= m_objectCount))
+						{
+							break;
+						}
+
+						bits[object / 64] |= (uint64_t)1 << (object % 64);
+						if (seeThroughObjects[object] == false)
+						{
+							break;
+						}
+						origin = origin + (direction * (distance + SEE_THROUGH_STEP));
+					}
+				}
+			}
+		}
+	});
+
+	auto stop = std::chrono::high_resolution_clock::now();
+	double elapsed = std::chrono::duration<double, std::milli>(stop - start).count();
+
+	// the average set size shows how much the sets cull
+	size_t visibleCount = 0;
+	for (int cell = 0; cell < GetCellCount(); cell++)
+	{
+		for (int object = 0; object < m_objectCount; object++)
+		{
+			visibleCount += IsObjectVisible(cell, object) ? 1 : 0;
+		}
+	}
+
+	char line[192];
+	snprintf(line, sizeof(line),
+		"INFO: Baked %d x %d x %d visibility cells in %.0f ms, %.1f of %d objects visible per cell",
+		m_cellCount[0],
+		m_cellCount[1],
+		m_cellCount[2],
+		elapsed,
+		(double)visibleCount / (double)GetCellCount(),
+		m_objectCount);
+	std::cout << line << std::endl;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for freeing the sets, after which the
+ *  camera is in no cell.
+ ***********************************************************/
+void PotentiallyVisibleSet::Clear()
+{
+	m_regionMin = glm::vec3(0.0f);
+	m_cellSize = 1.0f;
+	m_cellCount[0] = 0;
+	m_cellCount[1] = 0;
+	m_cellCount[2] = 0;
+	m_objectCount = 0;
+	m_wordsPerCell = 0;
+	m_bits.clear();
+}
+
+/***********************************************************
+ *  IsEmpty()
+ *
+ *  This method is used for checking whether any sets were
+ *  baked or loaded.
+ ***********************************************************/
+bool PotentiallyVisibleSet::IsEmpty() const
+{
+	return(m_bits.empty());
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the grid and the bitsets
+ *  of all cells into a file.
+ ***********************************************************/
+bool PotentiallyVisibleSet::Save(const char* filename) const
+{
+	PVS_FILE_HEADER header;
+	FILE* file = fopen(filename, "wb");
+
+	if (file == nullptr)
+	{
+		std::cout << "Could not create file:" << filename << std::endl;
+		return(false);
+	}
+
+	header.magic = PVS_FILE_MAGIC;
+	header.version = PVS_FILE_VERSION;
+	header.cellCountX = (uint32_t)m_cellCount[0];
+	header.cellCountY = (uint32_t)m_cellCount[1];
+	header.cellCountZ = (uint32_t)m_cellCount[2];
+	header.objectCount = (uint32_t)m_objectCount;
+	header.regionMin[0] = m_regionMin.x;
+	header.regionMin[1] = m_regionMin.y;
+	header.regionMin[2] = m_regionMin.z;
+	header.cellSize = m_cellSize;
+
+	bool bSuccess =
+		(fwrite(&header, sizeof(header), 1, file) == 1) &&
+		(fwrite(m_bits.data(), sizeof(uint64_t), m_bits.size(), file) == m_bits.size());
+	bSuccess = (fclose(file) == 0) && bSuccess;
+
+	if (bSuccess == false)
+	{
+		std::cout << "Could not write file:" << filename << std::endl;
+	}
+
+	return(bSuccess);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading the sets written by
+ *  Save(), checking that the file size matches its header.
+ ***********************************************************/
+bool PotentiallyVisibleSet::Load(const char* filename)
+{
+	PVS_FILE_HEADER header;
+	MappedFile file;
+
+	Clear();
+
+	if (file.Open(filename) == false)
+	{
+		std::cout << "Could not open file:" << filename << std::endl;
+		return(false);
+	}
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	if (size >= sizeof(header))
+	{
+		memcpy(&header, data, sizeof(header));
+	}
+
+	size_t cellCount = (size_t)header.cellCountX * (size_t)header.cellCountY * (size_t)header.cellCountZ;
+	size_t wordsPerCell = ((size_t)header.objectCount + 63) / 64;
+	if ((size < sizeof(header)) ||
+		(header.magic != PVS_FILE_MAGIC) ||
+		(header.version != PVS_FILE_VERSION) ||
+		(cellCount == 0) ||
+		(header.objectCount == 0) ||
+		(header.cellSize <= 0.0f) ||
+		(sizeof(header) + (cellCount * wordsPerCell * sizeof(uint64_t)) != size))
+	{
+		std::cout << "Not a valid PVS file:" << filename << std::endl;
+		return(false);
+	}
+
+	m_regionMin = glm::vec3(header.regionMin[0], header.regionMin[1], header.regionMin[2]);
+	m_cellSize = header.cellSize;
+	m_cellCount[0] = (int)header.cellCountX;
+	m_cellCount[1] = (int)header.cellCountY;
+	m_cellCount[2] = (int)header.cellCountZ;
+	m_objectCount = (int)header.objectCount;
+	m_wordsPerCell = (int)wordsPerCell;
+	m_bits.resize(cellCount * wordsPerCell);
+	memcpy(m_bits.data(), data + sizeof(header), m_bits.size() * sizeof(uint64_t));
+
+	return(true);
+}
+
+/***********************************************************
+ *  FindCell()
+ *
+ *  This method is used for finding the cell that holds the
+ *  passed in position, such as the camera position.
+ ***********************************************************/
+int PotentiallyVisibleSet::FindCell(const glm::vec3& position) const
+{
+	if (IsEmpty() == true)
+	{
+		return(-1);
+	}
+
+	int cell[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float offset = (position[axis] - m_regionMin[axis]) / m_cellSize;
+		if ((offset < 0.0f) || (offset >= (float)m_cellCount[axis]))
+		{
+			return(-1);
+		}
+		cell[axis] = (int)offset;
+	}
+
+	return(cell[0] + (m_cellCount[0] * (cell[1] + (m_cellCount[1] * cell[2]))));
+}
+
+/***********************************************************
+ *  GetVisibleObjects()
+ *
+ *  This method is used for reading the set of a cell into a
+ *  list of object indices, skipping the empty words.
+ ***********************************************************/
+void PotentiallyVisibleSet::GetVisibleObjects(int cell, std::vector<int>& objects) const
+{
+	objects.clear();
+
+	const uint64_t* bits = &m_bits[(size_t)cell * (size_t)m_wordsPerCell];
+	for (int word = 0; word < m_wordsPerCell; word++)
+	{
+		uint64_t remaining = bits[word];
+		for (int bit = 0; remaining != 0; bit++)
+		{
+			if ((remaining & 1) != 0)
+			{
+				objects.push_back((word * 64) + bit);
+			}
+			remaining = remaining >> 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsObjectVisible()
+ *
+ *  This method is used for checking one object in the set of
+ *  a cell.
+ ***********************************************************/
+bool PotentiallyVisibleSet::IsObjectVisible(int cell, int object) const
+{
+	uint64_t word = m_bits[((size_t)cell * (size_t)m_wordsPerCell) + (size_t)(object / 64)];
+	return(((word >> (object % 64)) & 1) != 0);
+}
+
+/***********************************************************
+ *  GetCellCount()
+ *
+ *  This method is used for getting the number of cells of
+ *  the grid.
+ ***********************************************************/
+int PotentiallyVisibleSet::GetCellCount() const
+{
+	return(m_cellCount[0] * m_cellCount[1] * m_cellCount[2]);
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of objects
+ *  each set was baked for.
+ ***********************************************************/
+int PotentiallyVisibleSet::GetObjectCount() const
+{
+	return(m_objectCount);
+}
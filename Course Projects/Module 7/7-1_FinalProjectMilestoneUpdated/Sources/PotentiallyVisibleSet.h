@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// potentiallyvisibleset.h
+// ============
+// precomputed sets of the objects visible from cells of the camera region
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/***********************************************************
+ *  PotentiallyVisibleSet
+ *
+ *  This class splits the region the camera can move in into
+ *  a grid of cells, and stores for each cell the objects of
+ *  a static scene that can be seen from anywhere inside it.
+ *
+ *  The sets are baked offline by casting rays in every
+ *  direction from points spread over each cell, on the
+ *  shared thread pool.  Each set is a bitset of one bit per
+ *  object, so looking up the cell of the camera and reading
+ *  its objects replaces the per-frame visibility tests.
+ ***********************************************************/
+class PotentiallyVisibleSet
+{
+public:
+	// find the closest object hit by the ray within the distance
+	// and shorten the distance to the hit - returns -1 when
+	// nothing is hit
+	typedef std::function<int(const glm::vec3& origin, const glm::vec3& direction, float& distance)> RAY_CAST;
+
+	struct PVS_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t cellCountX;
+		uint32_t cellCountY;
+		uint32_t cellCountZ;
+		uint32_t objectCount;
+		float regionMin[3];
+		float cellSize;
+	};
+
+	static const uint32_t PVS_FILE_MAGIC = 0x31535650;	// "PVS1"
+	static const uint32_t PVS_FILE_VERSION = 1;
+
+	// constructor
+	PotentiallyVisibleSet();
+
+	// bake the visible objects of every cell of the region -
+	// the rays pass through the see-through objects, and there
+	// is one entry per object in the vector
+	void Bake(
+		const glm::vec3& regionMin,
+		const glm::vec3& regionMax,
+		float cellSize,
+		const std::vector<bool>& seeThroughObjects,
+		const RAY_CAST& castRay);
+	// free the sets
+	void Clear();
+	// true when no sets are baked or loaded
+	bool IsEmpty() const;
+
+	// write and read the baked sets
+	bool Save(const char* filename) const;
+	bool Load(const char* filename);
+
+	// find the cell holding the position - returns -1 when the
+	// position is outside of the region
+	int FindCell(const glm::vec3& position) const;
+	// collect the objects visible from a cell, in index order
+	void GetVisibleObjects(int cell, std::vector<int>& objects) const;
+	// true when the object is visible from the cell
+	bool IsObjectVisible(int cell, int object) const;
+
+	// number of cells and of objects per set
+	int GetCellCount() const;
+	int GetObjectCount() const;
+
+private:
+	glm::vec3 m_regionMin;
+	float m_cellSize;
+	int m_cellCount[3];
+	int m_objectCount;
+	// 64 bit words of one set
+	int m_wordsPerCell;
+	// the sets of all cells, one after the other
+	std::vector<uint64_t> m_bits;
+};
@@ -0,0 +1,308 @@
+///////////////////////////////////////////////////////////////////////////////
+// programbinarycache.cpp
+// ============
+// linked shader programs saved to disk and reloaded on later launches
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ProgramBinaryCache.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  Continue a 64 bit FNV-1a hash over the passed in bytes.
+	 ***********************************************************/
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ULL;
+		}
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  HashString()
+	 *
+	 *  Continue the hash over a string and its length, so that
+	 *  moving text from one string to the next changes it.
+	 ***********************************************************/
+	uint64_t HashString(uint64_t hash, const std::string& text)
+	{
+		uint64_t length = (uint64_t)text.size();
+		hash = HashBytes(hash, &length, sizeof(length));
+		return(HashBytes(hash, text.data(), text.size()));
+	}
+
+	/***********************************************************
+	 *  GetDriverString()
+	 *
+	 *  Get one of the driver strings, empty when unavailable.
+	 ***********************************************************/
+	std::string GetDriverString(GLenum name)
+	{
+		const GLubyte* text = glGetString(name);
+		return((NULL != text) ? std::string((const char*)text) : std::string());
+	}
+}
+
+/***********************************************************
+ *  ProgramBinaryCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ProgramBinaryCache::ProgramBinaryCache()
+{
+	m_bOpen = false;
+	m_loaded = 0;
+	m_rejected = 0;
+	m_saved = 0;
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for starting to cache programs.  The
+ *  driver must return program binaries in at least one
+ *  format for the cache to be used.
+ ***********************************************************/
+bool ProgramBinaryCache::Open(const char* pathPrefix)
+{
+	m_bOpen = false;
+
+	if ((GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) == false)
+	{
+		return(false);
+	}
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	if (formatCount <= 0)
+	{
+		return(false);
+	}
+
+	m_pathPrefix = pathPrefix;
+	m_driver = GetDriverString(GL_VENDOR) + "|" +
+		GetDriverString(GL_RENDERER) + "|" +
+		GetDriverString(GL_VERSION);
+	m_bOpen = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsOpen()
+ *
+ *  This method is used for checking whether programs are
+ *  cached.
+ ***********************************************************/
+bool ProgramBinaryCache::IsOpen() const
+{
+	return(m_bOpen);
+}
+
+/***********************************************************
+ *  GetKey()
+ *
+ *  This method is used for hashing the sources of a program
+ *  with the driver strings.
+ ***********************************************************/
+uint64_t ProgramBinaryCache::GetKey(const std::string& vertexSource, const std::string& fragmentSource) const
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	hash = HashString(hash, m_driver);
+	hash = HashString(hash, vertexSource);
+	hash = HashString(hash, fragmentSource);
+	return(hash);
+}
+
+/***********************************************************
+ *  LoadProgram()
+ *
+ *  This method is used for loading the cached binary of a
+ *  key into a program.  A missing or damaged file, or a
+ *  binary the driver does not link, leaves the program to
+ *  be compiled from source.
+ ***********************************************************/
+bool ProgramBinaryCache::LoadProgram(GLuint program, uint64_t key)
+{
+	if (m_bOpen == false)
+	{
+		return(false);
+	}
+
+	PROGRAM_FILE_HEADER header;
+	MappedFile file;
+	std::string filename = GetFilename(key);
+
+	// no binary was saved for this key yet
+	if (file.Open(filename.c_str()) == false)
+	{
+		return(false);
+	}
+
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+	if (size >= sizeof(header))
+	{
+		memcpy(&header, data, sizeof(header));
+	}
+
+	if ((size < sizeof(header)) ||
+		(header.magic != PROGRAM_FILE_MAGIC) ||
+		(header.version != PROGRAM_FILE_VERSION) ||
+		(header.key != key) ||
+		(header.binaryLength == 0) ||
+		(sizeof(header) + (size_t)header.binaryLength != size))
+	{
+		std::cout << "Not a valid program binary file:" << filename << std::endl;
+		m_rejected++;
+		return(false);
+	}
+
+	glProgramBinary(program, (GLenum)header.binaryFormat, data + sizeof(header), (GLsizei)header.binaryLength);
+
+	GLint bLinked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &bLinked);
+	if (bLinked != GL_TRUE)
+	{
+		m_rejected++;
+		return(false);
+	}
+
+	m_loaded++;
+	return(true);
+}
+
+/***********************************************************
+ *  PrepareProgram()
+ *
+ *  This method is used for asking the driver to keep the
+ *  binary of a program, which must be done before linking.
+ ***********************************************************/
+void ProgramBinaryCache::PrepareProgram(GLuint program) const
+{
+	if (m_bOpen == true)
+	{
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+}
+
+/***********************************************************
+ *  SaveProgram()
+ *
+ *  This method is used for writing the binary of a linked
+ *  program into the file of its key.
+ ***********************************************************/
+bool ProgramBinaryCache::SaveProgram(GLuint program, uint64_t key)
+{
+	if (m_bOpen == false)
+	{
+		return(false);
+	}
+
+	GLint binaryLength = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0)
+	{
+		return(false);
+	}
+
+	std::vector<unsigned char> binary((size_t)binaryLength);
+	GLenum binaryFormat = 0;
+	GLsizei writtenLength = 0;
+	glGetProgramBinary(program, binaryLength, &writtenLength, &binaryFormat, binary.data());
+	if (writtenLength <= 0)
+	{
+		return(false);
+	}
+
+	PROGRAM_FILE_HEADER header;
+	std::string filename = GetFilename(key);
+	FILE* file = fopen(filename.c_str(), "wb");
+
+	if (file == nullptr)
+	{
+		std::cout << "Could not create file:" << filename << std::endl;
+		return(false);
+	}
+
+	header.magic = PROGRAM_FILE_MAGIC;
+	header.version = PROGRAM_FILE_VERSION;
+	header.key = key;
+	header.binaryFormat = (uint32_t)binaryFormat;
+	header.binaryLength = (uint32_t)writtenLength;
+
+	bool bSuccess =
+		(fwrite(&header, sizeof(header), 1, file) == 1) &&
+		(fwrite(binary.data(), 1, (size_t)writtenLength, file) == (size_t)writtenLength);
+	bSuccess = (fclose(file) == 0) && bSuccess;
+
+	if (bSuccess == false)
+	{
+		std::cout << "Could not write file:" << filename << std::endl;
+		remove(filename.c_str());
+		return(false);
+	}
+
+	m_saved++;
+	return(true);
+}
+
+/***********************************************************
+ *  GetLoadedCount()
+ *
+ *  This method is used for getting the number of programs
+ *  loaded from the cache.
+ ***********************************************************/
+int ProgramBinaryCache::GetLoadedCount() const
+{
+	return(m_loaded);
+}
+
+/***********************************************************
+ *  GetRejectedCount()
+ *
+ *  This method is used for getting the number of cached
+ *  binaries that were damaged or rejected by the driver.
+ ***********************************************************/
+int ProgramBinaryCache::GetRejectedCount() const
+{
+	return(m_rejected);
+}
+
+/***********************************************************
+ *  GetSavedCount()
+ *
+ *  This method is used for getting the number of programs
+ *  saved into the cache.
+ ***********************************************************/
+int ProgramBinaryCache::GetSavedCount() const
+{
+	return(m_saved);
+}
+
+/***********************************************************
+ *  GetFilename()
+ *
+ *  This method is used for getting the file of a key.
+ ***********************************************************/
+std::string ProgramBinaryCache::GetFilename(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return(m_pathPrefix + name);
+}
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// programbinarycache.h
+// ============
+// linked shader programs saved to disk and reloaded on later launches
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+
+/***********************************************************
+ *  ProgramBinaryCache
+ *
+ *  This class keeps the binaries of linked programs in
+ *  files, so that later launches load them instead of
+ *  compiling and linking the GLSL sources again.
+ *
+ *  A program is found by a hash of its sources, which hold
+ *  the injected defines, and of the vendor, renderer and
+ *  version strings of the driver.  A driver update changes
+ *  the hash, and a binary the driver still rejects is
+ *  compiled from source and saved again.
+ ***********************************************************/
+class ProgramBinaryCache
+{
+public:
+	// header at the start of each cached binary file
+	struct PROGRAM_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+	};
+
+	static const uint32_t PROGRAM_FILE_MAGIC = 0x31424750;	// "PGB1"
+	static const uint32_t PROGRAM_FILE_VERSION = 1;
+
+	// constructor
+	ProgramBinaryCache();
+
+	// start caching into files named by the path prefix and
+	// the program key - returns false when the driver cannot
+	// return program binaries, leaving the cache unused
+	bool Open(const char* pathPrefix);
+	// true when Open() succeeded
+	bool IsOpen() const;
+
+	// key of the program linked from the sources
+	uint64_t GetKey(const std::string& vertexSource, const std::string& fragmentSource) const;
+	// load the cached binary of the key into a new program -
+	// returns false when there is none or the driver rejects it
+	bool LoadProgram(GLuint program, uint64_t key);
+	// ask the driver to keep the binary of a program about to
+	// be linked from source
+	void PrepareProgram(GLuint program) const;
+	// save the binary of a linked program under the key
+	bool SaveProgram(GLuint program, uint64_t key);
+
+	// number of programs loaded, rejected by the driver, and
+	// saved since the cache was opened
+	int GetLoadedCount() const;
+	int GetRejectedCount() const;
+	int GetSavedCount() const;
+
+private:
+	std::string m_pathPrefix;
+	// vendor, renderer and version of the driver
+	std::string m_driver;
+	bool m_bOpen;
+	int m_loaded;
+	int m_rejected;
+	int m_saved;
+
+	// file holding the binary of a key
+	std::string GetFilename(uint64_t key) const;
+};
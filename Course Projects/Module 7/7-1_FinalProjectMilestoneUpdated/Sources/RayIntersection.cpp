@@ -0,0 +1,275 @@
+///////////////////////////////////////////////////////////////////////////////
+// rayintersection.cpp
+// ============
+// exact ray intersection tests against the object space scene primitives
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RayIntersection.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// the torus is marched until the ray is this close to its
+	// surface, relative to a main radius of one
+	const float TORUS_HIT_EPSILON = 1.0e-4f;
+	// steps taken before a grazing ray is counted as a miss
+	const int TORUS_MAX_STEPS = 256;
+
+	/***********************************************************
+	 *  IntersectSlabs()
+	 *
+	 *  Clip the ray against an axis aligned box, returning the
+	 *  parameters where it enters and leaves the box.
+	 ***********************************************************/
+	bool IntersectSlabs(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		const glm::vec3& boxMin,
+		const glm::vec3& boxMax,
+		float& enter,
+		float& leave)
+	{
+		enter = -1.0e30f;
+		leave = 1.0e30f;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (direction[axis] == 0.0f)
+			{
+				// parallel to the slab, inside or never
+				if ((origin[axis] < boxMin[axis]) || (origin[axis] > boxMax[axis]))
+				{
+					return(false);
+				}
+				continue;
+			}
+
+			float inverse = 1.0f / direction[axis];
+			float t0 = (boxMin[axis] - origin[axis]) * inverse;
+			float t1 = (boxMax[axis] - origin[axis]) * inverse;
+			enter = std::max(enter, std::min(t0, t1));
+			leave = std::min(leave, std::max(t0, t1));
+		}
+
+		return(enter <= leave);
+	}
+
+	/***********************************************************
+	 *  AcceptHit()
+	 *
+	 *  Shorten the distance to the parameter when it is inside
+	 *  the searched range.
+	 ***********************************************************/
+	bool AcceptHit(float t, float& distance)
+	{
+		if ((t >= 0.0f) && (t < distance))
+		{
+			distance = t;
+			return(true);
+		}
+		return(false);
+	}
+
+	/***********************************************************
+	 *  TorusDistance()
+	 *
+	 *  Signed distance from a point to the torus of main radius
+	 *  1 in the XY plane, or to its positive X and Y quarter.
+	 ***********************************************************/
+	float TorusDistance(const glm::vec3& point, float tubeRadius, bool bQuarter)
+	{
+		float ring = std::sqrt((point.x * point.x) + (point.y * point.y)) - 1.0f;
+		float distance = std::sqrt((ring * ring) + (point.z * point.z)) - tubeRadius;
+
+		if (bQuarter == true)
+		{
+			// intersection with the two half spaces, which never
+			// overestimates the distance
+			distance = std::max(distance, std::max(-point.x, -point.y));
+		}
+		return(distance);
+	}
+}
+
+/***********************************************************
+ *  IntersectBox()
+ *
+ *  This method is used for intersecting a ray with the unit
+ *  box centered on the origin.
+ ***********************************************************/
+bool RayIntersection::IntersectBox(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance)
+{
+	float enter = 0.0f;
+	float leave = 0.0f;
+
+	if (IntersectSlabs(origin, direction, glm::vec3(-0.5f), glm::vec3(0.5f), enter, leave) == false)
+	{
+		return(false);
+	}
+	if (AcceptHit(enter, distance) == true)
+	{
+		return(true);
+	}
+	return(AcceptHit(leave, distance));
+}
+
+/***********************************************************
+ *  IntersectPlane()
+ *
+ *  This method is used for intersecting a ray with the 2 x 2
+ *  plane lying in the XZ plane.
+ ***********************************************************/
+bool RayIntersection::IntersectPlane(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance)
+{
+	if (direction.y == 0.0f)
+	{
+		return(false);
+	}
+
+	float t = -origin.y / direction.y;
+	glm::vec3 point = origin + (direction * t);
+	if ((std::fabs(point.x) > 1.0f) || (std::fabs(point.z) > 1.0f))
+	{
+		return(false);
+	}
+	return(AcceptHit(t, distance));
+}
+
+/***********************************************************
+ *  IntersectCylinder()
+ *
+ *  This method is used for intersecting a ray with the
+ *  capped cylinder of radius 1 standing on the XZ plane.
+ ***********************************************************/
+bool RayIntersection::IntersectCylinder(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance)
+{
+	bool bHit = false;
+
+	// side wall, x^2 + z^2 = 1 between the caps
+	float a = (direction.x * direction.x) + (direction.z * direction.z);
+	float b = (origin.x * direction.x) + (origin.z * direction.z);
+	float c = (origin.x * origin.x) + (origin.z * origin.z) - 1.0f;
+	float discriminant = (b * b) - (a * c);
+	if ((a > 0.0f) && (discriminant >= 0.0f))
+	{
+		float root = std::sqrt(discriminant);
+		float roots[2] = { (-b - root) / a, (-b + root) / a };
+		for (float t : roots)
+		{
+			float y = origin.y + (direction.y * t);
+			if ((y >= 0.0f) && (y <= 1.0f) && (AcceptHit(t, distance) == true))
+			{
+				bHit = true;
+			}
+		}
+	}
+
+	// bottom and top caps
+	if (direction.y != 0.0f)
+	{
+		for (float capY = 0.0f; capY <= 1.0f; capY += 1.0f)
+		{
+			float t = (capY - origin.y) / direction.y;
+			float x = origin.x + (direction.x * t);
+			float z = origin.z + (direction.z * t);
+			if (((x * x) + (z * z) <= 1.0f) && (AcceptHit(t, distance) == true))
+			{
+				bHit = true;
+			}
+		}
+	}
+
+	return(bHit);
+}
+
+/***********************************************************
+ *  IntersectSphere()
+ *
+ *  This method is used for intersecting a ray with the unit
+ *  sphere centered on the origin.
+ ***********************************************************/
+bool RayIntersection::IntersectSphere(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance)
+{
+	float a = glm::dot(direction, direction);
+	float b = glm::dot(origin, direction);
+	float c = glm::dot(origin, origin) - 1.0f;
+	float discriminant = (b * b) - (a * c);
+	if ((a == 0.0f) || (discriminant < 0.0f))
+	{
+		return(false);
+	}
+
+	float root = std::sqrt(discriminant);
+	if (AcceptHit((-b - root) / a, distance) == true)
+	{
+		return(true);
+	}
+	return(AcceptHit((-b + root) / a, distance));
+}
+
+/***********************************************************
+ *  IntersectTorus()
+ *
+ *  This method is used for intersecting a ray with a torus.
+ *  Instead of solving the quartic, which loses precision for
+ *  thin tubes, the ray is clipped to the bounding box and
+ *  then sphere traced against the exact distance function
+ *  of the torus.
+ ***********************************************************/
+bool RayIntersection::IntersectTorus(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float tubeRadius,
+	bool bQuarter,
+	float& distance)
+{
+	glm::vec3 boxMin(-1.0f - tubeRadius, -1.0f - tubeRadius, -tubeRadius);
+	glm::vec3 boxMax(1.0f + tubeRadius, 1.0f + tubeRadius, tubeRadius);
+	if (bQuarter == true)
+	{
+		boxMin.x = 0.0f;
+		boxMin.y = 0.0f;
+	}
+
+	float enter = 0.0f;
+	float leave = 0.0f;
+	float length = glm::length(direction);
+	if ((length == 0.0f) ||
+		(IntersectSlabs(origin, direction, boxMin, boxMax, enter, leave) == false))
+	{
+		return(false);
+	}
+
+	// the distance function is measured in object space units,
+	// while the ray parameter advances by the direction length
+	float t = std::max(enter, 0.0f);
+	leave = std::min(leave, distance);
+	for (int step = 0; (step < TORUS_MAX_STEPS) && (t <= leave); step++)
+	{
+		float surfaceDistance = TorusDistance(origin + (direction * t), tubeRadius, bQuarter);
+		if (surfaceDistance < TORUS_HIT_EPSILON)
+		{
+			return(AcceptHit(t, distance));
+		}
+		t += surfaceDistance / length;
+	}
+
+	return(false);
+}
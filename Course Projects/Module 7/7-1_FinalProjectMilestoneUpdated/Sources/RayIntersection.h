@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// rayintersection.h
+// ============
+// exact ray intersection tests against the object space scene primitives
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  RayIntersection
+ *
+ *  This class tests rays against the primitives the scene
+ *  objects are drawn with, in the object space the meshes
+ *  are generated in.  A world ray moved into object space
+ *  with the inverse model matrix keeps its parameter, so
+ *  the distances returned here are the world distances as
+ *  long as the world direction has unit length.
+ *
+ *  Each test finds the closest hit at a distance between
+ *  zero and the passed in distance, and shortens the
+ *  distance to it.  Rays starting inside a solid count as
+ *  hitting it.
+ ***********************************************************/
+class RayIntersection
+{
+public:
+	// unit box centered on the origin
+	static bool IntersectBox(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance);
+	// 2 x 2 plane in the XZ plane, hit from both sides
+	static bool IntersectPlane(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance);
+	// capped cylinder of radius 1 from y = 0 to y = 1
+	static bool IntersectCylinder(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance);
+	// sphere of radius 1 centered on the origin
+	static bool IntersectSphere(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance);
+	// torus of main radius 1 lying in the XY plane, optionally
+	// cut down to the quarter with positive X and Y
+	static bool IntersectTorus(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float tubeRadius,
+		bool bQuarter,
+		float& distance);
+};
@@ -0,0 +1,315 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ============
+// hierarchy of local transformations with cached world matrices
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+#include "BenchmarkTimer.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+}
+
+/***********************************************************
+ *  ComposeMatrix()
+ *
+ *  This method is used for building a transformation matrix
+ *  from the scale, the rotations in X, Y and Z order, and
+ *  the translation.
+ ***********************************************************/
+glm::mat4 SceneGraph::ComposeMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	glm::mat4 scale = glm::scale(scaleXYZ);
+	glm::mat4 rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
+	glm::mat4 rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 translation = glm::translate(positionXYZ);
+
+	return(translation * rotationX * rotationY * rotationZ * scale);
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for adding a node below a parent that
+ *  already exists, which keeps every parent before its
+ *  children in the array.  The world matrix is ready at once
+ *  unless the parent is waiting for an update.
+ ***********************************************************/
+int SceneGraph::AddNode(
+	int parent,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	const int index = (int)m_nodes.size();
+	NODE node;
+
+	node.scaleXYZ = scaleXYZ;
+	node.XrotationDegrees = XrotationDegrees;
+	node.YrotationDegrees = YrotationDegrees;
+	node.ZrotationDegrees = ZrotationDegrees;
+	node.positionXYZ = positionXYZ;
+	node.localMatrix = ComposeMatrix(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	node.parent = ((parent >= 0) && (parent < index)) ? parent : -1;
+	node.firstChild = -1;
+	node.nextSibling = -1;
+	node.bDirty = false;
+
+	if (node.parent >= 0)
+	{
+		NODE& parentNode = m_nodes[node.parent];
+		node.worldMatrix = parentNode.worldMatrix * node.localMatrix;
+		node.nextSibling = parentNode.firstChild;
+		parentNode.firstChild = index;
+		// a dirty parent updates the new node along with itself
+		node.bDirty = parentNode.bDirty;
+	}
+	else
+	{
+		node.worldMatrix = node.localMatrix;
+	}
+
+	m_nodes.push_back(node);
+	return(index);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every node.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	m_nodes.clear();
+	m_dirtyNodes.clear();
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used for queueing a node for the next
+ *  update.  A node already marked is not queued twice.
+ ***********************************************************/
+void SceneGraph::MarkDirty(int node)
+{
+	if (m_nodes[node].bDirty == false)
+	{
+		m_nodes[node].bDirty = true;
+		m_dirtyNodes.push_back(node);
+	}
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used for changing the scale, rotation and
+ *  position of a node relative to its parent.
+ ***********************************************************/
+void SceneGraph::SetLocalTransform(
+	int node,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	NODE& target = m_nodes[node];
+
+	target.scaleXYZ = scaleXYZ;
+	target.XrotationDegrees = XrotationDegrees;
+	target.YrotationDegrees = YrotationDegrees;
+	target.ZrotationDegrees = ZrotationDegrees;
+	target.positionXYZ = positionXYZ;
+	target.localMatrix = ComposeMatrix(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	MarkDirty(node);
+}
+
+/***********************************************************
+ *  SetLocalPosition()
+ *
+ *  This method is used for moving a node relative to its
+ *  parent, keeping its scale and rotation.
+ ***********************************************************/
+void SceneGraph::SetLocalPosition(int node, glm::vec3 positionXYZ)
+{
+	const NODE& target = m_nodes[node];
+
+	SetLocalTransform(
+		node,
+		target.scaleXYZ,
+		target.XrotationDegrees,
+		target.YrotationDegrees,
+		target.ZrotationDegrees,
+		positionXYZ);
+}
+
+/***********************************************************
+ *  UpdateWorldTransforms()
+ *
+ *  This method is used for recomputing the world matrices
+ *  below the dirty nodes.  The dirty nodes are visited in
+ *  array order, so a dirty ancestor always comes first and
+ *  clears the flags of the dirty nodes in its subtree, which
+ *  are then skipped.
+ ***********************************************************/
+void SceneGraph::UpdateWorldTransforms(std::vector<int>& updatedNodes)
+{
+	updatedNodes.clear();
+	if (m_dirtyNodes.empty() == true)
+	{
+		return;
+	}
+
+	std::sort(m_dirtyNodes.begin(), m_dirtyNodes.end());
+	for (int root : m_dirtyNodes)
+	{
+		if (m_nodes[root].bDirty == false)
+		{
+			continue;
+		}
+
+		m_updateStack.push_back(root);
+		while (m_updateStack.empty() == false)
+		{
+			const int index = m_updateStack.back();
+			m_updateStack.pop_back();
+
+			NODE& node = m_nodes[index];
+			if (node.parent >= 0)
+			{
+				node.worldMatrix = m_nodes[node.parent].worldMatrix * node.localMatrix;
+			}
+			else
+			{
+				node.worldMatrix = node.localMatrix;
+			}
+			node.bDirty = false;
+			updatedNodes.push_back(index);
+
+			for (int child = node.firstChild; child >= 0; child = m_nodes[child].nextSibling)
+			{
+				m_updateStack.push_back(child);
+			}
+		}
+	}
+	m_dirtyNodes.clear();
+}
+
+/***********************************************************
+ *  GetWorldMatrix()
+ *
+ *  This method is used for getting the world matrix of a
+ *  node as of the last update.
+ ***********************************************************/
+const glm::mat4& SceneGraph::GetWorldMatrix(int node) const
+{
+	return(m_nodes[node].worldMatrix);
+}
+
+/***********************************************************
+ *  GetParent()
+ *
+ *  This method is used for getting the parent of a node.
+ ***********************************************************/
+int SceneGraph::GetParent(int node) const
+{
+	return(m_nodes[node].parent);
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used for getting the number of nodes.
+ ***********************************************************/
+int SceneGraph::GetNodeCount() const
+{
+	return((int)m_nodes.size());
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the updates of graphs made
+ *  of groups of objects under one root - moving the root,
+ *  moving one group, and moving one object.
+ ***********************************************************/
+void SceneGraph::RunBenchmark()
+{
+	const int groupSizes[] = { 100, 1000 };
+	const int repetitions = 5;
+
+	std::cout << "INFO: Scene graph benchmark" << std::endl;
+	std::cout << "      nodes   root ms   group ms   object ms" << std::endl;
+
+	for (int groupSize : groupSizes)
+	{
+		SceneGraph graph;
+		std::vector<int> updatedNodes;
+
+		int root = graph.AddNode(-1, glm::vec3(1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f));
+		int firstGroup = -1;
+		int lastObject = -1;
+		for (int group = 0; group < groupSize; group++)
+		{
+			int groupNode = graph.AddNode(root, glm::vec3(1.0f), 0.0f, (float)group, 0.0f, glm::vec3((float)group, 0.0f, 0.0f));
+			if (firstGroup < 0)
+			{
+				firstGroup = groupNode;
+			}
+			for (int object = 0; object < groupSize; object++)
+			{
+				lastObject = graph.AddNode(groupNode, glm::vec3(0.5f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, (float)object, 0.0f));
+			}
+		}
+
+		float offset = 0.0f;
+		double rootTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			offset += 1.0f;
+			graph.SetLocalPosition(root, glm::vec3(offset, 0.0f, 0.0f));
+			graph.UpdateWorldTransforms(updatedNodes);
+		}, repetitions);
+		double groupTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			offset += 1.0f;
+			graph.SetLocalPosition(firstGroup, glm::vec3(0.0f, offset, 0.0f));
+			graph.UpdateWorldTransforms(updatedNodes);
+		}, repetitions);
+		double objectTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			offset += 1.0f;
+			graph.SetLocalPosition(lastObject, glm::vec3(0.0f, 0.0f, offset));
+			graph.UpdateWorldTransforms(updatedNodes);
+		}, repetitions);
+
+		char line[128];
+		snprintf(line, sizeof(line), "  %9d  %8.3f  %9.3f  %10.4f",
+			graph.GetNodeCount(),
+			rootTime,
+			groupTime,
+			objectTime);
+		std::cout << line << std::endl;
+	}
+}
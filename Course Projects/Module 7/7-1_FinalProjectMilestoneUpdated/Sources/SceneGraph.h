@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// hierarchy of local transformations with cached world matrices
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  This class places every node relative to its parent with
+ *  a local scale, rotation and position, and caches the
+ *  resulting world matrix of each node.
+ *
+ *  The nodes are stored in one flat array where a parent
+ *  always comes before its children, and each node links to
+ *  its children.  Changing a node only marks it dirty, and
+ *  UpdateWorldTransforms() then recomputes the world
+ *  matrices of the dirty subtrees alone - moving a group is
+ *  one change and an update of the nodes below it.
+ ***********************************************************/
+class SceneGraph
+{
+public:
+	// constructor
+	SceneGraph();
+
+	// add a node below the parent, or a root node when the
+	// parent is -1 - returns the index of the new node
+	int AddNode(
+		int parent,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// remove every node
+	void Clear();
+
+	// change the local transformation of a node, its subtree
+	// is updated by the next UpdateWorldTransforms()
+	void SetLocalTransform(
+		int node,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	void SetLocalPosition(int node, glm::vec3 positionXYZ);
+	// recompute the world matrices of the dirty subtrees, and
+	// list the nodes whose world matrix changed
+	void UpdateWorldTransforms(std::vector<int>& updatedNodes);
+
+	// get the world matrix of a node as of the last update
+	const glm::mat4& GetWorldMatrix(int node) const;
+	// get the parent of a node, -1 for a root node
+	int GetParent(int node) const;
+	// number of nodes in the graph
+	int GetNodeCount() const;
+
+	// build a matrix from the scale, the rotations in X, Y and
+	// Z order, and the translation
+	static glm::mat4 ComposeMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// time full and partial updates of large graphs
+	static void RunBenchmark();
+
+private:
+	struct NODE
+	{
+		glm::mat4 localMatrix;
+		glm::mat4 worldMatrix;
+		glm::vec3 scaleXYZ;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		glm::vec3 positionXYZ;
+		int parent;
+		int firstChild;
+		int nextSibling;
+		bool bDirty;
+	};
+
+	// the nodes, parents always stored before their children
+	std::vector<NODE> m_nodes;
+	// nodes changed since the last update
+	std::vector<int> m_dirtyNodes;
+	// nodes left to visit while updating a subtree
+	std::vector<int> m_updateStack;
+
+	// mark a node for the next update
+	void MarkDirty(int node);
+};
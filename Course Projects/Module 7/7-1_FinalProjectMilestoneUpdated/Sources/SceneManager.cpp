@@ -8,6 +8,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "StaticPrimitives.h"
+#include "RayIntersection.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -16,6 +18,17 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define TEXTURE_ALPHA_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
 // declaration of global variables
 namespace
 {
@@ -24,6 +37,414 @@ namespace
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_AlphaTestName = "bAlphaTest";
+	const char* g_UVScaleName = "UVscale";
+	const char* g_UseClusteredLightsName = "bUseClusteredLights";
+	const char* g_UseObjectLightsName = "bUseObjectLights";
+	const char* g_ObjectLightOffsetName = "objectLightOffset";
+	const char* g_ObjectLightCountName = "objectLightCount";
+	const char* g_UseLightmapName = "bUseLightmap";
+	const char* g_LightmapShapeName = "lightmapShape";
+	const char* g_LightmapRectName = "lightmapRect";
+	const char* g_UseLightProbesName = "bUseLightProbes";
+	const char* g_VertexLightingName = "bVertexLighting";
+	const char* g_OrderIndependentName = "bOrderIndependent";
+
+	// material of the objects lit by the clustered lights or
+	// the deferred light passes
+	const glm::vec3 CLUSTER_DIFFUSE_COLOR = glm::vec3(1.0f);
+	const glm::vec3 CLUSTER_SPECULAR_COLOR = glm::vec3(0.2f);
+	const float CLUSTER_SHININESS = 32.0f;
+
+	// largest simplification error, in pixels, allowed when
+	// choosing the level of detail of an imported model
+	const float LOD_MAX_PIXEL_ERROR = 1.0f;
+
+	// tessellation of the generated torus meshes
+	const int TORUS_MAIN_SEGMENTS = 256;
+	const int TORUS_TUBE_SEGMENTS = 64;
+	// tessellation of the generated sphere mesh
+	const int SPHERE_STACKS = 64;
+	const int SPHERE_SLICES = 128;
+
+	// tube radius of the generated torus meshes, relative to
+	// their main radius of one
+	const float TORUS_TUBE_RADIUS = 0.3f;
+	const float THICK_TORUS_TUBE_RADIUS = 0.35f;
+	// thickness of the quarter torus rod curves
+	const float QUARTER_TORUS_TUBE_RADIUS = 0.2f;
+
+	// objects smaller than a pixel in both directions are not
+	// drawn by default
+	const float DEFAULT_SMALL_OBJECT_PIXELS = 1.0f;
+	// lit objects covering fewer pixels than a 20 x 20 square
+	// are lit per vertex by default
+	const float DEFAULT_VERTEX_LIGHTING_PIXELS = 400.0f;
+
+	// region the camera moves in, above the floor and in front
+	// of the background, split into cells for the baked
+	// visible sets
+	const glm::vec3 PVS_REGION_MIN = glm::vec3(-20.0f, 0.1f, -9.9f);
+	const glm::vec3 PVS_REGION_MAX = glm::vec3(20.0f, 10.0f, 20.0f);
+	const float PVS_CELL_SIZE = 2.5f;
+
+	// the lightmap atlas is bound after the three light buffers
+	// that follow the scene textures
+	const int LIGHTMAP_UNIT_OFFSET = 3;
+	// the directional and spot shadow maps follow the lightmap,
+	// and the light probe grid follows them
+	const int SHADOW_UNIT_OFFSET = 4;
+	const int LIGHT_PROBE_UNIT_OFFSET = 6;
+	// distance between the baked light probes, and the rays
+	// each probe casts
+	const float LIGHT_PROBE_SPACING = 2.0f;
+	const int LIGHT_PROBE_RAYS = 256;
+
+	// share of the directional and spot light color in the
+	// ambient and specular terms
+	const float SCENE_LIGHT_AMBIENT = 0.1f;
+	const float SCENE_LIGHT_SPECULAR = 0.5f;
+	// the meshlets are culled for the directional shadow map as
+	// if seen from this far against the light direction
+	const float DIRECTIONAL_LIGHT_DISTANCE = 1.0e4f;
+
+	/***********************************************************
+	 *  SetSceneLightValues()
+	 *
+	 *  Set the directional and spot light, and the matrices and
+	 *  texture units of their shadow maps, into a shader taking
+	 *  the light uniforms of the scene shader.  The shadow
+	 *  samplers always point at their own units, as samplers of
+	 *  different types must not share a unit.  The lights add
+	 *  no ambient when the light probes bring it instead.
+	 ***********************************************************/
+	template <typename SHADER>
+	void SetSceneLightValues(
+		SHADER* pShader,
+		const SceneManager::SCENE_LIGHT& directionalLight,
+		const SceneManager::SCENE_LIGHT& spotLight,
+		const ShadowMaps& shadowMaps,
+		int firstShadowUnit,
+		bool bProbeAmbient)
+	{
+		const float ambient = bProbeAmbient ? 0.0f : SCENE_LIGHT_AMBIENT;
+
+		pShader->setIntValue("directionalLight.bActive", directionalLight.bActive);
+		if (directionalLight.bActive == true)
+		{
+			pShader->setVec3Value("directionalLight.direction", directionalLight.direction);
+			pShader->setVec3Value("directionalLight.ambient", directionalLight.color * ambient);
+			pShader->setVec3Value("directionalLight.diffuse", directionalLight.color);
+			pShader->setVec3Value("directionalLight.specular", directionalLight.color * SCENE_LIGHT_SPECULAR);
+		}
+
+		pShader->setIntValue("spotLight.bActive", spotLight.bActive);
+		if (spotLight.bActive == true)
+		{
+			// the attenuation falls to about a hundredth at the range
+			float range = std::max(spotLight.range, 0.01f);
+			pShader->setVec3Value("spotLight.position", spotLight.position);
+			pShader->setVec3Value("spotLight.direction", spotLight.direction);
+			pShader->setFloatValue("spotLight.cutOff", std::cos(glm::radians(spotLight.cutOffDegrees)));
+			pShader->setFloatValue("spotLight.outerCutOff", std::cos(glm::radians(spotLight.outerCutOffDegrees)));
+			pShader->setFloatValue("spotLight.constant", 1.0f);
+			pShader->setFloatValue("spotLight.linear", 4.5f / range);
+			pShader->setFloatValue("spotLight.quadratic", 75.0f / (range * range));
+			pShader->setVec3Value("spotLight.ambient", spotLight.color * ambient);
+			pShader->setVec3Value("spotLight.diffuse", spotLight.color);
+			pShader->setVec3Value("spotLight.specular", spotLight.color * SCENE_LIGHT_SPECULAR);
+		}
+
+		pShader->setIntValue("bDirectionalShadow",
+			(directionalLight.bActive == true) && (shadowMaps.IsActive(ShadowMaps::SHADOW_DIRECTIONAL) == true));
+		pShader->setMat4Value("directionalShadowMatrix", shadowMaps.GetShadowMatrix(ShadowMaps::SHADOW_DIRECTIONAL));
+		pShader->setSampler2DValue("directionalShadowMap", firstShadowUnit);
+		pShader->setIntValue("bSpotShadow",
+			(spotLight.bActive == true) && (shadowMaps.IsActive(ShadowMaps::SHADOW_SPOT) == true));
+		pShader->setMat4Value("spotShadowMatrix", shadowMaps.GetShadowMatrix(ShadowMaps::SHADOW_SPOT));
+		pShader->setSampler2DValue("spotShadowMap", firstShadowUnit + 1);
+	}
+
+	/***********************************************************
+	 *  SetUniformValue()
+	 *
+	 *  Set a uniform into a shader through the setter matching
+	 *  the type of the value.  The flags and samplers are set
+	 *  as integers.
+	 ***********************************************************/
+	template <typename SHADER>
+	void SetUniformValue(SHADER* pShader, const std::string& name, int value)
+	{
+		pShader->setIntValue(name, value);
+	}
+	template <typename SHADER>
+	void SetUniformValue(SHADER* pShader, const std::string& name, float value)
+	{
+		pShader->setFloatValue(name, value);
+	}
+	template <typename SHADER>
+	void SetUniformValue(SHADER* pShader, const std::string& name, const glm::vec2& value)
+	{
+		pShader->setVec2Value(name, value);
+	}
+	template <typename SHADER>
+	void SetUniformValue(SHADER* pShader, const std::string& name, const glm::vec3& value)
+	{
+		pShader->setVec3Value(name, value);
+	}
+	template <typename SHADER>
+	void SetUniformValue(SHADER* pShader, const std::string& name, const glm::vec4& value)
+	{
+		pShader->setVec4Value(name, value);
+	}
+	template <typename SHADER>
+	void SetUniformValue(SHADER* pShader, const std::string& name, const glm::mat4& value)
+	{
+		pShader->setMat4Value(name, value);
+	}
+
+	/***********************************************************
+	 *  ClassifyImageAlpha()
+	 *
+	 *  Scan the alpha channel of an RGBA image, four pixels at
+	 *  a time with SSE.  The scan stops at the first pixel that
+	 *  is neither fully opaque nor fully clear.
+	 ***********************************************************/
+	SceneManager::TEXTURE_ALPHA ClassifyImageAlpha(const unsigned char* image, size_t pixelCount)
+	{
+		bool bAllOpaque = true;
+		size_t pixel = 0;
+
+#ifdef TEXTURE_ALPHA_USE_SSE
+		const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+		const __m128i zero = _mm_setzero_si128();
+		__m128i allOpaque = _mm_set1_epi32(-1);
+		for (; pixel + 4 <= pixelCount; pixel += 4)
+		{
+			__m128i alpha = _mm_and_si128(
+				_mm_loadu_si128((const __m128i*)(image + (pixel * 4))),
+				alphaMask);
+			__m128i opaque = _mm_cmpeq_epi32(alpha, alphaMask);
+			__m128i clear = _mm_cmpeq_epi32(alpha, zero);
+			if (_mm_movemask_epi8(_mm_or_si128(opaque, clear)) != 0xFFFF)
+			{
+				return(SceneManager::TEXTURE_BLENDED);
+			}
+			allOpaque = _mm_and_si128(allOpaque, opaque);
+		}
+		bAllOpaque = (_mm_movemask_epi8(allOpaque) == 0xFFFF);
+#endif
+
+		for (; pixel < pixelCount; pixel++)
+		{
+			unsigned char alpha = image[(pixel * 4) + 3];
+			if ((alpha != 0) && (alpha != 255))
+			{
+				return(SceneManager::TEXTURE_BLENDED);
+			}
+			bAllOpaque = bAllOpaque && (alpha == 255);
+		}
+
+		return(bAllOpaque ? SceneManager::TEXTURE_OPAQUE : SceneManager::TEXTURE_ALPHA_TESTED);
+	}
+
+	/***********************************************************
+	 *  PackImageRGB()
+	 *
+	 *  Drop the alpha channel of an RGBA image in place, the
+	 *  RGB pixels are written over the front of the image.
+	 ***********************************************************/
+	void PackImageRGB(unsigned char* image, size_t pixelCount)
+	{
+		for (size_t pixel = 0; pixel < pixelCount; pixel++)
+		{
+			image[(pixel * 3) + 0] = image[(pixel * 4) + 0];
+			image[(pixel * 3) + 1] = image[(pixel * 4) + 1];
+			image[(pixel * 3) + 2] = image[(pixel * 4) + 2];
+		}
+	}
+
+	/***********************************************************
+	 *  AverageImageColor()
+	 *
+	 *  Average the RGB channels of an image stored with three
+	 *  or four channels per pixel.
+	 ***********************************************************/
+	glm::vec3 AverageImageColor(const unsigned char* image, size_t pixelCount, int channels)
+	{
+		uint64_t sum[3] = { 0, 0, 0 };
+		for (size_t pixel = 0; pixel < pixelCount; pixel++)
+		{
+			sum[0] += image[(pixel * channels) + 0];
+			sum[1] += image[(pixel * channels) + 1];
+			sum[2] += image[(pixel * channels) + 2];
+		}
+
+		float scale = 1.0f / (255.0f * (float)std::max(pixelCount, (size_t)1));
+		return(glm::vec3((float)sum[0], (float)sum[1], (float)sum[2]) * scale);
+	}
+
+	/***********************************************************
+	 *  TransformBounds()
+	 *
+	 *  Compute the world space box around a transformed object
+	 *  space box, from its center and its half extents.
+	 ***********************************************************/
+	void TransformBounds(
+		const glm::mat4& matrix,
+		const glm::vec3& localMin,
+		const glm::vec3& localMax,
+		glm::vec3& worldMin,
+		glm::vec3& worldMax)
+	{
+		glm::vec3 center = glm::vec3(matrix * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+		glm::vec3 extent = (localMax - localMin) * 0.5f;
+		glm::vec3 worldExtent =
+			(glm::abs(glm::vec3(matrix[0])) * extent.x) +
+			(glm::abs(glm::vec3(matrix[1])) * extent.y) +
+			(glm::abs(glm::vec3(matrix[2])) * extent.z);
+
+		worldMin = center - worldExtent;
+		worldMax = center + worldExtent;
+	}
+
+	/***********************************************************
+	 *  ProjectBounds()
+	 *
+	 *  Compute the screen rectangle around a world space box,
+	 *  returning its width and height and the pixels it covers
+	 *  inside the viewport.  A box reaching behind the camera
+	 *  is counted as covering the whole viewport.
+	 ***********************************************************/
+	float ProjectBounds(
+		const glm::mat4& viewProjection,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		float viewportWidth,
+		float viewportHeight,
+		float& width,
+		float& height)
+	{
+		glm::vec2 screenMin(1.0e30f);
+		glm::vec2 screenMax(-1.0e30f);
+
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec4 clip = viewProjection * glm::vec4(
+				(corner & 1) ? boundsMax.x : boundsMin.x,
+				(corner & 2) ? boundsMax.y : boundsMin.y,
+				(corner & 4) ? boundsMax.z : boundsMin.z,
+				1.0f);
+			if (clip.w <= 0.0f)
+			{
+				width = viewportWidth;
+				height = viewportHeight;
+				return(viewportWidth * viewportHeight);
+			}
+
+			glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+			screenMin = glm::min(screenMin, ndc);
+			screenMax = glm::max(screenMax, ndc);
+		}
+
+		// normalized device coordinates span two units
+		width = (screenMax.x - screenMin.x) * viewportWidth * 0.5f;
+		height = (screenMax.y - screenMin.y) * viewportHeight * 0.5f;
+
+		float coveredWidth = (std::min(screenMax.x, 1.0f) - std::max(screenMin.x, -1.0f)) * viewportWidth * 0.5f;
+		float coveredHeight = (std::min(screenMax.y, 1.0f) - std::max(screenMin.y, -1.0f)) * viewportHeight * 0.5f;
+		return(std::max(coveredWidth, 0.0f) * std::max(coveredHeight, 0.0f));
+	}
+
+	/***********************************************************
+	 *  GetMeshBounds()
+	 *
+	 *  Get the object space bounding box of a scene mesh.
+	 ***********************************************************/
+	void GetMeshBounds(SceneManager::SCENE_MESH mesh, glm::vec3& boundsMin, glm::vec3& boundsMax)
+	{
+		float tube = 0.0f;
+
+		switch (mesh)
+		{
+		case SceneManager::MESH_PLANE:
+			// 2 x 2 plane in the XZ plane
+			boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+			boundsMax = glm::vec3(1.0f, 0.0f, 1.0f);
+			return;
+		case SceneManager::MESH_BOX:
+			// unit box centered on the origin
+			boundsMin = glm::vec3(-0.5f);
+			boundsMax = glm::vec3(0.5f);
+			return;
+		case SceneManager::MESH_CYLINDER:
+			// cylinder of radius 1 from y = 0 to y = 1
+			boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+			boundsMax = glm::vec3(1.0f, 1.0f, 1.0f);
+			return;
+		case SceneManager::MESH_SPHERE:
+			boundsMin = glm::vec3(-1.0f);
+			boundsMax = glm::vec3(1.0f);
+			return;
+		case SceneManager::MESH_TORUS:
+			tube = TORUS_TUBE_RADIUS;
+			break;
+		case SceneManager::MESH_THICK_TORUS:
+			tube = THICK_TORUS_TUBE_RADIUS;
+			break;
+		case SceneManager::MESH_QUARTER_TORUS:
+			// bounded like the full torus it is cut from
+			tube = QUARTER_TORUS_TUBE_RADIUS;
+			break;
+		case SceneManager::MESH_MODEL:
+			// bounded by the imported model instead
+			boundsMin = glm::vec3(0.0f);
+			boundsMax = glm::vec3(0.0f);
+			return;
+		}
+
+		// torus of main radius 1 lying in the XY plane
+		boundsMin = glm::vec3(-1.0f - tube, -1.0f - tube, -tube);
+		boundsMax = glm::vec3(1.0f + tube, 1.0f + tube, tube);
+	}
+
+	/***********************************************************
+	 *  GetMeshChartShape()
+	 *
+	 *  Get the lightmap chart layout of a scene mesh, and the
+	 *  tube radius of the torus meshes.
+	 ***********************************************************/
+	LightmapBaker::CHART_SHAPE GetMeshChartShape(SceneManager::SCENE_MESH mesh, float& tubeRadius)
+	{
+		tubeRadius = 0.0f;
+
+		switch (mesh)
+		{
+		case SceneManager::MESH_PLANE:
+			return(LightmapBaker::CHART_PLANE);
+		case SceneManager::MESH_BOX:
+			return(LightmapBaker::CHART_BOX);
+		case SceneManager::MESH_CYLINDER:
+			return(LightmapBaker::CHART_CYLINDER);
+		case SceneManager::MESH_SPHERE:
+			return(LightmapBaker::CHART_SPHERE);
+		case SceneManager::MESH_TORUS:
+			tubeRadius = TORUS_TUBE_RADIUS;
+			return(LightmapBaker::CHART_TORUS);
+		case SceneManager::MESH_THICK_TORUS:
+			tubeRadius = THICK_TORUS_TUBE_RADIUS;
+			return(LightmapBaker::CHART_TORUS);
+		case SceneManager::MESH_QUARTER_TORUS:
+			tubeRadius = QUARTER_TORUS_TUBE_RADIUS;
+			return(LightmapBaker::CHART_QUARTER_TORUS);
+		case SceneManager::MESH_MODEL:
+			// the imported models have no chart, and are not
+			// lightmapped
+			return(LightmapBaker::CHART_BOX);
+		}
+
+		return(LightmapBaker::CHART_PLANE);
+	}
 }
 
 /***********************************************************
@@ -34,13 +455,58 @@ namespace
 SceneManager::SceneManager(ShaderManager* pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
+	m_pShaderVariants = NULL;
+	m_bUseLighting = false;
+	m_activePointLights = 0;
+	m_bVariantsOutdated = false;
+	m_lightAssignment = LIGHTS_PER_CLUSTER;
+	m_directionalLight = {};
+	m_spotLight = {};
+	m_pDepthShaderManager = NULL;
+	m_bDepthPrePass = false;
+	m_pDeferredRenderer = NULL;
+	m_bDeferredShading = false;
+	m_pTransparencyRenderer = NULL;
+	m_bOrderIndependent = false;
+	m_bAccumulatingTransparency = false;
+	m_bSortObjects = true;
+	m_bCountShadedSamples = false;
+	m_shadedSampleQuery = 0;
+	m_shadedSamples = 0;
 	m_basicMeshes = new ShapeMeshes();
+	m_boxMesh = {};
+	m_cylinderMesh = {};
+	m_planeMesh.glMesh = {};
+	m_torusMesh.glMesh = {};
+	m_thickTorusMesh.glMesh = {};
+	m_sphereMesh = {};
+	m_modelMatrix = glm::mat4(1.0f);
+	m_cameraPosition = glm::vec3(0.0f);
+	m_lodPixelScale = 0.0f;
+	m_bOrthographicView = false;
+	m_visibleMeshlets = 0;
+	m_culledMeshlets = 0;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewProjection = glm::mat4(1.0f);
+	m_groupNode = -1;
+	m_drawnObjects = 0;
+	m_culledObjects = 0;
+	m_occludedObjects = 0;
+	m_smallObjects = 0;
+	m_viewportWidth = 0.0f;
+	m_viewportHeight = 0.0f;
+	m_smallObjectPixels = DEFAULT_SMALL_OBJECT_PIXELS;
+	m_totalCoverage = 0.0f;
+	m_vertexLightingPixels = DEFAULT_VERTEX_LIGHTING_PIXELS;
+	m_vertexLitObjects = 0;
 
 	// initialize the texture collection
 	for (int i = 0; i < 16; i++)
 	{
 		m_textureIDs[i].tag = "/0";
 		m_textureIDs[i].ID = -1;
+		m_textureIDs[i].alpha = TEXTURE_OPAQUE;
 	}
 	m_loadedTextures = 0;
 }
@@ -54,12 +520,67 @@ SceneManager::~SceneManager()
 {
 	// clear the allocated memory
 	m_pShaderManager = NULL;
+	m_pShaderVariants = NULL;
+	m_pDepthShaderManager = NULL;
+	if (m_shadedSampleQuery != 0)
+	{
+		glDeleteQueries(1, &m_shadedSampleQuery);
+		m_shadedSampleQuery = 0;
+	}
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	// free the generated meshes
+	ShapeGenerator::DestroyMesh(m_boxMesh);
+	ShapeGenerator::DestroyMesh(m_cylinderMesh);
+	MeshletBuilder::DestroyMeshletMesh(m_planeMesh);
+	MeshletBuilder::DestroyMeshletMesh(m_torusMesh);
+	MeshletBuilder::DestroyMeshletMesh(m_thickTorusMesh);
+	ShapeGenerator::DestroyMesh(m_sphereMesh);
+	// free the imported models
+	for (size_t i = 0; i < m_importedModels.size(); i++)
+	{
+		MeshImporter::DestroyModel(m_importedModels[i].model);
+	}
+	m_importedModels.clear();
 	// destroy the created OpenGL textures
 	DestroyGLTextures();
 }
 
+/***********************************************************
+ *  SetShaderValue()
+ *
+ *  This method is used for setting a uniform value into the
+ *  shader variants when they are used, or else into the
+ *  shader manager program.
+ ***********************************************************/
+template <typename VALUE>
+void SceneManager::SetShaderValue(const std::string& name, const VALUE& value)
+{
+	if (NULL != m_pShaderVariants)
+	{
+		SetUniformValue(m_pShaderVariants, name, value);
+	}
+	else if (NULL != m_pShaderManager)
+	{
+		SetUniformValue(m_pShaderManager, name, value);
+	}
+}
+
+/***********************************************************
+ *  SetShaderFeature()
+ *
+ *  This method is used for setting a feature flag into the
+ *  shader manager program.  The shader variants are compiled
+ *  with their features instead, so nothing is set into them.
+ ***********************************************************/
+void SceneManager::SetShaderFeature(const std::string& name, bool bEnabled)
+{
+	if ((NULL == m_pShaderVariants) && (NULL != m_pShaderManager))
+	{
+		m_pShaderManager->setIntValue(name, bEnabled);
+	}
+}
+
 /***********************************************************
  *  CreateGLTexture()
  *
@@ -101,9 +622,31 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+		// an RGBA image whose pixels are all fully opaque is
+		// stored without its alpha channel
+		TEXTURE_ALPHA alpha = TEXTURE_OPAQUE;
+		if (colorChannels == 4)
+		{
+			size_t pixelCount = (size_t)width * (size_t)height;
+			alpha = ClassifyImageAlpha(image, pixelCount);
+			if (alpha == TEXTURE_OPAQUE)
+			{
+				PackImageRGB(image, pixelCount);
+				colorChannels = 3;
+			}
+			std::cout << "Texture " << tag << " alpha: "
+				<< ((alpha == TEXTURE_OPAQUE) ? "opaque, stored as RGB" : (alpha == TEXTURE_ALPHA_TESTED) ? "alpha tested" : "blended")
+				<< std::endl;
+		}
+
 		// if the loaded image is in RGB format
 		if (colorChannels == 3)
+		{
+			// the RGB rows are not always a multiple of four bytes
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
 		// if the loaded image is in RGBA format - it supports transparency
 		else if (colorChannels == 4)
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
@@ -113,6 +656,8 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 			return false;
 		}
 
+		glm::vec3 averageColor = AverageImageColor(image, (size_t)width * (size_t)height, colorChannels);
+
 		// generate the texture mipmaps for mapping textures to lower resolutions
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -123,6 +668,8 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 		// register the loaded texture and associate it with the special tag string
 		m_textureIDs[m_loadedTextures].ID = textureID;
 		m_textureIDs[m_loadedTextures].tag = tag;
+		m_textureIDs[m_loadedTextures].alpha = alpha;
+		m_textureIDs[m_loadedTextures].averageColor = averageColor;
 		m_loadedTextures++;
 
 		return true;
@@ -216,6 +763,24 @@ int SceneManager::FindTextureSlot(std::string tag)
 	return(textureSlot);
 }
 
+/***********************************************************
+ *  GetTextureAlpha()
+ *
+ *  This method is used for getting how the loaded texture
+ *  with the passed in tag uses its alpha channel, which
+ *  chooses between the opaque, alpha tested and blended
+ *  drawing.
+ ***********************************************************/
+SceneManager::TEXTURE_ALPHA SceneManager::GetTextureAlpha(std::string tag)
+{
+	int textureSlot = FindTextureSlot(tag);
+	if (textureSlot < 0)
+	{
+		return(TEXTURE_OPAQUE);
+	}
+	return(m_textureIDs[textureSlot].alpha);
+}
+
 /***********************************************************
  *  FindMaterial()
  *
@@ -251,6 +816,109 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 	return(true);
 }
 
+/***********************************************************
+ *  LoadSceneModel()
+ *
+ *  This method is used for importing an OBJ, glTF or LOD
+ *  model file and storing it under the passed in tag.  OBJ
+ *  meshes can be simplified into levels of detail at load
+ *  time, while .lod files already contain them.
+ ***********************************************************/
+bool SceneManager::LoadSceneModel(const char* filename, std::string tag, bool bBuildLODs)
+{
+	MODEL_INFO modelInfo;
+
+	if (MeshImporter::ImportModel(filename, modelInfo.model, bBuildLODs) == false)
+	{
+		std::cout << "Could not load model:" << filename << std::endl;
+		return(false);
+	}
+
+	modelInfo.tag = tag;
+	m_importedModels.push_back(modelInfo);
+
+	return(true);
+}
+
+/***********************************************************
+ *  FindSceneModel()
+ *
+ *  This method is used for getting the index of the imported
+ *  model associated with the passed in tag, -1 when no model
+ *  was imported under it.
+ ***********************************************************/
+int SceneManager::FindSceneModel(std::string tag) const
+{
+	for (size_t i = 0; i < m_importedModels.size(); i++)
+	{
+		if (m_importedModels[i].tag.compare(tag) == 0)
+		{
+			return((int)i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  DrawSceneModel()
+ *
+ *  This method is used for drawing an imported model placed
+ *  by the model matrix of its scene object, which is culled
+ *  with the other objects before.  Each primitive with
+ *  levels of detail draws the coarsest one whose error stays
+ *  under a pixel on screen.
+ ***********************************************************/
+void SceneManager::DrawSceneModel(int modelIndex, ShaderManager* pShader)
+{
+	const MeshImporter::IMPORTED_MODEL& model = m_importedModels[modelIndex].model;
+
+	for (size_t i = 0; i < model.instances.size(); i++)
+	{
+		const MeshImporter::IMPORTED_INSTANCE& instance = model.instances[i];
+		const MeshImporter::IMPORTED_PRIMITIVE& primitive = model.primitives[instance.primitive];
+		glm::mat4 instanceMatrix = m_modelMatrix * instance.transform;
+		int lod = 0;
+
+		if (primitive.lods.size() > 1)
+		{
+			// the error grows with the largest scale axis, and
+			// shrinks with the distance in perspective views
+			float scale = std::max(
+				glm::length(glm::vec3(instanceMatrix[0])),
+				std::max(glm::length(glm::vec3(instanceMatrix[1])), glm::length(glm::vec3(instanceMatrix[2]))));
+			float pixelsPerUnit = m_lodPixelScale * scale;
+			if (m_bOrthographicView == false)
+			{
+				glm::vec4 center = instanceMatrix * glm::vec4((primitive.boundsMin + primitive.boundsMax) * 0.5f, 1.0f);
+				float distance = glm::length(glm::vec3(center) - m_cameraPosition);
+				pixelsPerUnit = pixelsPerUnit / std::max(distance, 0.1f);
+			}
+			lod = MeshSimplifier::SelectLOD(primitive.lods, pixelsPerUnit, LOD_MAX_PIXEL_ERROR);
+		}
+
+		if (NULL != pShader)
+		{
+			pShader->setMat4Value(g_ModelName, instanceMatrix);
+		}
+		else
+		{
+			SetShaderValue(g_ModelName, instanceMatrix);
+		}
+		MeshImporter::DrawPrimitive(model, instance.primitive, lod);
+	}
+
+	// restore the model matrix for the following draws
+	if (NULL != pShader)
+	{
+		pShader->setMat4Value(g_ModelName, m_modelMatrix);
+	}
+	else
+	{
+		SetShaderValue(g_ModelName, m_modelMatrix);
+	}
+}
+
 /***********************************************************
  *  SetTransformations()
  *
@@ -264,29 +932,25 @@ void SceneManager::SetTransformations(
 	float ZrotationDegrees,
 	glm::vec3 positionXYZ)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+	SetModelMatrix(SceneGraph::ComposeMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ));
+}
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
+/***********************************************************
+ *  SetModelMatrix()
+ *
+ *  This method is used for setting an already composed
+ *  model matrix into the shader, such as the world matrix of
+ *  a scene graph node.
+ ***********************************************************/
+void SceneManager::SetModelMatrix(const glm::mat4& modelMatrix)
+{
+	m_modelMatrix = modelMatrix;
+	SetShaderValue(g_ModelName, modelMatrix);
 }
 
 /***********************************************************
@@ -309,11 +973,9 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
+	SetShaderFeature(g_UseTextureName, false);
+	SetShaderFeature(g_AlphaTestName, false);
+	SetShaderValue(g_ColorValueName, currentColor);
 }
 
 /***********************************************************
@@ -324,18 +986,19 @@ void SceneManager::SetShaderColor(
  ***********************************************************/
 void SceneManager::SetShaderTexture(std::string textureTag)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+	SetShaderFeature(g_UseTextureName, true);
 
-		int textureSlot = FindTextureSlot(textureTag);
-		if (textureSlot >= 0)
-		{
-			glActiveTexture(GL_TEXTURE0 + textureSlot);
-			glBindTexture(GL_TEXTURE_2D, m_textureIDs[textureSlot].ID);
-			m_pShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
-		}
+	int textureSlot = FindTextureSlot(textureTag);
+	if (textureSlot >= 0)
+	{
+		glActiveTexture(GL_TEXTURE0 + textureSlot);
+		glBindTexture(GL_TEXTURE_2D, m_textureIDs[textureSlot].ID);
+		SetShaderValue(g_TextureValueName, textureSlot);
 	}
+	// discard the clear pixels instead of blending them
+	SetShaderFeature(
+		g_AlphaTestName,
+		(textureSlot >= 0) && (m_textureIDs[textureSlot].alpha == TEXTURE_ALPHA_TESTED));
 }
 
 /***********************************************************
@@ -346,10 +1009,7 @@ void SceneManager::SetShaderTexture(std::string textureTag)
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
+	SetShaderValue(g_UVScaleName, glm::vec2(u, v));
 }
 
 /***********************************************************
@@ -369,61 +1029,1998 @@ void SceneManager::SetShaderMaterial(
 		bReturn = FindMaterial(materialTag, material);
 		if (bReturn == true)
 		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			SetShaderValue("material.ambientColor", material.ambientColor);
+			SetShaderValue("material.ambientStrength", material.ambientStrength);
+			SetShaderValue("material.diffuseColor", material.diffuseColor);
+			SetShaderValue("material.specularColor", material.specularColor);
+			SetShaderValue("material.shininess", material.shininess);
 		}
 	}
 }
 
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
-
-/***************************************************************
-*  LoadSceneTextures()                                         *
-*                                                              *
-*  This method is used for preparing the 3D scene by loading   *
-*  the shapes, textures in memory to support the 3D scene      *
-*  rendering                                                   *
-****************************************************************/
-void SceneManager::LoadSceneTextures()
+/***********************************************************
+ *  DrawMeshletMesh()
+ *
+ *  This method is used for culling the meshlets of the passed
+ *  in mesh against the camera, using the scene graph world
+ *  matrix set by the last SetModelMatrix() call, and drawing
+ *  only the visible and front-facing meshlets.
+ ***********************************************************/
+void SceneManager::DrawMeshletMesh(
+	MeshletBuilder::MESHLET_MESH& meshletMesh)
 {
-	// Load wood texture for the bead maze base, ring            
-	// stacker base, and ring stacker vertical rod               
-	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/oakwood.jpg", "oakWood");
+	MeshletBuilder::CullMeshlets(
+		meshletMesh,
+		m_modelMatrix,
+		m_viewFrustum,
+		m_cameraPosition);
 
-	// Load metal texture for the bead maze rods
-	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/metal.jpg", "metalTexture");
+	m_visibleMeshlets += meshletMesh.visibleMeshlets;
+	m_culledMeshlets += meshletMesh.culledMeshlets;
 
+	MeshletBuilder::DrawVisibleMeshlets(meshletMesh);
+}
 
-	// Load steel texture for the bead maze rods
-	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/stainless.jpg", "steelTexture");
+/***********************************************************
+ *  AddSceneObject()
+ *
+ *  This method is used for adding an object to the list of
+ *  objects drawn by RenderScene(), along with the world
+ *  space bounding box used for culling it.  Occluders must
+ *  be opaque and use a box or plane mesh.
+ ***********************************************************/
+void SceneManager::AddSceneObject(
+	std::string name,
+	SCENE_MESH mesh,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	std::string textureTag,
+	std::string materialTag,
+	glm::vec2 UVscale,
+	glm::vec4 color,
+	bool bOccluder)
+{
+	SCENE_OBJECT object;
 
-	/*************************************************************
-	*    Load different colored plastic textures for the bead    *
-	*    maze beads and the rings of the ring stacker            *
-	**************************************************************/
+	object.name = name;
+	object.mesh = mesh;
+	object.model = -1;
+	object.node = m_sceneGraph.AddNode(
+		m_groupNode,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+	object.scaleXYZ = scaleXYZ;
+	object.XrotationDegrees = XrotationDegrees;
+	object.YrotationDegrees = YrotationDegrees;
+	object.ZrotationDegrees = ZrotationDegrees;
+	object.positionXYZ = positionXYZ;
+	object.textureTag = textureTag;
+	object.materialTag = materialTag;
+	object.UVscale = UVscale;
+	object.color = color;
+	object.bOccluder = bOccluder;
+	object.bDynamic = false;
+	object.bTransparent = (IsObjectOpaque(object) == false);
+	object.bAlphaTested =
+		(object.textureTag.empty() == false) &&
+		(GetTextureAlpha(object.textureTag) == TEXTURE_ALPHA_TESTED);
+
+	glm::vec3 localMin;
+	glm::vec3 localMax;
+	GetMeshBounds(mesh, localMin, localMax);
+	TransformBounds(
+		m_sceneGraph.GetWorldMatrix(object.node),
+		localMin,
+		localMax,
+		object.boundsMin,
+		object.boundsMax);
+
+	m_nodeObjects.resize(m_sceneGraph.GetNodeCount(), -1);
+	m_nodeObjects[object.node] = (int)m_sceneObjects.size();
+	m_sceneObjects.push_back(object);
+}
 
-	// Load light blue plastic texture
-	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/lightblueplastic.jpg", "ltbluePlastic");
+/***********************************************************
+ *  AddSceneModel()
+ *
+ *  This method is used for adding an object drawn with the
+ *  imported model of the passed in tag.  It is culled like
+ *  the other objects, by the box of the model placed with
+ *  the transformation of the object, and casts shadows, but
+ *  is never an occluder and is left out of the lightmap.
+ *  The object boxes are indexed again, so that models can
+ *  be added after PrepareScene().
+ ***********************************************************/
+bool SceneManager::AddSceneModel(
+	std::string modelTag,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	std::string textureTag,
+	glm::vec2 UVscale,
+	glm::vec4 color)
+{
+	const int model = FindSceneModel(modelTag);
+	if (model < 0)
+	{
+		std::cout << "No model was imported as:" << modelTag << std::endl;
+		return(false);
+	}
 
-	// Load blue plastic texture
-	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/blueplastic.jpg", "bluePlastic");
+	AddSceneObject(
+		modelTag,
+		MESH_MODEL,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ,
+		textureTag,
+		"",
+		UVscale,
+		color);
+
+	SCENE_OBJECT& object = m_sceneObjects.back();
+	object.model = model;
+
+	glm::vec3 localMin;
+	glm::vec3 localMax;
+	GetObjectLocalBounds(object, localMin, localMax);
+	TransformBounds(
+		m_sceneGraph.GetWorldMatrix(object.node),
+		localMin,
+		localMax,
+		object.boundsMin,
+		object.boundsMax);
+
+	BuildObjectHierarchy();
+	PrecompileObjectVariants();
 
-	// Load magenta plastic texture
-	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/magentaplastic.jpg", "magentaPlastic");
+	return(true);
+}
 
-	// Load red plastic texture
-	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/redplastic.jpg", "redPlastic");
+/***********************************************************
+ *  GetObjectLocalBounds()
+ *
+ *  This method is used for getting the object space bounding
+ *  box of a scene object, from its generated mesh or its
+ *  imported model.
+ ***********************************************************/
+void SceneManager::GetObjectLocalBounds(const SCENE_OBJECT& object, glm::vec3& boundsMin, glm::vec3& boundsMax) const
+{
+	if (object.mesh == MESH_MODEL)
+	{
+		boundsMin = m_importedModels[object.model].model.boundsMin;
+		boundsMax = m_importedModels[object.model].model.boundsMax;
+		return;
+	}
 
-	// Load yellow-orange plastic texture
-	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/orangeplastic.jpg", "orangePlastic");
+	GetMeshBounds(object.mesh, boundsMin, boundsMax);
+}
+
+/***********************************************************
+ *  BeginSceneGroup()
+ *
+ *  This method is used for starting a group of scene objects
+ *  that are positioned relative to the group, so that the
+ *  whole group is moved by changing the group position.
+ ***********************************************************/
+int SceneManager::BeginSceneGroup(glm::vec3 positionXYZ)
+{
+	m_groupNode = m_sceneGraph.AddNode(
+		m_groupNode,
+		glm::vec3(1.0f),
+		0.0f,
+		0.0f,
+		0.0f,
+		positionXYZ);
+	m_nodeObjects.resize(m_sceneGraph.GetNodeCount(), -1);
+
+	return(m_groupNode);
+}
+
+/***********************************************************
+ *  EndSceneGroup()
+ *
+ *  This method is used for ending the current group, the
+ *  objects added next are placed in the enclosing group.
+ ***********************************************************/
+void SceneManager::EndSceneGroup()
+{
+	if (m_groupNode >= 0)
+	{
+		m_groupNode = m_sceneGraph.GetParent(m_groupNode);
+	}
+}
+
+/***********************************************************
+ *  DrawSceneMesh()
+ *
+ *  This method is used for drawing the mesh of a scene
+ *  object with the current shader settings.
+ ***********************************************************/
+void SceneManager::DrawSceneMesh(const SCENE_OBJECT& object, ShaderManager* pShader)
+{
+	switch (object.mesh)
+	{
+	case MESH_PLANE:
+		DrawMeshletMesh(m_planeMesh);
+		break;
+	case MESH_BOX:
+		ShapeGenerator::DrawMesh(m_boxMesh);
+		break;
+	case MESH_CYLINDER:
+		ShapeGenerator::DrawMesh(m_cylinderMesh);
+		break;
+	case MESH_SPHERE:
+		ShapeGenerator::DrawMesh(m_sphereMesh);
+		break;
+	case MESH_TORUS:
+		DrawMeshletMesh(m_torusMesh);
+		break;
+	case MESH_THICK_TORUS:
+		DrawMeshletMesh(m_thickTorusMesh);
+		break;
+	case MESH_QUARTER_TORUS:
+		m_basicMeshes->DrawQuarterTorusMesh(QUARTER_TORUS_TUBE_RADIUS);
+		break;
+	case MESH_MODEL:
+		DrawSceneModel(object.model, pShader);
+		break;
+	}
+}
+
+/***********************************************************
+ *  DrawSceneObject()
+ *
+ *  This method is used for setting the transformation, the
+ *  texture or color, and the light list of a scene object
+ *  into the shader and drawing its mesh.
+ ***********************************************************/
+void SceneManager::DrawSceneObject(int index)
+{
+	const SCENE_OBJECT& object = m_sceneObjects[index];
+
+	// the objects covering few pixels are lit per vertex
+	const bool bVertexLit = IsObjectVertexLit(index);
+	if (NULL != m_pShaderVariants)
+	{
+		m_pShaderVariants->Use(GetObjectVariant(index, bVertexLit, m_bAccumulatingTransparency));
+	}
+	SetShaderFeature(g_VertexLightingName, bVertexLit);
+
+	// the objects baked into the lightmap read their lighting
+	// from their chart
+	const bool bLightmapped = m_lightmap.HasChart(index);
+	if (bLightmapped == true)
+	{
+		float tubeRadius = 0.0f;
+		int chartShape = (int)GetMeshChartShape(object.mesh, tubeRadius);
+		SetShaderValue(g_LightmapShapeName, chartShape);
+		SetShaderValue(g_LightmapRectName, m_lightmap.GetChartRect(index));
+	}
+	SetShaderFeature(g_UseLightmapName, bLightmapped);
+
+	if ((m_pointLights.empty() == false) && (m_lightAssignment == LIGHTS_PER_OBJECT))
+	{
+		glm::ivec2 lightList = m_objectLights.GetObjectList(index);
+		SetShaderValue(g_ObjectLightOffsetName, lightList.x);
+		SetShaderValue(g_ObjectLightCountName, lightList.y);
+	}
+
+	// set the world matrix of the object into memory to be
+	// used on the drawn meshes
+	SetModelMatrix(m_sceneGraph.GetWorldMatrix(object.node));
+
+	SetTextureUVScale(object.UVscale.x, object.UVscale.y);
+	if (object.textureTag.empty() == true)
+	{
+		SetShaderColor(object.color.r, object.color.g, object.color.b, object.color.a);
+	}
+	else
+	{
+		SetShaderTexture(object.textureTag);
+	}
+
+	DrawSceneMesh(object);
+}
+
+/***********************************************************
+ *  GetObjectVariant()
+ *
+ *  This method is used for getting the key of the shader
+ *  variant that holds only the features a scene object is
+ *  drawn with.
+ ***********************************************************/
+uint32_t SceneManager::GetObjectVariant(int index, bool bVertexLighting, bool bOrderIndependent) const
+{
+	const SCENE_OBJECT& object = m_sceneObjects[index];
+	uint32_t features = 0;
+
+	if (object.textureTag.empty() == false)
+	{
+		features |= ShaderVariants::FEATURE_TEXTURE;
+	}
+	if (object.bAlphaTested == true)
+	{
+		features |= ShaderVariants::FEATURE_ALPHA_TEST;
+	}
+	if (m_bUseLighting == true)
+	{
+		features |= ShaderVariants::FEATURE_LIGHTING;
+	}
+	if ((m_pointLights.empty() == false) && (m_lightAssignment == LIGHTS_PER_CLUSTER))
+	{
+		features |= ShaderVariants::FEATURE_CLUSTERED_LIGHTS;
+	}
+	if ((m_pointLights.empty() == false) && (m_lightAssignment == LIGHTS_PER_OBJECT))
+	{
+		features |= ShaderVariants::FEATURE_OBJECT_LIGHTS;
+	}
+	if (m_lightmap.HasChart(index) == true)
+	{
+		features |= ShaderVariants::FEATURE_LIGHTMAP;
+	}
+	if (m_lightProbes.IsEmpty() == false)
+	{
+		features |= ShaderVariants::FEATURE_LIGHT_PROBES;
+	}
+	if (bVertexLighting == true)
+	{
+		features |= ShaderVariants::FEATURE_VERTEX_LIGHTING;
+	}
+	if (bOrderIndependent == true)
+	{
+		features |= ShaderVariants::FEATURE_ORDER_INDEPENDENT;
+	}
+
+	return(ShaderVariants::MakeKey(features, m_activePointLights));
+}
+
+/***********************************************************
+ *  IsObjectOpaque()
+ *
+ *  This method is used for checking whether a scene object
+ *  hides everything behind it - its color is fully opaque,
+ *  or its texture has no alpha channel.
+ ***********************************************************/
+bool SceneManager::IsObjectOpaque(const SCENE_OBJECT& object)
+{
+	if (object.textureTag.empty() == true)
+	{
+		return(object.color.a >= 1.0f);
+	}
+
+	// the alpha tested pixels are either opaque or discarded
+	return(GetTextureAlpha(object.textureTag) != TEXTURE_BLENDED);
+}
+
+/***********************************************************
+ *  RenderDepthPrePass()
+ *
+ *  This method is used for writing the depth of the visible
+ *  opaque objects with the depth only shader.  The shading
+ *  pass that follows then runs the fragment shader once per
+ *  pixel instead of once per overlapping object.
+ ***********************************************************/
+void SceneManager::RenderDepthPrePass()
+{
+	m_pDepthShaderManager->use();
+	m_pDepthShaderManager->setMat4Value("view", m_viewMatrix);
+	m_pDepthShaderManager->setMat4Value("projection", m_projectionMatrix);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+	for (size_t i = 0; i < m_opaqueObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_opaqueObjects[i]];
+
+		m_modelMatrix = m_sceneGraph.GetWorldMatrix(object.node);
+		m_pDepthShaderManager->setMat4Value(g_ModelName, m_modelMatrix);
+
+		// the clear pixels of alpha tested textures must not
+		// write depth either
+		m_pDepthShaderManager->setIntValue(g_AlphaTestName, object.bAlphaTested);
+		if (object.bAlphaTested == true)
+		{
+			int textureSlot = FindTextureSlot(object.textureTag);
+			glActiveTexture(GL_TEXTURE0 + textureSlot);
+			glBindTexture(GL_TEXTURE_2D, m_textureIDs[textureSlot].ID);
+			m_pDepthShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
+			m_pDepthShaderManager->setVec2Value(g_UVScaleName, object.UVscale);
+		}
+
+		DrawSceneMesh(object, m_pDepthShaderManager);
+	}
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	m_pShaderManager->use();
+	if (NULL != m_pShaderVariants)
+	{
+		m_pShaderVariants->ResetBinding();
+	}
+
+	// the meshlets are counted by the shading pass
+	m_visibleMeshlets = 0;
+	m_culledMeshlets = 0;
+}
+
+/***********************************************************
+ *  RenderDeferredObjects()
+ *
+ *  This method is used for writing the albedo, normal,
+ *  specular color and shininess, and depth of the visible
+ *  opaque objects into the geometry buffer, then lighting
+ *  every covered pixel once.  The scene textures are bound
+ *  again afterwards, as the lighting reads the geometry
+ *  buffer through the first texture units.
+ ***********************************************************/
+bool SceneManager::RenderDeferredObjects()
+{
+	if (m_pDeferredRenderer->BeginGeometryPass((int)m_viewportWidth, (int)m_viewportHeight) == false)
+	{
+		return(false);
+	}
+
+	ShaderManager* pGeometryShader = m_pDeferredRenderer->GetGeometryShader();
+	pGeometryShader->setMat4Value("view", m_viewMatrix);
+	pGeometryShader->setMat4Value("projection", m_projectionMatrix);
+	pGeometryShader->setVec3Value("material.specularColor", CLUSTER_SPECULAR_COLOR);
+	pGeometryShader->setFloatValue("material.shininess", CLUSTER_SHININESS);
+
+	for (size_t i = 0; i < m_opaqueObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_opaqueObjects[i]];
+
+		m_modelMatrix = m_sceneGraph.GetWorldMatrix(object.node);
+		pGeometryShader->setMat4Value(g_ModelName, m_modelMatrix);
+		pGeometryShader->setVec2Value(g_UVScaleName, object.UVscale);
+		pGeometryShader->setIntValue(g_AlphaTestName, object.bAlphaTested);
+		if (object.textureTag.empty() == true)
+		{
+			pGeometryShader->setIntValue(g_UseTextureName, false);
+			pGeometryShader->setVec4Value(g_ColorValueName, object.color);
+		}
+		else
+		{
+			int textureSlot = FindTextureSlot(object.textureTag);
+			glActiveTexture(GL_TEXTURE0 + textureSlot);
+			glBindTexture(GL_TEXTURE_2D, m_textureIDs[textureSlot].ID);
+			pGeometryShader->setIntValue(g_UseTextureName, true);
+			pGeometryShader->setSampler2DValue(g_TextureValueName, textureSlot);
+		}
+
+		DrawSceneMesh(object, pGeometryShader);
+	}
+
+	// the lighting pass shades with the same directional and
+	// spot light, and their shadow maps, as the scene shader
+	ShaderManager* pLightingShader = m_pDeferredRenderer->GetLightingShader();
+	pLightingShader->use();
+	SetSceneLightValues(
+		pLightingShader,
+		m_directionalLight,
+		m_spotLight,
+		m_shadowMaps,
+		m_loadedTextures + SHADOW_UNIT_OFFSET,
+		false);
+
+	m_pDeferredRenderer->RenderLighting(
+		m_viewMatrix,
+		m_projectionMatrix,
+		m_cameraPosition,
+		m_pointLights,
+		m_bUseLighting);
+
+	BindGLTextures();
+	glActiveTexture(GL_TEXTURE0);
+	m_pShaderManager->use();
+	if (NULL != m_pShaderVariants)
+	{
+		m_pShaderVariants->ResetBinding();
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  RenderOrderIndependentObjects()
+ *
+ *  This method is used for adding the visible transparent
+ *  objects into the order independent transparency targets,
+ *  then blending their average over the window once.  The
+ *  layers add up the same in any order, so the objects are
+ *  drawn grouped by shader variant and texture instead of
+ *  back to front, and each variant is bound once.  The
+ *  scene textures are bound again afterwards, as the
+ *  composite pass reads the targets through the first
+ *  texture units.
+ ***********************************************************/
+bool SceneManager::RenderOrderIndependentObjects()
+{
+	if (m_pTransparencyRenderer->BeginAccumulation((int)m_viewportWidth, (int)m_viewportHeight) == false)
+	{
+		return(false);
+	}
+
+	m_objectVariantKeys.resize(m_sceneObjects.size(), 0);
+	for (size_t i = 0; i < m_transparentObjects.size(); i++)
+	{
+		int index = m_transparentObjects[i];
+		m_objectVariantKeys[index] = GetObjectVariant(index, IsObjectVertexLit(index), true);
+	}
+	const std::vector<uint32_t>& variantKeys = m_objectVariantKeys;
+	const std::vector<SCENE_OBJECT>& sceneObjects = m_sceneObjects;
+	std::sort(m_transparentObjects.begin(), m_transparentObjects.end(),
+		[&variantKeys, &sceneObjects](int a, int b)
+		{
+			if (variantKeys[a] != variantKeys[b])
+			{
+				return(variantKeys[a] < variantKeys[b]);
+			}
+			return(sceneObjects[a].textureTag < sceneObjects[b].textureTag);
+		});
+
+	m_bAccumulatingTransparency = true;
+	SetShaderFeature(g_OrderIndependentName, true);
+	for (size_t i = 0; i < m_transparentObjects.size(); i++)
+	{
+		DrawSceneObject(m_transparentObjects[i]);
+	}
+	m_bAccumulatingTransparency = false;
+
+	m_pTransparencyRenderer->Composite();
+
+	BindGLTextures();
+	glActiveTexture(GL_TEXTURE0);
+	m_pShaderManager->use();
+	if (NULL != m_pShaderVariants)
+	{
+		m_pShaderVariants->ResetBinding();
+	}
+	SetShaderFeature(g_OrderIndependentName, false);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SortVisibleObjects()
+ *
+ *  This method is used for splitting the visible objects
+ *  into the opaque and transparent passes.  The opaque
+ *  objects are sorted front to back, so the closer surfaces
+ *  fill the depth buffer first and the hidden fragments of
+ *  the farther ones are rejected before shading.  The
+ *  transparent objects are sorted back to front, so each one
+ *  is blended over everything behind it.
+ ***********************************************************/
+void SceneManager::SortVisibleObjects()
+{
+	m_opaqueObjects.clear();
+	m_transparentObjects.clear();
+	m_objectViewDepth.resize(m_sceneObjects.size(), 0.0f);
+
+	for (size_t i = 0; i < m_visibleObjects.size(); i++)
+	{
+		int index = m_visibleObjects[i];
+		const SCENE_OBJECT& object = m_sceneObjects[index];
+
+		// distance of the box center along the view direction,
+		// which also orders the objects in orthographic views
+		glm::vec3 center = (object.boundsMin + object.boundsMax) * 0.5f;
+		m_objectViewDepth[index] = -(m_viewMatrix * glm::vec4(center, 1.0f)).z;
+
+		if (object.bTransparent == true)
+		{
+			m_transparentObjects.push_back(index);
+		}
+		else
+		{
+			m_opaqueObjects.push_back(index);
+		}
+	}
+
+	const std::vector<float>& viewDepth = m_objectViewDepth;
+	std::sort(m_opaqueObjects.begin(), m_opaqueObjects.end(),
+		[&viewDepth](int a, int b) { return(viewDepth[a] < viewDepth[b]); });
+	std::sort(m_transparentObjects.begin(), m_transparentObjects.end(),
+		[&viewDepth](int a, int b) { return(viewDepth[a] > viewDepth[b]); });
+}
+
+/***********************************************************
+ *  BakeVisibleSets()
+ *
+ *  This method is used for the offline visibility step of
+ *  the static scene - the objects seen from each cell of the
+ *  camera region are found by casting rays against the exact
+ *  shapes, and the sets are written into a file.  The rays
+ *  pass through the transparent objects.
+ ***********************************************************/
+bool SceneManager::BakeVisibleSets(const char* filename)
+{
+	// the transforms of the moved groups must be current
+	UpdateSceneTransforms();
+
+	std::vector<bool> seeThroughObjects(m_sceneObjects.size(), false);
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		seeThroughObjects[i] = m_sceneObjects[i].bTransparent;
+	}
+
+	m_visibleSets.Bake(
+		PVS_REGION_MIN,
+		PVS_REGION_MAX,
+		PVS_CELL_SIZE,
+		seeThroughObjects,
+		[this](const glm::vec3& origin, const glm::vec3& direction, float& distance)
+		{
+			return(PickSceneObject(origin, direction, distance));
+		});
+
+	return(m_visibleSets.Save(filename));
+}
+
+/***********************************************************
+ *  LoadVisibleSets()
+ *
+ *  This method is used for loading the visible sets baked by
+ *  BakeVisibleSets().  The sets are only used when they were
+ *  baked for the same number of scene objects.
+ ***********************************************************/
+bool SceneManager::LoadVisibleSets(const char* filename)
+{
+	if (m_visibleSets.Load(filename) == false)
+	{
+		return(false);
+	}
+
+	if (m_visibleSets.GetObjectCount() != (int)m_sceneObjects.size())
+	{
+		std::cout << "The visible sets in " << filename << " were baked for a different scene" << std::endl;
+		m_visibleSets.Clear();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  BakeLightmaps()
+ *
+ *  This method is used for the offline lighting step of the
+ *  static scene - the opaque objects get charts in the
+ *  lightmap, lit by the point lights and the default sun and
+ *  sky, with the rays cast against the exact shapes like for
+ *  the visible sets.  The transparent objects let the light
+ *  through and keep being lit by the shader.
+ ***********************************************************/
+bool SceneManager::BakeLightmaps(const char* filename)
+{
+	std::vector<LightmapBaker::BAKE_SURFACE> surfaces;
+	GetBakeSurfaces(surfaces);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	m_lightmap.Bake(
+		surfaces,
+		m_pointLights,
+		LightmapBaker::GetDefaultSettings(),
+		[this](const glm::vec3& origin, const glm::vec3& direction, float& distance)
+		{
+			return(PickSceneObject(origin, direction, distance));
+		});
+
+	auto stop = std::chrono::high_resolution_clock::now();
+	double elapsed = std::chrono::duration<double, std::milli>(stop - start).count();
+
+	int chartCount = 0;
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		chartCount += m_lightmap.HasChart((int)i) ? 1 : 0;
+	}
+
+	char line[192];
+	snprintf(line, sizeof(line),
+		"INFO: Baked %d lightmap charts into a %d x %d atlas in %.0f ms on %d threads",
+		chartCount,
+		m_lightmap.GetAtlasWidth(),
+		m_lightmap.GetAtlasHeight(),
+		elapsed,
+		ThreadPool::GetShared()->GetThreadCount());
+	std::cout << line << std::endl;
+
+	return(m_lightmap.Save(filename));
+}
+
+/***********************************************************
+ *  LoadLightmaps()
+ *
+ *  This method is used for loading the lightmap baked by
+ *  BakeLightmaps().  The lightmap is only used when it was
+ *  baked for the same number of scene objects.
+ ***********************************************************/
+bool SceneManager::LoadLightmaps(const char* filename)
+{
+	if (m_lightmap.Load(filename) == false)
+	{
+		return(false);
+	}
+
+	if (m_lightmap.GetObjectCount() != (int)m_sceneObjects.size())
+	{
+		std::cout << "The lightmap in " << filename << " was baked for a different scene" << std::endl;
+		m_lightmap.Clear();
+		return(false);
+	}
+
+	m_lightmap.Upload();
+
+	// the objects with a chart are drawn with other variants
+	PrecompileObjectVariants();
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetBakeSurfaces()
+ *
+ *  This method is used for describing every scene object to
+ *  the offline lighting steps - its chart shape, world
+ *  matrix and color, with the textured objects taking the
+ *  average color of their texture.  The transparent objects
+ *  let the rays and light through.
+ ***********************************************************/
+void SceneManager::GetBakeSurfaces(std::vector<LightmapBaker::BAKE_SURFACE>& surfaces)
+{
+	// the transforms of the moved groups must be current
+	UpdateSceneTransforms();
+
+	surfaces.resize(m_sceneObjects.size());
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[i];
+		LightmapBaker::BAKE_SURFACE& surface = surfaces[i];
+
+		surface.shape = GetMeshChartShape(object.mesh, surface.tubeRadius);
+		surface.model = m_sceneGraph.GetWorldMatrix(object.node);
+		surface.albedo = glm::vec3(object.color);
+		if (object.textureTag.empty() == false)
+		{
+			int textureSlot = FindTextureSlot(object.textureTag);
+			if (textureSlot >= 0)
+			{
+				surface.albedo = m_textureIDs[textureSlot].averageColor;
+			}
+		}
+		// the imported models have no chart shape to trace, so
+		// the rays pass through them
+		surface.bLightmapped = (object.bTransparent == false) && (object.mesh != MESH_MODEL);
+		surface.bSeeThrough = (object.bTransparent == true) || (object.mesh == MESH_MODEL);
+	}
+}
+
+/***********************************************************
+ *  BakeLightProbes()
+ *
+ *  This method is used for baking the light probes over the
+ *  box of every scene object, lit by the point lights and
+ *  the default sun and sky of the lightmap, with the rays
+ *  cast against the exact shapes.
+ ***********************************************************/
+bool SceneManager::BakeLightProbes(const char* filename)
+{
+	std::vector<LightmapBaker::BAKE_SURFACE> surfaces;
+	GetBakeSurfaces(surfaces);
+
+	glm::vec3 sceneMin = glm::vec3(FLT_MAX);
+	glm::vec3 sceneMax = glm::vec3(-FLT_MAX);
+	for (const SCENE_OBJECT& object : m_sceneObjects)
+	{
+		sceneMin = glm::min(sceneMin, object.boundsMin);
+		sceneMax = glm::max(sceneMax, object.boundsMax);
+	}
+	if (sceneMin.x > sceneMax.x)
+	{
+		std::cout << "There are no scene objects to bake light probes for" << std::endl;
+		return(false);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	m_lightProbes.Bake(
+		sceneMin,
+		sceneMax,
+		LIGHT_PROBE_SPACING,
+		LIGHT_PROBE_RAYS,
+		surfaces,
+		m_pointLights,
+		LightmapBaker::GetDefaultSettings(),
+		[this](const glm::vec3& origin, const glm::vec3& direction, float& distance)
+		{
+			return(PickSceneObject(origin, direction, distance));
+		});
+
+	auto stop = std::chrono::high_resolution_clock::now();
+	double elapsed = std::chrono::duration<double, std::milli>(stop - start).count();
+
+	glm::ivec3 counts = m_lightProbes.GetProbeCounts();
+	char line[192];
+	snprintf(line, sizeof(line),
+		"INFO: Baked a %d x %d x %d light probe grid with %d rays per probe in %.0f ms on %d threads",
+		counts.x,
+		counts.y,
+		counts.z,
+		LIGHT_PROBE_RAYS,
+		elapsed,
+		ThreadPool::GetShared()->GetThreadCount());
+	std::cout << line << std::endl;
+
+	return(m_lightProbes.Save(filename));
+}
+
+/***********************************************************
+ *  LoadLightProbes()
+ *
+ *  This method is used for loading the light probes baked
+ *  by BakeLightProbes().  The lit objects are then drawn
+ *  with the variants that read the probes.
+ ***********************************************************/
+bool SceneManager::LoadLightProbes(const char* filename)
+{
+	if (m_lightProbes.Load(filename) == false)
+	{
+		return(false);
+	}
+
+	m_lightProbes.Upload();
+
+	PrecompileObjectVariants();
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetObjectSorting()
+ *
+ *  This method is used for turning the opaque and transparent
+ *  pass split on or off.  When it is off, every object is
+ *  blended in the order it was defined, which is kept for
+ *  measuring the split.
+ ***********************************************************/
+void SceneManager::SetObjectSorting(bool bEnabled)
+{
+	m_bSortObjects = bEnabled;
+}
+
+/***********************************************************
+ *  SetShaderVariants()
+ *
+ *  This method is used for drawing the scene objects with
+ *  the shader variants of their features, instead of the
+ *  single program of the shader manager.
+ ***********************************************************/
+void SceneManager::SetShaderVariants(ShaderVariants* pShaderVariants)
+{
+	m_pShaderVariants = pShaderVariants;
+}
+
+/***********************************************************
+ *  AddPointLight()
+ *
+ *  This method is used for adding a point light to the
+ *  scene.  The light adds nothing past its range, so only
+ *  the view clusters it reaches shade it.
+ ***********************************************************/
+void SceneManager::AddPointLight(glm::vec3 position, float range, glm::vec3 color)
+{
+	LightClusters::POINT_LIGHT light;
+
+	light.position = position;
+	light.range = range;
+	light.color = color;
+	m_pointLights.push_back(light);
+	UpdateLightingState();
+}
+
+/***********************************************************
+ *  ClearPointLights()
+ *
+ *  This method is used for removing the point lights, which
+ *  draws the scene unlit again.
+ ***********************************************************/
+void SceneManager::ClearPointLights()
+{
+	m_pointLights.clear();
+	UpdateLightingState();
+}
+
+/***********************************************************
+ *  GetPointLightCount()
+ *
+ *  This method is used for getting the number of point
+ *  lights added to the scene.
+ ***********************************************************/
+int SceneManager::GetPointLightCount() const
+{
+	return((int)m_pointLights.size());
+}
+
+/***********************************************************
+ *  SetLightAssignment()
+ *
+ *  This method is used for choosing whether the point
+ *  lights are listed for the view clusters, or for the
+ *  drawn objects from a sphere query of the object
+ *  hierarchy per light, or whether the first of them are
+ *  written into the fixed point light array.
+ ***********************************************************/
+void SceneManager::SetLightAssignment(LIGHT_ASSIGNMENT assignment)
+{
+	if (assignment != m_lightAssignment)
+	{
+		m_lightAssignment = assignment;
+		UpdateLightingState();
+	}
+}
+
+/***********************************************************
+ *  GetAverageObjectLightCount()
+ *
+ *  This method is used for getting the average length of
+ *  the light lists of the objects drawn in the last frame.
+ ***********************************************************/
+float SceneManager::GetAverageObjectLightCount() const
+{
+	if ((m_pointLights.empty() == true) || (m_lightAssignment != LIGHTS_PER_OBJECT))
+	{
+		return(0.0f);
+	}
+	return(m_objectLights.GetAverageLightCount());
+}
+
+/***********************************************************
+ *  AssignPointLights()
+ *
+ *  This method is used for binning the point lights into
+ *  the clusters of the camera view, or listing them for the
+ *  drawn objects, and passing the light lists to the scene
+ *  shader, or writing the first of them into the fixed point
+ *  light array.  The buffer textures are bound after the
+ *  loaded textures.
+ ***********************************************************/
+void SceneManager::AssignPointLights()
+{
+	const bool bClustered = (m_pointLights.empty() == false) && (m_lightAssignment == LIGHTS_PER_CLUSTER);
+	const bool bObjectLights = (m_pointLights.empty() == false) && (m_lightAssignment == LIGHTS_PER_OBJECT);
+	const int firstUnit = m_loadedTextures;
+	glm::vec2 tileSize = glm::vec2(1.0f);
+	glm::vec3 depthSlices = glm::vec3(0.0f);
+
+	if (bClustered == true)
+	{
+		m_lightClusters.Build(m_pointLights, m_viewMatrix, m_projectionMatrix);
+		m_lightClusters.Upload();
+		m_lightClusters.Bind(firstUnit);
+		tileSize = glm::vec2(
+			std::max(1.0f, m_viewportWidth / (float)LightClusters::TILES_X),
+			std::max(1.0f, m_viewportHeight / (float)LightClusters::TILES_Y));
+		depthSlices = m_lightClusters.GetDepthSliceParameters();
+	}
+	else if (bObjectLights == true)
+	{
+		m_objectLights.Build(m_pointLights, m_objectHierarchy, m_visibleObjects);
+		m_objectLights.Upload();
+		m_objectLights.Bind(firstUnit);
+	}
+
+	// the buffer samplers always point at their own units, as
+	// samplers of different types must not share a unit - the
+	// object light indices share the unit of the cluster table,
+	// which has the same type and is unused with object lists
+	SetShaderValue("lightData", firstUnit);
+	SetShaderValue("clusterTable", firstUnit + 1);
+	SetShaderValue("clusterLightIndices", firstUnit + 2);
+	SetShaderValue("objectLightIndices", firstUnit + 1);
+	SetShaderValue("clusterTileSize", tileSize);
+	SetShaderValue("clusterDepth", depthSlices);
+	SetShaderValue("material.diffuseColor", CLUSTER_DIFFUSE_COLOR);
+	SetShaderValue("material.specularColor", CLUSTER_SPECULAR_COLOR);
+	SetShaderValue("material.shininess", CLUSTER_SHININESS);
+	SetShaderFeature(g_UseLightingName, m_bUseLighting);
+	SetShaderFeature(g_UseClusteredLightsName, bClustered);
+	SetShaderFeature(g_UseObjectLightsName, bObjectLights);
+	glActiveTexture(GL_TEXTURE0);
+
+	// the fixed array holds the first lights, and the variants
+	// are compiled to loop over exactly that many
+	for (int i = 0; i < m_activePointLights; i++)
+	{
+		const LightClusters::POINT_LIGHT& light = m_pointLights[i];
+		const std::string name = "pointLights[" + std::to_string(i) + "]";
+
+		SetShaderValue(name + ".position", light.position);
+		SetShaderValue(name + ".ambient", light.color * SCENE_LIGHT_AMBIENT);
+		SetShaderValue(name + ".diffuse", light.color);
+		SetShaderValue(name + ".specular", light.color * SCENE_LIGHT_SPECULAR);
+	}
+	SetShaderValue("activePointLights", m_activePointLights);
+}
+
+/***********************************************************
+ *  BindLightmap()
+ *
+ *  This method is used for binding the lightmap atlas to
+ *  the texture unit after the light buffers, when a
+ *  lightmap is loaded.
+ ***********************************************************/
+void SceneManager::BindLightmap()
+{
+	if (m_lightmap.IsEmpty() == true)
+	{
+		return;
+	}
+
+	const int textureUnit = m_loadedTextures + LIGHTMAP_UNIT_OFFSET;
+	m_lightmap.Bind(textureUnit);
+	SetShaderValue("lightmapAtlas", textureUnit);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  BindLightProbes()
+ *
+ *  This method is used for binding the light probe grid to
+ *  the texture unit after the shadow maps, and passing the
+ *  box and probe counts of the grid, when probes are loaded.
+ ***********************************************************/
+void SceneManager::BindLightProbes()
+{
+	const bool bProbes = (m_lightProbes.IsEmpty() == false);
+	SetShaderFeature(g_UseLightProbesName, bProbes);
+	if (bProbes == false)
+	{
+		return;
+	}
+
+	const int textureUnit = m_loadedTextures + LIGHT_PROBE_UNIT_OFFSET;
+	const glm::vec3 counts = glm::vec3(m_lightProbes.GetProbeCounts());
+	m_lightProbes.Bind(textureUnit);
+	SetShaderValue("lightProbeGrid", textureUnit);
+	SetShaderValue("lightProbeMin", m_lightProbes.GetBoundsMin());
+	SetShaderValue("lightProbeMax", m_lightProbes.GetBoundsMax());
+	SetShaderValue("lightProbeCounts", counts);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  SetDirectionalLight()
+ *
+ *  This method is used for setting up the directional light
+ *  of the scene shader, which lights the scene along the
+ *  passed in direction.  A shadow resolution above zero
+ *  gives it a shadow map fitted around the static objects.
+ ***********************************************************/
+void SceneManager::SetDirectionalLight(glm::vec3 direction, glm::vec3 color, int shadowResolution)
+{
+	m_directionalLight.bActive = true;
+	m_directionalLight.direction = glm::normalize(direction);
+	m_directionalLight.color = color;
+	m_shadowMaps.SetResolution(ShadowMaps::SHADOW_DIRECTIONAL, shadowResolution);
+	UpdateLightingState();
+}
+
+/***********************************************************
+ *  SetSpotLight()
+ *
+ *  This method is used for setting up the spot light of the
+ *  scene shader.  The light fades between the inner and the
+ *  outer cone, and its shadow map covers the outer cone out
+ *  to the range.
+ ***********************************************************/
+void SceneManager::SetSpotLight(
+	glm::vec3 position,
+	glm::vec3 direction,
+	float cutOffDegrees,
+	float outerCutOffDegrees,
+	float range,
+	glm::vec3 color,
+	int shadowResolution)
+{
+	m_spotLight.bActive = true;
+	m_spotLight.position = position;
+	m_spotLight.direction = glm::normalize(direction);
+	m_spotLight.cutOffDegrees = cutOffDegrees;
+	m_spotLight.outerCutOffDegrees = std::max(outerCutOffDegrees, cutOffDegrees);
+	m_spotLight.range = range;
+	m_spotLight.color = color;
+	m_shadowMaps.SetResolution(ShadowMaps::SHADOW_SPOT, shadowResolution);
+	UpdateLightingState();
+}
+
+/***********************************************************
+ *  ClearSceneLights()
+ *
+ *  This method is used for turning the directional and spot
+ *  light off and freeing their shadow maps.
+ ***********************************************************/
+void SceneManager::ClearSceneLights()
+{
+	m_directionalLight.bActive = false;
+	m_spotLight.bActive = false;
+	m_shadowMaps.SetResolution(ShadowMaps::SHADOW_DIRECTIONAL, 0);
+	m_shadowMaps.SetResolution(ShadowMaps::SHADOW_SPOT, 0);
+	UpdateLightingState();
+}
+
+/***********************************************************
+ *  SetShadowCaching()
+ *
+ *  This method is used for keeping the shadow depth of the
+ *  static objects between frames, or drawing every object
+ *  into the shadow maps each frame.
+ ***********************************************************/
+void SceneManager::SetShadowCaching(bool bEnabled)
+{
+	m_shadowMaps.SetCaching(bEnabled);
+}
+
+/***********************************************************
+ *  GetShadowCasterDrawCount()
+ *
+ *  This method is used for getting the number of objects
+ *  drawn into the shadow maps in the last frame.
+ ***********************************************************/
+int SceneManager::GetShadowCasterDrawCount() const
+{
+	return(m_shadowMaps.GetCasterDrawCount());
+}
+
+/***********************************************************
+ *  UpdateLightingState()
+ *
+ *  This method is used for drawing the scene lit while any
+ *  point, directional or spot light is set up, and counting
+ *  the lights of the fixed point light array.  The variants
+ *  of the objects follow the lights, so they are compiled
+ *  ahead again before the next frame.
+ ***********************************************************/
+void SceneManager::UpdateLightingState()
+{
+	m_bUseLighting =
+		(m_pointLights.empty() == false) ||
+		(m_directionalLight.bActive == true) ||
+		(m_spotLight.bActive == true);
+	m_activePointLights = 0;
+	if (m_lightAssignment == LIGHTS_FIXED)
+	{
+		m_activePointLights = (int)m_pointLights.size();
+	}
+	if (m_activePointLights > ShaderVariants::MAX_POINT_LIGHTS)
+	{
+		m_activePointLights = ShaderVariants::MAX_POINT_LIGHTS;
+	}
+	m_bVariantsOutdated = true;
+}
+
+/***********************************************************
+ *  RenderShadowMaps()
+ *
+ *  This method is used for updating the shadow maps and
+ *  passing the directional and spot light to the scene
+ *  shader.  The directional light is fitted around the
+ *  static objects, so that its view only changes when one of
+ *  them moves, and the dynamic objects are drawn over the
+ *  cached static depth every frame.  The maps are bound after
+ *  the lightmap atlas.
+ ***********************************************************/
+void SceneManager::RenderShadowMaps()
+{
+	const int firstUnit = m_loadedTextures + SHADOW_UNIT_OFFSET;
+	const bool bDirectionalShadow =
+		(m_directionalLight.bActive == true) &&
+		(m_shadowMaps.GetResolution(ShadowMaps::SHADOW_DIRECTIONAL) > 0);
+	const bool bSpotShadow =
+		(m_spotLight.bActive == true) &&
+		(m_shadowMaps.GetResolution(ShadowMaps::SHADOW_SPOT) > 0);
+
+	if (((bDirectionalShadow == true) || (bSpotShadow == true)) && (NULL != m_pDepthShaderManager))
+	{
+		bool bDynamicCasters = false;
+		glm::vec3 staticMin = glm::vec3(FLT_MAX);
+		glm::vec3 staticMax = glm::vec3(-FLT_MAX);
+		for (size_t i = 0; i < m_sceneObjects.size(); i++)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[i];
+			if (object.bDynamic == true)
+			{
+				bDynamicCasters = true;
+			}
+			else
+			{
+				staticMin = glm::min(staticMin, object.boundsMin);
+				staticMax = glm::max(staticMax, object.boundsMax);
+			}
+		}
+		if (staticMin.x > staticMax.x)
+		{
+			staticMin = glm::vec3(0.0f);
+			staticMax = glm::vec3(0.0f);
+		}
+
+		// where each light looks from when its meshlets are culled
+		glm::vec3 lightPositions[ShadowMaps::SHADOW_LIGHT_COUNT];
+		lightPositions[ShadowMaps::SHADOW_DIRECTIONAL] =
+			((staticMin + staticMax) * 0.5f) - (m_directionalLight.direction * DIRECTIONAL_LIGHT_DISTANCE);
+		lightPositions[ShadowMaps::SHADOW_SPOT] = m_spotLight.position;
+
+		if (bDirectionalShadow == true)
+		{
+			m_shadowMaps.SetLightMatrix(
+				ShadowMaps::SHADOW_DIRECTIONAL,
+				ShadowMaps::GetDirectionalMatrix(m_directionalLight.direction, staticMin, staticMax));
+		}
+		if (bSpotShadow == true)
+		{
+			m_shadowMaps.SetLightMatrix(
+				ShadowMaps::SHADOW_SPOT,
+				ShadowMaps::GetSpotMatrix(
+					m_spotLight.position,
+					m_spotLight.direction,
+					m_spotLight.outerCutOffDegrees,
+					m_spotLight.range));
+		}
+
+		// the camera frustum and position are replaced by the
+		// ones of each light while its casters are drawn
+		const Frustum viewFrustum = m_viewFrustum;
+		const glm::vec3 cameraPosition = m_cameraPosition;
+
+		m_pDepthShaderManager->use();
+		m_pDepthShaderManager->setMat4Value("projection", glm::mat4(1.0f));
+		m_shadowMaps.Render(
+			[this, &lightPositions](ShadowMaps::SHADOW_LIGHT light, const glm::mat4& lightViewProjection, bool bStatic)
+			{
+				return(DrawShadowCasters(lightViewProjection, lightPositions[light], bStatic));
+			},
+			bDynamicCasters);
+
+		m_viewFrustum = viewFrustum;
+		m_cameraPosition = cameraPosition;
+		m_pShaderManager->use();
+		if (NULL != m_pShaderVariants)
+		{
+			m_pShaderVariants->ResetBinding();
+		}
+
+		// the meshlets are counted by the shading pass
+		m_visibleMeshlets = 0;
+		m_culledMeshlets = 0;
+	}
+
+	m_shadowMaps.Bind(ShadowMaps::SHADOW_DIRECTIONAL, firstUnit);
+	m_shadowMaps.Bind(ShadowMaps::SHADOW_SPOT, firstUnit + 1);
+	const bool bProbeAmbient = (m_lightProbes.IsEmpty() == false);
+	if (NULL != m_pShaderVariants)
+	{
+		SetSceneLightValues(m_pShaderVariants, m_directionalLight, m_spotLight, m_shadowMaps, firstUnit, bProbeAmbient);
+	}
+	else if (NULL != m_pShaderManager)
+	{
+		SetSceneLightValues(m_pShaderManager, m_directionalLight, m_spotLight, m_shadowMaps, firstUnit, bProbeAmbient);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  DrawShadowCasters()
+ *
+ *  This method is used for drawing the depth of the static
+ *  or the dynamic objects inside the view of a light into
+ *  the bound shadow map.  The blended objects let the light
+ *  through and cast no shadow, and the clear pixels of the
+ *  alpha tested textures are discarded.
+ ***********************************************************/
+int SceneManager::DrawShadowCasters(
+	const glm::mat4& lightViewProjection,
+	const glm::vec3& lightPosition,
+	bool bStatic)
+{
+	m_viewFrustum.ExtractPlanes(lightViewProjection);
+	m_cameraPosition = lightPosition;
+	m_pDepthShaderManager->setMat4Value("view", lightViewProjection);
+
+	int drawn = 0;
+	m_objectHierarchy.QueryFrustum(m_viewFrustum, m_shadowCasters);
+	for (int index : m_shadowCasters)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[index];
+		if ((object.bDynamic == bStatic) || (object.bTransparent == true))
+		{
+			continue;
+		}
+
+		m_modelMatrix = m_sceneGraph.GetWorldMatrix(object.node);
+		m_pDepthShaderManager->setMat4Value(g_ModelName, m_modelMatrix);
+		m_pDepthShaderManager->setIntValue(g_AlphaTestName, object.bAlphaTested);
+		if (object.bAlphaTested == true)
+		{
+			int textureSlot = FindTextureSlot(object.textureTag);
+			glActiveTexture(GL_TEXTURE0 + textureSlot);
+			glBindTexture(GL_TEXTURE_2D, m_textureIDs[textureSlot].ID);
+			m_pDepthShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
+			m_pDepthShaderManager->setVec2Value(g_UVScaleName, object.UVscale);
+		}
+
+		DrawSceneMesh(object, m_pDepthShaderManager);
+		drawn++;
+	}
+
+	return(drawn);
+}
+
+/***********************************************************
+ *  SetDepthPrePassShader()
+ *
+ *  This method is used for passing the depth only shader
+ *  used by the depth pre-pass.
+ ***********************************************************/
+void SceneManager::SetDepthPrePassShader(ShaderManager* pDepthShaderManager)
+{
+	m_pDepthShaderManager = pDepthShaderManager;
+}
+
+/***********************************************************
+ *  SetDeferredRenderer()
+ *
+ *  This method is used for passing the geometry buffer and
+ *  lighting passes of the deferred path.
+ ***********************************************************/
+void SceneManager::SetDeferredRenderer(DeferredRenderer* pDeferredRenderer)
+{
+	m_pDeferredRenderer = pDeferredRenderer;
+}
+
+/***********************************************************
+ *  SetTransparencyRenderer()
+ *
+ *  This method is used for passing the targets and the
+ *  composite pass of the order independent transparency.
+ ***********************************************************/
+void SceneManager::SetTransparencyRenderer(TransparencyRenderer* pTransparencyRenderer)
+{
+	m_pTransparencyRenderer = pTransparencyRenderer;
+}
+
+/***********************************************************
+ *  SetOrderIndependentTransparency()
+ *
+ *  This method is used for adding the transparent objects
+ *  into the order independent transparency targets, or
+ *  blending them back to front, in the next rendered frames.
+ ***********************************************************/
+void SceneManager::SetOrderIndependentTransparency(bool bEnabled)
+{
+	m_bOrderIndependent = bEnabled;
+}
+
+/***********************************************************
+ *  SetDeferredShading()
+ *
+ *  This method is used for lighting the opaque objects per
+ *  pixel through the geometry buffer, or shading them
+ *  forward, in the next rendered frames.  The transparent
+ *  objects are shaded forward either way.
+ ***********************************************************/
+void SceneManager::SetDeferredShading(bool bEnabled)
+{
+	m_bDeferredShading = bEnabled;
+}
+
+/***********************************************************
+ *  SetDepthPrePass()
+ *
+ *  This method is used for turning the depth pre-pass on or
+ *  off for the next rendered frames.
+ ***********************************************************/
+void SceneManager::SetDepthPrePass(bool bEnabled)
+{
+	m_bDepthPrePass = bEnabled;
+}
+
+/***********************************************************
+ *  SetShadedSampleCounting()
+ *
+ *  This method is used for counting the samples that pass
+ *  the depth test in the shading passes of every frame,
+ *  which is the number of fragments that were shaded.
+ ***********************************************************/
+void SceneManager::SetShadedSampleCounting(bool bEnabled)
+{
+	if ((bEnabled == true) && (m_shadedSampleQuery == 0))
+	{
+		glGenQueries(1, &m_shadedSampleQuery);
+	}
+	m_bCountShadedSamples = bEnabled;
+	m_shadedSamples = 0;
+}
+
+/***********************************************************
+ *  GetShadedSampleCount()
+ *
+ *  This method is used for getting the number of shaded
+ *  samples of the last rendered frame.
+ ***********************************************************/
+GLuint64 SceneManager::GetShadedSampleCount() const
+{
+	return(m_shadedSamples);
+}
+
+/***********************************************************
+ *  BuildObjectHierarchy()
+ *
+ *  This method is used for building the bounding volume
+ *  hierarchy over the boxes of the scene objects, so that
+ *  culling and other spatial queries do not need to test
+ *  every object.
+ ***********************************************************/
+void SceneManager::BuildObjectHierarchy()
+{
+	std::vector<glm::vec3> boundsMin(m_sceneObjects.size());
+	std::vector<glm::vec3> boundsMax(m_sceneObjects.size());
+
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		boundsMin[i] = m_sceneObjects[i].boundsMin;
+		boundsMax[i] = m_sceneObjects[i].boundsMax;
+	}
+
+	m_objectHierarchy.Build(boundsMin, boundsMax);
+}
+
+/***********************************************************
+ *  UpdateSceneTransforms()
+ *
+ *  This method is used for updating the world matrices of
+ *  the moved scene graph nodes, and passing the new boxes of
+ *  the objects below them to the hierarchy.
+ ***********************************************************/
+void SceneManager::UpdateSceneTransforms()
+{
+	m_sceneGraph.UpdateWorldTransforms(m_updatedNodes);
+	if (m_updatedNodes.empty() == true)
+	{
+		return;
+	}
+
+	for (int node : m_updatedNodes)
+	{
+		const int index = m_nodeObjects[node];
+		if (index < 0)
+		{
+			continue;
+		}
+
+		SCENE_OBJECT& object = m_sceneObjects[index];
+		glm::vec3 localMin;
+		glm::vec3 localMax;
+		GetObjectLocalBounds(object, localMin, localMax);
+		TransformBounds(
+			m_sceneGraph.GetWorldMatrix(node),
+			localMin,
+			localMax,
+			object.boundsMin,
+			object.boundsMax);
+		m_objectHierarchy.UpdateObject(index, object.boundsMin, object.boundsMax);
+
+		// the cached shadows of the static objects no longer hold
+		// once one of them moves
+		if (object.bDynamic == false)
+		{
+			m_shadowMaps.Invalidate();
+		}
+	}
+	m_objectHierarchy.Refit();
+}
+
+/***********************************************************
+ *  GetSceneNodeParent()
+ *
+ *  This method is used for getting the group that a scene
+ *  object or group was added to.
+ ***********************************************************/
+int SceneManager::GetSceneNodeParent(int node) const
+{
+	return(m_sceneGraph.GetParent(node));
+}
+
+/***********************************************************
+ *  SetSceneNodePosition()
+ *
+ *  This method is used for moving a scene object or group
+ *  relative to its parent.  Only the moved subtree is
+ *  updated, at the start of the next rendered frame.
+ ***********************************************************/
+void SceneManager::SetSceneNodePosition(int node, glm::vec3 positionXYZ)
+{
+	m_sceneGraph.SetLocalPosition(node, positionXYZ);
+
+	const int index = m_nodeObjects[node];
+	if (index >= 0)
+	{
+		m_sceneObjects[index].positionXYZ = positionXYZ;
+	}
+}
+
+/***********************************************************
+ *  SetSceneObjectDynamic()
+ *
+ *  This method is used for marking a scene object as moving
+ *  while the scene runs.  The shadows of the dynamic objects
+ *  are drawn every frame over the cached depth of the static
+ *  ones, so moving them keeps the cache.
+ ***********************************************************/
+void SceneManager::SetSceneObjectDynamic(int index, bool bDynamic)
+{
+	if ((index < 0) || (index >= (int)m_sceneObjects.size()))
+	{
+		return;
+	}
+
+	if (m_sceneObjects[index].bDynamic != bDynamic)
+	{
+		m_sceneObjects[index].bDynamic = bDynamic;
+		m_shadowMaps.Invalidate();
+	}
+}
+
+/***********************************************************
+ *  GetDrawnObjectCount()
+ *
+ *  This method is used for getting the number of scene
+ *  objects drawn in the last rendered frame.
+ ***********************************************************/
+int SceneManager::GetDrawnObjectCount() const
+{
+	return(m_drawnObjects);
+}
+
+/***********************************************************
+ *  GetCulledObjectCount()
+ *
+ *  This method is used for getting the number of scene
+ *  objects skipped by view-frustum culling in the last
+ *  rendered frame.
+ ***********************************************************/
+int SceneManager::GetCulledObjectCount() const
+{
+	return(m_culledObjects);
+}
+
+/***********************************************************
+ *  GetOccludedObjectCount()
+ *
+ *  This method is used for getting the number of scene
+ *  objects inside the view but hidden behind occluders in
+ *  the last rendered frame.
+ ***********************************************************/
+int SceneManager::GetOccludedObjectCount() const
+{
+	return(m_occludedObjects);
+}
+
+/***********************************************************
+ *  PickSceneObject()
+ *
+ *  This method is used for finding the scene object under
+ *  a world space ray, such as the one under the mouse.  The
+ *  hierarchy finds the boxes along the ray, and only those
+ *  objects are tested exactly in their own object space.
+ ***********************************************************/
+int SceneManager::PickSceneObject(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance) const
+{
+	const glm::vec3 unitDirection = glm::normalize(direction);
+
+	return(m_objectHierarchy.Raycast(
+		origin,
+		unitDirection,
+		distance,
+		[&](int index, float& hitDistance)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[index];
+			glm::mat4 inverseModel = glm::inverse(m_sceneGraph.GetWorldMatrix(object.node));
+
+			// the object space direction is not normalized, so
+			// the ray parameter stays the world distance
+			glm::vec3 localOrigin = glm::vec3(inverseModel * glm::vec4(origin, 1.0f));
+			glm::vec3 localDirection = glm::vec3(inverseModel * glm::vec4(unitDirection, 0.0f));
+
+			switch (object.mesh)
+			{
+			case MESH_PLANE:
+				return(RayIntersection::IntersectPlane(localOrigin, localDirection, hitDistance));
+			case MESH_BOX:
+				return(RayIntersection::IntersectBox(localOrigin, localDirection, hitDistance));
+			case MESH_CYLINDER:
+				return(RayIntersection::IntersectCylinder(localOrigin, localDirection, hitDistance));
+			case MESH_SPHERE:
+				return(RayIntersection::IntersectSphere(localOrigin, localDirection, hitDistance));
+			case MESH_TORUS:
+				return(RayIntersection::IntersectTorus(localOrigin, localDirection, TORUS_TUBE_RADIUS, false, hitDistance));
+			case MESH_THICK_TORUS:
+				return(RayIntersection::IntersectTorus(localOrigin, localDirection, THICK_TORUS_TUBE_RADIUS, false, hitDistance));
+			case MESH_QUARTER_TORUS:
+				return(RayIntersection::IntersectTorus(localOrigin, localDirection, QUARTER_TORUS_TUBE_RADIUS, true, hitDistance));
+			case MESH_MODEL:
+			{
+				// the imported models are hit on their box, scaled
+				// into the unit box without changing the parameter
+				glm::vec3 localMin;
+				glm::vec3 localMax;
+				GetObjectLocalBounds(object, localMin, localMax);
+				glm::vec3 size = glm::max(localMax - localMin, glm::vec3(1.0e-4f));
+				glm::vec3 center = (localMin + localMax) * 0.5f;
+				return(RayIntersection::IntersectBox((localOrigin - center) / size, localDirection / size, hitDistance));
+			}
+			}
+			return(false);
+		}));
+}
+
+/***********************************************************
+ *  GetSceneObject()
+ *
+ *  This method is used for getting a scene object by the
+ *  index returned from PickSceneObject().
+ ***********************************************************/
+const SceneManager::SCENE_OBJECT& SceneManager::GetSceneObject(int index) const
+{
+	return(m_sceneObjects[index]);
+}
+
+/***********************************************************
+ *  GetSceneObjectWorldMatrix()
+ *
+ *  This method is used for getting the world transformation
+ *  of a scene object.  The transformation stored with the
+ *  object is relative to its group.
+ ***********************************************************/
+glm::mat4 SceneManager::GetSceneObjectWorldMatrix(int index) const
+{
+	return(m_sceneGraph.GetWorldMatrix(m_sceneObjects[index].node));
+}
+
+/***********************************************************
+ *  GetSceneMeshName()
+ *
+ *  This method is used for getting the name of a scene mesh
+ *  for display.
+ ***********************************************************/
+const char* SceneManager::GetSceneMeshName(SCENE_MESH mesh)
+{
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		return("plane");
+	case MESH_BOX:
+		return("box");
+	case MESH_CYLINDER:
+		return("cylinder");
+	case MESH_SPHERE:
+		return("sphere");
+	case MESH_TORUS:
+		return("torus");
+	case MESH_THICK_TORUS:
+		return("thick torus");
+	case MESH_QUARTER_TORUS:
+		return("quarter torus");
+	case MESH_MODEL:
+		return("model");
+	}
+	return("unknown");
+}
+
+/***********************************************************
+ *  CullOccludedObjects()
+ *
+ *  This method is used for rasterizing the visible occluders
+ *  into the software depth buffer, then removing the visible
+ *  objects whose boxes are completely behind them.
+ ***********************************************************/
+void SceneManager::CullOccludedObjects()
+{
+	m_occlusionCuller.BeginFrame(m_viewProjection);
+
+	for (size_t i = 0; i < m_visibleObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_visibleObjects[i]];
+		if (object.bOccluder == false)
+		{
+			continue;
+		}
+
+		const glm::mat4& modelMatrix = m_sceneGraph.GetWorldMatrix(object.node);
+
+		if (object.mesh == MESH_PLANE)
+		{
+			m_occlusionCuller.AddOccluder(
+				StaticPrimitives::PLANE_OCCLUDER.vertices,
+				StaticPrimitives::FLOATS_PER_VERTEX,
+				StaticPrimitives::PLANE_OCCLUDER.indices,
+				StaticPrimitives::PLANE_OCCLUDER.indexCount,
+				modelMatrix);
+		}
+		else if (object.mesh == MESH_BOX)
+		{
+			m_occlusionCuller.AddOccluder(
+				StaticPrimitives::BOX.vertices,
+				StaticPrimitives::FLOATS_PER_VERTEX,
+				StaticPrimitives::BOX.indices,
+				StaticPrimitives::BOX.indexCount,
+				modelMatrix);
+		}
+	}
+
+	if (m_occlusionCuller.GetOccluderTriangleCount() == 0)
+	{
+		return;
+	}
+	m_occlusionCuller.RasterizeOccluders();
+
+	// keep the order of the visible objects while removing the
+	// hidden ones
+	size_t keptObjects = 0;
+	for (size_t i = 0; i < m_visibleObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_visibleObjects[i]];
+		if (m_occlusionCuller.IsBoxVisible(object.boundsMin, object.boundsMax) == true)
+		{
+			m_visibleObjects[keptObjects++] = m_visibleObjects[i];
+		}
+		else
+		{
+			m_objectCoverage[m_visibleObjects[i]] = 0.0f;
+		}
+	}
+	m_occludedObjects = (int)(m_visibleObjects.size() - keptObjects);
+	m_visibleObjects.resize(keptObjects);
+}
+
+/***********************************************************
+ *  CullSmallObjects()
+ *
+ *  This method is used for measuring how many pixels the
+ *  box of each visible object covers on screen, and for
+ *  removing the objects whose screen rectangle is below the
+ *  small object threshold in both directions.  Thin but long
+ *  objects such as the rods are kept while their length is
+ *  still visible.
+ ***********************************************************/
+void SceneManager::CullSmallObjects()
+{
+	m_objectCoverage.assign(m_sceneObjects.size(), 0.0f);
+	m_totalCoverage = 0.0f;
+
+	size_t keptObjects = 0;
+	for (size_t i = 0; i < m_visibleObjects.size(); i++)
+	{
+		const int index = m_visibleObjects[i];
+		const SCENE_OBJECT& object = m_sceneObjects[index];
+		float width = 0.0f;
+		float height = 0.0f;
+		float coverage = ProjectBounds(
+			m_viewProjection,
+			object.boundsMin,
+			object.boundsMax,
+			m_viewportWidth,
+			m_viewportHeight,
+			width,
+			height);
+
+		if ((width < m_smallObjectPixels) && (height < m_smallObjectPixels))
+		{
+			continue;
+		}
+
+		m_objectCoverage[index] = coverage;
+		m_visibleObjects[keptObjects++] = index;
+	}
+	m_smallObjects = (int)(m_visibleObjects.size() - keptObjects);
+	m_visibleObjects.resize(keptObjects);
+}
+
+/***********************************************************
+ *  GetSmallObjectCount()
+ *
+ *  This method is used for getting the number of visible
+ *  scene objects skipped as too small in the last rendered
+ *  frame.
+ ***********************************************************/
+int SceneManager::GetSmallObjectCount() const
+{
+	return(m_smallObjects);
+}
+
+/***********************************************************
+ *  SetSmallObjectThreshold()
+ *
+ *  This method is used for setting the screen size in pixels
+ *  below which scene objects are not drawn.
+ ***********************************************************/
+void SceneManager::SetSmallObjectThreshold(float pixels)
+{
+	m_smallObjectPixels = std::max(pixels, 0.0f);
+}
+
+/***********************************************************
+ *  GetObjectScreenCoverage()
+ *
+ *  This method is used for getting the screen pixels covered
+ *  by the bounding box of a scene object in the last frame.
+ ***********************************************************/
+float SceneManager::GetObjectScreenCoverage(int index) const
+{
+	if ((index < 0) || (index >= (int)m_objectCoverage.size()))
+	{
+		return(0.0f);
+	}
+	return(m_objectCoverage[index]);
+}
+
+/***********************************************************
+ *  SetVertexLightingThreshold()
+ *
+ *  This method is used for setting the screen coverage in
+ *  pixels below which the lit objects are lit per vertex.
+ *  The variants lit per vertex are compiled ahead when the
+ *  threshold turns them on.
+ ***********************************************************/
+void SceneManager::SetVertexLightingThreshold(float pixels)
+{
+	const bool bWasEnabled = (m_vertexLightingPixels > 0.0f);
+	m_vertexLightingPixels = std::max(pixels, 0.0f);
+	if ((m_vertexLightingPixels > 0.0f) && (bWasEnabled == false))
+	{
+		PrecompileObjectVariants();
+	}
+}
+
+/***********************************************************
+ *  IsObjectVertexLit()
+ *
+ *  This method is used for checking whether a lit scene
+ *  object covers fewer pixels than the vertex lighting
+ *  threshold in the current frame.  The objects with a
+ *  lightmap chart read their lighting from it instead.
+ ***********************************************************/
+bool SceneManager::IsObjectVertexLit(int index) const
+{
+	if ((m_bUseLighting == false) ||
+		(m_vertexLightingPixels <= 0.0f) ||
+		(index < 0) ||
+		(index >= (int)m_objectCoverage.size()) ||
+		(m_lightmap.HasChart(index) == true))
+	{
+		return(false);
+	}
+	return(m_objectCoverage[index] < m_vertexLightingPixels);
+}
+
+/***********************************************************
+ *  GetVertexLitObjectCount()
+ *
+ *  This method is used for getting the number of drawn
+ *  objects lit per vertex in the last rendered frame.
+ ***********************************************************/
+int SceneManager::GetVertexLitObjectCount() const
+{
+	return(m_vertexLitObjects);
+}
+
+/***********************************************************
+ *  GetTotalScreenCoverage()
+ *
+ *  This method is used for getting the screen pixels covered
+ *  by the boxes of all drawn objects in the last frame.
+ ***********************************************************/
+float SceneManager::GetTotalScreenCoverage() const
+{
+	return(m_totalCoverage);
+}
+
+/***********************************************************
+ *  SetViewParameters()
+ *
+ *  This method is used for passing the camera of the frame
+ *  about to be rendered, so that hidden geometry can be
+ *  rejected on the CPU before it is drawn.
+ ***********************************************************/
+void SceneManager::SetViewParameters(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& cameraPosition)
+{
+	GLint viewport[4] = { 0, 0, 0, 0 };
+
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewProjection = projection * view;
+	m_viewFrustum.ExtractPlanes(m_viewProjection);
+	m_cameraPosition = cameraPosition;
+
+	// the view manager only sets the camera into the shader
+	// manager program
+	if (NULL != m_pShaderVariants)
+	{
+		m_pShaderVariants->setMat4Value("view", view);
+		m_pShaderVariants->setMat4Value("projection", projection);
+		m_pShaderVariants->setVec3Value("viewPosition", cameraPosition);
+	}
+
+	// projection[1][1] maps a vertical unit to clip space,
+	// which spans the viewport height in two units
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	m_viewportWidth = (float)viewport[2];
+	m_viewportHeight = (float)viewport[3];
+	m_lodPixelScale = projection[1][1] * (float)viewport[3] * 0.5f;
+	m_bOrthographicView = (projection[3][3] == 1.0f);
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+/***************************************************************
+*  LoadSceneTextures()                                         *
+*                                                              *
+*  This method is used for preparing the 3D scene by loading   *
+*  the shapes, textures in memory to support the 3D scene      *
+*  rendering                                                   *
+****************************************************************/
+void SceneManager::LoadSceneTextures()
+{
+	// Load wood texture for the bead maze base, ring            
+	// stacker base, and ring stacker vertical rod               
+	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/oakwood.jpg", "oakWood");
+
+	// Load metal texture for the bead maze rods
+	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/metal.jpg", "metalTexture");
+
+
+	// Load steel texture for the bead maze rods
+	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/stainless.jpg", "steelTexture");
+
+	/*************************************************************
+	*    Load different colored plastic textures for the bead    *
+	*    maze beads and the rings of the ring stacker            *
+	**************************************************************/
+
+	// Load light blue plastic texture
+	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/lightblueplastic.jpg", "ltbluePlastic");
+
+	// Load blue plastic texture
+	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/blueplastic.jpg", "bluePlastic");
+
+	// Load magenta plastic texture
+	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/magentaplastic.jpg", "magentaPlastic");
+
+	// Load red plastic texture
+	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/redplastic.jpg", "redPlastic");
+
+	// Load yellow-orange plastic texture
+	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/orangeplastic.jpg", "orangePlastic");
 
 	// Load green plastic texture
 	CreateGLTexture("../../../../CS330 Content/CS330Content/Projects/7-1_FinalProjectMilestones/Source/textures/greenplastic.jpg", "greenPlastic");
@@ -460,14 +3057,45 @@ void SceneManager::PrepareScene()
 	// loaded in memory no matter how many times it is drawn
 	// in the rendered 3D scene
 
-	// Load the plane mesh (used for the floor and background)
-	m_basicMeshes->LoadPlaneMesh();
+	ShapeGenerator::MESH_DATA meshData;
+	std::vector<MeshletBuilder::MESHLET> planeMeshlets;
+
+	// Load the plane mesh (used for the floor and background),
+	// subdivided into tiles so that the hidden parts can be culled
+	for (const StaticPrimitives::MESHLET_BOUNDS& bounds : StaticPrimitives::PLANE_MESHLETS.meshlets)
+	{
+		MeshletBuilder::MESHLET meshlet;
+		meshlet.firstIndex = bounds.firstIndex;
+		meshlet.indexCount = bounds.indexCount;
+		meshlet.center = glm::vec3(bounds.center[0], bounds.center[1], bounds.center[2]);
+		meshlet.radius = bounds.radius;
+		meshlet.coneAxis = glm::vec3(bounds.coneAxis[0], bounds.coneAxis[1], bounds.coneAxis[2]);
+		meshlet.coneCutoff = bounds.coneCutoff;
+		planeMeshlets.push_back(meshlet);
+	}
+	MeshletBuilder::UploadMeshletMesh(
+		StaticPrimitives::PLANE.vertices,
+		StaticPrimitives::PLANE.vertexCount,
+		StaticPrimitives::PLANE.indices,
+		StaticPrimitives::PLANE.indexCount,
+		planeMeshlets,
+		m_planeMesh);
 
 	// Load the cylinder mesh (used for the vertical rod)
-	m_basicMeshes->LoadCylinderMesh();
+	ShapeGenerator::UploadMesh(
+		StaticPrimitives::CYLINDER.vertices,
+		StaticPrimitives::CYLINDER.vertexCount,
+		StaticPrimitives::CYLINDER.indices,
+		StaticPrimitives::CYLINDER.indexCount,
+		m_cylinderMesh);
 
 	// Load the box mesh (used for the bead maze base)
-	m_basicMeshes->LoadBoxMesh();
+	ShapeGenerator::UploadMesh(
+		StaticPrimitives::BOX.vertices,
+		StaticPrimitives::BOX.vertexCount,
+		StaticPrimitives::BOX.indices,
+		StaticPrimitives::BOX.indexCount,
+		m_boxMesh);
 
 	/******************************************************************/
 	/*** Load the torus mesh with set and unset thickness           ***/
@@ -476,25 +3104,80 @@ void SceneManager::PrepareScene()
 	/******************************************************************/
 
 	// Set tube thickness to 0.3f for torus mesh
-	m_basicMeshes->LoadTorusMesh(0.3f);
+	ShapeGenerator::GenerateTorus(meshData, TORUS_MAIN_SEGMENTS, TORUS_TUBE_SEGMENTS, 1.0f, TORUS_TUBE_RADIUS);
+	MeshletBuilder::UploadMeshletMesh(meshData, m_torusMesh);
 
-	m_basicMeshes->LoadExtraTorusMesh1(0.35f);
+	// Set tube thickness to 0.35f for the smallest ring
+	ShapeGenerator::GenerateTorus(meshData, TORUS_MAIN_SEGMENTS, TORUS_TUBE_SEGMENTS, 1.0f, THICK_TORUS_TUBE_RADIUS);
+	MeshletBuilder::UploadMeshletMesh(meshData, m_thickTorusMesh);
 
 	// Load the newly created quarter torus mesh 
 	// (used for the rod curves the beads are on in the bead maze)
-	m_basicMeshes->DrawQuarterTorusMesh(0.2f);
+	m_basicMeshes->DrawQuarterTorusMesh(QUARTER_TORUS_TUBE_RADIUS);
 
 	// Load the sphere mesh (used for the bead-maze beads 
-	m_basicMeshes->LoadSphereMesh();
+	ShapeGenerator::GenerateSphere(meshData, SPHERE_STACKS, SPHERE_SLICES);
+	ShapeGenerator::UploadMesh(meshData, m_sphereMesh);
+
+	// define the objects drawn in the 3D scene
+	DefineSceneObjects();
+
+	// index the object boxes for culling and spatial queries
+	BuildObjectHierarchy();
+
+	// start compiling the shader variants of the scene objects,
+	// which finish while the first frame is prepared
+	PrecompileObjectVariants();
 }
 
 /***********************************************************
- *  RenderScene()
+ *  PrecompileObjectVariants()
  *
- *  This method is used for rendering the 3D scene by
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for starting the compiles of the
+ *  shader variants the scene objects are drawn with, so
+ *  that they run while the next frame is prepared.  With
+ *  vertex lighting on, the variant of each object lit per
+ *  vertex is compiled as well, as any object can shrink
+ *  under the threshold.  With a transparency renderer, the
+ *  variants adding the transparent objects into its targets
+ *  are compiled too.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::PrecompileObjectVariants()
+{
+	m_bVariantsOutdated = false;
+	if (NULL == m_pShaderVariants)
+	{
+		return;
+	}
+
+	const int lightingModes = (m_vertexLightingPixels > 0.0f) ? 2 : 1;
+	std::vector<uint32_t> variantKeys;
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		const int blendModes = ((NULL != m_pTransparencyRenderer) && (m_sceneObjects[i].bTransparent == true)) ? 2 : 1;
+		for (int mode = 0; mode < lightingModes; mode++)
+		{
+			for (int blend = 0; blend < blendModes; blend++)
+			{
+				uint32_t key = GetObjectVariant((int)i, mode == 1, blend == 1);
+				if (std::find(variantKeys.begin(), variantKeys.end(), key) == variantKeys.end())
+				{
+					variantKeys.push_back(key);
+				}
+			}
+		}
+	}
+	m_pShaderVariants->Precompile(variantKeys);
+}
+
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  This method is used for defining the transformations and
+ *  the textures of every object in the 3D scene, once, so
+ *  that RenderScene() only needs to cull and draw them
+ ***********************************************************/
+void SceneManager::DefineSceneObjects()
 {
 	// declare the variables for the transformations
 	glm::vec3 scaleXYZ;
@@ -503,6 +3186,8 @@ void SceneManager::RenderScene()
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
 
+	m_sceneObjects.clear();
+
 	/*** Set needed transformations before drawing the basic mesh.  ***/
 	/*** This same ordering of code should be used for transforming ***/
 	/*** and drawing all the basic 3D shapes.						***/
@@ -523,20 +3208,20 @@ void SceneManager::RenderScene()
 	// set the XYZ position for the floor mesh
 	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the floor mesh to the scene
+	AddSceneObject(
+		"floor",
+		MESH_PLANE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	// White
-	SetShaderColor(1, 1, 1, 1);
-
-	// draw the floor mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+		ZrotationDegrees,
+		positionXYZ,
+		"",
+		"tile",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		true);
 	/****************************************************************/
 
 
@@ -559,20 +3244,20 @@ void SceneManager::RenderScene()
 	// set the XYZ position for the background mesh
 	positionXYZ = glm::vec3(0.0f, 10.0f, -10.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the background mesh to the scene
+	AddSceneObject(
+		"background",
+		MESH_PLANE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	// White
-	SetShaderColor(1, 1, 1, 1);
-
-	// draw the background mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+		positionXYZ,
+		"",
+		"plaster",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+		true);
 	/****************************************************************/
 
 	/******************************************************************/
@@ -580,6 +3265,10 @@ void SceneManager::RenderScene()
 	/*** the ring stacker toy from the reference image.             ***/
 	/******************************************************************/
 
+	// the ring stacker parts are placed relative to the center
+	// of its base, so the whole toy moves with the group
+	BeginSceneGroup(glm::vec3(10.0f, 0.0f, -1.5f));
+
 	/******************************************************************/
 	/*** Base of the Ring Stacker (Flat/Short Cylinder)             ***/
 	/******************************************************************/
@@ -592,24 +3281,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the base mesh
-	positionXYZ = glm::vec3(10.0f, 0.0f, -1.5f);
+	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the base mesh to the scene
+	AddSceneObject(
+		"ring stacker base",
+		MESH_CYLINDER,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set and apply the wood texture
-	SetShaderTexture("oakWood");
-
-	// draw the base mesh 
-	m_basicMeshes->DrawCylinderMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"oakWood",
+		"wood",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
 
@@ -625,24 +3310,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the rod mesh
-	positionXYZ = glm::vec3(10.0f, 0.1f, -1.5f);
+	positionXYZ = glm::vec3(0.0f, 0.1f, 0.0f);
 
-	// apply transformations for the rod mesh
-	SetTransformations(
+	// add the rod mesh (Vertical rod for rings) to the scene
+	AddSceneObject(
+		"ring stacker rod",
+		MESH_CYLINDER,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set and apply the wood texture
-	SetShaderTexture("oakWood");
-
-	// draw the rod mesh (Vertical rod for rings)
-	m_basicMeshes->DrawCylinderMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"oakWood",
+		"wood",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -665,24 +3346,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the ring mesh
-	positionXYZ = glm::vec3(10.0f, 0.6f, -1.5f);
+	positionXYZ = glm::vec3(0.0f, 0.6f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the torus mesh (Ring 1 - Bottom, Light-Blue) to the scene
+	AddSceneObject(
+		"ring 1",
+		MESH_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set light blue plastic texture
-	SetShaderTexture("ltbluePlastic");
-
-	// draw the torus mesh (Ring 1 - Bottom, Light-Blue)
-	m_basicMeshes->DrawTorusMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"ltbluePlastic",
+		"plastic",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
 
@@ -705,24 +3382,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the ring mesh
-	positionXYZ = glm::vec3(10.0f, 1.7f, -1.5f);
+	positionXYZ = glm::vec3(0.0f, 1.7f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the torus mesh (Ring 2 - Blue) to the scene
+	AddSceneObject(
+		"ring 2",
+		MESH_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set blue plastic texture
-	SetShaderTexture("bluePlastic");
-
-	// draw the torus mesh (Ring 2 - Blue)
-	m_basicMeshes->DrawTorusMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"bluePlastic",
+		"plastic",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
 
@@ -745,24 +3418,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the ring mesh
-	positionXYZ = glm::vec3(10.0f, 2.65f, -1.5f);
+	positionXYZ = glm::vec3(0.0f, 2.65f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the torus mesh (Ring 3 - Magenta) to the scene
+	AddSceneObject(
+		"ring 3",
+		MESH_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set magenta plastic texture
-	SetShaderTexture("magentaPlastic");
-
-	// draw the torus mesh (Ring 3 - Magenta)
-	m_basicMeshes->DrawTorusMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"magentaPlastic",
+		"plastic",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
 
@@ -785,24 +3454,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the ring mesh
-	positionXYZ = glm::vec3(10.0f, 3.4f, -1.5f);
+	positionXYZ = glm::vec3(0.0f, 3.4f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the torus mesh (Ring 4 - Red) to the scene
+	AddSceneObject(
+		"ring 4",
+		MESH_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set red plastic texture
-	SetShaderTexture("redPlastic");
-
-	// draw the torus mesh (Ring 4 - Red)
-	m_basicMeshes->DrawTorusMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"redPlastic",
+		"plastic",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
 
@@ -825,25 +3490,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the ring mesh
-	positionXYZ = glm::vec3(10.0f, 4.05f, -1.5f);
+	positionXYZ = glm::vec3(0.0f, 4.05f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the torus mesh (Ring 5 - Yellow) to the scene
+	AddSceneObject(
+		"ring 5",
+		MESH_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	// Yellow
-	// SetShaderColor(1.0f, 0.78431f, 0.0f, 1.0f);
-
-	// Set orange plastic texture
-	SetShaderTexture("orangePlastic");
-
-	// draw the torus mesh (Ring 5 - Yellow)
-	m_basicMeshes->DrawTorusMesh();
+		positionXYZ,
+		"orangePlastic",
+		"plastic",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
 
@@ -865,30 +3525,35 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the ring mesh
-	positionXYZ = glm::vec3(10.0f, 4.6f, -1.5f);
+	positionXYZ = glm::vec3(0.0f, 4.6f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the torus mesh (Ring 6 - Green) to the scene
+	AddSceneObject(
+		"ring 6",
+		MESH_THICK_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling	
-	// SetTextureUVScale(0.1f, 0.1f);
-	// Set green plastic texture
-	SetShaderTexture("greenPlastic");
-
-	// draw the torus mesh (Ring 6 - Green)
-	m_basicMeshes->DrawExtraTorusMesh1();
+		positionXYZ,
+		"greenPlastic",
+		"plastic",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
+	// end of the ring stacker group
+	EndSceneGroup();
+
 	/******************************************************************/
 	/*** Below are the codes to draw all shapes needed to create    ***/
 	/*** the bead maze toy from the reference image.                ***/
 	/******************************************************************/
 
+	// the bead maze parts are placed relative to the center of
+	// its base on the floor, so the whole toy moves with the
+	// group
+	BeginSceneGroup(glm::vec3(0.0f, 0.0f, -3.5f));
+
 	/******************************************************************/
 	/*** Set needed transformations before drawing Ring 5 (Yellow). ***/
 	/*** This same ordering of code should be used for transforming ***/
@@ -908,24 +3573,22 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the base mesh
-	positionXYZ = glm::vec3(0.0f, 0.35f, -3.5f);
+	positionXYZ = glm::vec3(0.0f, 0.35f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the box mesh to the scene
+	AddSceneObject(
+		"bead maze base",
+		MESH_BOX,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set and apply the wood texture
-	SetShaderTexture("oakWood");
-
-	// draw the box mesh 
-	m_basicMeshes->DrawBoxMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"oakWood",
+		"wood",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(1.0f),
+		true);
 	/******************************************************************/
 
 	/******************************************************************/
@@ -948,27 +3611,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the rod mesh
-	positionXYZ = glm::vec3(4.25f, 0.75f, -3.5f);
+	positionXYZ = glm::vec3(4.25f, 0.75f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod mesh to the scene
+	AddSceneObject(
+		"bead maze tall right rod",
+		MESH_CYLINDER,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod mesh 
-	m_basicMeshes->DrawCylinderMesh();
-	
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -991,26 +3647,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the rod mesh
-	positionXYZ = glm::vec3(-4.25f, 0.75f, -3.5f);
+	positionXYZ = glm::vec3(-4.25f, 0.75f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod mesh to the scene
+	AddSceneObject(
+		"bead maze tall left rod",
+		MESH_CYLINDER,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod mesh 
-	m_basicMeshes->DrawCylinderMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1033,26 +3683,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 90.0f;
 
 	// set the XYZ position for the rod mesh
-	positionXYZ = glm::vec3(4.05f, 5.95f, -3.5f);
+	positionXYZ = glm::vec3(4.05f, 5.95f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod mesh to the scene
+	AddSceneObject(
+		"bead maze long rod",
+		MESH_CYLINDER,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod mesh 
-	m_basicMeshes->DrawCylinderMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1075,26 +3719,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the rod-curve mesh
-	positionXYZ = glm::vec3(4.05f, 5.75f, -3.5f);
+	positionXYZ = glm::vec3(4.05f, 5.75f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod-curve mesh to the scene
+	AddSceneObject(
+		"bead maze long right curve",
+		MESH_QUARTER_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod-curve mesh 
-	m_basicMeshes->DrawQuarterTorusMesh(0.2f);
-	
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1107,7 +3745,7 @@ void SceneManager::RenderScene()
 	/*** Curve where longer, horizontal rod and taller left         ***/
 	/*** vertical rod of the bead maze meet. (quarter torus)        ***/
 	/******************************************************************/
-	
+
 	// set the XYZ scale for rod-curve mesh
 	scaleXYZ = glm::vec3(0.2f, 0.2f, 0.175f);
 
@@ -1117,26 +3755,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 90.0f;
 
 	// set the XYZ position for the rod-curve mesh
-	positionXYZ = glm::vec3(-4.05f, 5.75f, -3.5f);
+	positionXYZ = glm::vec3(-4.05f, 5.75f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod-curve mesh to the scene
+	AddSceneObject(
+		"bead maze long left curve",
+		MESH_QUARTER_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod-curve mesh 
-	m_basicMeshes->DrawQuarterTorusMesh(0.2f);
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 
@@ -1150,7 +3782,7 @@ void SceneManager::RenderScene()
 	/*** Shorter, vertical rod on the right of the bead maze        ***/
 	/*** (long, skinny cylinder)                                    ***/
 	/******************************************************************/
-	
+
 	// set the XYZ scale for rod mesh
 	scaleXYZ = glm::vec3(0.05f, 3.0f, 0.05f);
 
@@ -1160,23 +3792,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the rod mesh
-	positionXYZ = glm::vec3(2.5f, 0.75f, -3.5f);	
+	positionXYZ = glm::vec3(2.5f, 0.75f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod mesh to the scene
+	AddSceneObject(
+		"bead maze short right rod",
+		MESH_CYLINDER,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod mesh
-	m_basicMeshes->DrawCylinderMesh();
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1189,7 +3818,7 @@ void SceneManager::RenderScene()
 	/*** Shorter, vertical rod on the left of the bead maze         ***/
 	/*** (long, skinny cylinder)                                    ***/
 	/******************************************************************/
-	
+
 	// set the XYZ scale for rod mesh
 	scaleXYZ = glm::vec3(0.05f, 3.0f, 0.05f);
 
@@ -1199,24 +3828,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the rod mesh
-	positionXYZ = glm::vec3(-2.5f, 0.75f, -3.5f);
+	positionXYZ = glm::vec3(-2.5f, 0.75f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod mesh to the scene
+	AddSceneObject(
+		"bead maze short left rod",
+		MESH_CYLINDER,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod mesh
-	m_basicMeshes->DrawCylinderMesh();
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1229,7 +3854,7 @@ void SceneManager::RenderScene()
 	/*** Shorter, horizontal rod of the bead maze                   ***/
 	/*** (long, skinny cylinder)                                    ***/
 	/******************************************************************/
-	
+
 	// set the XYZ scale for rod mesh
 	scaleXYZ = glm::vec3(0.05f, 4.75f, 0.05f);
 
@@ -1239,26 +3864,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 90.0f;
 
 	// set the XYZ position for the rod mesh
-	positionXYZ = glm::vec3(2.375f, 3.95f, -3.5f);
+	positionXYZ = glm::vec3(2.375f, 3.95f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod mesh to the scene
+	AddSceneObject(
+		"bead maze short rod",
+		MESH_CYLINDER,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// set the color values into the shader
-	// SetShaderColor(0.2901f, 0.2862f, 0.2823f, 1.0f);
-
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod mesh
-	m_basicMeshes->DrawCylinderMesh();
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1281,26 +3900,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the rod-curve mesh
-	positionXYZ = glm::vec3(2.3f, 3.75f, -3.5f);
+	positionXYZ = glm::vec3(2.3f, 3.75f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod-curve mesh to the scene
+	AddSceneObject(
+		"bead maze short right curve",
+		MESH_QUARTER_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod-curve mesh 
-	m_basicMeshes->DrawQuarterTorusMesh(0.2f);
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1323,26 +3936,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 90.0f;
 
 	// set the XYZ position for the rod-curve mesh
-	positionXYZ = glm::vec3(-2.3f, 3.75f, -3.5f);
+	positionXYZ = glm::vec3(-2.3f, 3.75f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the rod-curve mesh to the scene
+	AddSceneObject(
+		"bead maze short left curve",
+		MESH_QUARTER_TORUS,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling	
-	SetTextureUVScale(0.1f, 0.1f);
-	// Set and apply the metal texture
-	SetShaderTexture("steelTexture");
-
-	// draw the rod-curve mesh 
-	m_basicMeshes->DrawQuarterTorusMesh(0.2f);
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"steelTexture",
+		"metal",
+		glm::vec2(0.1f, 0.1f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1364,26 +3971,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(4.25f, 1.5f, -3.5f);
+	positionXYZ = glm::vec3(4.25f, 1.5f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 1",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	 SetTextureUVScale(0.5f, 0.5f);
-	// Set and apply the blue plastic texture
-	SetShaderTexture("bluePlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"bluePlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1405,26 +4006,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(4.25f, 3.0f, -3.5f);
+	positionXYZ = glm::vec3(4.25f, 3.0f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 2",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling	
-	SetTextureUVScale(0.5f, 0.5f); 
-	// Set and apply the light bkue plastic texture
-	SetShaderTexture("ltbluePlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"ltbluePlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1446,26 +4041,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(4.25f, 4.5f, -3.5f);
+	positionXYZ = glm::vec3(4.25f, 4.5f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 3",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(0.5f, 0.5f);
-	// Set and apply the green plastic texture
-	SetShaderTexture("greenPlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"greenPlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1487,26 +4076,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(-4.25f, 1.5f, -3.5f);
+	positionXYZ = glm::vec3(-4.25f, 1.5f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 4",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(0.5f, 0.5f);
-	// Set and apply the red plastic texture
-	SetShaderTexture("redPlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"redPlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1528,26 +4111,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(-4.25f, 3.0f, -3.5f);
+	positionXYZ = glm::vec3(-4.25f, 3.0f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 5",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(0.5f, 0.5f);
-	// Set and apply the orange plastic texture
-	SetShaderTexture("orangePlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"orangePlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1570,26 +4147,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(2.375f, 1.5f, -3.5f);
+	positionXYZ = glm::vec3(2.375f, 1.5f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 6",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(0.5f, 0.5f);
-	// Set and apply the magenta plastic texture
-	SetShaderTexture("magentaPlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"magentaPlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1612,26 +4183,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(2.375f, 3.0f, -3.5f);
+	positionXYZ = glm::vec3(2.375f, 3.0f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 7",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(0.5f, 0.5f);
-	// Set and apply the red plastic texture
-	SetShaderTexture("redPlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"redPlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1654,26 +4219,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(0.75f, 3.95f, -3.5f);
+	positionXYZ = glm::vec3(0.75f, 3.95f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 8",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(0.5f, 0.5f);
-	// Set and apply the orange plastic texture
-	SetShaderTexture("orangePlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"orangePlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1696,26 +4255,20 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(-0.75f, 3.95f, -3.5f);
+	positionXYZ = glm::vec3(-0.75f, 3.95f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 9",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(0.5f, 0.5f);
-	// Set and apply the green plastic texture
-	SetShaderTexture("greenPlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"greenPlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1738,28 +4291,25 @@ void SceneManager::RenderScene()
 	ZrotationDegrees = 0.0f;
 
 	// set the XYZ position for the bead mesh
-	positionXYZ = glm::vec3(-2.375f, 1.5f, -3.5f);
+	positionXYZ = glm::vec3(-2.375f, 1.5f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the bead mesh to the scene
+	AddSceneObject(
+		"bead 10",
+		MESH_SPHERE,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(0.5f, 0.5f);
-	// Set and apply the light blue plastic texture
-	SetShaderTexture("ltbluePlastic");
-
-	// draw the bead mesh 
-	m_basicMeshes->DrawSphereMesh();
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"ltbluePlastic",
+		"plastic",
+		glm::vec2(0.5f, 0.5f));
 	/******************************************************************/
 
+	// end of the bead maze group
+	EndSceneGroup();
+
 	/******************************************************************/
 	/*** Set needed transformations before drawing the rod.         ***/
 	/*** This same ordering of code should be used for transforming ***/
@@ -1781,21 +4331,20 @@ void SceneManager::RenderScene()
 	// set the XYZ position for the block mesh
 	positionXYZ = glm::vec3(-0.75f, 1.0f, 0.75f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the block mesh to the scene
+	AddSceneObject(
+		"letter block A",
+		MESH_BOX,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(1.0f, 1.0f);
-	// Set and apply the ash wood texture
-	SetShaderTexture("ashWood");
-
-	// draw the block mesh 
-	m_basicMeshes->DrawBoxMesh();
+		positionXYZ,
+		"ashWood",
+		"wood",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(1.0f),
+		true);
 
 	// set the XYZ scale for the block mesh
 	scaleXYZ = glm::vec3(2.01f, 2.01f, 2.01f);
@@ -1808,27 +4357,18 @@ void SceneManager::RenderScene()
 	// set the XYZ position for the overlay block mesh
 	positionXYZ = glm::vec3(-0.7501f, 1.01f, 0.7501f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the overlay block mesh to the scene
+	AddSceneObject(
+		"letter A",
+		MESH_BOX,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-	
-	// Set UV scaling
-	SetTextureUVScale(1.0f, 1.0f);
-	//SetShaderTexture("letterA");	
-	// Overlay the letter texture
-	SetShaderTexture("letterA");
-
-	// draw the overlay block mesh 
-	m_basicMeshes->DrawBoxMesh();
-
-	glPolygonOffset(-1.0f, -1.0f);  // Prevent z-fighting 
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"letterA",
+		"paper",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1852,21 +4392,20 @@ void SceneManager::RenderScene()
 	// set the XYZ position for the block mesh
 	positionXYZ = glm::vec3(2.0f, 1.0f, 0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the block mesh to the scene
+	AddSceneObject(
+		"letter block B",
+		MESH_BOX,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(1.0f, 1.0f);
-	// Draw the base block with wood texture
-	SetShaderTexture("ashWood");
-
-	// draw the block mesh 
-	m_basicMeshes->DrawBoxMesh();
+		positionXYZ,
+		"ashWood",
+		"wood",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(1.0f),
+		true);
 
 	// set the XYZ scale for the overlay block mesh
 	scaleXYZ = glm::vec3(2.01f, 2.01f, 2.01f);
@@ -1879,27 +4418,18 @@ void SceneManager::RenderScene()
 	// set the XYZ position for the overlay block mesh
 	positionXYZ = glm::vec3(2.01f, 1.01f, 0.01f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the overlay block mesh to the scene
+	AddSceneObject(
+		"letter B",
+		MESH_BOX,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(1.0f, 1.0f);
-	//SetShaderTexture("letterB");	
-	// Overlay the letter texture
-	SetShaderTexture("letterB");
-
-	// draw the overlay block mesh 
-	m_basicMeshes->DrawBoxMesh();
-
-	glPolygonOffset(-1.0f, -1.0f);  // Prevent z-fighting 
-
-	// Unbind the texture to prevent it from affecting other objects
-	glBindTexture(GL_TEXTURE_2D, 0);
+		positionXYZ,
+		"letterB",
+		"paper",
+		glm::vec2(1.0f, 1.0f));
 	/******************************************************************/
 
 	/******************************************************************/
@@ -1917,21 +4447,20 @@ void SceneManager::RenderScene()
 	// set the XYZ position for the block mesh
 	positionXYZ = glm::vec3(0.75f, 3.0f, 0.75f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the first block mesh to the scene
+	AddSceneObject(
+		"letter block C",
+		MESH_BOX,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
-
-	// Set UV scaling
-	SetTextureUVScale(1.0f, 1.0f);
-	// Draw the base block with wood texture
-	SetShaderTexture("ashWood");
-	
-	// Draw the first block mesh
-	m_basicMeshes->DrawBoxMesh();
+		positionXYZ,
+		"ashWood",
+		"wood",
+		glm::vec2(1.0f, 1.0f),
+		glm::vec4(1.0f),
+		true);
 
 
 	// set the XYZ scale for the overlay block mesh
@@ -1945,25 +4474,166 @@ void SceneManager::RenderScene()
 	// set the XYZ position for the overlay block mesh
 	positionXYZ = glm::vec3(0.7501f, 3.01f, 0.7501f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	// add the overlay block mesh to the scene
+	AddSceneObject(
+		"letter C",
+		MESH_BOX,
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
-		positionXYZ);
+		positionXYZ,
+		"letterC",
+		"paper",
+		glm::vec2(1.0f, 1.0f));
+	/******************************************************************/
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by
+ *  transforming and drawing the basic 3D shapes
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	// reset the per-frame culling counters
+	m_visibleMeshlets = 0;
+	m_culledMeshlets = 0;
+	m_occludedObjects = 0;
+
+	// the lights were changed since the variants of the objects
+	// were compiled ahead
+	if (m_bVariantsOutdated == true)
+	{
+		PrecompileObjectVariants();
+	}
+
+	// move the boxes of the objects whose groups were moved
+	UpdateSceneTransforms();
+
+	// the baked sets only hold for the scene they were baked
+	// from, so they are dropped once an object moves
+	if ((m_updatedNodes.empty() == false) && (m_visibleSets.IsEmpty() == false))
+	{
+		std::cout << "Scene objects moved, the baked visible sets are no longer used" << std::endl;
+		m_visibleSets.Clear();
+	}
+
+	// inside the baked region the cell of the camera already
+	// holds the visible objects, otherwise collect the objects
+	// inside the camera view and drop the ones hidden behind
+	// the occluders - in both cases the objects too small to
+	// see are dropped
+	const int visibleSetCell = m_visibleSets.FindCell(m_cameraPosition);
+	if (visibleSetCell >= 0)
+	{
+		m_visibleSets.GetVisibleObjects(visibleSetCell, m_visibleObjects);
+		m_culledObjects = (int)(m_sceneObjects.size() - m_visibleObjects.size());
+		CullSmallObjects();
+	}
+	else
+	{
+		m_objectHierarchy.QueryFrustum(m_viewFrustum, m_visibleObjects);
+		std::sort(m_visibleObjects.begin(), m_visibleObjects.end());
+		m_culledObjects = (int)(m_sceneObjects.size() - m_visibleObjects.size());
+		CullSmallObjects();
+		CullOccludedObjects();
+	}
+	m_drawnObjects = (int)m_visibleObjects.size();
+	m_vertexLitObjects = 0;
+	for (size_t i = 0; i < m_visibleObjects.size(); i++)
+	{
+		m_totalCoverage += m_objectCoverage[m_visibleObjects[i]];
+		m_vertexLitObjects += IsObjectVertexLit(m_visibleObjects[i]) ? 1 : 0;
+	}
+
+	AssignPointLights();
+	BindLightmap();
+	BindLightProbes();
+	RenderShadowMaps();
+
+	if (m_bSortObjects == false)
+	{
+		// every object blended in the defined order
+		if (m_bCountShadedSamples == true)
+		{
+			glBeginQuery(GL_SAMPLES_PASSED, m_shadedSampleQuery);
+		}
+		glEnable(GL_BLEND);
+		for (size_t i = 0; i < m_visibleObjects.size(); i++)
+		{
+			DrawSceneObject(m_visibleObjects[i]);
+		}
+	}
+	else
+	{
+		SortVisibleObjects();
+
+		// the geometry buffer pass already shades each pixel once,
+		// so the depth pre-pass is only used by forward shading
+		bool bDeferred = (m_bDeferredShading == true) && (NULL != m_pDeferredRenderer);
+		const bool bDepthPrePass = (bDeferred == false) && (m_bDepthPrePass == true) && (NULL != m_pDepthShaderManager);
+		if (bDepthPrePass == true)
+		{
+			RenderDepthPrePass();
+		}
 
+		if (m_bCountShadedSamples == true)
+		{
+			glBeginQuery(GL_SAMPLES_PASSED, m_shadedSampleQuery);
+		}
+
+		// the opaque objects replace what is behind them, so
+		// blending is only a cost for them
+		glDisable(GL_BLEND);
+		if (bDeferred == true)
+		{
+			bDeferred = RenderDeferredObjects();
+		}
+		if (bDeferred == false)
+		{
+			if (bDepthPrePass == true)
+			{
+				// the opaque objects are shaded only where they are the
+				// closest surface, with their depth already written
+				glDepthFunc(GL_EQUAL);
+				glDepthMask(GL_FALSE);
+			}
+			for (size_t i = 0; i < m_opaqueObjects.size(); i++)
+			{
+				DrawSceneObject(m_opaqueObjects[i]);
+			}
+		}
 
-	//SetShaderTexture("letterC");	
-	// Overlay the letter texture
-	SetShaderTexture("letterC");
-	// Draw the overlay block mesh with letter texture
-	m_basicMeshes->DrawBoxMesh();
+		// the transparent objects are tested against the opaque
+		// depth, but do not hide each other
+		bool bOrderIndependent = (m_bOrderIndependent == true) &&
+			(NULL != m_pTransparencyRenderer) &&
+			(m_transparentObjects.empty() == false);
+		if (bOrderIndependent == true)
+		{
+			bOrderIndependent = RenderOrderIndependentObjects();
+		}
+		if (bOrderIndependent == false)
+		{
+			glEnable(GL_BLEND);
+			glDepthFunc(GL_LESS);
+			glDepthMask(GL_FALSE);
+			for (size_t i = 0; i < m_transparentObjects.size(); i++)
+			{
+				DrawSceneObject(m_transparentObjects[i]);
+			}
+			glDepthMask(GL_TRUE);
+		}
+	}
 
-	glPolygonOffset(-1.0f, -1.0f);  // Prevent z-fighting 
+	if (m_bCountShadedSamples == true)
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+		glGetQueryObjectui64v(m_shadedSampleQuery, GL_QUERY_RESULT, &m_shadedSamples);
+	}
 
 	// Unbind the texture to prevent it from affecting other objects
 	glBindTexture(GL_TEXTURE_2D, 0);
-	/******************************************************************/
-
 }
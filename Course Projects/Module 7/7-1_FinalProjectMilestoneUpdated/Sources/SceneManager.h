@@ -10,7 +10,23 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "ShaderVariants.h"
 #include "ShapeMeshes.h"
+#include "ShapeGenerator.h"
+#include "MeshletBuilder.h"
+#include "MeshImporter.h"
+#include "Frustum.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCuller.h"
+#include "SceneGraph.h"
+#include "PotentiallyVisibleSet.h"
+#include "LightClusters.h"
+#include "ObjectLightLists.h"
+#include "DeferredRenderer.h"
+#include "TransparencyRenderer.h"
+#include "LightmapBaker.h"
+#include "LightProbeGrid.h"
+#include "ShadowMaps.h"
 
 #include <string>
 #include <vector>
@@ -29,10 +45,38 @@ public:
 	// destructor
 	~SceneManager();
 
+	// how the alpha channel of a loaded texture is used
+	enum TEXTURE_ALPHA
+	{
+		// no alpha channel, or every pixel fully opaque
+		TEXTURE_OPAQUE,
+		// every pixel fully opaque or fully clear, so the clear
+		// pixels are discarded without blending
+		TEXTURE_ALPHA_TESTED,
+		// partly transparent pixels that must be blended
+		TEXTURE_BLENDED
+	};
+
+	// how the point lights are narrowed down for shading
+	enum LIGHT_ASSIGNMENT
+	{
+		// the lights reaching the view cluster of each fragment
+		LIGHTS_PER_CLUSTER,
+		// the lights reaching the bounding box of each object
+		LIGHTS_PER_OBJECT,
+		// the first few lights written into the fixed point
+		// light array, which every fragment loops over
+		LIGHTS_FIXED
+	};
+
 	struct TEXTURE_INFO
 	{
 		std::string tag;
 		uint32_t ID;
+		TEXTURE_ALPHA alpha;
+		// average color of the image, bounced by the textured
+		// objects when lightmaps are baked
+		glm::vec3 averageColor;
 	};
 
 	struct OBJECT_MATERIAL
@@ -45,17 +89,219 @@ public:
 		std::string tag;
 	};
 
+	struct MODEL_INFO
+	{
+		std::string tag;
+		MeshImporter::IMPORTED_MODEL model;
+	};
+
+	// meshes that scene objects can be drawn with
+	enum SCENE_MESH
+	{
+		MESH_PLANE,
+		MESH_BOX,
+		MESH_CYLINDER,
+		MESH_SPHERE,
+		MESH_TORUS,
+		MESH_THICK_TORUS,
+		MESH_QUARTER_TORUS,
+		// imported model, the object holds its index
+		MESH_MODEL
+	};
+
+	struct SCENE_OBJECT
+	{
+		// name of the object for display, such as when picked
+		std::string name;
+		SCENE_MESH mesh;
+		// imported model drawn by MESH_MODEL objects, -1 for the
+		// generated meshes
+		int model;
+		// scene graph node of the object, the transformation
+		// below is relative to the group it was added to
+		int node;
+		glm::vec3 scaleXYZ;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		glm::vec3 positionXYZ;
+		// the object is drawn with the color when the
+		// texture tag is empty
+		std::string textureTag;
+		// the surface the object is made of
+		std::string materialTag;
+		glm::vec2 UVscale;
+		glm::vec4 color;
+		// world space bounding box used for culling
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// large opaque objects rasterized for occlusion culling
+		bool bOccluder;
+		// the color or texture lets the objects behind show
+		// through, so the object is blended after the opaque ones
+		bool bTransparent;
+		// the texture has fully clear pixels that are discarded
+		bool bAlphaTested;
+		// the object moves while the scene runs, so its shadow
+		// is drawn every frame instead of being cached
+		bool bDynamic;
+	};
+
+	// directional or spot light of the scene shader
+	struct SCENE_LIGHT
+	{
+		bool bActive;
+		// position of the spot light
+		glm::vec3 position;
+		glm::vec3 direction;
+		// inner and outer cone angles of the spot light
+		float cutOffDegrees;
+		float outerCutOffDegrees;
+		// distance the spot light reaches
+		float range;
+		glm::vec3 color;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// specialized programs of the scene shader, used instead
+	// of the shader manager program when they are set
+	ShaderVariants* m_pShaderVariants;
+	// lighting features the variants are chosen for - the
+	// scene is drawn unlit until lights are set up
+	bool m_bUseLighting;
+	int m_activePointLights;
+	// the lights changed the features of the objects since
+	// their variants were last compiled ahead
+	bool m_bVariantsOutdated;
+	// point lights shaded through the lists of the view
+	// clusters they reach into
+	std::vector<LightClusters::POINT_LIGHT> m_pointLights;
+	LightClusters m_lightClusters;
+	// the lights listed for each drawn object instead
+	ObjectLightLists m_objectLights;
+	LIGHT_ASSIGNMENT m_lightAssignment;
+	// directional and spot light, with their shadow maps
+	SCENE_LIGHT m_directionalLight;
+	SCENE_LIGHT m_spotLight;
+	ShadowMaps m_shadowMaps;
+	// objects in the light view of the shadow map being drawn
+	std::vector<int> m_shadowCasters;
+	// depth only shader used by the depth pre-pass
+	ShaderManager* m_pDepthShaderManager;
+	// lay down the depth of the opaque objects before shading
+	bool m_bDepthPrePass;
+	// geometry buffer the opaque objects are written into when
+	// they are lit per pixel instead of shaded forward
+	DeferredRenderer* m_pDeferredRenderer;
+	bool m_bDeferredShading;
+	// targets the transparent objects are added into in any
+	// order, instead of blended back to front
+	TransparencyRenderer* m_pTransparencyRenderer;
+	bool m_bOrderIndependent;
+	// the transparent objects are being drawn into its targets
+	bool m_bAccumulatingTransparency;
+	// draw the opaque objects front to back without blending,
+	// then the transparent ones back to front with blending
+	bool m_bSortObjects;
+	// count the samples written by the shading passes
+	bool m_bCountShadedSamples;
+	GLuint m_shadedSampleQuery;
+	GLuint64 m_shadedSamples;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
+	// unit box mesh for the bead maze base and letter blocks
+	ShapeGenerator::GL_MESH m_boxMesh;
+	// cylinder mesh for the rods and the ring stacker base
+	ShapeGenerator::GL_MESH m_cylinderMesh;
+	// subdivided plane mesh for the floor and background
+	MeshletBuilder::MESHLET_MESH m_planeMesh;
+	// highly tessellated torus mesh for the stackable rings
+	MeshletBuilder::MESHLET_MESH m_torusMesh;
+	// thicker torus mesh for the smallest stackable ring
+	MeshletBuilder::MESHLET_MESH m_thickTorusMesh;
+	// highly tessellated sphere mesh for the bead maze beads
+	ShapeGenerator::GL_MESH m_sphereMesh;
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// models imported from OBJ and glTF files
+	std::vector<MODEL_INFO> m_importedModels;
+	// model matrix of the object being drawn
+	glm::mat4 m_modelMatrix;
+	// camera frustum of the current frame
+	Frustum m_viewFrustum;
+	// view and projection matrices of the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::mat4 m_viewProjection;
+	// camera position of the current frame
+	glm::vec3 m_cameraPosition;
+	// pixels covered by one unit at distance one (perspective)
+	// or at any distance (orthographic) in the current frame
+	float m_lodPixelScale;
+	bool m_bOrthographicView;
+	// meshlets drawn and culled during the current frame
+	int m_visibleMeshlets;
+	int m_culledMeshlets;
+	// objects of the scene, drawn in order
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// groups and objects of the scene placed relative to
+	// their parents
+	SceneGraph m_sceneGraph;
+	// group that added objects are placed in, -1 for none
+	int m_groupNode;
+	// scene object of each scene graph node, -1 for groups
+	std::vector<int> m_nodeObjects;
+	// nodes moved by the last scene graph update
+	std::vector<int> m_updatedNodes;
+	// spatial index over the scene object boxes
+	BoundingVolumeHierarchy m_objectHierarchy;
+	// objects inside the camera view in the current frame
+	std::vector<int> m_visibleObjects;
+	// precomputed visible objects of the camera cells, used
+	// instead of the frustum and occlusion culling
+	PotentiallyVisibleSet m_visibleSets;
+	// baked diffuse lighting of the static objects, sampled
+	// instead of the lights by the objects with a chart
+	LightmapBaker m_lightmap;
+	// baked indirect light around the scene, replacing the flat
+	// ambient of the lights for the lit objects
+	LightProbeGrid m_lightProbes;
+	// visible objects of the opaque and transparent passes,
+	// and the view depth of each object used to sort them
+	std::vector<int> m_opaqueObjects;
+	std::vector<int> m_transparentObjects;
+	std::vector<float> m_objectViewDepth;
+	// shader variant of each object, used to order the
+	// transparent objects of the order independent pass
+	std::vector<uint32_t> m_objectVariantKeys;
+	// depth buffer of the occluders in the current frame
+	OcclusionCuller m_occlusionCuller;
+	// size of the viewport of the current frame in pixels
+	float m_viewportWidth;
+	float m_viewportHeight;
+	// objects whose screen rectangle is smaller than this many
+	// pixels in both directions are not drawn
+	float m_smallObjectPixels;
+	// screen pixels covered by the bounding box of each drawn
+	// object in the current frame, 0 when not drawn
+	std::vector<float> m_objectCoverage;
+	float m_totalCoverage;
+	// lit objects covering fewer screen pixels than this are
+	// lit per vertex, and the number lit so in the frame
+	float m_vertexLightingPixels;
+	int m_vertexLitObjects;
+	// scene objects drawn, culled, occluded and skipped as too
+	// small during the current frame
+	int m_drawnObjects;
+	int m_culledObjects;
+	int m_occludedObjects;
+	int m_smallObjects;
 
 	// texture identifier for ash wood texture
 	const std::string ASH_WOOD = "ashWood";
@@ -86,6 +332,8 @@ private:
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
+	// find how a loaded texture uses its alpha channel
+	TEXTURE_ALPHA GetTextureAlpha(std::string tag);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
@@ -95,6 +343,23 @@ private:
 	int FindTextureSlot(std::string tag);
 	// find a defined material by tag
 	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	// find an imported model by tag
+	int FindSceneModel(std::string tag) const;
+	// draw an imported model with the current model matrix, at
+	// the level of detail matching its size on screen - the
+	// instance matrices are set into the passed in shader, or
+	// into the scene shader when it is NULL
+	void DrawSceneModel(int model, ShaderManager* pShader);
+
+	// set the model matrix into the transform buffer
+	void SetModelMatrix(const glm::mat4& modelMatrix);
+	// set a uniform value into the shader variants when they
+	// are used, or else into the shader manager program
+	template <typename VALUE>
+	void SetShaderValue(const std::string& name, const VALUE& value);
+	// set a feature flag into the shader manager program - the
+	// shader variants are compiled with their features instead
+	void SetShaderFeature(const std::string& name, bool bEnabled);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -124,6 +389,98 @@ private:
 	void SetShaderMaterial(
 		std::string materialTag);
 
+	// cull the meshlets of the mesh with the current model
+	// matrix and draw the visible ones
+	void DrawMeshletMesh(
+		MeshletBuilder::MESHLET_MESH& meshletMesh);
+
+	// start a group placed at the position, the objects and
+	// groups added until EndSceneGroup() are placed relative
+	// to it - returns the scene graph node of the group
+	int BeginSceneGroup(glm::vec3 positionXYZ);
+	void EndSceneGroup();
+	// add an object to the list drawn every frame
+	void AddSceneObject(
+		std::string name,
+		SCENE_MESH mesh,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		std::string textureTag,
+		std::string materialTag,
+		glm::vec2 UVscale,
+		glm::vec4 color = glm::vec4(1.0f),
+		bool bOccluder = false);
+
+	// draw the mesh of a scene object - the imported models set
+	// the matrices of their instances into the passed in shader,
+	// or into the scene shader when it is NULL
+	void DrawSceneMesh(const SCENE_OBJECT& object, ShaderManager* pShader = NULL);
+	// get the object space bounding box of a scene object
+	void GetObjectLocalBounds(const SCENE_OBJECT& object, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+	// set the shader values of a scene object and draw it
+	void DrawSceneObject(int index);
+	// key of the shader variant with the features of an object,
+	// lit per vertex or per fragment, and blended or added into
+	// the order independent transparency targets
+	uint32_t GetObjectVariant(int index, bool bVertexLighting, bool bOrderIndependent) const;
+	// true when the object covers few enough pixels in the
+	// current frame to be lit per vertex
+	bool IsObjectVertexLit(int index) const;
+	// start compiling the shader variants of the scene objects
+	void PrecompileObjectVariants();
+	// true when nothing behind the object shows through it
+	bool IsObjectOpaque(const SCENE_OBJECT& object);
+	// split the visible objects into the opaque and transparent
+	// lists, each sorted by the distance from the camera
+	void SortVisibleObjects();
+	// write the depth of the visible opaque objects only
+	void RenderDepthPrePass();
+	// write the visible opaque objects into the geometry buffer
+	// and light it - returns false when the geometry buffer
+	// cannot be used, leaving the objects undrawn
+	bool RenderDeferredObjects();
+	// add the visible transparent objects into the order
+	// independent transparency targets and composite them -
+	// returns false when the targets cannot be used, leaving
+	// the objects undrawn
+	bool RenderOrderIndependentObjects();
+	// index the boxes of the scene objects
+	void BuildObjectHierarchy();
+	// apply the moved scene graph nodes to the object boxes
+	void UpdateSceneTransforms();
+	// rasterize the visible occluders and drop the visible
+	// objects hidden behind them
+	void CullOccludedObjects();
+	// measure the screen coverage of the visible objects and
+	// drop the ones below the small object threshold
+	void CullSmallObjects();
+	// assign the point lights to the clusters of the camera
+	// view or to the drawn objects, and pass the light lists
+	// to the scene shader
+	void AssignPointLights();
+	// bind the lightmap atlas for the objects drawn with it
+	void BindLightmap();
+	// bind the light probe grid and pass its box to the scene
+	// shader
+	void BindLightProbes();
+	// describe every scene object to the lightmap and light
+	// probe bakes
+	void GetBakeSurfaces(std::vector<LightmapBaker::BAKE_SURFACE>& surfaces);
+	// update the shadow maps of the directional and spot light,
+	// and pass the lights and their maps to the scene shader
+	void RenderShadowMaps();
+	// draw the static or dynamic objects in the light view into
+	// the bound shadow map - returns the number drawn
+	int DrawShadowCasters(
+		const glm::mat4& lightViewProjection,
+		const glm::vec3& lightPosition,
+		bool bStatic);
+	// the scene is lit once any light is set up
+	void UpdateLightingState();
+
 public:
 
 	// The following methods are for the students to 
@@ -131,5 +488,147 @@ public:
 	void PrepareScene();
 	void RenderScene();
 	void LoadSceneTextures();
+	void DefineSceneObjects();
+
+	// set the camera used for culling the next rendered frame
+	void SetViewParameters(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& cameraPosition);
+
+	// get the scene objects drawn, culled, occluded and skipped
+	// as too small in the last frame
+	int GetDrawnObjectCount() const;
+	int GetCulledObjectCount() const;
+	int GetOccludedObjectCount() const;
+	int GetSmallObjectCount() const;
+
+	// bake the visible objects of the camera region of the
+	// static scene into a file, or load them from one
+	bool BakeVisibleSets(const char* filename);
+	bool LoadVisibleSets(const char* filename);
+	// bake the diffuse lighting of the static scene objects
+	// into a lightmap file, or load it from one - the loaded
+	// lighting replaces the lights of the opaque objects
+	bool BakeLightmaps(const char* filename);
+	bool LoadLightmaps(const char* filename);
+	// bake the indirect light around the scene into a grid of
+	// light probes in a file, or load it from one - the loaded
+	// probes replace the ambient of the lights
+	bool BakeLightProbes(const char* filename);
+	bool LoadLightProbes(const char* filename);
+
+	// turn the opaque and transparent pass split on or off -
+	// when off, every object is blended in the defined order
+	void SetObjectSorting(bool bEnabled);
+
+	// draw with the specialized shader variants - they are
+	// compiled for the scene objects by PrepareScene()
+	void SetShaderVariants(ShaderVariants* pShaderVariants);
+
+	// add a point light that fades out at its range - once
+	// lights are added the scene is drawn lit, each fragment
+	// shading only the lights listed for its view cluster
+	void AddPointLight(glm::vec3 position, float range, glm::vec3 color);
+	void ClearPointLights();
+	int GetPointLightCount() const;
+	// set up the directional light, or the spot light with its
+	// cone angles in degrees - a resolution above 0 gives the
+	// light a shadow map of that size
+	void SetDirectionalLight(glm::vec3 direction, glm::vec3 color, int shadowResolution = 0);
+	void SetSpotLight(
+		glm::vec3 position,
+		glm::vec3 direction,
+		float cutOffDegrees,
+		float outerCutOffDegrees,
+		float range,
+		glm::vec3 color,
+		int shadowResolution = 0);
+	// turn the directional and spot light off
+	void ClearSceneLights();
+	// keep the shadow depth of the static objects between
+	// frames, or draw every object into the maps each frame
+	void SetShadowCaching(bool bEnabled);
+	// get the objects drawn into the shadow maps in the last
+	// frame
+	int GetShadowCasterDrawCount() const;
+	// list the lights per view cluster or per object
+	void SetLightAssignment(LIGHT_ASSIGNMENT assignment);
+	// get the average number of lights listed for the drawn
+	// objects in the last frame, 0 unless listed per object
+	float GetAverageObjectLightCount() const;
+
+	// set the depth only shader and turn the depth pre-pass
+	// on or off - without a shader the pre-pass stays off
+	void SetDepthPrePassShader(ShaderManager* pDepthShaderManager);
+	void SetDepthPrePass(bool bEnabled);
+	// set the deferred renderer and switch the opaque objects
+	// between forward shading and the deferred path - without
+	// a renderer they stay forward shaded
+	void SetDeferredRenderer(DeferredRenderer* pDeferredRenderer);
+	void SetDeferredShading(bool bEnabled);
+	// set the transparency renderer and switch the transparent
+	// objects between sorted blending and the order independent
+	// pass - without a renderer they stay sorted
+	void SetTransparencyRenderer(TransparencyRenderer* pTransparencyRenderer);
+	void SetOrderIndependentTransparency(bool bEnabled);
+	// count the samples written by the shading passes of each
+	// frame, and get the count of the last frame
+	void SetShadedSampleCounting(bool bEnabled);
+	GLuint64 GetShadedSampleCount() const;
+
+	// set the screen size in pixels below which objects are not
+	// drawn, 0 draws every object
+	void SetSmallObjectThreshold(float pixels);
+	// get the screen pixels covered by the bounding box of a
+	// scene object in the last frame, 0 when it was not drawn
+	float GetObjectScreenCoverage(int index) const;
+	// get the sum of the coverage of all drawn objects, which
+	// can exceed the viewport when objects overlap
+	float GetTotalScreenCoverage() const;
+	// set the screen coverage in pixels below which the lit
+	// objects are lit per vertex, 0 lights every object per
+	// fragment
+	void SetVertexLightingThreshold(float pixels);
+	// get the objects lit per vertex in the last frame
+	int GetVertexLitObjectCount() const;
+
+	// import a model file and store it under the tag
+	bool LoadSceneModel(const char* filename, std::string tag, bool bBuildLODs = false);
+	// add an object drawn with an imported model - the object
+	// boxes are indexed again, so it can be added once the
+	// scene is prepared
+	bool AddSceneModel(
+		std::string modelTag,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		std::string textureTag,
+		glm::vec2 UVscale,
+		glm::vec4 color = glm::vec4(1.0f));
 
+	// find the closest scene object hit by a world space ray
+	// within the distance - returns -1 when nothing is hit
+	int PickSceneObject(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance) const;
+	// get a scene object, such as the one that was picked
+	const SCENE_OBJECT& GetSceneObject(int index) const;
+	// get the world transformation of a scene object, with the
+	// groups it was added to applied
+	glm::mat4 GetSceneObjectWorldMatrix(int index) const;
+	// get the group a scene graph node was added to, -1 for
+	// nodes outside any group
+	int GetSceneNodeParent(int node) const;
+	// move a scene object or group relative to its parent,
+	// everything below it follows in the next frame
+	void SetSceneNodePosition(int node, glm::vec3 positionXYZ);
+	// mark a scene object as moving while the scene runs - the
+	// cached shadows are drawn again when a static one moves
+	void SetSceneObjectDynamic(int index, bool bDynamic);
+	// get the display name of a scene mesh
+	static const char* GetSceneMeshName(SCENE_MESH mesh);
 };
\ No newline at end of file
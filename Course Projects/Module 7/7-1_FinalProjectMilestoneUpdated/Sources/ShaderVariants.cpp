@@ -0,0 +1,593 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariants.cpp
+// ============
+// specialized shader programs compiled from one source with injected defines
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderVariants.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	// the point light count is stored above the feature bits
+	const int POINT_LIGHT_SHIFT = 16;
+
+	/***********************************************************
+	 *  ReadTextFile()
+	 *
+	 *  Read a whole text file into a string, returns false when
+	 *  the file cannot be opened.
+	 ***********************************************************/
+	bool ReadTextFile(const char* filename, std::string& text)
+	{
+		std::ifstream file(filename, std::ios::in | std::ios::binary);
+		if (file.is_open() == false)
+		{
+			std::cout << "Could not open shader file:" << filename << std::endl;
+			return(false);
+		}
+
+		std::stringstream stream;
+		stream << file.rdbuf();
+		text = stream.str();
+		return(true);
+	}
+
+	/***********************************************************
+	 *  CompileShader()
+	 *
+	 *  Create a shader object and start compiling the source,
+	 *  without waiting for the result.
+	 ***********************************************************/
+	GLuint CompileShader(GLenum type, const std::string& source)
+	{
+		GLuint shader = glCreateShader(type);
+		const char* text = source.c_str();
+		glShaderSource(shader, 1, &text, NULL);
+		glCompileShader(shader);
+		return(shader);
+	}
+
+	/***********************************************************
+	 *  PrintShaderLog()
+	 *
+	 *  Print the compile errors of a shader, if any.
+	 ***********************************************************/
+	void PrintShaderLog(GLuint shader, const char* stage)
+	{
+		GLint bCompiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &bCompiled);
+		if (bCompiled == GL_TRUE)
+		{
+			return;
+		}
+
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		std::cout << "ERROR: " << stage << " shader variant compile failed: " << log << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ShaderVariants()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderVariants::ShaderVariants()
+{
+	m_serial = 0;
+	m_pCurrent = NULL;
+	m_pBinaryCache = NULL;
+}
+
+/***********************************************************
+ *  ~ShaderVariants()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderVariants::~ShaderVariants()
+{
+	for (auto& entry : m_variants)
+	{
+		glDeleteShader(entry.second.vertexShader);
+		glDeleteShader(entry.second.fragmentShader);
+		glDeleteProgram(entry.second.program);
+	}
+	m_variants.clear();
+	m_pCurrent = NULL;
+}
+
+/***********************************************************
+ *  LoadSources()
+ *
+ *  This method is used for reading the shader sources that
+ *  all the variants are compiled from.  On drivers with
+ *  parallel compilation, the compiles are spread over all
+ *  the threads it offers.
+ ***********************************************************/
+bool ShaderVariants::LoadSources(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	if ((ReadTextFile(vertexShaderFile, m_vertexSource) == false) ||
+		(ReadTextFile(fragmentShaderFile, m_fragmentSource) == false))
+	{
+		return(false);
+	}
+
+	if (GLEW_ARB_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+	}
+	else if (GLEW_KHR_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetBinaryCache()
+ *
+ *  This method is used for passing the cache the linked
+ *  variants are loaded from and saved into.
+ ***********************************************************/
+void ShaderVariants::SetBinaryCache(ProgramBinaryCache* pBinaryCache)
+{
+	m_pBinaryCache = pBinaryCache;
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for building the key of the variant
+ *  with the passed in features and number of point lights.
+ ***********************************************************/
+uint32_t ShaderVariants::MakeKey(uint32_t features, int pointLights)
+{
+	// the point lights only matter to the lit variants, and the
+	// clustered and object list variants read theirs from the
+	// light lists
+	if ((features & FEATURE_LIGHTING) == 0)
+	{
+		features &= ~(uint32_t)(FEATURE_CLUSTERED_LIGHTS | FEATURE_OBJECT_LIGHTS | FEATURE_LIGHT_PROBES | FEATURE_VERTEX_LIGHTING);
+		pointLights = 0;
+	}
+	if ((features & (FEATURE_CLUSTERED_LIGHTS | FEATURE_OBJECT_LIGHTS)) != 0)
+	{
+		pointLights = 0;
+	}
+	// the baked lighting replaces the lights and the probes
+	if ((features & FEATURE_LIGHTMAP) != 0)
+	{
+		features &= ~(uint32_t)(FEATURE_LIGHTING | FEATURE_CLUSTERED_LIGHTS | FEATURE_OBJECT_LIGHTS |
+			FEATURE_LIGHT_PROBES | FEATURE_VERTEX_LIGHTING);
+		pointLights = 0;
+	}
+	if (pointLights > MAX_POINT_LIGHTS)
+	{
+		pointLights = MAX_POINT_LIGHTS;
+	}
+	return(features | ((uint32_t)pointLights << POINT_LIGHT_SHIFT));
+}
+
+/***********************************************************
+ *  Precompile()
+ *
+ *  This method is used for starting the compiles of the
+ *  passed in variants.  Every compile is started before any
+ *  result is checked, and the results are only checked when
+ *  each variant is first used.
+ ***********************************************************/
+void ShaderVariants::Precompile(const std::vector<uint32_t>& keys)
+{
+	for (uint32_t key : keys)
+	{
+		if (m_variants.find(key) == m_variants.end())
+		{
+			StartVariant(key);
+		}
+	}
+}
+
+/***********************************************************
+ *  Use()
+ *
+ *  This method is used for binding the program of a variant
+ *  and setting the uniform values that changed since it was
+ *  last bound.
+ ***********************************************************/
+bool ShaderVariants::Use(uint32_t key)
+{
+	auto found = m_variants.find(key);
+	VARIANT& variant = (found != m_variants.end()) ? found->second : StartVariant(key);
+
+	if (m_pCurrent == &variant)
+	{
+		return(variant.bLinked);
+	}
+
+	if (CheckVariant(key, variant) == false)
+	{
+		return(false);
+	}
+
+	glUseProgram(variant.program);
+	m_pCurrent = &variant;
+
+	if (variant.appliedSerial < m_serial)
+	{
+		for (const auto& uniform : m_uniforms)
+		{
+			if (uniform.second.serial > variant.appliedSerial)
+			{
+				ApplyValue(variant, uniform.first, uniform.second);
+			}
+		}
+		variant.appliedSerial = m_serial;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  ResetBinding()
+ *
+ *  This method is used for noting that another program was
+ *  bound, such as the depth pre-pass shader.
+ ***********************************************************/
+void ShaderVariants::ResetBinding()
+{
+	m_pCurrent = NULL;
+}
+
+/***********************************************************
+ *  setIntValue()
+ *
+ *  This method is used for setting an integer or boolean
+ *  uniform value.
+ ***********************************************************/
+void ShaderVariants::setIntValue(const std::string& name, int value)
+{
+	UNIFORM_VALUE uniform;
+	uniform.type = GL_INT;
+	uniform.intValue = value;
+	StoreValue(name, uniform);
+}
+
+/***********************************************************
+ *  setFloatValue()
+ *
+ *  This method is used for setting a float uniform value.
+ ***********************************************************/
+void ShaderVariants::setFloatValue(const std::string& name, float value)
+{
+	UNIFORM_VALUE uniform;
+	uniform.type = GL_FLOAT;
+	uniform.values[0] = value;
+	StoreValue(name, uniform);
+}
+
+/***********************************************************
+ *  setVec2Value()
+ *
+ *  This method is used for setting a vec2 uniform value.
+ ***********************************************************/
+void ShaderVariants::setVec2Value(const std::string& name, const glm::vec2& value)
+{
+	UNIFORM_VALUE uniform;
+	uniform.type = GL_FLOAT_VEC2;
+	memcpy(uniform.values, glm::value_ptr(value), sizeof(float) * 2);
+	StoreValue(name, uniform);
+}
+
+/***********************************************************
+ *  setVec3Value()
+ *
+ *  This method is used for setting a vec3 uniform value.
+ ***********************************************************/
+void ShaderVariants::setVec3Value(const std::string& name, const glm::vec3& value)
+{
+	UNIFORM_VALUE uniform;
+	uniform.type = GL_FLOAT_VEC3;
+	memcpy(uniform.values, glm::value_ptr(value), sizeof(float) * 3);
+	StoreValue(name, uniform);
+}
+
+/***********************************************************
+ *  setVec4Value()
+ *
+ *  This method is used for setting a vec4 uniform value.
+ ***********************************************************/
+void ShaderVariants::setVec4Value(const std::string& name, const glm::vec4& value)
+{
+	UNIFORM_VALUE uniform;
+	uniform.type = GL_FLOAT_VEC4;
+	memcpy(uniform.values, glm::value_ptr(value), sizeof(float) * 4);
+	StoreValue(name, uniform);
+}
+
+/***********************************************************
+ *  setMat4Value()
+ *
+ *  This method is used for setting a mat4 uniform value.
+ ***********************************************************/
+void ShaderVariants::setMat4Value(const std::string& name, const glm::mat4& value)
+{
+	UNIFORM_VALUE uniform;
+	uniform.type = GL_FLOAT_MAT4;
+	memcpy(uniform.values, glm::value_ptr(value), sizeof(float) * 16);
+	StoreValue(name, uniform);
+}
+
+/***********************************************************
+ *  setSampler2DValue()
+ *
+ *  This method is used for setting the texture unit of a
+ *  sampler uniform.
+ ***********************************************************/
+void ShaderVariants::setSampler2DValue(const std::string& name, int value)
+{
+	setIntValue(name, value);
+}
+
+/***********************************************************
+ *  ReportVariants()
+ *
+ *  This method is used for printing every compiled variant.
+ *  OpenGL has no standard query for the instruction count of
+ *  a program, so the size of the program binary is printed
+ *  instead where the driver supports program binaries.
+ ***********************************************************/
+void ShaderVariants::ReportVariants()
+{
+	const bool bBinarySize = (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary);
+
+	std::cout << "INFO: Shader variants" << std::endl;
+	std::cout << "      texture  lighting  alpha test  clustered  per object  lightmap  probes  per vertex  weighted oit  point lights  linked  cached  binary bytes" << std::endl;
+
+	for (auto& entry : m_variants)
+	{
+		uint32_t key = entry.first;
+		VARIANT& variant = entry.second;
+		bool bLinked = CheckVariant(key, variant);
+
+		GLint binaryLength = 0;
+		if ((bLinked == true) && (bBinarySize == true))
+		{
+			glGetProgramiv(variant.program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		}
+
+		char line[176];
+		snprintf(line, sizeof(line), "      %7s  %8s  %10s  %9s  %10s  %8s  %6s  %10s  %12s  %12d  %6s  %6s  %12s",
+			((key & FEATURE_TEXTURE) != 0) ? "yes" : "no",
+			((key & FEATURE_LIGHTING) != 0) ? "yes" : "no",
+			((key & FEATURE_ALPHA_TEST) != 0) ? "yes" : "no",
+			((key & FEATURE_CLUSTERED_LIGHTS) != 0) ? "yes" : "no",
+			((key & FEATURE_OBJECT_LIGHTS) != 0) ? "yes" : "no",
+			((key & FEATURE_LIGHTMAP) != 0) ? "yes" : "no",
+			((key & FEATURE_LIGHT_PROBES) != 0) ? "yes" : "no",
+			((key & FEATURE_VERTEX_LIGHTING) != 0) ? "yes" : "no",
+			((key & FEATURE_ORDER_INDEPENDENT) != 0) ? "yes" : "no",
+			(int)(key >> POINT_LIGHT_SHIFT),
+			bLinked ? "yes" : "no",
+			variant.bCached ? "yes" : "no",
+			(binaryLength > 0) ? std::to_string(binaryLength).c_str() : "n/a");
+		std::cout << line << std::endl;
+	}
+
+	if (NULL != m_pBinaryCache)
+	{
+		std::cout << "      program binary cache: " << m_pBinaryCache->GetLoadedCount() << " loaded, "
+			<< m_pBinaryCache->GetRejectedCount() << " rejected, "
+			<< m_pBinaryCache->GetSavedCount() << " saved" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  StartVariant()
+ *
+ *  This method is used for starting the compile and link of
+ *  a variant, without waiting for the driver.
+ ***********************************************************/
+ShaderVariants::VARIANT& ShaderVariants::StartVariant(uint32_t key)
+{
+	VARIANT& variant = m_variants[key];
+	std::string vertexSource = GetVariantSource(m_vertexSource, key);
+	std::string fragmentSource = GetVariantSource(m_fragmentSource, key);
+
+	variant.program = glCreateProgram();
+	variant.vertexShader = 0;
+	variant.fragmentShader = 0;
+	variant.appliedSerial = 0;
+	variant.bCached = false;
+	variant.cacheKey = 0;
+
+	// a binary linked on an earlier launch needs no compile
+	if ((NULL != m_pBinaryCache) && (m_pBinaryCache->IsOpen() == true))
+	{
+		variant.cacheKey = m_pBinaryCache->GetKey(vertexSource, fragmentSource);
+		if (m_pBinaryCache->LoadProgram(variant.program, variant.cacheKey) == true)
+		{
+			variant.bCached = true;
+			variant.bChecked = true;
+			variant.bLinked = true;
+			return(variant);
+		}
+		m_pBinaryCache->PrepareProgram(variant.program);
+	}
+
+	variant.vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource);
+	variant.fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	glAttachShader(variant.program, variant.vertexShader);
+	glAttachShader(variant.program, variant.fragmentShader);
+	glLinkProgram(variant.program);
+
+	variant.bChecked = false;
+	variant.bLinked = false;
+
+	return(variant);
+}
+
+/***********************************************************
+ *  CheckVariant()
+ *
+ *  This method is used for getting the link result of a
+ *  variant, which waits for the driver to finish it.  The
+ *  errors are printed once.
+ ***********************************************************/
+bool ShaderVariants::CheckVariant(uint32_t key, VARIANT& variant)
+{
+	if (variant.bChecked == true)
+	{
+		return(variant.bLinked);
+	}
+
+	GLint bLinked = GL_FALSE;
+	glGetProgramiv(variant.program, GL_LINK_STATUS, &bLinked);
+	variant.bChecked = true;
+	variant.bLinked = (bLinked == GL_TRUE);
+
+	if (variant.bLinked == false)
+	{
+		char log[1024];
+		PrintShaderLog(variant.vertexShader, "vertex");
+		PrintShaderLog(variant.fragmentShader, "fragment");
+		glGetProgramInfoLog(variant.program, sizeof(log), NULL, log);
+		std::cout << "ERROR: shader variant " << key << " link failed: " << log << std::endl;
+	}
+	else if ((NULL != m_pBinaryCache) && (m_pBinaryCache->IsOpen() == true))
+	{
+		m_pBinaryCache->SaveProgram(variant.program, variant.cacheKey);
+	}
+
+	// the linked program keeps the compiled code
+	glDetachShader(variant.program, variant.vertexShader);
+	glDetachShader(variant.program, variant.fragmentShader);
+	glDeleteShader(variant.vertexShader);
+	glDeleteShader(variant.fragmentShader);
+	variant.vertexShader = 0;
+	variant.fragmentShader = 0;
+
+	return(variant.bLinked);
+}
+
+/***********************************************************
+ *  GetVariantSource()
+ *
+ *  This method is used for inserting the feature defines of
+ *  a variant after the #version line of a source.
+ ***********************************************************/
+std::string ShaderVariants::GetVariantSource(const std::string& source, uint32_t key) const
+{
+	char defines[416];
+	snprintf(defines, sizeof(defines),
+		"#define SHADER_VARIANT\n"
+		"#define VARIANT_TEXTURE %d\n"
+		"#define VARIANT_LIGHTING %d\n"
+		"#define VARIANT_ALPHA_TEST %d\n"
+		"#define VARIANT_CLUSTERED_LIGHTS %d\n"
+		"#define VARIANT_OBJECT_LIGHTS %d\n"
+		"#define VARIANT_LIGHTMAP %d\n"
+		"#define VARIANT_LIGHT_PROBES %d\n"
+		"#define VARIANT_VERTEX_LIGHTING %d\n"
+		"#define VARIANT_ORDER_INDEPENDENT %d\n"
+		"#define VARIANT_POINT_LIGHTS %d\n",
+		((key & FEATURE_TEXTURE) != 0) ? 1 : 0,
+		((key & FEATURE_LIGHTING) != 0) ? 1 : 0,
+		((key & FEATURE_ALPHA_TEST) != 0) ? 1 : 0,
+		((key & FEATURE_CLUSTERED_LIGHTS) != 0) ? 1 : 0,
+		((key & FEATURE_OBJECT_LIGHTS) != 0) ? 1 : 0,
+		((key & FEATURE_LIGHTMAP) != 0) ? 1 : 0,
+		((key & FEATURE_LIGHT_PROBES) != 0) ? 1 : 0,
+		((key & FEATURE_VERTEX_LIGHTING) != 0) ? 1 : 0,
+		((key & FEATURE_ORDER_INDEPENDENT) != 0) ? 1 : 0,
+		(int)(key >> POINT_LIGHT_SHIFT));
+
+	// the #version line must stay the first line
+	size_t insert = 0;
+	if (source.compare(0, 8, "#version") == 0)
+	{
+		insert = source.find('\n');
+		insert = (insert == std::string::npos) ? source.size() : insert + 1;
+	}
+
+	return(source.substr(0, insert) + defines + source.substr(insert));
+}
+
+/***********************************************************
+ *  StoreValue()
+ *
+ *  This method is used for keeping a uniform value for the
+ *  variants bound later, and setting it on the bound one.
+ ***********************************************************/
+void ShaderVariants::StoreValue(const std::string& name, const UNIFORM_VALUE& value)
+{
+	UNIFORM_VALUE& stored = m_uniforms[name];
+	stored = value;
+	stored.serial = ++m_serial;
+
+	if (NULL != m_pCurrent)
+	{
+		ApplyValue(*m_pCurrent, name, stored);
+		m_pCurrent->appliedSerial = m_serial;
+	}
+}
+
+/***********************************************************
+ *  ApplyValue()
+ *
+ *  This method is used for setting a stored value on the
+ *  program of a variant, which must be the bound program.
+ ***********************************************************/
+void ShaderVariants::ApplyValue(VARIANT& variant, const std::string& name, const UNIFORM_VALUE& value)
+{
+	auto found = variant.locations.find(name);
+	GLint location = -1;
+	if (found == variant.locations.end())
+	{
+		location = glGetUniformLocation(variant.program, name.c_str());
+		variant.locations[name] = location;
+	}
+	else
+	{
+		location = found->second;
+	}
+
+	// uniforms the variant compiled out are skipped
+	if (location < 0)
+	{
+		return;
+	}
+
+	switch (value.type)
+	{
+	case GL_INT:
+		glUniform1i(location, value.intValue);
+		break;
+	case GL_FLOAT:
+		glUniform1f(location, value.values[0]);
+		break;
+	case GL_FLOAT_VEC2:
+		glUniform2fv(location, 1, value.values);
+		break;
+	case GL_FLOAT_VEC3:
+		glUniform3fv(location, 1, value.values);
+		break;
+	case GL_FLOAT_VEC4:
+		glUniform4fv(location, 1, value.values);
+		break;
+	case GL_FLOAT_MAT4:
+		glUniformMatrix4fv(location, 1, GL_FALSE, value.values);
+		break;
+	}
+}
@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariants.h
+// ============
+// specialized shader programs compiled from one source with injected defines
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ProgramBinaryCache.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  ShaderVariants
+ *
+ *  This class compiles the scene shader sources into one
+ *  program per combination of features, by inserting
+ *  #define lines after the #version line.  Each variant only
+ *  holds the code of its features, instead of branching on
+ *  uniforms for every fragment.
+ *
+ *  Variants are compiled the first time they are used, or
+ *  ahead of time with Precompile(), which starts every
+ *  compile before checking any result so that drivers with
+ *  parallel compilation work on them at the same time.
+ *
+ *  With a program binary cache set, a variant linked on an
+ *  earlier launch is loaded from its binary instead.
+ *
+ *  The uniform setters match ShaderManager.  The values are
+ *  kept here, so that a variant bound later receives the
+ *  values set while another variant was in use.
+ ***********************************************************/
+class ShaderVariants
+{
+public:
+	// features compiled into a variant
+	enum FEATURE
+	{
+		FEATURE_TEXTURE = 1,
+		FEATURE_LIGHTING = 2,
+		FEATURE_ALPHA_TEST = 4,
+		FEATURE_CLUSTERED_LIGHTS = 8,
+		FEATURE_OBJECT_LIGHTS = 16,
+		FEATURE_LIGHTMAP = 32,
+		FEATURE_LIGHT_PROBES = 64,
+		FEATURE_VERTEX_LIGHTING = 128,
+		FEATURE_ORDER_INDEPENDENT = 256
+	};
+
+	// most point lights a variant can be compiled for, the
+	// size of the fixed point light array of the scene shader
+	static const int MAX_POINT_LIGHTS = 5;
+
+	// constructor
+	ShaderVariants();
+	// destructor
+	~ShaderVariants();
+
+	// read the vertex and fragment shader sources - returns
+	// false when a file cannot be read
+	bool LoadSources(const char* vertexShaderFile, const char* fragmentShaderFile);
+	// load the variants from the cache where it holds them,
+	// and save the ones compiled from source into it
+	void SetBinaryCache(ProgramBinaryCache* pBinaryCache);
+
+	// key of the variant with the features and the number of
+	// active point lights
+	static uint32_t MakeKey(uint32_t features, int pointLights);
+
+	// start compiling the variants that are not compiled yet
+	void Precompile(const std::vector<uint32_t>& keys);
+	// bind the variant, compiling it first when needed - returns
+	// false when the variant failed to compile
+	bool Use(uint32_t key);
+	// forget the bound variant after another program was bound,
+	// so that the next Use() binds its program again
+	void ResetBinding();
+
+	// set uniform values on the bound variant and the ones
+	// bound later
+	void setIntValue(const std::string& name, int value);
+	void setFloatValue(const std::string& name, float value);
+	void setVec2Value(const std::string& name, const glm::vec2& value);
+	void setVec3Value(const std::string& name, const glm::vec3& value);
+	void setVec4Value(const std::string& name, const glm::vec4& value);
+	void setMat4Value(const std::string& name, const glm::mat4& value);
+	void setSampler2DValue(const std::string& name, int value);
+
+	// print the compiled variants and the size of their program
+	// binaries, where the driver provides them
+	void ReportVariants();
+
+private:
+	// a uniform value and when it was last set
+	struct UNIFORM_VALUE
+	{
+		GLenum type;
+		float values[16];
+		int intValue;
+		uint64_t serial;
+	};
+
+	struct VARIANT
+	{
+		GLuint program;
+		GLuint vertexShader;
+		GLuint fragmentShader;
+		// the link result was checked
+		bool bChecked;
+		bool bLinked;
+		// the program was loaded from the binary cache
+		bool bCached;
+		// key of the program in the binary cache
+		uint64_t cacheKey;
+		// serial of the newest uniform value set on the program
+		uint64_t appliedSerial;
+		// cached uniform locations by name, -1 when unused
+		std::unordered_map<std::string, GLint> locations;
+	};
+
+	std::string m_vertexSource;
+	std::string m_fragmentSource;
+	std::map<uint32_t, VARIANT> m_variants;
+	std::unordered_map<std::string, UNIFORM_VALUE> m_uniforms;
+	uint64_t m_serial;
+	// the bound variant, NULL when none is bound
+	VARIANT* m_pCurrent;
+	// cache of the linked variants, NULL when not used
+	ProgramBinaryCache* m_pBinaryCache;
+
+	// start the compile and link of a variant
+	VARIANT& StartVariant(uint32_t key);
+	// wait for the link of a variant and print its errors
+	bool CheckVariant(uint32_t key, VARIANT& variant);
+	// the source with the defines of the key inserted
+	std::string GetVariantSource(const std::string& source, uint32_t key) const;
+	// store a value, and set it on the bound variant
+	void StoreValue(const std::string& name, const UNIFORM_VALUE& value);
+	// set a stored value on the bound program of a variant
+	void ApplyValue(VARIANT& variant, const std::string& name, const UNIFORM_VALUE& value);
+};
@@ -0,0 +1,426 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.cpp
+// ============
+// depth maps of the directional and spot lights with a cached static part
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowMaps.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// slope scaled and constant depth offset of the drawn
+	// casters, which keeps the lit surfaces from shadowing
+	// themselves
+	const float CASTER_OFFSET_FACTOR = 2.0f;
+	const float CASTER_OFFSET_UNITS = 4.0f;
+
+	/***********************************************************
+	 *  GetLightUp()
+	 *
+	 *  Choose the up vector of a light view, away from the
+	 *  direction the light points in.
+	 ***********************************************************/
+	glm::vec3 GetLightUp(const glm::vec3& direction)
+	{
+		if (std::fabs(direction.y) > 0.99f)
+		{
+			return(glm::vec3(0.0f, 0.0f, 1.0f));
+		}
+		return(glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+}
+
+/***********************************************************
+ *  ShadowMaps()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowMaps::ShadowMaps()
+{
+	for (int i = 0; i < SHADOW_LIGHT_COUNT; i++)
+	{
+		SHADOW_MAP& map = m_maps[i];
+		map.resolution = 0;
+		map.lightViewProjection = glm::mat4(1.0f);
+		map.staticFramebuffer = 0;
+		map.staticDepth = 0;
+		map.framebuffer = 0;
+		map.depth = 0;
+		map.bStaticValid = false;
+		map.bComplete = false;
+		map.bDynamicDrawn = false;
+	}
+	m_bCaching = true;
+	m_casterDraws = 0;
+	m_staticRenders = 0;
+}
+
+/***********************************************************
+ *  ~ShadowMaps()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowMaps::~ShadowMaps()
+{
+	for (int i = 0; i < SHADOW_LIGHT_COUNT; i++)
+	{
+		DestroyMaps(m_maps[i]);
+	}
+}
+
+/***********************************************************
+ *  SetResolution()
+ *
+ *  This method is used for setting the size of the maps of
+ *  a light, which are created again for the new size.
+ ***********************************************************/
+void ShadowMaps::SetResolution(SHADOW_LIGHT light, int resolution)
+{
+	SHADOW_MAP& map = m_maps[light];
+	resolution = std::max(resolution, 0);
+	if (resolution == map.resolution)
+	{
+		return;
+	}
+
+	DestroyMaps(map);
+	map.resolution = resolution;
+	if (resolution > 0)
+	{
+		CreateMaps(map);
+	}
+}
+
+/***********************************************************
+ *  GetResolution()
+ *
+ *  This method is used for getting the size of the maps of
+ *  a light, 0 when it casts no shadows.
+ ***********************************************************/
+int ShadowMaps::GetResolution(SHADOW_LIGHT light) const
+{
+	return(m_maps[light].resolution);
+}
+
+/***********************************************************
+ *  SetLightMatrix()
+ *
+ *  This method is used for setting the view and projection
+ *  the maps of a light are drawn with.  The same matrix is
+ *  set every frame, so the cached depth is only dropped when
+ *  it differs.
+ ***********************************************************/
+void ShadowMaps::SetLightMatrix(SHADOW_LIGHT light, const glm::mat4& lightViewProjection)
+{
+	SHADOW_MAP& map = m_maps[light];
+	if (map.lightViewProjection != lightViewProjection)
+	{
+		map.lightViewProjection = lightViewProjection;
+		map.bStaticValid = false;
+	}
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for dropping the cached depth of the
+ *  static objects, which is drawn again by the next Render().
+ ***********************************************************/
+void ShadowMaps::Invalidate()
+{
+	for (int i = 0; i < SHADOW_LIGHT_COUNT; i++)
+	{
+		m_maps[i].bStaticValid = false;
+	}
+}
+
+/***********************************************************
+ *  SetCaching()
+ *
+ *  This method is used for keeping the depth of the static
+ *  objects between frames, or drawing every object into the
+ *  maps each frame.
+ ***********************************************************/
+void ShadowMaps::SetCaching(bool bEnabled)
+{
+	m_bCaching = bEnabled;
+	Invalidate();
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for drawing the maps of the lights
+ *  that cast shadows.  The static objects are drawn into the
+ *  cached map when it was invalidated, then the cached depth
+ *  is copied into the second map and the dynamic objects are
+ *  drawn over it.  The viewport and the window framebuffer
+ *  are restored afterwards.
+ ***********************************************************/
+void ShadowMaps::Render(const DRAW_CASTERS& drawCasters, bool bDynamicCasters)
+{
+	m_casterDraws = 0;
+	m_staticRenders = 0;
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(CASTER_OFFSET_FACTOR, CASTER_OFFSET_UNITS);
+
+	for (int i = 0; i < SHADOW_LIGHT_COUNT; i++)
+	{
+		SHADOW_MAP& map = m_maps[i];
+		map.bDynamicDrawn = false;
+		if ((map.resolution <= 0) || (map.bComplete == false))
+		{
+			continue;
+		}
+
+		glViewport(0, 0, map.resolution, map.resolution);
+
+		// without caching, every object is drawn straight into
+		// the second map
+		if (m_bCaching == false)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, map.framebuffer);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			m_casterDraws += drawCasters((SHADOW_LIGHT)i, map.lightViewProjection, true);
+			if (bDynamicCasters == true)
+			{
+				m_casterDraws += drawCasters((SHADOW_LIGHT)i, map.lightViewProjection, false);
+			}
+			map.bDynamicDrawn = true;
+			map.bStaticValid = false;
+			m_staticRenders++;
+			continue;
+		}
+
+		if (map.bStaticValid == false)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, map.staticFramebuffer);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			m_casterDraws += drawCasters((SHADOW_LIGHT)i, map.lightViewProjection, true);
+			map.bStaticValid = true;
+			m_staticRenders++;
+		}
+
+		if (bDynamicCasters == true)
+		{
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, map.staticFramebuffer);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, map.framebuffer);
+			glBlitFramebuffer(
+				0, 0, map.resolution, map.resolution,
+				0, 0, map.resolution, map.resolution,
+				GL_DEPTH_BUFFER_BIT,
+				GL_NEAREST);
+			glBindFramebuffer(GL_FRAMEBUFFER, map.framebuffer);
+			m_casterDraws += drawCasters((SHADOW_LIGHT)i, map.lightViewProjection, false);
+			map.bDynamicDrawn = true;
+		}
+	}
+
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the map of a light to a
+ *  texture unit - the second map when the dynamic objects
+ *  were drawn into it, otherwise the cached one.
+ ***********************************************************/
+void ShadowMaps::Bind(SHADOW_LIGHT light, int textureUnit) const
+{
+	const SHADOW_MAP& map = m_maps[light];
+
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_2D, (map.bDynamicDrawn == true) ? map.depth : map.staticDepth);
+}
+
+/***********************************************************
+ *  IsActive()
+ *
+ *  This method is used for checking whether a light has a
+ *  shadow map that was drawn.
+ ***********************************************************/
+bool ShadowMaps::IsActive(SHADOW_LIGHT light) const
+{
+	const SHADOW_MAP& map = m_maps[light];
+	return((map.resolution > 0) && (map.bComplete == true) &&
+		((map.bStaticValid == true) || (map.bDynamicDrawn == true)));
+}
+
+/***********************************************************
+ *  GetShadowMatrix()
+ *
+ *  This method is used for getting the matrix that takes a
+ *  world position into the texture coordinates and depth of
+ *  the map of a light, all from zero to one.
+ ***********************************************************/
+glm::mat4 ShadowMaps::GetShadowMatrix(SHADOW_LIGHT light) const
+{
+	glm::mat4 bias = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f));
+	bias = glm::scale(bias, glm::vec3(0.5f));
+	return(bias * m_maps[light].lightViewProjection);
+}
+
+/***********************************************************
+ *  GetCasterDrawCount()
+ *
+ *  This method is used for getting the number of objects
+ *  drawn into the maps in the last frame.
+ ***********************************************************/
+int ShadowMaps::GetCasterDrawCount() const
+{
+	return(m_casterDraws);
+}
+
+/***********************************************************
+ *  GetStaticRenderCount()
+ *
+ *  This method is used for getting the number of maps the
+ *  static objects were drawn into in the last frame.
+ ***********************************************************/
+int ShadowMaps::GetStaticRenderCount() const
+{
+	return(m_staticRenders);
+}
+
+/***********************************************************
+ *  GetDirectionalMatrix()
+ *
+ *  This method is used for getting the view and projection
+ *  of a directional light.  The orthographic box holds the
+ *  sphere around the passed in box, so that it covers the
+ *  box from any direction.
+ ***********************************************************/
+glm::mat4 ShadowMaps::GetDirectionalMatrix(
+	const glm::vec3& direction,
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax)
+{
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = std::max(glm::length(boundsMax - boundsMin) * 0.5f, 0.01f);
+	glm::vec3 lightDirection = glm::normalize(direction);
+
+	glm::mat4 view = glm::lookAt(
+		center - (lightDirection * radius),
+		center,
+		GetLightUp(lightDirection));
+	glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius);
+
+	return(projection * view);
+}
+
+/***********************************************************
+ *  GetSpotMatrix()
+ *
+ *  This method is used for getting the view and projection
+ *  of a spot light, whose frustum holds the outer cone out
+ *  to the range of the light.
+ ***********************************************************/
+glm::mat4 ShadowMaps::GetSpotMatrix(
+	const glm::vec3& position,
+	const glm::vec3& direction,
+	float outerCutOffDegrees,
+	float range)
+{
+	glm::vec3 lightDirection = glm::normalize(direction);
+	float fieldOfView = glm::radians(std::min(outerCutOffDegrees * 2.0f, 170.0f));
+	float nearPlane = std::max(range * 0.01f, 0.05f);
+
+	glm::mat4 view = glm::lookAt(position, position + lightDirection, GetLightUp(lightDirection));
+	glm::mat4 projection = glm::perspective(fieldOfView, 1.0f, nearPlane, std::max(range, nearPlane * 2.0f));
+
+	return(projection * view);
+}
+
+/***********************************************************
+ *  CreateMaps()
+ *
+ *  This method is used for creating the two depth maps of a
+ *  light.  They compare the depth in the sampler with linear
+ *  filtering, and read as lit outside their border.
+ ***********************************************************/
+void ShadowMaps::CreateMaps(SHADOW_MAP& map)
+{
+	const GLfloat border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	GLuint* textures[2] = { &map.staticDepth, &map.depth };
+	GLuint* framebuffers[2] = { &map.staticFramebuffer, &map.framebuffer };
+
+	map.bComplete = true;
+	for (int i = 0; i < 2; i++)
+	{
+		glGenTextures(1, textures[i]);
+		glBindTexture(GL_TEXTURE_2D, *textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, map.resolution, map.resolution, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+		// depth only, there is no color to write
+		glGenFramebuffers(1, framebuffers[i]);
+		glBindFramebuffer(GL_FRAMEBUFFER, *framebuffers[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, *textures[i], 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			map.bComplete = false;
+		}
+	}
+
+	if (map.bComplete == false)
+	{
+		std::cout << "ERROR: a shadow map framebuffer is incomplete" << std::endl;
+	}
+
+	map.bStaticValid = false;
+	map.bDynamicDrawn = false;
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  DestroyMaps()
+ *
+ *  This method is used for freeing the depth maps of a
+ *  light.
+ ***********************************************************/
+void ShadowMaps::DestroyMaps(SHADOW_MAP& map)
+{
+	if (map.staticFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &map.staticFramebuffer);
+		glDeleteFramebuffers(1, &map.framebuffer);
+		glDeleteTextures(1, &map.staticDepth);
+		glDeleteTextures(1, &map.depth);
+	}
+	map.staticFramebuffer = 0;
+	map.framebuffer = 0;
+	map.staticDepth = 0;
+	map.depth = 0;
+	map.bComplete = false;
+	map.bStaticValid = false;
+	map.bDynamicDrawn = false;
+}
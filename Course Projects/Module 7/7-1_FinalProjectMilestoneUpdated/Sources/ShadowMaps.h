@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.h
+// ============
+// depth maps of the directional and spot lights with a cached static part
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <functional>
+
+/***********************************************************
+ *  ShadowMaps
+ *
+ *  This class holds the shadow maps of the directional and
+ *  spot lights of the scene shader.  Each light has two
+ *  depth maps of its own resolution - the static objects are
+ *  drawn into the first one only when it is invalidated,
+ *  because a light or a static object moved, and every
+ *  frame the cached depth is copied into the second one and
+ *  only the dynamic objects are drawn over it.  Without
+ *  dynamic objects the cached map is sampled directly.
+ *
+ *  The maps compare the depth in the texture sampler, so
+ *  each tap of the percentage closer filter in the shader
+ *  is already blended between four texels.
+ ***********************************************************/
+class ShadowMaps
+{
+public:
+	// lights that cast shadows
+	enum SHADOW_LIGHT
+	{
+		SHADOW_DIRECTIONAL,
+		SHADOW_SPOT,
+		SHADOW_LIGHT_COUNT
+	};
+
+	// draw the static or the dynamic objects with the depth
+	// shader for the view and projection of the light - returns
+	// the number of objects drawn
+	typedef std::function<int(SHADOW_LIGHT light, const glm::mat4& lightViewProjection, bool bStatic)> DRAW_CASTERS;
+
+	// constructor
+	ShadowMaps();
+	// destructor
+	~ShadowMaps();
+
+	// set the size of the square maps of a light, 0 turns its
+	// shadows off
+	void SetResolution(SHADOW_LIGHT light, int resolution);
+	int GetResolution(SHADOW_LIGHT light) const;
+	// set the view and projection of a light - the cached
+	// depth is only dropped when the matrix changes
+	void SetLightMatrix(SHADOW_LIGHT light, const glm::mat4& lightViewProjection);
+	// drop the cached static depth of every light
+	void Invalidate();
+	// keep the static depth between frames, or draw every
+	// object into the maps each frame when off
+	void SetCaching(bool bEnabled);
+
+	// draw the shadow maps of the lights with a resolution,
+	// the static objects only when their depth is not cached
+	void Render(const DRAW_CASTERS& drawCasters, bool bDynamicCasters);
+	// bind the map of a light to the texture unit
+	void Bind(SHADOW_LIGHT light, int textureUnit) const;
+	// true when the light has a shadow map to sample
+	bool IsActive(SHADOW_LIGHT light) const;
+	// matrix taking world positions into the texture
+	// coordinates and depth of the map of a light
+	glm::mat4 GetShadowMatrix(SHADOW_LIGHT light) const;
+
+	// objects drawn into the maps in the last frame, and the
+	// static maps drawn again in it
+	int GetCasterDrawCount() const;
+	int GetStaticRenderCount() const;
+
+	// view and projection of a directional light covering the
+	// box, and of a spot light with its cone and range
+	static glm::mat4 GetDirectionalMatrix(
+		const glm::vec3& direction,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax);
+	static glm::mat4 GetSpotMatrix(
+		const glm::vec3& position,
+		const glm::vec3& direction,
+		float outerCutOffDegrees,
+		float range);
+
+private:
+	// the two maps of a light
+	struct SHADOW_MAP
+	{
+		int resolution;
+		glm::mat4 lightViewProjection;
+		// depth of the static objects, kept while valid
+		GLuint staticFramebuffer;
+		GLuint staticDepth;
+		// copy of the static depth with the dynamic objects
+		GLuint framebuffer;
+		GLuint depth;
+		bool bStaticValid;
+		bool bComplete;
+		// the dynamic objects were drawn into the second map
+		// in the last frame
+		bool bDynamicDrawn;
+	};
+
+	SHADOW_MAP m_maps[SHADOW_LIGHT_COUNT];
+	bool m_bCaching;
+	int m_casterDraws;
+	int m_staticRenders;
+
+	// create the depth maps of a light for its resolution
+	void CreateMaps(SHADOW_MAP& map);
+	// free the depth maps of a light
+	void DestroyMaps(SHADOW_MAP& map);
+};
@@ -0,0 +1,605 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegenerator.cpp
+// ============
+// generate highly tessellated parametric meshes with data-parallel kernels
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeGenerator.h"
+#include "BenchmarkTimer.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SHAPEGEN_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const float PI = 3.14159265358979f;
+
+	// minimum number of rows given to a worker at once
+	const int MIN_ROWS_PER_BATCH = 8;
+
+	// angle table for one parametric direction - the cosine and
+	// sine of every sample plus the matching texture coordinate
+	struct ANGLE_TABLE
+	{
+		std::vector<float> cosines;
+		std::vector<float> sines;
+		std::vector<float> coords;
+	};
+
+	/***********************************************************
+	 *  BuildAngleTable()
+	 *
+	 *  Fill the table with segments + 1 samples spanning
+	 *  [startAngle, startAngle + sweep].  The last sample
+	 *  duplicates the first so that the texture seam can use
+	 *  its own UV coordinate.
+	 ***********************************************************/
+	void BuildAngleTable(ANGLE_TABLE& table, int segments, float startAngle, float sweep)
+	{
+		table.cosines.resize(segments + 1);
+		table.sines.resize(segments + 1);
+		table.coords.resize(segments + 1);
+
+		for (int i = 0; i <= segments; i++)
+		{
+			float t = (float)i / (float)segments;
+			float angle = startAngle + (t * sweep);
+			table.cosines[i] = std::cos(angle);
+			table.sines[i] = std::sin(angle);
+			table.coords[i] = t;
+		}
+	}
+
+	/***********************************************************
+	 *  WriteVertex()
+	 *
+	 *  Store one interleaved vertex.
+	 ***********************************************************/
+	inline void WriteVertex(
+		float* out,
+		float x, float y, float z,
+		float nx, float ny, float nz,
+		float u, float v)
+	{
+		out[0] = x;
+		out[1] = y;
+		out[2] = z;
+		out[3] = nx;
+		out[4] = ny;
+		out[5] = nz;
+		out[6] = u;
+		out[7] = v;
+	}
+
+#ifdef SHAPEGEN_USE_SSE
+	/***********************************************************
+	 *  StoreVertices4()
+	 *
+	 *  Convert four vertices from structure-of-arrays registers
+	 *  into the interleaved vertex layout and store them.
+	 ***********************************************************/
+	inline void StoreVertices4(
+		float* out,
+		__m128 x, __m128 y, __m128 z,
+		__m128 nx, __m128 ny, __m128 nz,
+		__m128 u, __m128 v)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, nx);
+		_MM_TRANSPOSE4_PS(ny, nz, u, v);
+
+		_mm_storeu_ps(out + 0, x);
+		_mm_storeu_ps(out + 4, ny);
+		_mm_storeu_ps(out + 8, y);
+		_mm_storeu_ps(out + 12, nz);
+		_mm_storeu_ps(out + 16, z);
+		_mm_storeu_ps(out + 20, u);
+		_mm_storeu_ps(out + 24, nx);
+		_mm_storeu_ps(out + 28, v);
+	}
+#endif
+
+	/***********************************************************
+	 *  GenerateTorusRow()
+	 *
+	 *  Evaluate every vertex around the tube for one position
+	 *  along the main ring.
+	 ***********************************************************/
+	void GenerateTorusRow(
+		float* out,
+		const ANGLE_TABLE& tube,
+		float cosMain,
+		float sinMain,
+		float u,
+		float mainRadius,
+		float tubeRadius)
+	{
+		const int columns = (int)tube.cosines.size();
+		int j = 0;
+
+#ifdef SHAPEGEN_USE_SSE
+		const __m128 vMainRadius = _mm_set1_ps(mainRadius);
+		const __m128 vTubeRadius = _mm_set1_ps(tubeRadius);
+		const __m128 vCosMain = _mm_set1_ps(cosMain);
+		const __m128 vSinMain = _mm_set1_ps(sinMain);
+		const __m128 vU = _mm_set1_ps(u);
+
+		for (; j + 4 <= columns; j += 4)
+		{
+			__m128 cosTube = _mm_loadu_ps(&tube.cosines[j]);
+			__m128 sinTube = _mm_loadu_ps(&tube.sines[j]);
+			__m128 radial = _mm_add_ps(vMainRadius, _mm_mul_ps(vTubeRadius, cosTube));
+
+			StoreVertices4(
+				out + (j * ShapeGenerator::FLOATS_PER_VERTEX),
+				_mm_mul_ps(radial, vCosMain),
+				_mm_mul_ps(radial, vSinMain),
+				_mm_mul_ps(vTubeRadius, sinTube),
+				_mm_mul_ps(cosTube, vCosMain),
+				_mm_mul_ps(cosTube, vSinMain),
+				sinTube,
+				vU,
+				_mm_loadu_ps(&tube.coords[j]));
+		}
+#endif
+
+		// remaining columns that do not fill a SIMD register
+		for (; j < columns; j++)
+		{
+			float cosTube = tube.cosines[j];
+			float sinTube = tube.sines[j];
+			float radial = mainRadius + (tubeRadius * cosTube);
+
+			WriteVertex(
+				out + (j * ShapeGenerator::FLOATS_PER_VERTEX),
+				radial * cosMain,
+				radial * sinMain,
+				tubeRadius * sinTube,
+				cosTube * cosMain,
+				cosTube * sinMain,
+				sinTube,
+				u,
+				tube.coords[j]);
+		}
+	}
+
+	/***********************************************************
+	 *  GenerateSphereRow()
+	 *
+	 *  Evaluate every vertex around one stack of the sphere.
+	 ***********************************************************/
+	void GenerateSphereRow(
+		float* out,
+		const ANGLE_TABLE& slices,
+		float cosStack,
+		float sinStack,
+		float v)
+	{
+		const int columns = (int)slices.cosines.size();
+		int j = 0;
+
+#ifdef SHAPEGEN_USE_SSE
+		const __m128 vCosStack = _mm_set1_ps(cosStack);
+		const __m128 vSinStack = _mm_set1_ps(sinStack);
+		const __m128 vV = _mm_set1_ps(v);
+
+		for (; j + 4 <= columns; j += 4)
+		{
+			__m128 x = _mm_mul_ps(vSinStack, _mm_loadu_ps(&slices.cosines[j]));
+			__m128 z = _mm_mul_ps(vSinStack, _mm_loadu_ps(&slices.sines[j]));
+
+			// the normal of a unit sphere is its position
+			StoreVertices4(
+				out + (j * ShapeGenerator::FLOATS_PER_VERTEX),
+				x, vCosStack, z,
+				x, vCosStack, z,
+				_mm_loadu_ps(&slices.coords[j]),
+				vV);
+		}
+#endif
+
+		// remaining columns that do not fill a SIMD register
+		for (; j < columns; j++)
+		{
+			float x = sinStack * slices.cosines[j];
+			float z = sinStack * slices.sines[j];
+
+			WriteVertex(
+				out + (j * ShapeGenerator::FLOATS_PER_VERTEX),
+				x, cosStack, z,
+				x, cosStack, z,
+				slices.coords[j],
+				v);
+		}
+	}
+
+	/***********************************************************
+	 *  GenerateGridIndices()
+	 *
+	 *  Build two triangles for every quad of a rows x columns
+	 *  vertex grid.  When bFlipWinding is false the triangles
+	 *  are (a, b, a + 1) and (a + 1, b, b + 1), where a is on
+	 *  the current row and b is on the next one.
+	 ***********************************************************/
+	void GenerateGridIndices(
+		std::vector<GLuint>& indices,
+		int rows,
+		int columns,
+		bool bFlipWinding)
+	{
+		const int quadRows = rows - 1;
+		const int quadColumns = columns - 1;
+
+		indices.resize((size_t)quadRows * quadColumns * 6);
+
+		ThreadPool::GetShared()->ParallelFor(quadRows, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				GLuint* out = &indices[(size_t)i * quadColumns * 6];
+				for (int j = 0; j < quadColumns; j++)
+				{
+					GLuint a = (GLuint)(i * columns + j);
+					GLuint b = a + (GLuint)columns;
+
+					if (bFlipWinding == false)
+					{
+						out[0] = a; out[1] = b; out[2] = a + 1;
+						out[3] = a + 1; out[4] = b; out[5] = b + 1;
+					}
+					else
+					{
+						out[0] = a; out[1] = a + 1; out[2] = b;
+						out[3] = a + 1; out[4] = b + 1; out[5] = b;
+					}
+					out += 6;
+				}
+			}
+		}, MIN_ROWS_PER_BATCH);
+	}
+
+	/***********************************************************
+	 *  GenerateTorusReference()
+	 *
+	 *  Straightforward single threaded torus generation with a
+	 *  sine and cosine call per vertex.  This is only used as
+	 *  the baseline for the generation benchmark.
+	 ***********************************************************/
+	void GenerateTorusReference(
+		ShapeGenerator::MESH_DATA& mesh,
+		int mainSegments,
+		int tubeSegments,
+		float mainRadius,
+		float tubeRadius)
+	{
+		mesh.vertices.clear();
+		mesh.indices.clear();
+
+		for (int i = 0; i <= mainSegments; i++)
+		{
+			float u = (float)i / (float)mainSegments;
+			for (int j = 0; j <= tubeSegments; j++)
+			{
+				float v = (float)j / (float)tubeSegments;
+				float mainAngle = u * 2.0f * PI;
+				float tubeAngle = v * 2.0f * PI;
+				float radial = mainRadius + (tubeRadius * std::cos(tubeAngle));
+
+				mesh.vertices.push_back(radial * std::cos(mainAngle));
+				mesh.vertices.push_back(radial * std::sin(mainAngle));
+				mesh.vertices.push_back(tubeRadius * std::sin(tubeAngle));
+				mesh.vertices.push_back(std::cos(tubeAngle) * std::cos(mainAngle));
+				mesh.vertices.push_back(std::cos(tubeAngle) * std::sin(mainAngle));
+				mesh.vertices.push_back(std::sin(tubeAngle));
+				mesh.vertices.push_back(u);
+				mesh.vertices.push_back(v);
+			}
+		}
+
+		for (int i = 0; i < mainSegments; i++)
+		{
+			for (int j = 0; j < tubeSegments; j++)
+			{
+				GLuint a = (GLuint)(i * (tubeSegments + 1) + j);
+				GLuint b = a + (GLuint)(tubeSegments + 1);
+				mesh.indices.push_back(a);
+				mesh.indices.push_back(b);
+				mesh.indices.push_back(a + 1);
+				mesh.indices.push_back(a + 1);
+				mesh.indices.push_back(b);
+				mesh.indices.push_back(b + 1);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GenerateTorus()
+ *
+ *  This method is used for generating a torus centered on the
+ *  origin and lying in the XY plane.  The main ring rows are
+ *  evaluated in parallel on the shared thread pool.
+ ***********************************************************/
+void ShapeGenerator::GenerateTorus(
+	MESH_DATA& mesh,
+	int mainSegments,
+	int tubeSegments,
+	float mainRadius,
+	float tubeRadius)
+{
+	ANGLE_TABLE mainTable;
+	ANGLE_TABLE tubeTable;
+
+	if ((mainSegments < 3) || (tubeSegments < 3))
+	{
+		std::cout << "Torus needs at least 3 segments in each direction" << std::endl;
+		return;
+	}
+
+	BuildAngleTable(mainTable, mainSegments, 0.0f, 2.0f * PI);
+	BuildAngleTable(tubeTable, tubeSegments, 0.0f, 2.0f * PI);
+
+	const int rows = mainSegments + 1;
+	const int columns = tubeSegments + 1;
+	mesh.vertices.resize((size_t)rows * columns * FLOATS_PER_VERTEX);
+
+	ThreadPool::GetShared()->ParallelFor(rows, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			GenerateTorusRow(
+				&mesh.vertices[(size_t)i * columns * FLOATS_PER_VERTEX],
+				tubeTable,
+				mainTable.cosines[i],
+				mainTable.sines[i],
+				mainTable.coords[i],
+				mainRadius,
+				tubeRadius);
+		}
+	}, MIN_ROWS_PER_BATCH);
+
+	GenerateGridIndices(mesh.indices, rows, columns, false);
+}
+
+/***********************************************************
+ *  GenerateSphere()
+ *
+ *  This method is used for generating a unit sphere centered
+ *  on the origin.  Each stack is a row of the vertex grid and
+ *  the stacks are evaluated in parallel.
+ ***********************************************************/
+void ShapeGenerator::GenerateSphere(
+	MESH_DATA& mesh,
+	int stacks,
+	int slices)
+{
+	ANGLE_TABLE stackTable;
+	ANGLE_TABLE sliceTable;
+
+	if ((stacks < 2) || (slices < 3))
+	{
+		std::cout << "Sphere needs at least 2 stacks and 3 slices" << std::endl;
+		return;
+	}
+
+	BuildAngleTable(stackTable, stacks, 0.0f, PI);
+	BuildAngleTable(sliceTable, slices, 0.0f, 2.0f * PI);
+
+	const int rows = stacks + 1;
+	const int columns = slices + 1;
+	mesh.vertices.resize((size_t)rows * columns * FLOATS_PER_VERTEX);
+
+	ThreadPool::GetShared()->ParallelFor(rows, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			GenerateSphereRow(
+				&mesh.vertices[(size_t)i * columns * FLOATS_PER_VERTEX],
+				sliceTable,
+				stackTable.cosines[i],
+				stackTable.sines[i],
+				1.0f - stackTable.coords[i]);
+		}
+	}, MIN_ROWS_PER_BATCH);
+
+	GenerateGridIndices(mesh.indices, rows, columns, true);
+}
+
+/***********************************************************
+ *  GeneratePlane()
+ *
+ *  This method is used for generating a flat plane spanning
+ *  -1 to 1 on the X and Z axes.  The plane is subdivided so
+ *  that parts of it can be culled independently.
+ ***********************************************************/
+void ShapeGenerator::GeneratePlane(
+	MESH_DATA& mesh,
+	int xDivisions,
+	int zDivisions)
+{
+	if ((xDivisions < 1) || (zDivisions < 1))
+	{
+		std::cout << "Plane needs at least 1 division in each direction" << std::endl;
+		return;
+	}
+
+	const int rows = zDivisions + 1;
+	const int columns = xDivisions + 1;
+	mesh.vertices.resize((size_t)rows * columns * FLOATS_PER_VERTEX);
+
+	ThreadPool::GetShared()->ParallelFor(rows, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			float v = (float)i / (float)zDivisions;
+			float* out = &mesh.vertices[(size_t)i * columns * FLOATS_PER_VERTEX];
+			for (int j = 0; j < columns; j++)
+			{
+				float u = (float)j / (float)xDivisions;
+				WriteVertex(
+					out + (j * FLOATS_PER_VERTEX),
+					(u * 2.0f) - 1.0f, 0.0f, (v * 2.0f) - 1.0f,
+					0.0f, 1.0f, 0.0f,
+					u, 1.0f - v);
+			}
+		}
+	}, MIN_ROWS_PER_BATCH);
+
+	GenerateGridIndices(mesh.indices, rows, columns, false);
+}
+
+/***********************************************************
+ *  UploadMesh()
+ *
+ *  This method is used for uploading the vertex and index
+ *  data generated on the CPU.
+ ***********************************************************/
+bool ShapeGenerator::UploadMesh(const MESH_DATA& mesh, GL_MESH& glMesh)
+{
+	return(UploadMesh(
+		mesh.vertices.data(),
+		(int)(mesh.vertices.size() / FLOATS_PER_VERTEX),
+		mesh.indices.data(),
+		(int)mesh.indices.size(),
+		glMesh));
+}
+
+/***********************************************************
+ *  UploadMesh()
+ *
+ *  This method is used for creating the vertex array object
+ *  and buffers for a mesh and copying the interleaved vertex
+ *  and index arrays into them.  The arrays can live in
+ *  read-only memory since they are only read by OpenGL.
+ ***********************************************************/
+bool ShapeGenerator::UploadMesh(
+	const float* vertices,
+	int vertexCount,
+	const GLuint* indices,
+	int indexCount,
+	GL_MESH& glMesh)
+{
+	const GLsizei stride = sizeof(float) * FLOATS_PER_VERTEX;
+
+	if ((vertexCount <= 0) || (indexCount <= 0))
+	{
+		return(false);
+	}
+
+	glGenVertexArrays(1, &glMesh.vao);
+	glBindVertexArray(glMesh.vao);
+
+	glGenBuffers(1, &glMesh.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, glMesh.vbo);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCount * stride, vertices, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &glMesh.ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glMesh.ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexCount * sizeof(GLuint), indices, GL_STATIC_DRAW);
+
+	// vertex positions
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(0);
+	// vertex normals
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 3));
+	glEnableVertexAttribArray(1);
+	// texture coordinates
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 6));
+	glEnableVertexAttribArray(2);
+
+	glBindVertexArray(0);
+
+	glMesh.nVertices = (GLsizei)vertexCount;
+	glMesh.nIndices = (GLsizei)indexCount;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing all the triangles of a
+ *  previously uploaded mesh.
+ ***********************************************************/
+void ShapeGenerator::DrawMesh(const GL_MESH& glMesh)
+{
+	glBindVertexArray(glMesh.vao);
+	glDrawElements(GL_TRIANGLES, glMesh.nIndices, GL_UNSIGNED_INT, NULL);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyMesh()
+ *
+ *  This method is used for freeing the OpenGL buffers of a
+ *  previously uploaded mesh.
+ ***********************************************************/
+void ShapeGenerator::DestroyMesh(GL_MESH& glMesh)
+{
+	glDeleteVertexArrays(1, &glMesh.vao);
+	glDeleteBuffers(1, &glMesh.vbo);
+	glDeleteBuffers(1, &glMesh.ebo);
+	glMesh.vao = 0;
+	glMesh.vbo = 0;
+	glMesh.ebo = 0;
+	glMesh.nVertices = 0;
+	glMesh.nIndices = 0;
+}
+
+/***********************************************************
+ *  RunGenerationBenchmark()
+ *
+ *  This method is used for timing the torus and sphere
+ *  generators at increasing tessellation levels against a
+ *  per-vertex sine/cosine reference implementation.
+ ***********************************************************/
+void ShapeGenerator::RunGenerationBenchmark()
+{
+	const int levels[] = { 32, 128, 512, 1024 };
+	const int repetitions = 5;
+	MESH_DATA mesh;
+
+	std::cout << "INFO: Shape generation benchmark ("
+		<< ThreadPool::GetShared()->GetThreadCount() << " threads"
+#ifdef SHAPEGEN_USE_SSE
+		<< ", SSE"
+#endif
+		<< ")" << std::endl;
+	std::cout << "  segments    vertices   reference ms   torus ms   sphere ms" << std::endl;
+
+	for (int level : levels)
+	{
+		double referenceTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			GenerateTorusReference(mesh, level, level, 1.0f, 0.3f);
+		}, repetitions);
+
+		double torusTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			GenerateTorus(mesh, level, level, 1.0f, 0.3f);
+		}, repetitions);
+
+		double sphereTime = BenchmarkTimer::TimeMilliseconds([&]()
+		{
+			GenerateSphere(mesh, level, level);
+		}, repetitions);
+
+		char line[128];
+		snprintf(line, sizeof(line), "  %8d  %10d  %13.3f  %9.3f  %10.3f",
+			level,
+			(level + 1) * (level + 1),
+			referenceTime,
+			torusTime,
+			sphereTime);
+		std::cout << line << std::endl;
+	}
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegenerator.h
+// ============
+// generate highly tessellated parametric meshes with data-parallel kernels
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  ShapeGenerator
+ *
+ *  This class builds the vertex and index data for the
+ *  parametric primitives on the CPU.  The sine and cosine
+ *  values are computed once per ring into angle tables, the
+ *  vertices of a row are evaluated four at a time with SIMD,
+ *  and the rows are split across the shared thread pool.
+ *
+ *  The vertex layout matches the one used by ShapeMeshes:
+ *  position (3 floats), normal (3 floats), UV (2 floats).
+ ***********************************************************/
+class ShapeGenerator
+{
+public:
+	// number of floats in each interleaved vertex
+	static const int FLOATS_PER_VERTEX = 8;
+
+	// vertex and index data generated on the CPU
+	struct MESH_DATA
+	{
+		std::vector<float> vertices;
+		std::vector<GLuint> indices;
+	};
+
+	// OpenGL buffers holding an uploaded mesh
+	struct GL_MESH
+	{
+		GLuint vao;
+		GLuint vbo;
+		GLuint ebo;
+		GLsizei nVertices;
+		GLsizei nIndices;
+	};
+
+	// generate a torus lying in the XY plane
+	static void GenerateTorus(
+		MESH_DATA& mesh,
+		int mainSegments,
+		int tubeSegments,
+		float mainRadius,
+		float tubeRadius);
+
+	// generate a unit sphere with its poles on the Y axis
+	static void GenerateSphere(
+		MESH_DATA& mesh,
+		int stacks,
+		int slices);
+
+	// generate a 2 x 2 plane in the XZ plane facing +Y,
+	// subdivided into a grid of quads
+	static void GeneratePlane(
+		MESH_DATA& mesh,
+		int xDivisions,
+		int zDivisions);
+
+	// copy the generated mesh data into OpenGL buffers
+	static bool UploadMesh(const MESH_DATA& mesh, GL_MESH& glMesh);
+	// copy interleaved vertex and index arrays into OpenGL buffers
+	static bool UploadMesh(
+		const float* vertices,
+		int vertexCount,
+		const GLuint* indices,
+		int indexCount,
+		GL_MESH& glMesh);
+	// draw all the triangles of an uploaded mesh
+	static void DrawMesh(const GL_MESH& glMesh);
+	// free the OpenGL buffers of an uploaded mesh
+	static void DestroyMesh(GL_MESH& glMesh);
+
+	// time the generators across several tessellation levels
+	// and print the results to the console
+	static void RunGenerationBenchmark();
+};
@@ -0,0 +1,495 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticprimitives.h
+// ============
+// fixed primitive meshes generated at compile time
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  StaticPrimitives
+ *
+ *  The vertex and index tables of the fixed primitives are
+ *  built by constexpr functions, so they are stored in the
+ *  read-only data of the executable and can be passed to
+ *  glBufferData() without any work at startup.  The vertex
+ *  layout matches ShapeGenerator: position, normal, UV.
+ ***********************************************************/
+namespace StaticPrimitives
+{
+	// number of floats in each interleaved vertex
+	constexpr int FLOATS_PER_VERTEX = 8;
+
+	// number of segments around the fixed cylinder
+	constexpr int CYLINDER_SEGMENTS = 36;
+
+	// quads along each side of the subdivided plane, and the
+	// size of the quad tiles that form its meshlets
+	constexpr int PLANE_DIVISIONS = 32;
+	constexpr int PLANE_TILE_COLUMNS = 8;
+	constexpr int PLANE_TILE_ROWS = 4;
+
+	// vertex and index table of a primitive
+	template <int VERTEX_COUNT, int INDEX_COUNT>
+	struct MESH_TABLE
+	{
+		static constexpr int vertexCount = VERTEX_COUNT;
+		static constexpr int indexCount = INDEX_COUNT;
+
+		float vertices[VERTEX_COUNT * FLOATS_PER_VERTEX];
+		GLuint indices[INDEX_COUNT];
+	};
+
+	// culling bounds of a contiguous range of plane indices
+	struct MESHLET_BOUNDS
+	{
+		GLuint firstIndex;
+		GLuint indexCount;
+		float center[3];
+		float radius;
+		float coneAxis[3];
+		float coneCutoff;
+	};
+
+	// meshlet table of the subdivided plane
+	template <int MESHLET_COUNT>
+	struct MESHLET_TABLE
+	{
+		static constexpr int meshletCount = MESHLET_COUNT;
+
+		MESHLET_BOUNDS meshlets[MESHLET_COUNT];
+	};
+
+	namespace Detail
+	{
+		constexpr double PI = 3.14159265358979323846;
+
+		/***********************************************************
+		 *  Sine()
+		 *
+		 *  Compile time sine - the angle is reduced to [-pi, pi]
+		 *  and evaluated with a Taylor series.
+		 ***********************************************************/
+		constexpr double Sine(double angle)
+		{
+			while (angle > PI)
+			{
+				angle -= 2.0 * PI;
+			}
+			while (angle < -PI)
+			{
+				angle += 2.0 * PI;
+			}
+
+			double term = angle;
+			double sum = angle;
+			for (int n = 1; n < 12; n++)
+			{
+				term *= -(angle * angle) / (double)((2 * n) * (2 * n + 1));
+				sum += term;
+			}
+			return(sum);
+		}
+
+		/***********************************************************
+		 *  Cosine()
+		 *
+		 *  Compile time cosine.
+		 ***********************************************************/
+		constexpr double Cosine(double angle)
+		{
+			return(Sine(angle + (PI * 0.5)));
+		}
+
+		/***********************************************************
+		 *  SquareRoot()
+		 *
+		 *  Compile time square root using Newton iterations.
+		 ***********************************************************/
+		constexpr double SquareRoot(double value)
+		{
+			if (value <= 0.0)
+			{
+				return(0.0);
+			}
+
+			double estimate = (value > 1.0) ? value : 1.0;
+			for (int i = 0; i < 64; i++)
+			{
+				estimate = 0.5 * (estimate + (value / estimate));
+			}
+			return(estimate);
+		}
+
+		/***********************************************************
+		 *  SetVertex()
+		 *
+		 *  Store one interleaved vertex into a table.
+		 ***********************************************************/
+		constexpr void SetVertex(
+			float* vertices,
+			int index,
+			double x, double y, double z,
+			double nx, double ny, double nz,
+			double u, double v)
+		{
+			float* out = vertices + (index * FLOATS_PER_VERTEX);
+			out[0] = (float)x;
+			out[1] = (float)y;
+			out[2] = (float)z;
+			out[3] = (float)nx;
+			out[4] = (float)ny;
+			out[5] = (float)nz;
+			out[6] = (float)u;
+			out[7] = (float)v;
+		}
+
+		/***********************************************************
+		 *  SetTriangle()
+		 *
+		 *  Store the three indices of a triangle into a table.
+		 ***********************************************************/
+		constexpr void SetTriangle(GLuint* indices, int triangle, int a, int b, int c)
+		{
+			indices[(triangle * 3) + 0] = (GLuint)a;
+			indices[(triangle * 3) + 1] = (GLuint)b;
+			indices[(triangle * 3) + 2] = (GLuint)c;
+		}
+	}
+
+	/***********************************************************
+	 *  BuildBox()
+	 *
+	 *  Unit box centered on the origin.  Every face has its own
+	 *  four vertices so that normals and UVs stay flat.
+	 ***********************************************************/
+	constexpr MESH_TABLE<24, 36> BuildBox()
+	{
+		MESH_TABLE<24, 36> table{};
+
+		// face normal, U axis and V axis (U x V = normal)
+		constexpr double faces[6][9] =
+		{
+			{  0,  0,  1,    1, 0,  0,   0, 1,  0 },	// front
+			{  0,  0, -1,   -1, 0,  0,   0, 1,  0 },	// back
+			{  1,  0,  0,    0, 0, -1,   0, 1,  0 },	// right
+			{ -1,  0,  0,    0, 0,  1,   0, 1,  0 },	// left
+			{  0,  1,  0,    1, 0,  0,   0, 0, -1 },	// top
+			{  0, -1,  0,    1, 0,  0,   0, 0,  1 },	// bottom
+		};
+		constexpr double corners[4][2] =
+		{
+			{ 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 }
+		};
+
+		for (int f = 0; f < 6; f++)
+		{
+			const double* n = &faces[f][0];
+			const double* u = &faces[f][3];
+			const double* v = &faces[f][6];
+
+			for (int c = 0; c < 4; c++)
+			{
+				double su = corners[c][0] - 0.5;
+				double sv = corners[c][1] - 0.5;
+				Detail::SetVertex(
+					table.vertices,
+					(f * 4) + c,
+					(n[0] * 0.5) + (u[0] * su) + (v[0] * sv),
+					(n[1] * 0.5) + (u[1] * su) + (v[1] * sv),
+					(n[2] * 0.5) + (u[2] * su) + (v[2] * sv),
+					n[0], n[1], n[2],
+					corners[c][0], corners[c][1]);
+			}
+
+			Detail::SetTriangle(table.indices, (f * 2) + 0, (f * 4) + 0, (f * 4) + 1, (f * 4) + 2);
+			Detail::SetTriangle(table.indices, (f * 2) + 1, (f * 4) + 0, (f * 4) + 2, (f * 4) + 3);
+		}
+
+		return(table);
+	}
+
+	// vertices in the cylinder side, and in each of its caps
+	constexpr int CYLINDER_SIDE_VERTICES = (CYLINDER_SEGMENTS + 1) * 2;
+	constexpr int CYLINDER_CAP_VERTICES = CYLINDER_SEGMENTS + 2;
+
+	/***********************************************************
+	 *  BuildCylinder()
+	 *
+	 *  Cylinder with a radius of 1 standing on the XZ plane,
+	 *  from y = 0 to y = 1, with its top and bottom caps.
+	 ***********************************************************/
+	constexpr MESH_TABLE<
+		CYLINDER_SIDE_VERTICES + (CYLINDER_CAP_VERTICES * 2),
+		CYLINDER_SEGMENTS * 12> BuildCylinder()
+	{
+		MESH_TABLE<
+			CYLINDER_SIDE_VERTICES + (CYLINDER_CAP_VERTICES * 2),
+			CYLINDER_SEGMENTS * 12> table{};
+
+		const int topCenter = CYLINDER_SIDE_VERTICES;
+		const int bottomCenter = CYLINDER_SIDE_VERTICES + CYLINDER_CAP_VERTICES;
+		int triangle = 0;
+
+		Detail::SetVertex(table.vertices, topCenter, 0, 1, 0, 0, 1, 0, 0.5, 0.5);
+		Detail::SetVertex(table.vertices, bottomCenter, 0, 0, 0, 0, -1, 0, 0.5, 0.5);
+
+		for (int j = 0; j <= CYLINDER_SEGMENTS; j++)
+		{
+			double u = (double)j / (double)CYLINDER_SEGMENTS;
+			double angle = u * 2.0 * Detail::PI;
+			double c = Detail::Cosine(angle);
+			double s = Detail::Sine(angle);
+
+			// side vertices - bottom and top of each segment edge
+			Detail::SetVertex(table.vertices, (j * 2) + 0, c, 0, s, c, 0, s, u, 0);
+			Detail::SetVertex(table.vertices, (j * 2) + 1, c, 1, s, c, 0, s, u, 1);
+
+			// cap rim vertices
+			Detail::SetVertex(table.vertices, topCenter + 1 + j, c, 1, s, 0, 1, 0, 0.5 + (c * 0.5), 0.5 - (s * 0.5));
+			Detail::SetVertex(table.vertices, bottomCenter + 1 + j, c, 0, s, 0, -1, 0, 0.5 + (c * 0.5), 0.5 + (s * 0.5));
+		}
+
+		for (int j = 0; j < CYLINDER_SEGMENTS; j++)
+		{
+			int bottom = j * 2;
+			int top = bottom + 1;
+
+			Detail::SetTriangle(table.indices, triangle++, bottom, top, bottom + 2);
+			Detail::SetTriangle(table.indices, triangle++, bottom + 2, top, top + 2);
+			Detail::SetTriangle(table.indices, triangle++, topCenter, topCenter + 2 + j, topCenter + 1 + j);
+			Detail::SetTriangle(table.indices, triangle++, bottomCenter, bottomCenter + 1 + j, bottomCenter + 2 + j);
+		}
+
+		return(table);
+	}
+
+	// number of vertices along each side of the plane grid
+	constexpr int PLANE_GRID_COLUMNS = PLANE_DIVISIONS + 1;
+	// number of quad tiles (meshlets) in the plane
+	constexpr int PLANE_TILE_COUNT =
+		(PLANE_DIVISIONS / PLANE_TILE_COLUMNS) * (PLANE_DIVISIONS / PLANE_TILE_ROWS);
+
+	/***********************************************************
+	 *  BuildPlane()
+	 *
+	 *  2 x 2 plane in the XZ plane facing +Y, subdivided into a
+	 *  grid of quads.  The indices are emitted tile by tile so
+	 *  that every tile is a ready-made meshlet.
+	 ***********************************************************/
+	constexpr MESH_TABLE<
+		PLANE_GRID_COLUMNS * PLANE_GRID_COLUMNS,
+		PLANE_DIVISIONS * PLANE_DIVISIONS * 6> BuildPlane()
+	{
+		MESH_TABLE<
+			PLANE_GRID_COLUMNS * PLANE_GRID_COLUMNS,
+			PLANE_DIVISIONS * PLANE_DIVISIONS * 6> table{};
+
+		int triangle = 0;
+
+		for (int i = 0; i < PLANE_GRID_COLUMNS; i++)
+		{
+			double v = (double)i / (double)PLANE_DIVISIONS;
+			for (int j = 0; j < PLANE_GRID_COLUMNS; j++)
+			{
+				double u = (double)j / (double)PLANE_DIVISIONS;
+				Detail::SetVertex(
+					table.vertices,
+					(i * PLANE_GRID_COLUMNS) + j,
+					(u * 2.0) - 1.0, 0.0, (v * 2.0) - 1.0,
+					0.0, 1.0, 0.0,
+					u, 1.0 - v);
+			}
+		}
+
+		for (int tileRow = 0; tileRow < PLANE_DIVISIONS; tileRow += PLANE_TILE_ROWS)
+		{
+			for (int tileColumn = 0; tileColumn < PLANE_DIVISIONS; tileColumn += PLANE_TILE_COLUMNS)
+			{
+				for (int i = tileRow; i < tileRow + PLANE_TILE_ROWS; i++)
+				{
+					for (int j = tileColumn; j < tileColumn + PLANE_TILE_COLUMNS; j++)
+					{
+						int a = (i * PLANE_GRID_COLUMNS) + j;
+						int b = a + PLANE_GRID_COLUMNS;
+						Detail::SetTriangle(table.indices, triangle++, a, b, a + 1);
+						Detail::SetTriangle(table.indices, triangle++, a + 1, b, b + 1);
+					}
+				}
+			}
+		}
+
+		return(table);
+	}
+
+	/***********************************************************
+	 *  BuildPlaneOccluder()
+	 *
+	 *  The same 2 x 2 plane as two triangles, for the software
+	 *  occlusion rasterizer, which does not need the grid.
+	 ***********************************************************/
+	constexpr MESH_TABLE<4, 6> BuildPlaneOccluder()
+	{
+		MESH_TABLE<4, 6> table{};
+
+		Detail::SetVertex(table.vertices, 0, -1, 0, -1, 0, 1, 0, 0, 1);
+		Detail::SetVertex(table.vertices, 1, 1, 0, -1, 0, 1, 0, 1, 1);
+		Detail::SetVertex(table.vertices, 2, -1, 0, 1, 0, 1, 0, 0, 0);
+		Detail::SetVertex(table.vertices, 3, 1, 0, 1, 0, 1, 0, 1, 0);
+		Detail::SetTriangle(table.indices, 0, 0, 2, 1);
+		Detail::SetTriangle(table.indices, 1, 1, 2, 3);
+
+		return(table);
+	}
+
+	/***********************************************************
+	 *  BuildPlaneMeshlets()
+	 *
+	 *  Bounding spheres of the plane tiles, in the same order
+	 *  as the tiles were emitted by BuildPlane().
+	 ***********************************************************/
+	constexpr MESHLET_TABLE<PLANE_TILE_COUNT> BuildPlaneMeshlets()
+	{
+		MESHLET_TABLE<PLANE_TILE_COUNT> table{};
+
+		const double quadSize = 2.0 / (double)PLANE_DIVISIONS;
+		const double halfWidth = quadSize * PLANE_TILE_COLUMNS * 0.5;
+		const double halfDepth = quadSize * PLANE_TILE_ROWS * 0.5;
+		const GLuint tileIndices = PLANE_TILE_COLUMNS * PLANE_TILE_ROWS * 6;
+		int tile = 0;
+
+		for (int tileRow = 0; tileRow < PLANE_DIVISIONS; tileRow += PLANE_TILE_ROWS)
+		{
+			for (int tileColumn = 0; tileColumn < PLANE_DIVISIONS; tileColumn += PLANE_TILE_COLUMNS)
+			{
+				MESHLET_BOUNDS& bounds = table.meshlets[tile];
+				bounds.firstIndex = (GLuint)tile * tileIndices;
+				bounds.indexCount = tileIndices;
+				bounds.center[0] = (float)(-1.0 + (tileColumn * quadSize) + halfWidth);
+				bounds.center[1] = 0.0f;
+				bounds.center[2] = (float)(-1.0 + (tileRow * quadSize) + halfDepth);
+				bounds.radius = (float)Detail::SquareRoot((halfWidth * halfWidth) + (halfDepth * halfDepth));
+				// every triangle of the plane faces +Y
+				bounds.coneAxis[0] = 0.0f;
+				bounds.coneAxis[1] = 1.0f;
+				bounds.coneAxis[2] = 0.0f;
+				bounds.coneCutoff = 0.0f;
+				tile++;
+			}
+		}
+
+		return(table);
+	}
+
+	/***********************************************************
+	 *  IndicesInRange()
+	 *
+	 *  Compile time check that every index refers to a vertex
+	 *  of the table.
+	 ***********************************************************/
+	template <typename TABLE>
+	constexpr bool IndicesInRange(const TABLE& table)
+	{
+		for (int i = 0; i < TABLE::indexCount; i++)
+		{
+			if (table.indices[i] >= (GLuint)TABLE::vertexCount)
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  NormalsAreUnitLength()
+	 *
+	 *  Compile time check that every vertex normal is of unit
+	 *  length.
+	 ***********************************************************/
+	template <typename TABLE>
+	constexpr bool NormalsAreUnitLength(const TABLE& table)
+	{
+		for (int i = 0; i < TABLE::vertexCount; i++)
+		{
+			const float* normal = &table.vertices[(i * FLOATS_PER_VERTEX) + 3];
+			double lengthSquared = (normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]);
+			if ((lengthSquared < 0.999) || (lengthSquared > 1.001))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  TrianglesFaceNormals()
+	 *
+	 *  Compile time check that the winding of every triangle is
+	 *  counter-clockwise when seen from the side its vertex
+	 *  normals point to.
+	 ***********************************************************/
+	template <typename TABLE>
+	constexpr bool TrianglesFaceNormals(const TABLE& table)
+	{
+		for (int t = 0; t < TABLE::indexCount; t += 3)
+		{
+			const float* p0 = &table.vertices[table.indices[t + 0] * FLOATS_PER_VERTEX];
+			const float* p1 = &table.vertices[table.indices[t + 1] * FLOATS_PER_VERTEX];
+			const float* p2 = &table.vertices[table.indices[t + 2] * FLOATS_PER_VERTEX];
+
+			double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			double face[3] =
+			{
+				(e1[1] * e2[2]) - (e1[2] * e2[1]),
+				(e1[2] * e2[0]) - (e1[0] * e2[2]),
+				(e1[0] * e2[1]) - (e1[1] * e2[0])
+			};
+
+			// sum the vertex normals of the triangle
+			double normal[3] = { 0.0, 0.0, 0.0 };
+			for (int k = 0; k < 3; k++)
+			{
+				const float* vertex = &table.vertices[table.indices[t + k] * FLOATS_PER_VERTEX];
+				normal[0] += vertex[3];
+				normal[1] += vertex[4];
+				normal[2] += vertex[5];
+			}
+
+			if ((face[0] * normal[0]) + (face[1] * normal[1]) + (face[2] * normal[2]) <= 0.0)
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	// the primitive tables - evaluated by the compiler
+	inline constexpr auto BOX = BuildBox();
+	inline constexpr auto CYLINDER = BuildCylinder();
+	inline constexpr auto PLANE = BuildPlane();
+	inline constexpr auto PLANE_MESHLETS = BuildPlaneMeshlets();
+	inline constexpr auto PLANE_OCCLUDER = BuildPlaneOccluder();
+
+	// validate the tables at compile time
+	static_assert(IndicesInRange(BOX), "box index out of range");
+	static_assert(IndicesInRange(CYLINDER), "cylinder index out of range");
+	static_assert(IndicesInRange(PLANE), "plane index out of range");
+	static_assert(NormalsAreUnitLength(BOX), "box normals must be unit length");
+	static_assert(NormalsAreUnitLength(CYLINDER), "cylinder normals must be unit length");
+	static_assert(NormalsAreUnitLength(PLANE), "plane normals must be unit length");
+	static_assert(TrianglesFaceNormals(BOX), "box triangles must wind counter-clockwise");
+	static_assert(TrianglesFaceNormals(CYLINDER), "cylinder triangles must wind counter-clockwise");
+	static_assert(TrianglesFaceNormals(PLANE), "plane triangles must wind counter-clockwise");
+	static_assert(TrianglesFaceNormals(PLANE_OCCLUDER), "plane occluder triangles must wind counter-clockwise");
+	static_assert((PLANE_DIVISIONS % PLANE_TILE_COLUMNS) == 0, "plane tiles must cover the grid");
+	static_assert((PLANE_DIVISIONS % PLANE_TILE_ROWS) == 0, "plane tiles must cover the grid");
+	static_assert(
+		PLANE_MESHLETS.meshlets[PLANE_TILE_COUNT - 1].firstIndex +
+		PLANE_MESHLETS.meshlets[PLANE_TILE_COUNT - 1].indexCount == (GLuint)decltype(PLANE)::indexCount,
+		"plane meshlets must cover every index");
+}
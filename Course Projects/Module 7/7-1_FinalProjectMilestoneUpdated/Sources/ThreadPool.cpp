@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////
+// threadpool.cpp
+// ============
+// distribute data-parallel work across persistent worker threads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	// number of batches handed out per thread, so that uneven
+	// batches can still be balanced across the workers
+	const int BATCHES_PER_THREAD = 4;
+
+	// shared pool used by all the engine systems
+	ThreadPool* g_pSharedPool = nullptr;
+
+	// set on worker threads so that nested ParallelFor() calls
+	// run inline instead of deadlocking the pool
+	thread_local bool t_bIsWorkerThread = false;
+}
+
+/***********************************************************
+ *  ThreadPool()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ThreadPool::ThreadPool(int threadCount)
+{
+	m_pTask = nullptr;
+	m_count = 0;
+	m_batchSize = 0;
+	m_batchCount = 0;
+	m_nextBatch = 0;
+	m_activeWorkers = 0;
+	m_jobGeneration = 0;
+	m_bShutdown = false;
+
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+
+	// the calling thread also processes batches, so one less
+	// worker than the requested thread count is created
+	for (int i = 1; i < threadCount; i++)
+	{
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+/***********************************************************
+ *  ~ThreadPool()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bShutdown = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+/***********************************************************
+ *  GetShared()
+ *
+ *  This method is used for getting the thread pool shared
+ *  by all the engine systems, creating it on first use.
+ ***********************************************************/
+ThreadPool* ThreadPool::GetShared()
+{
+	static std::once_flag createFlag;
+	std::call_once(createFlag, []()
+	{
+		g_pSharedPool = new ThreadPool();
+	});
+
+	return(g_pSharedPool);
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of threads
+ *  that work on each ParallelFor() call.
+ ***********************************************************/
+int ThreadPool::GetThreadCount() const
+{
+	return((int)m_workers.size() + 1);
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for splitting the range [0, count)
+ *  into batches and processing them on all the threads of
+ *  the pool.  It returns once every batch has completed.
+ ***********************************************************/
+void ThreadPool::ParallelFor(
+	int count,
+	const std::function<void(int begin, int end)>& task,
+	int minBatchSize)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	minBatchSize = std::max(1, minBatchSize);
+
+	// small jobs, nested calls and single threaded pools are
+	// processed directly on the calling thread
+	if ((m_workers.empty()) ||
+		(count <= minBatchSize) ||
+		(t_bIsWorkerThread == true))
+	{
+		task(0, count);
+		return;
+	}
+
+	std::lock_guard<std::mutex> submitLock(m_submitMutex);
+
+	int batchCount = std::min(count / minBatchSize, GetThreadCount() * BATCHES_PER_THREAD);
+	batchCount = std::max(1, batchCount);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pTask = &task;
+		m_count = count;
+		m_batchCount = batchCount;
+		m_batchSize = (count + batchCount - 1) / batchCount;
+		m_nextBatch = 0;
+		m_activeWorkers = (int)m_workers.size();
+		m_jobGeneration++;
+	}
+	m_wakeCondition.notify_all();
+
+	// the calling thread works on the job too
+	RunBatches();
+
+	// wait for the workers to finish their last batches
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this]() { return(m_activeWorkers == 0); });
+	m_pTask = nullptr;
+}
+
+/***********************************************************
+ *  RunBatches()
+ *
+ *  This method is used for claiming and processing batches
+ *  of the current job until all of them have been taken.
+ ***********************************************************/
+void ThreadPool::RunBatches()
+{
+	int batch = m_nextBatch.fetch_add(1);
+	while (batch < m_batchCount)
+	{
+		int begin = batch * m_batchSize;
+		int end = std::min(begin + m_batchSize, m_count);
+		if (begin < end)
+		{
+			(*m_pTask)(begin, end);
+		}
+		batch = m_nextBatch.fetch_add(1);
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is the main loop of every worker thread.  It
+ *  sleeps until a job is posted, helps process it, and then
+ *  reports back to the thread waiting in ParallelFor().
+ ***********************************************************/
+void ThreadPool::WorkerLoop()
+{
+	unsigned long long lastGeneration = 0;
+
+	t_bIsWorkerThread = true;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeCondition.wait(lock, [&]()
+			{
+				return((m_bShutdown == true) || (m_jobGeneration != lastGeneration));
+			});
+			if (m_bShutdown == true)
+			{
+				return;
+			}
+			lastGeneration = m_jobGeneration;
+		}
+
+		RunBatches();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_activeWorkers--;
+			if (m_activeWorkers == 0)
+			{
+				m_doneCondition.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// threadpool.h
+// ============
+// distribute data-parallel work across persistent worker threads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  ThreadPool
+ *
+ *  This class keeps a set of worker threads alive for the
+ *  lifetime of the application so that data-parallel loops
+ *  (mesh generation, culling, baking) can be split into
+ *  batches without paying the thread creation cost on
+ *  every call.
+ ***********************************************************/
+class ThreadPool
+{
+public:
+	// constructor - zero threads means one per hardware core
+	ThreadPool(int threadCount = 0);
+	// destructor
+	~ThreadPool();
+
+	// run task(begin, end) over [0, count) split into batches of
+	// at least minBatchSize items, and wait for all of them to finish
+	void ParallelFor(
+		int count,
+		const std::function<void(int begin, int end)>& task,
+		int minBatchSize = 1);
+
+	// total number of threads working on a ParallelFor() call,
+	// including the calling thread
+	int GetThreadCount() const;
+
+	// the pool shared by all the engine systems
+	static ThreadPool* GetShared();
+
+private:
+	// worker threads owned by the pool
+	std::vector<std::thread> m_workers;
+	// protects the job state below
+	std::mutex m_mutex;
+	// only one ParallelFor() can be in flight at a time
+	std::mutex m_submitMutex;
+	// signaled when a new job is posted or on shutdown
+	std::condition_variable m_wakeCondition;
+	// signaled when the last worker leaves the current job
+	std::condition_variable m_doneCondition;
+
+	// the job currently being processed
+	const std::function<void(int, int)>* m_pTask;
+	int m_count;
+	int m_batchSize;
+	int m_batchCount;
+	std::atomic<int> m_nextBatch;
+	// number of workers still inside the current job
+	int m_activeWorkers;
+	// incremented for every job so workers can detect new work
+	unsigned long long m_jobGeneration;
+	bool m_bShutdown;
+
+	// main loop for each worker thread
+	void WorkerLoop();
+	// process batches of the current job until none are left
+	void RunBatches();
+};
@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////
+// transparencyrenderer.cpp
+// ============
+// weighted blended order independent transparency targets and composite pass
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransparencyRenderer.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// texture units the targets are read from
+	const int ACCUMULATION_UNIT = 0;
+	const int WEIGHT_UNIT = 1;
+
+	// cleared values of the targets - no color, every bit of
+	// the light let through, and no weight
+	const GLfloat ACCUMULATION_CLEAR[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	const GLfloat WEIGHT_CLEAR[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+}
+
+/***********************************************************
+ *  TransparencyRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransparencyRenderer::TransparencyRenderer(ShaderManager* pCompositeShader)
+{
+	m_pCompositeShader = pCompositeShader;
+	m_framebuffer = 0;
+	m_targets[0] = 0;
+	m_targets[1] = 0;
+	m_depthTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_bComplete = false;
+	m_screenVAO = 0;
+}
+
+/***********************************************************
+ *  ~TransparencyRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TransparencyRenderer::~TransparencyRenderer()
+{
+	DestroyTargets();
+	if (m_screenVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_screenVAO);
+	}
+}
+
+/***********************************************************
+ *  BeginAccumulation()
+ *
+ *  This method is used for binding the targets of the
+ *  transparent layers, with the opaque depth of the window
+ *  copied into them.  OpenGL 3.3 blends every draw buffer
+ *  with the same function, so both targets add their color,
+ *  and the alpha of the first one is multiplied by the light
+ *  each layer lets through.  The layers are tested against
+ *  the depth without writing it.
+ ***********************************************************/
+bool TransparencyRenderer::BeginAccumulation(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+	if ((width != m_width) || (height != m_height))
+	{
+		CreateTargets(width, height);
+	}
+	if (m_bComplete == false)
+	{
+		return(false);
+	}
+
+	// the opaque objects hide the layers behind them
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+	glBlitFramebuffer(
+		0, 0, m_width, m_height,
+		0, 0, m_width, m_height,
+		GL_DEPTH_BUFFER_BIT,
+		GL_NEAREST);
+
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glDrawBuffers(2, drawBuffers);
+	glClearBufferfv(GL_COLOR, 0, ACCUMULATION_CLEAR);
+	glClearBufferfv(GL_COLOR, 1, WEIGHT_CLEAR);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Composite()
+ *
+ *  This method is used for blending the average color of
+ *  the transparent layers over the opaque image in the
+ *  window.  The pixels no layer covered are left as they
+ *  are by the shader.
+ ***********************************************************/
+void TransparencyRenderer::Composite()
+{
+	if (m_screenVAO == 0)
+	{
+		glGenVertexArrays(1, &m_screenVAO);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+
+	for (int i = 0; i < 2; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + ACCUMULATION_UNIT + i);
+		glBindTexture(GL_TEXTURE_2D, m_targets[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	m_pCompositeShader->use();
+	m_pCompositeShader->setSampler2DValue("accumulationBuffer", ACCUMULATION_UNIT);
+	m_pCompositeShader->setSampler2DValue("weightBuffer", WEIGHT_UNIT);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBindVertexArray(m_screenVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the targets for a
+ *  viewport size.  The summed colors and weights need half
+ *  floats, since the weights of the closer layers reach the
+ *  thousands.  The depth has a stencil part so that it
+ *  matches the window depth buffer it is copied from.
+ ***********************************************************/
+void TransparencyRenderer::CreateTargets(int width, int height)
+{
+	DestroyTargets();
+
+	m_width = width;
+	m_height = height;
+
+	const GLint internalFormats[2] = { GL_RGBA16F, GL_R16F };
+	const GLenum formats[2] = { GL_RGBA, GL_RED };
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	glGenTextures(2, m_targets);
+	for (int i = 0; i < 2; i++)
+	{
+		glBindTexture(GL_TEXTURE_2D, m_targets[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, formats[i], GL_HALF_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_targets[i], 0);
+	}
+
+	glGenTextures(1, &m_depthTexture);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+
+	m_bComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	if (m_bComplete == false)
+	{
+		std::cout << "ERROR: the transparency targets are incomplete" << std::endl;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for freeing the targets.
+ ***********************************************************/
+void TransparencyRenderer::DestroyTargets()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteTextures(2, m_targets);
+		glDeleteTextures(1, &m_depthTexture);
+		m_framebuffer = 0;
+		m_targets[0] = 0;
+		m_targets[1] = 0;
+		m_depthTexture = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+	m_bComplete = false;
+}
@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+// transparencyrenderer.h
+// ============
+// weighted blended order independent transparency targets and composite pass
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  TransparencyRenderer
+ *
+ *  This class holds the targets of the weighted blended
+ *  order independent transparency pass.  The transparent
+ *  objects are drawn into them in any order - the first
+ *  target adds up their colors weighted by coverage and
+ *  depth, and multiplies its alpha by the light let through
+ *  each layer, while the second target adds up the weights.
+ *  Both are blended by additions and products, which give
+ *  the same result in every order, so the transparent
+ *  objects no longer need sorting back to front.
+ *
+ *  The composite pass divides the summed colors by the
+ *  summed weights and blends the average over the opaque
+ *  image in the window, covering it by the share of the
+ *  light the layers did not let through.
+ *
+ *  The depth of the opaque objects is copied from the window
+ *  first, so the layers behind them are still hidden.
+ ***********************************************************/
+class TransparencyRenderer
+{
+public:
+	// constructor - the composite shader reads the two targets
+	TransparencyRenderer(ShaderManager* pCompositeShader);
+	// destructor
+	~TransparencyRenderer();
+
+	// bind and clear the targets, creating them for the
+	// viewport size when needed, and set the blending of the
+	// transparent layers - returns false when the targets
+	// cannot be used
+	bool BeginAccumulation(int width, int height);
+	// blend the accumulated layers over the window and restore
+	// the blending of the window - the targets are bound to the
+	// first two texture units
+	void Composite();
+
+private:
+	ShaderManager* m_pCompositeShader;
+
+	// framebuffer with the weighted color and revealage, and
+	// the summed weight targets, and the copied opaque depth
+	GLuint m_framebuffer;
+	GLuint m_targets[2];
+	GLuint m_depthTexture;
+	int m_width;
+	int m_height;
+	bool m_bComplete;
+	// vertex array of the full screen triangle, which has no
+	// vertex data of its own
+	GLuint m_screenVAO;
+
+	// create the targets for a viewport size
+	void CreateTargets(int width, int height);
+	// free the targets
+	void DestroyTargets();
+};
@@ -54,6 +54,10 @@ ViewManager::ViewManager(
 	m_pWindow = NULL;
 	g_pCamera = new Camera();
 	m_IsOrthographic = false; // Start in perspective mode
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_bLeftButtonDown = false;
+	m_bPickRequested = false;
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 0.5f, 10.0f);
 	g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
@@ -110,8 +114,8 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// Set the scroll callback to handle mouse wheel input for adjusting movement speed
 	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Callback);
 
-	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
+	// set the blending for supporting tranparent rendering,
+	// the scene manager enables it only for the transparent pass
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	m_pWindow = window;
@@ -230,6 +234,24 @@ void ViewManager::ProcessKeyboardEvents()
 	}
 }
 
+/***********************************************************
+ *  ProcessMouseButtons()
+ *
+ *  This method is called to detect clicks of the left mouse
+ *  button, which request picking the object under the cursor.
+ ***********************************************************/
+void ViewManager::ProcessMouseButtons()
+{
+	bool bLeftButtonDown = (glfwGetMouseButton(m_pWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+
+	// only the press is a click, not holding the button
+	if ((bLeftButtonDown == true) && (m_bLeftButtonDown == false))
+	{
+		m_bPickRequested = true;
+	}
+	m_bLeftButtonDown = bLeftButtonDown;
+}
+
 /***********************************************************
  *  PrepareSceneView()
  *
@@ -250,6 +272,7 @@ void ViewManager::PrepareSceneView()
 	// process any keyboard events that may be waiting in the 
 	// event queue
 	ProcessKeyboardEvents();
+	ProcessMouseButtons();
 
 	// get the current view matrix from the camera
 	view = g_pCamera->GetViewMatrix();
@@ -273,6 +296,10 @@ void ViewManager::PrepareSceneView()
 			0.1f, 100.0f);
 	}
 
+	// keep the matrices for the CPU side culling of the frame
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
 	{
@@ -283,4 +310,106 @@ void ViewManager::PrepareSceneView()
 		// set the view position of the camera into the shader for proper rendering
 		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
 	}
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *  GetViewMatrix()
+ *
+ *  This method is used for getting the view matrix that was
+ *  calculated by the last PrepareSceneView() call.
+ ***********************************************************/
+glm::mat4 ViewManager::GetViewMatrix() const
+{
+	return(m_viewMatrix);
+}
+
+/***********************************************************
+ *  GetProjectionMatrix()
+ *
+ *  This method is used for getting the projection matrix
+ *  that was calculated by the last PrepareSceneView() call.
+ ***********************************************************/
+glm::mat4 ViewManager::GetProjectionMatrix() const
+{
+	return(m_projectionMatrix);
+}
+
+/***********************************************************
+ *  GetCameraPosition()
+ *
+ *  This method is used for getting the world position of
+ *  the camera.
+ ***********************************************************/
+glm::vec3 ViewManager::GetCameraPosition() const
+{
+	return(g_pCamera->Position);
+}
+
+/***********************************************************
+ *  GetPickingRay()
+ *
+ *  This method is used for converting a position in the
+ *  window into a world space ray.  The window position is
+ *  moved back from the near plane to the far plane with the
+ *  inverse of the view and projection matrices, which works
+ *  for both the perspective and orthographic projections.
+ ***********************************************************/
+void ViewManager::GetPickingRay(
+	double xWindowPos,
+	double yWindowPos,
+	glm::vec3& origin,
+	glm::vec3& direction) const
+{
+	int windowWidth = WINDOW_WIDTH;
+	int windowHeight = WINDOW_HEIGHT;
+	if (NULL != m_pWindow)
+	{
+		glfwGetWindowSize(m_pWindow, &windowWidth, &windowHeight);
+	}
+
+	// window Y goes down, normalized device Y goes up
+	float xNDC = ((2.0f * (float)xWindowPos) / (float)windowWidth) - 1.0f;
+	float yNDC = 1.0f - ((2.0f * (float)yWindowPos) / (float)windowHeight);
+
+	glm::mat4 inverseViewProjection = glm::inverse(m_projectionMatrix * m_viewMatrix);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(xNDC, yNDC, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(xNDC, yNDC, 1.0f, 1.0f);
+
+	origin = glm::vec3(nearPoint) / nearPoint.w;
+	direction = glm::normalize((glm::vec3(farPoint) / farPoint.w) - origin);
+}
+
+/***********************************************************
+ *  GetPickRequest()
+ *
+ *  This method is used for taking the pick request of the
+ *  last left click.  While the cursor is captured for the
+ *  camera, the ray goes through the center of the window.
+ ***********************************************************/
+bool ViewManager::GetPickRequest(glm::vec3& origin, glm::vec3& direction)
+{
+	if ((m_bPickRequested == false) || (NULL == m_pWindow))
+	{
+		return(false);
+	}
+	m_bPickRequested = false;
+
+	int windowWidth = 0;
+	int windowHeight = 0;
+	double xCursorPos = 0.0;
+	double yCursorPos = 0.0;
+	glfwGetWindowSize(m_pWindow, &windowWidth, &windowHeight);
+
+	if (glfwGetInputMode(m_pWindow, GLFW_CURSOR) == GLFW_CURSOR_DISABLED)
+	{
+		xCursorPos = windowWidth * 0.5;
+		yCursorPos = windowHeight * 0.5;
+	}
+	else
+	{
+		glfwGetCursorPos(m_pWindow, &xCursorPos, &yCursorPos);
+	}
+
+	GetPickingRay(xCursorPos, yCursorPos, origin, direction);
+	return(true);
+}
@@ -38,8 +38,19 @@ private:
 	GLFWwindow* m_pWindow;
 	// Tracks whether we're using orthographic projection
 	bool m_IsOrthographic;
+	// view matrix used for the current frame
+	glm::mat4 m_viewMatrix;
+	// projection matrix used for the current frame
+	glm::mat4 m_projectionMatrix;
+	// state of the left mouse button in the last frame
+	bool m_bLeftButtonDown;
+	// set when the left button was clicked, until the pick
+	// request is taken
+	bool m_bPickRequested;
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
+	// process mouse button events for picking scene objects
+	void ProcessMouseButtons();
 
 public:
 	// create the initial OpenGL display window
@@ -47,4 +58,22 @@ public:
 
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// get the view matrix of the current frame
+	glm::mat4 GetViewMatrix() const;
+	// get the projection matrix of the current frame
+	glm::mat4 GetProjectionMatrix() const;
+	// get the world position of the camera
+	glm::vec3 GetCameraPosition() const;
+
+	// get the world space ray through a window position, using
+	// the matrices of the current frame
+	void GetPickingRay(
+		double xWindowPos,
+		double yWindowPos,
+		glm::vec3& origin,
+		glm::vec3& direction) const;
+	// get the ray under the cursor once after each left click,
+	// returns false when there was no click
+	bool GetPickRequest(glm::vec3& origin, glm::vec3& direction);
 };
\ No newline at end of file
@@ -0,0 +1,276 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 screenTextureCoordinate;
+
+struct DirectionalLight {
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    bool bActive;
+};
+
+struct PointLight {
+    vec3 position;
+    
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    bool bActive;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+  
+    float constant;
+    float linear;
+    float quadratic;
+  
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;       
+
+    bool bActive;
+};
+
+#define TOTAL_POINT_LIGHTS 5
+
+// values of the lightPass uniform
+#define SCENE_LIGHT_PASS 0
+#define POINT_LIGHT_PASS 1
+
+// the geometry buffer - albedo with the coverage in alpha, the
+// world space normal with the shininess, the specular color,
+// and the depth
+uniform sampler2D albedoBuffer;
+uniform sampler2D normalBuffer;
+uniform sampler2D specularBuffer;
+uniform sampler2D depthBuffer;
+uniform mat4 inverseViewProjection;
+
+uniform bool bUseLighting = false;
+uniform int lightPass = SCENE_LIGHT_PASS;
+uniform vec3 viewPosition;
+uniform DirectionalLight directionalLight;
+uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
+uniform SpotLight spotLight;
+// diffuse material color of the lit scene
+uniform vec3 diffuseColor = vec3(1.0f);
+
+// shadow maps of the directional and spot light, the same as
+// in the forward scene shader
+uniform bool bDirectionalShadow = false;
+uniform sampler2DShadow directionalShadowMap;
+uniform mat4 directionalShadowMatrix;
+uniform bool bSpotShadow = false;
+uniform sampler2DShadow spotShadowMap;
+uniform mat4 spotShadowMatrix;
+
+// point light with a range of the scissored light passes
+uniform vec3 pointLightPosition;
+uniform float pointLightRange;
+uniform vec3 pointLightColor;
+
+// surface values of the pixel, read from the geometry buffer
+vec3 albedo;
+vec3 specularColor;
+float shininess;
+// world position of the pixel, from its depth
+vec3 surfacePosition;
+
+// function prototypes
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcRangeLight(vec3 normal, vec3 fragPos, vec3 viewDir);
+float CalcShadow(sampler2DShadow shadowMap, mat4 shadowMatrix, vec3 fragPos, vec3 worldNormal, vec3 lightDir);
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 albedoCoverage = texelFetch(albedoBuffer, pixel, 0);
+    // no object covers the pixel, the clear color stays
+    if(albedoCoverage.a < 0.5f)
+    {
+        discard;
+    }
+    albedo = albedoCoverage.rgb;
+
+    if(bUseLighting == false)
+    {
+        fragmentColor = vec4(albedo, 1.0f);
+        return;
+    }
+
+    vec4 normalShininess = texelFetch(normalBuffer, pixel, 0);
+    specularColor = texelFetch(specularBuffer, pixel, 0).rgb;
+    shininess = normalShininess.w;
+
+    // world position from the depth of the pixel
+    float depth = texelFetch(depthBuffer, pixel, 0).r;
+    vec4 world = inverseViewProjection * vec4((vec3(screenTextureCoordinate, depth) * 2.0f) - 1.0f, 1.0f);
+    vec3 fragPos = world.xyz / world.w;
+    surfacePosition = fragPos;
+
+    vec3 norm = normalize(normalShininess.xyz);
+    vec3 viewDir = normalize(viewPosition - fragPos);
+    vec3 phongResult = vec3(0.0f);
+
+    if(lightPass == POINT_LIGHT_PASS)
+    {
+        phongResult = CalcRangeLight(norm, fragPos, viewDir);
+    }
+    else
+    {
+        // the same phases as the forward scene shader
+        if(directionalLight.bActive == true)
+        {
+            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
+        }
+        for(int i = 0; i < TOTAL_POINT_LIGHTS; i++)
+        {
+            if(pointLights[i].bActive == true)
+            {
+                phongResult += CalcPointLight(pointLights[i], norm, fragPos, viewDir);
+            }
+        }
+        if(spotLight.bActive == true)
+        {
+            phongResult += CalcSpotLight(spotLight, norm, fragPos, viewDir);
+        }
+    }
+
+    fragmentColor = vec4(phongResult, 1.0f);
+}
+
+// calculates the color when using a directional light.
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
+{
+    vec3 lightDirection = normalize(-light.direction);
+    // diffuse shading
+    float diff = max(dot(normal, lightDirection), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDirection, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // combine results
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * diffuseColor * albedo;
+    vec3 specular = light.specular * spec * specularColor * albedo;
+    // the shadow only takes away the direct light
+    float shadow = 1.0f;
+    if(bDirectionalShadow == true)
+    {
+        shadow = CalcShadow(directionalShadowMap, directionalShadowMatrix, surfacePosition, normal, lightDirection);
+    }
+    return (ambient + ((diffuse + specular) * shadow));
+}
+
+// calculates the color when using a point light.
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // combine results
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * diffuseColor * albedo;
+    vec3 specular = light.specular * specularComponent * specularColor;
+    return (ambient + diffuse + specular);
+}
+
+// calculates the color when using a spot light.
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    // spotlight intensity
+    float theta = dot(lightDir, normalize(-light.direction)); 
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    // combine results
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * diffuseColor * albedo;
+    vec3 specular = light.specular * spec * specularColor * albedo;
+    float shadow = 1.0f;
+    if(bSpotShadow == true)
+    {
+        shadow = CalcShadow(spotShadowMap, spotShadowMatrix, fragPos, normal, lightDir);
+    }
+    return (ambient + ((diffuse + specular) * shadow)) * attenuation * intensity;
+}
+
+// calculates the color of the point light of a scissored pass,
+// with the same windowed falloff as the clustered lights of
+// the forward scene shader.
+vec3 CalcRangeLight(vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 toLight = pointLightPosition - fragPos;
+    float distance = length(toLight);
+    if(distance >= pointLightRange)
+    {
+        return vec3(0.0f);
+    }
+    vec3 lightDir = toLight / max(distance, 1.0e-4f);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // windowed inverse square attenuation
+    float ratio = distance / pointLightRange;
+    float window = clamp(1.0f - (ratio * ratio * ratio * ratio), 0.0f, 1.0f);
+    float attenuation = (window * window) / ((distance * distance) + 1.0f);
+
+    vec3 diffuse = pointLightColor * diff * diffuseColor * albedo;
+    vec3 specular = pointLightColor * spec * specularColor;
+    return (diffuse + specular) * attenuation;
+}
+
+// finds the share of the light reaching the fragment with a
+// 3 x 3 percentage closer filter, each tap of which already
+// blends the depth comparisons of four texels.  The slope bias
+// compares the world space normal with the world space light
+// direction, so it holds for rotated receivers.
+float CalcShadow(sampler2DShadow shadowMap, mat4 shadowMatrix, vec3 fragPos, vec3 worldNormal, vec3 lightDir)
+{
+    vec4 position = shadowMatrix * vec4(fragPos, 1.0f);
+    // behind the spot light or past its range nothing is shadowed
+    if(position.w <= 0.0f)
+    {
+        return 1.0f;
+    }
+    vec3 coordinate = position.xyz / position.w;
+    if(coordinate.z >= 1.0f)
+    {
+        return 1.0f;
+    }
+    // the surfaces turned away from the light need more bias
+    float bias = max(0.002f * (1.0f - dot(worldNormal, lightDir)), 0.0005f);
+    vec2 texelSize = 1.0f / vec2(textureSize(shadowMap, 0));
+    float lit = 0.0f;
+    for(int x = -1; x <= 1; x++)
+    {
+        for(int y = -1; y <= 1; y++)
+        {
+            lit += texture(shadowMap, vec3(coordinate.xy + (vec2(x, y) * texelSize), coordinate.z - bias));
+        }
+    }
+    return lit / 9.0f;
+}
@@ -0,0 +1,11 @@
+#version 330 core
+out vec2 screenTextureCoordinate;
+
+// one triangle covering the screen, built from the vertex index
+// without any vertex data
+void main()
+{
+    vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    screenTextureCoordinate = corner;
+    gl_Position = vec4((corner * 2.0f) - 1.0f, 0.0f, 1.0f);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D objectTexture;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// the clear texture pixels do not write depth
+uniform bool bAlphaTest = false;
+
+// the depth pre-pass only writes depth, no color is output
+void main()
+{
+    if((bAlphaTest == true) && (texture(objectTexture, fragmentTextureCoordinate * UVscale).a < 0.5f))
+    {
+        discard;
+    }
+}
\ No newline at end of file
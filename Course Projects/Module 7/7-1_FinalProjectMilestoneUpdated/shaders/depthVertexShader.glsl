@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+out vec2 fragmentTextureCoordinate;
+
+// the position is computed exactly like in vertexShader.glsl,
+// so that the color pass can test the depth for equality
+invariant gl_Position;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
+   fragmentTextureCoordinate = inTextureCoordinate;
+}
\ No newline at end of file
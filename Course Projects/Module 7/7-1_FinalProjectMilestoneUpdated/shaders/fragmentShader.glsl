@@ -1,9 +1,16 @@
 #version 330 core
-out vec4 fragmentColor;
+layout (location = 0) out vec4 fragmentColor;
+// summed weight of the transparent layers, only written by
+// the order independent transparency pass
+layout (location = 1) out vec4 weightOutput;
 
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+in vec3 fragmentObjectPosition;
+in vec3 fragmentObjectNormal;
+in vec3 vertexDiffuseLight;
+in vec3 vertexSpecularLight;
 
 struct Material {
     vec3 diffuseColor;
@@ -56,19 +63,153 @@ uniform vec4 objectColor = vec4(1.0f);
 uniform vec3 viewPosition;
 uniform DirectionalLight directionalLight;
 uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
+// the point lights written first into the fixed array
+uniform int activePointLights = 0;
 uniform SpotLight spotLight;
 uniform Material material;
 uniform sampler2D objectTexture;
 uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// the texture pixels are either opaque or discarded
+uniform bool bAlphaTest = false;
+
+// clustered point lights - two texels per light holding the
+// position and range and the color, the offset and count of
+// the light list of every cluster, and the lists themselves
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 9
+#define CLUSTER_SLICES 24
+uniform bool bUseClusteredLights = false;
+uniform mat4 view;
+uniform samplerBuffer lightData;
+uniform usamplerBuffer clusterTable;
+uniform usamplerBuffer clusterLightIndices;
+// size of a screen tile in pixels
+uniform vec2 clusterTileSize = vec2(1.0f);
+// scale and bias turning the view depth, or its logarithm when
+// the third value is one, into the depth slice
+uniform vec3 clusterDepth = vec3(0.0f);
+
+// point lights listed for the drawn object instead - the list
+// starts at the offset in the light indices and uses the same
+// light data as the clusters
+uniform bool bUseObjectLights = false;
+uniform usamplerBuffer objectLightIndices;
+uniform int objectLightOffset = 0;
+uniform int objectLightCount = 0;
+
+// baked diffuse lighting of the static objects, sampled from
+// the chart of the object in the lightmap atlas instead of
+// evaluating the lights - the chart layout of each primitive
+// matches the chart shapes of the lightmap baker
+#define LIGHTMAP_PLANE 0
+#define LIGHTMAP_BOX 1
+#define LIGHTMAP_CYLINDER 2
+#define LIGHTMAP_SPHERE 3
+#define LIGHTMAP_TORUS 4
+#define LIGHTMAP_QUARTER_TORUS 5
+#define PI 3.14159265f
+uniform bool bUseLightmap = false;
+uniform sampler2D lightmapAtlas;
+uniform int lightmapShape = LIGHTMAP_PLANE;
+// offset and size of the chart of the object in the atlas
+uniform vec4 lightmapRect = vec4(0.0f);
+
+// shadow maps of the directional and spot light, compared in
+// the sampler - the matrices take world positions into the
+// texture coordinates and depth of each map
+uniform bool bDirectionalShadow = false;
+uniform sampler2DShadow directionalShadowMap;
+uniform mat4 directionalShadowMatrix;
+uniform bool bSpotShadow = false;
+uniform sampler2DShadow spotShadowMap;
+uniform mat4 spotShadowMatrix;
+
+// baked light probes replacing the flat ambient of the lights -
+// the nine spherical harmonic coefficients of each probe are
+// held in seven RGBA blocks of the grid placed along X, and
+// the probes on the corners of the box are at its texel centers
+#define LIGHT_PROBE_BLOCKS 7
+uniform bool bUseLightProbes = false;
+uniform sampler3D lightProbeGrid;
+uniform vec3 lightProbeMin = vec3(0.0f);
+uniform vec3 lightProbeMax = vec3(1.0f);
+uniform vec3 lightProbeCounts = vec3(2.0f);
+
+// the object covers few enough pixels for the lighting to be
+// evaluated at its vertices and interpolated
+uniform bool bVertexLighting = false;
+
+// the transparent object is drawn into the order independent
+// transparency targets instead of blended over the window
+uniform bool bOrderIndependent = false;
+
+// the shader variants define the features they are compiled
+// for, with the active point lights stored first - without
+// them the features are checked for every fragment
+#ifdef SHADER_VARIANT
+#define USE_TEXTURE (VARIANT_TEXTURE != 0)
+#define USE_LIGHTING (VARIANT_LIGHTING != 0)
+#define USE_ALPHA_TEST (VARIANT_ALPHA_TEST != 0)
+#define USE_CLUSTERED_LIGHTS (VARIANT_CLUSTERED_LIGHTS != 0)
+#define USE_OBJECT_LIGHTS (VARIANT_OBJECT_LIGHTS != 0)
+#define USE_LIGHTMAP (VARIANT_LIGHTMAP != 0)
+#define USE_LIGHT_PROBES (VARIANT_LIGHT_PROBES != 0)
+#define USE_VERTEX_LIGHTING (VARIANT_VERTEX_LIGHTING != 0)
+#define USE_ORDER_INDEPENDENT (VARIANT_ORDER_INDEPENDENT != 0)
+#define ACTIVE_POINT_LIGHTS VARIANT_POINT_LIGHTS
+#else
+#define USE_TEXTURE (bUseTexture == true)
+#define USE_LIGHTING (bUseLighting == true)
+#define USE_ALPHA_TEST (bAlphaTest == true)
+#define USE_CLUSTERED_LIGHTS (bUseClusteredLights == true)
+#define USE_OBJECT_LIGHTS (bUseObjectLights == true)
+#define USE_LIGHTMAP (bUseLightmap == true)
+#define USE_LIGHT_PROBES (bUseLightProbes == true)
+#define USE_VERTEX_LIGHTING (bVertexLighting == true)
+#define USE_ORDER_INDEPENDENT (bOrderIndependent == true)
+#define ACTIVE_POINT_LIGHTS activePointLights
+#endif
 
 // function prototypes
 vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcClusterLight(int lightIndex, vec3 normal, vec3 fragPos, vec3 viewDir);
+int GetCluster(vec3 fragPos);
+vec2 GetLightmapCoordinate();
+float CalcShadow(sampler2DShadow shadowMap, mat4 shadowMatrix, vec3 fragPos, vec3 worldNormal, vec3 lightDir);
+vec3 CalcProbeIrradiance(vec3 fragPos, vec3 worldNormal);
+float CalcTransparencyWeight(float alpha, float depth);
 
 void main()
 {    
-    if(bUseLighting == true)
+    if(USE_LIGHTMAP)
+    {
+        vec4 albedo = objectColor;
+        if(USE_TEXTURE)
+        {
+            albedo = texture(objectTexture, fragmentTextureCoordinate * UVscale);
+        }
+        vec3 bakedLight = texture(lightmapAtlas, GetLightmapCoordinate()).rgb;
+        fragmentColor = vec4(albedo.rgb * bakedLight, albedo.a);
+    }
+    else if(USE_LIGHTING && USE_VERTEX_LIGHTING)
+    {
+        // the lights were evaluated by the vertex shader, only
+        // the surface color is read per fragment
+        vec4 albedo = objectColor;
+        if(USE_TEXTURE)
+        {
+            albedo = texture(objectTexture, fragmentTextureCoordinate);
+        }
+        vec3 lightResult = (albedo.rgb * vertexDiffuseLight) + vertexSpecularLight;
+        if(USE_LIGHT_PROBES)
+        {
+            lightResult += albedo.rgb * CalcProbeIrradiance(fragmentPosition, normalize(fragmentVertexNormal));
+        }
+        fragmentColor = vec4(lightResult, albedo.a);
+    }
+    else if(USE_LIGHTING)
     {
         vec3 phongResult = vec3(0.0f);
         // properties
@@ -86,10 +227,29 @@ void main()
         {
             phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
         }
-        // phase 2: point lights
-        for(int i = 0; i < TOTAL_POINT_LIGHTS; i++)
+        // phase 2: point lights, either the ones listed for the
+        // cluster of the fragment or for the object, or the
+        // fixed array
+        if(USE_CLUSTERED_LIGHTS)
+        {
+            uvec2 lightList = texelFetch(clusterTable, GetCluster(fragmentPosition)).xy;
+            for(uint i = 0u; i < lightList.y; i++)
+            {
+                int lightIndex = int(texelFetch(clusterLightIndices, int(lightList.x + i)).x);
+                phongResult += CalcClusterLight(lightIndex, norm, fragmentPosition, viewDir);
+            }
+        }
+        else if(USE_OBJECT_LIGHTS)
         {
-	    if(pointLights[i].bActive == true)
+            for(int i = 0; i < objectLightCount; i++)
+            {
+                int lightIndex = int(texelFetch(objectLightIndices, objectLightOffset + i).x);
+                phongResult += CalcClusterLight(lightIndex, norm, fragmentPosition, viewDir);
+            }
+        }
+        else
+        {
+            for(int i = 0; i < ACTIVE_POINT_LIGHTS; i++)
             {
                 phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
             }
@@ -99,8 +259,19 @@ void main()
         {
             phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
         }
+        // phase 4: indirect light from the probes around the
+        // fragment, in place of the ambient of the lights
+        if(USE_LIGHT_PROBES)
+        {
+            vec3 albedo = vec3(objectColor);
+            if(USE_TEXTURE)
+            {
+                albedo = vec3(texture(objectTexture, fragmentTextureCoordinate));
+            }
+            phongResult += albedo * CalcProbeIrradiance(fragmentPosition, norm);
+        }
     
-        if(bUseTexture == true)
+        if(USE_TEXTURE)
         {
             fragmentColor = vec4(phongResult, (texture(objectTexture, fragmentTextureCoordinate)).a);
         }
@@ -111,7 +282,7 @@ void main()
     }
     else
     {
-        if(bUseTexture == true)
+        if(USE_TEXTURE)
         {
             fragmentColor = texture(objectTexture, fragmentTextureCoordinate * UVscale);
         }
@@ -120,6 +291,22 @@ void main()
             fragmentColor = objectColor;
         }
     }
+
+    if(USE_ALPHA_TEST && (fragmentColor.a < 0.5f))
+    {
+        discard;
+    }
+
+    // the layer adds its weighted color and weight, and its
+    // alpha takes away from the light let through, so the
+    // layers can be drawn in any order
+    if(USE_ORDER_INDEPENDENT)
+    {
+        float alpha = fragmentColor.a;
+        float weight = alpha * CalcTransparencyWeight(alpha, gl_FragCoord.z);
+        fragmentColor = vec4(fragmentColor.rgb * weight, alpha);
+        weightOutput = vec4(weight, 0.0f, 0.0f, alpha);
+    }
 }
 
 // calculates the color when using a directional light.
@@ -136,7 +323,7 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
     vec3 reflectDir = reflect(-lightDirection, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     // combine results
-    if(bUseTexture == true)
+    if(USE_TEXTURE)
     {
         ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate));
         diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
@@ -148,8 +335,14 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
         diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
         specular = light.specular * spec * material.specularColor * vec3(objectColor);
     }
+    // the shadow only takes away the direct light
+    float shadow = 1.0f;
+    if(bDirectionalShadow == true)
+    {
+        shadow = CalcShadow(directionalShadowMap, directionalShadowMatrix, fragmentPosition, normal, lightDirection);
+    }
     
-    return (ambient + diffuse + specular);
+    return (ambient + ((diffuse + specular) * shadow));
 }
 
 // calculates the color when using a point light.
@@ -168,7 +361,7 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
    
     // combine results
-    if(bUseTexture == true)
+    if(USE_TEXTURE)
     {
         ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate));
         diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
@@ -205,7 +398,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    if(bUseTexture == true)
+    if(USE_TEXTURE)
     {
         ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate));
         diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
@@ -218,8 +411,222 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
         specular = light.specular * spec * material.specularColor * vec3(objectColor);
     }
     
+    float shadow = 1.0f;
+    if(bSpotShadow == true)
+    {
+        shadow = CalcShadow(spotShadowMap, spotShadowMatrix, fragPos, normal, lightDir);
+    }
+    
     ambient *= attenuation * intensity;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
+    diffuse *= attenuation * intensity * shadow;
+    specular *= attenuation * intensity * shadow;
     return (ambient + diffuse + specular);
 }
+
+// finds the cluster holding the fragment from its pixel and
+// its view depth.
+int GetCluster(vec3 fragPos)
+{
+    float depth = -(view * vec4(fragPos, 1.0f)).z;
+    float slice = (clusterDepth.z > 0.5f) ? log(max(depth, 1.0e-4f)) : depth;
+    int sliceIndex = clamp(int(floor(slice * clusterDepth.x + clusterDepth.y)), 0, CLUSTER_SLICES - 1);
+    ivec2 tile = ivec2(gl_FragCoord.xy / clusterTileSize);
+    tile = clamp(tile, ivec2(0), ivec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+    return (((sliceIndex * CLUSTER_TILES_Y) + tile.y) * CLUSTER_TILES_X) + tile.x;
+}
+
+// calculates the color of a clustered point light, fading to
+// nothing at its range so that lights left out of a cluster
+// add nothing there.
+vec3 CalcClusterLight(int lightIndex, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec4 positionRange = texelFetch(lightData, lightIndex * 2);
+    vec3 color = texelFetch(lightData, (lightIndex * 2) + 1).rgb;
+
+    vec3 toLight = positionRange.xyz - fragPos;
+    float distance = length(toLight);
+    if(distance >= positionRange.w)
+    {
+        return vec3(0.0f);
+    }
+    vec3 lightDir = toLight / max(distance, 1.0e-4f);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    // windowed inverse square attenuation
+    float ratio = distance / positionRange.w;
+    float window = clamp(1.0f - (ratio * ratio * ratio * ratio), 0.0f, 1.0f);
+    float attenuation = (window * window) / ((distance * distance) + 1.0f);
+
+    vec3 surfaceColor = vec3(objectColor);
+    if(USE_TEXTURE)
+    {
+        surfaceColor = vec3(texture(objectTexture, fragmentTextureCoordinate));
+    }
+    vec3 diffuse = color * diff * material.diffuseColor * surfaceColor;
+    vec3 specular = color * spec * material.specularColor;
+    return (diffuse + specular) * attenuation;
+}
+
+// finds where the fragment lies in the lightmap atlas, from its
+// object space position and normal and the chart layout of the
+// primitive.
+vec2 GetLightmapCoordinate()
+{
+    vec3 position = fragmentObjectPosition;
+    vec3 normal = normalize(fragmentObjectNormal);
+    // cell of the chart holding the fragment, and the position
+    // across the cell
+    vec4 cell = vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    vec2 local = vec2(0.0f);
+
+    if(lightmapShape == LIGHTMAP_PLANE)
+    {
+        local = (position.xz * 0.5f) + 0.5f;
+    }
+    else if(lightmapShape == LIGHTMAP_BOX)
+    {
+        // one cell per face in a 3 x 2 grid
+        vec3 extent = abs(normal);
+        int face = 0;
+        if((extent.x >= extent.y) && (extent.x >= extent.z))
+        {
+            face = (normal.x >= 0.0f) ? 0 : 1;
+            local = position.zy + 0.5f;
+        }
+        else if(extent.y >= extent.z)
+        {
+            face = (normal.y >= 0.0f) ? 2 : 3;
+            local = position.xz + 0.5f;
+        }
+        else
+        {
+            face = (normal.z >= 0.0f) ? 4 : 5;
+            local = position.xy + 0.5f;
+        }
+        cell = vec4(float(face % 3) / 3.0f, float(face / 3) * 0.5f, 1.0f / 3.0f, 0.5f);
+    }
+    else if(lightmapShape == LIGHTMAP_CYLINDER)
+    {
+        // the side in the lower half, the caps in the upper
+        if(abs(normal.y) > 0.5f)
+        {
+            cell = vec4((normal.y > 0.0f) ? 0.0f : 0.5f, 0.5f, 0.5f, 0.5f);
+            local = (position.xz * 0.5f) + 0.5f;
+        }
+        else
+        {
+            cell = vec4(0.0f, 0.0f, 1.0f, 0.5f);
+            local = vec2((atan(position.z, position.x) / (2.0f * PI)) + 0.5f, position.y);
+        }
+    }
+    else if(lightmapShape == LIGHTMAP_SPHERE)
+    {
+        vec3 direction = normalize(position);
+        local = vec2(
+            (atan(direction.z, direction.x) / (2.0f * PI)) + 0.5f,
+            (asin(clamp(direction.y, -1.0f, 1.0f)) / PI) + 0.5f);
+    }
+    else
+    {
+        // around the main ring, then around the tube
+        float ringAngle = atan(position.y, position.x);
+        vec2 ring = vec2(cos(ringAngle), sin(ringAngle));
+        vec2 tube = vec2(dot(position.xy, ring) - 1.0f, position.z);
+        local.x = (lightmapShape == LIGHTMAP_TORUS) ? ((ringAngle / (2.0f * PI)) + 0.5f) : (ringAngle / (0.5f * PI));
+        local.y = (atan(tube.y, tube.x) / (2.0f * PI)) + 0.5f;
+    }
+
+    // stay half a texel inside the cell, so that the filtering
+    // never blends in the texels of the next cell or chart
+    vec2 cellTexels = lightmapRect.zw * cell.zw * vec2(textureSize(lightmapAtlas, 0));
+    vec2 border = 0.5f / max(cellTexels, vec2(1.0f));
+    local = clamp(local, border, 1.0f - border);
+    return lightmapRect.xy + ((cell.xy + (local * cell.zw)) * lightmapRect.zw);
+}
+
+// finds the share of the light reaching the fragment with a
+// 3 x 3 percentage closer filter, each tap of which already
+// blends the depth comparisons of four texels.  The slope bias
+// compares the world space normal with the world space light
+// direction, so it holds for rotated receivers.
+float CalcShadow(sampler2DShadow shadowMap, mat4 shadowMatrix, vec3 fragPos, vec3 worldNormal, vec3 lightDir)
+{
+    vec4 position = shadowMatrix * vec4(fragPos, 1.0f);
+    // behind the spot light or past its range nothing is shadowed
+    if(position.w <= 0.0f)
+    {
+        return 1.0f;
+    }
+    vec3 coordinate = position.xyz / position.w;
+    if(coordinate.z >= 1.0f)
+    {
+        return 1.0f;
+    }
+    // the surfaces turned away from the light need more bias
+    float bias = max(0.002f * (1.0f - dot(worldNormal, lightDir)), 0.0005f);
+    vec2 texelSize = 1.0f / vec2(textureSize(shadowMap, 0));
+    float lit = 0.0f;
+    for(int x = -1; x <= 1; x++)
+    {
+        for(int y = -1; y <= 1; y++)
+        {
+            lit += texture(shadowMap, vec3(coordinate.xy + (vec2(x, y) * texelSize), coordinate.z - bias));
+        }
+    }
+    return lit / 9.0f;
+}
+
+// finds the light reaching the fragment from the probes around
+// it - the eight nearest probes are blended by the filtering of
+// each block, then the coefficients are evaluated for the normal
+// with the second order spherical harmonics.  The probes were
+// baked with world space directions, so the normal must be in
+// world space as well.
+vec3 CalcProbeIrradiance(vec3 fragPos, vec3 worldNormal)
+{
+    vec3 cell = clamp((fragPos - lightProbeMin) / (lightProbeMax - lightProbeMin), 0.0f, 1.0f) * (lightProbeCounts - 1.0f);
+    vec3 coordinate = (cell + 0.5f) / lightProbeCounts;
+    coordinate.x /= float(LIGHT_PROBE_BLOCKS);
+
+    float values[LIGHT_PROBE_BLOCKS * 4];
+    for(int block = 0; block < LIGHT_PROBE_BLOCKS; block++)
+    {
+        vec4 texel = texture(lightProbeGrid, coordinate + vec3(float(block) / float(LIGHT_PROBE_BLOCKS), 0.0f, 0.0f));
+        values[(block * 4) + 0] = texel.x;
+        values[(block * 4) + 1] = texel.y;
+        values[(block * 4) + 2] = texel.z;
+        values[(block * 4) + 3] = texel.w;
+    }
+
+    float basis[9];
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * worldNormal.y;
+    basis[2] = 0.488603f * worldNormal.z;
+    basis[3] = 0.488603f * worldNormal.x;
+    basis[4] = 1.092548f * worldNormal.x * worldNormal.y;
+    basis[5] = 1.092548f * worldNormal.y * worldNormal.z;
+    basis[6] = 0.315392f * ((3.0f * worldNormal.z * worldNormal.z) - 1.0f);
+    basis[7] = 1.092548f * worldNormal.x * worldNormal.z;
+    basis[8] = 0.546274f * ((worldNormal.x * worldNormal.x) - (worldNormal.y * worldNormal.y));
+
+    vec3 irradiance = vec3(0.0f);
+    for(int i = 0; i < 9; i++)
+    {
+        irradiance += vec3(values[i * 3], values[(i * 3) + 1], values[(i * 3) + 2]) * basis[i];
+    }
+    return max(irradiance, vec3(0.0f));
+}
+
+// finds the weight of a transparent layer in the average color
+// of a pixel - the closer and more opaque layers are weighted
+// far above the ones behind them, so the average stays close
+// to the color sorted blending would give.
+float CalcTransparencyWeight(float alpha, float depth)
+{
+    float coverage = min(1.0f, alpha * 10.0f) + 0.01f;
+    float falloff = 1.0f - (depth * 0.9f);
+    return clamp(coverage * coverage * coverage * 1.0e8f * falloff * falloff * falloff, 1.0e-2f, 3.0e3f);
+}
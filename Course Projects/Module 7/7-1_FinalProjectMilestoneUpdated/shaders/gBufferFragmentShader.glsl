@@ -0,0 +1,44 @@
+#version 330 core
+layout (location = 0) out vec4 albedoOutput;
+layout (location = 1) out vec4 normalOutput;
+layout (location = 2) out vec4 specularOutput;
+
+in vec3 fragmentPosition;
+// world space normal, so that the lighting passes can compare
+// it against the world position rebuilt from the depth
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+
+struct Material {
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float shininess;
+};
+
+uniform bool bUseTexture = false;
+uniform vec4 objectColor = vec4(1.0f);
+uniform sampler2D objectTexture;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// the texture pixels are either opaque or discarded
+uniform bool bAlphaTest = false;
+uniform Material material;
+
+// the geometry pass of the deferred path writes the surface
+// values of the opaque objects, the albedo alpha marks the
+// covered pixels for the lighting passes
+void main()
+{
+    vec4 albedo = objectColor;
+    if(bUseTexture == true)
+    {
+        albedo = texture(objectTexture, fragmentTextureCoordinate * UVscale);
+    }
+    if((bAlphaTest == true) && (albedo.a < 0.5f))
+    {
+        discard;
+    }
+
+    albedoOutput = vec4(albedo.rgb, 1.0f);
+    normalOutput = vec4(normalize(fragmentVertexNormal), material.shininess);
+    specularOutput = vec4(material.specularColor, 1.0f);
+}
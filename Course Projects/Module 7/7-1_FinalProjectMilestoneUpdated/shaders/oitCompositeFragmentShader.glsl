@@ -0,0 +1,26 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 screenTextureCoordinate;
+
+// summed weighted colors with the light let through in alpha,
+// and the summed weights of the transparent layers
+uniform sampler2D accumulationBuffer;
+uniform sampler2D weightBuffer;
+
+// blends the weighted average color of the transparent layers
+// over the opaque image, covering it by the light the layers
+// did not let through
+void main()
+{
+    vec4 accumulation = texture(accumulationBuffer, screenTextureCoordinate);
+    float revealage = accumulation.a;
+    // no layer covers the pixel
+    if(revealage >= 1.0f)
+    {
+        discard;
+    }
+    float weight = texture(weightBuffer, screenTextureCoordinate).r;
+    vec3 averageColor = accumulation.rgb / max(weight, 1.0e-5f);
+    fragmentColor = vec4(averageColor, 1.0f - revealage);
+}
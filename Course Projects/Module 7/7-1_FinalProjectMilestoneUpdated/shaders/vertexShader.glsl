@@ -4,17 +4,253 @@ layout (location = 1) in vec3 inVertexNormal;
 layout (location = 2) in vec2 inTextureCoordinate;
 
 out vec3 fragmentPosition;
+// world space normal, matching the lights and positions
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+// object space position and normal, for the lightmap coordinates
+out vec3 fragmentObjectPosition;
+out vec3 fragmentObjectNormal;
+// lighting of the distant objects evaluated at the vertices -
+// the light multiplied into the surface color, and the
+// highlight added over it
+out vec3 vertexDiffuseLight;
+out vec3 vertexSpecularLight;
+
+// the depth pre-pass shader computes the same position, which
+// must match bit for bit for the GL_EQUAL depth test
+invariant gl_Position;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// the light uniforms are shared with the fragment shader and
+// declared the same way
+struct Material {
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float shininess;
+}; 
+
+struct DirectionalLight {
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    bool bActive;
+};
+
+struct PointLight {
+    vec3 position;
+    
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    bool bActive;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+  
+    float constant;
+    float linear;
+    float quadratic;
+  
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;       
+
+    bool bActive;
+};
+
+#define TOTAL_POINT_LIGHTS 5
+
+uniform vec3 viewPosition;
+uniform DirectionalLight directionalLight;
+uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
+// the point lights written first into the fixed array
+uniform int activePointLights = 0;
+uniform SpotLight spotLight;
+uniform Material material;
+
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 9
+#define CLUSTER_SLICES 24
+uniform bool bUseClusteredLights = false;
+uniform samplerBuffer lightData;
+uniform usamplerBuffer clusterTable;
+uniform usamplerBuffer clusterLightIndices;
+uniform vec2 clusterTileSize = vec2(1.0f);
+uniform vec3 clusterDepth = vec3(0.0f);
+
+uniform bool bUseObjectLights = false;
+uniform usamplerBuffer objectLightIndices;
+uniform int objectLightOffset = 0;
+uniform int objectLightCount = 0;
+
+uniform bool bDirectionalShadow = false;
+uniform sampler2DShadow directionalShadowMap;
+uniform mat4 directionalShadowMatrix;
+uniform bool bSpotShadow = false;
+uniform sampler2DShadow spotShadowMap;
+uniform mat4 spotShadowMatrix;
+
+// the object covers few enough pixels to be lit per vertex
+uniform bool bVertexLighting = false;
+
+#ifdef SHADER_VARIANT
+#define USE_VERTEX_LIGHTING (VARIANT_VERTEX_LIGHTING != 0)
+#define USE_CLUSTERED_LIGHTS (VARIANT_CLUSTERED_LIGHTS != 0)
+#define USE_OBJECT_LIGHTS (VARIANT_OBJECT_LIGHTS != 0)
+#define ACTIVE_POINT_LIGHTS VARIANT_POINT_LIGHTS
+#else
+#define USE_VERTEX_LIGHTING (bVertexLighting == true)
+#define USE_CLUSTERED_LIGHTS (bUseClusteredLights == true)
+#define USE_OBJECT_LIGHTS (bUseObjectLights == true)
+#define ACTIVE_POINT_LIGHTS activePointLights
+#endif
+
+// function prototypes
+void LightVertex(vec3 position, vec3 normal);
+
 void main()
 {
    fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
    gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = inVertexNormal;
+   // the inverse transpose keeps the normals of scaled objects
+   // perpendicular to their surfaces
+   fragmentVertexNormal = transpose(inverse(mat3(model))) * inVertexNormal;
    fragmentTextureCoordinate = inTextureCoordinate;
-}
\ No newline at end of file
+   fragmentObjectPosition = inVertexPosition;
+   fragmentObjectNormal = inVertexNormal;
+
+   vertexDiffuseLight = vec3(0.0f);
+   vertexSpecularLight = vec3(0.0f);
+   if(USE_VERTEX_LIGHTING)
+   {
+       LightVertex(fragmentPosition, normalize(fragmentVertexNormal));
+   }
+}
+
+// adds the light of one light source to the vertex, scaled by
+// its attenuation, with the shadow taking away the direct light.
+void AddVertexLight(vec3 ambient, vec3 diffuse, vec3 specular, vec3 lightDir, vec3 normal, vec3 viewDir, float attenuation, float shadow)
+{
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vertexDiffuseLight += (ambient + (diffuse * diff * material.diffuseColor * shadow)) * attenuation;
+    vertexSpecularLight += specular * spec * material.specularColor * shadow * attenuation;
+}
+
+// finds the share of the light reaching the vertex with a single
+// compared tap of the shadow map.
+float CalcVertexShadow(sampler2DShadow shadowMap, mat4 shadowMatrix, vec3 position, vec3 normal, vec3 lightDir)
+{
+    vec4 coordinate = shadowMatrix * vec4(position, 1.0f);
+    if((coordinate.w <= 0.0f) || ((coordinate.z / coordinate.w) >= 1.0f))
+    {
+        return 1.0f;
+    }
+    float bias = max(0.002f * (1.0f - dot(normal, lightDir)), 0.0005f);
+    return texture(shadowMap, vec3(coordinate.xy / coordinate.w, (coordinate.z / coordinate.w) - bias));
+}
+
+// adds a point light of the light data buffer, fading to nothing
+// at its range like the clustered lights of the fragment shader.
+void AddBufferLight(int lightIndex, vec3 position, vec3 normal, vec3 viewDir)
+{
+    vec4 positionRange = texelFetch(lightData, lightIndex * 2);
+    vec3 color = texelFetch(lightData, (lightIndex * 2) + 1).rgb;
+
+    vec3 toLight = positionRange.xyz - position;
+    float distance = length(toLight);
+    if(distance >= positionRange.w)
+    {
+        return;
+    }
+    float ratio = distance / positionRange.w;
+    float window = clamp(1.0f - (ratio * ratio * ratio * ratio), 0.0f, 1.0f);
+    float attenuation = (window * window) / ((distance * distance) + 1.0f);
+    AddVertexLight(vec3(0.0f), color, color, toLight / max(distance, 1.0e-4f), normal, viewDir, attenuation, 1.0f);
+}
+
+// finds the cluster holding the vertex from where it lands on
+// the screen - the tiles together cover the viewport.
+int GetVertexCluster(vec3 position)
+{
+    float depth = -(view * vec4(position, 1.0f)).z;
+    float slice = (clusterDepth.z > 0.5f) ? log(max(depth, 1.0e-4f)) : depth;
+    int sliceIndex = clamp(int(floor(slice * clusterDepth.x + clusterDepth.y)), 0, CLUSTER_SLICES - 1);
+    vec2 screen = ((gl_Position.xy / max(gl_Position.w, 1.0e-4f)) * 0.5f) + 0.5f;
+    ivec2 tile = ivec2(floor(screen * vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y)));
+    tile = clamp(tile, ivec2(0), ivec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+    return (((sliceIndex * CLUSTER_TILES_Y) + tile.y) * CLUSTER_TILES_X) + tile.x;
+}
+
+// lights the vertex with the same lights as the fragment shader,
+// leaving the surface color to be multiplied in per fragment.
+// The position and normal are in world space, like the lights.
+void LightVertex(vec3 position, vec3 normal)
+{
+    vec3 viewDir = normalize(viewPosition - position);
+
+    if(directionalLight.bActive == true)
+    {
+        vec3 lightDir = normalize(-directionalLight.direction);
+        float shadow = 1.0f;
+        if(bDirectionalShadow == true)
+        {
+            shadow = CalcVertexShadow(directionalShadowMap, directionalShadowMatrix, position, normal, lightDir);
+        }
+        AddVertexLight(directionalLight.ambient, directionalLight.diffuse, directionalLight.specular,
+            lightDir, normal, viewDir, 1.0f, shadow);
+    }
+
+    if(USE_CLUSTERED_LIGHTS)
+    {
+        uvec2 lightList = texelFetch(clusterTable, GetVertexCluster(position)).xy;
+        for(uint i = 0u; i < lightList.y; i++)
+        {
+            AddBufferLight(int(texelFetch(clusterLightIndices, int(lightList.x + i)).x), position, normal, viewDir);
+        }
+    }
+    else if(USE_OBJECT_LIGHTS)
+    {
+        for(int i = 0; i < objectLightCount; i++)
+        {
+            AddBufferLight(int(texelFetch(objectLightIndices, objectLightOffset + i).x), position, normal, viewDir);
+        }
+    }
+    else
+    {
+        for(int i = 0; i < ACTIVE_POINT_LIGHTS; i++)
+        {
+            AddVertexLight(pointLights[i].ambient, pointLights[i].diffuse, pointLights[i].specular,
+                normalize(pointLights[i].position - position), normal, viewDir, 1.0f, 1.0f);
+        }
+    }
+
+    if(spotLight.bActive == true)
+    {
+        vec3 lightDir = normalize(spotLight.position - position);
+        float distance = length(spotLight.position - position);
+        float attenuation = 1.0 / (spotLight.constant + spotLight.linear * distance + spotLight.quadratic * (distance * distance));
+        float theta = dot(lightDir, normalize(-spotLight.direction));
+        float epsilon = spotLight.cutOff - spotLight.outerCutOff;
+        float intensity = clamp((theta - spotLight.outerCutOff) / epsilon, 0.0, 1.0);
+        float shadow = 1.0f;
+        if(bSpotShadow == true)
+        {
+            shadow = CalcVertexShadow(spotShadowMap, spotShadowMatrix, position, normal, lightDir);
+        }
+        AddVertexLight(spotLight.ambient, spotLight.diffuse, spotLight.specular,
+            lightDir, normal, viewDir, attenuation * intensity, shadow);
+    }
+}